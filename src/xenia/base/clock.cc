@@ -10,6 +10,7 @@
 #include "xenia/base/clock.h"
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <mutex>
 
@@ -38,13 +39,69 @@ uint64_t guest_system_time_base_ = Clock::QueryHostSystemTime();
 // Computed by RecomputeGuestTickScalar.
 std::pair<uint64_t, uint64_t> guest_tick_ratio_ = std::make_pair(1, 1);
 
-// Native guest ticks.
-uint64_t last_guest_tick_count_ = 0;
-// Last sampled host tick count.
-uint64_t last_host_tick_count_ = Clock::QueryHostTickCount();
-// Mutex to ensure last_host_tick_count_ and last_guest_tick_count_ are in sync
+// Guest tick count at a host tick count, and the host to guest tick ratio in
+// 32.32 fixed point, from which the guest tick count is extrapolated.
+// Published with a sequence lock so queries don't block each other: the
+// sequence is odd while an update is in progress, and readers retry if it has
+// changed while they were reading.
+std::atomic<uint32_t> guest_clock_sequence_ = {0};
+std::atomic<uint64_t> guest_clock_host_tick_base_ = {
+    Clock::QueryHostTickCount()};
+std::atomic<uint64_t> guest_clock_guest_tick_base_ = {0};
+std::atomic<uint64_t> guest_clock_tick_multiplier_ = {uint64_t(1) << 32};
+// Serializes updates of the published clock.
 std::mutex tick_mutex_;
 
+inline uint64_t MultiplyTicksFixed32(uint64_t ticks, uint64_t multiplier) {
+#if XE_COMPILER_MSVC
+  return (__umulh(ticks, multiplier) << 32) | ((ticks * multiplier) >> 32);
+#else
+  return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) *
+                                static_cast<unsigned __int128>(multiplier)) >>
+                               32);
+#endif  // XE_COMPILER_MSVC
+}
+
+// Guest tick count extrapolated from the given published base and ratio.
+inline uint64_t ExtrapolateGuestTickCount(uint64_t host_tick_count,
+                                          uint64_t host_tick_base,
+                                          uint64_t guest_tick_base,
+                                          uint64_t tick_multiplier) {
+  // Host ticks before the base may be observed from another core.
+  uint64_t host_tick_delta =
+      host_tick_count > host_tick_base ? host_tick_count - host_tick_base : 0;
+  return guest_tick_base +
+         MultiplyTicksFixed32(host_tick_delta, tick_multiplier);
+}
+
+// Current guest tick count with the currently published base and ratio.
+uint64_t CalculateGuestTickCount() {
+  uint32_t sequence;
+  uint64_t host_tick_count, host_tick_base, guest_tick_base, tick_multiplier;
+  while (true) {
+    sequence = guest_clock_sequence_.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      continue;
+    }
+    // Sampled within the read section, so if the parameters are still valid,
+    // the host tick count is earlier than the one the next update rebases at,
+    // and the guest tick count can't go backwards across the update.
+    host_tick_count = Clock::QueryHostTickCount();
+    host_tick_base =
+        guest_clock_host_tick_base_.load(std::memory_order_relaxed);
+    guest_tick_base =
+        guest_clock_guest_tick_base_.load(std::memory_order_relaxed);
+    tick_multiplier =
+        guest_clock_tick_multiplier_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (guest_clock_sequence_.load(std::memory_order_relaxed) == sequence) {
+      break;
+    }
+  }
+  return ExtrapolateGuestTickCount(host_tick_count, host_tick_base,
+                                   guest_tick_base, tick_multiplier);
+}
+
 void RecomputeGuestTickScalar() {
   // Create a rational number with numerator (first) and denominator (second)
   auto frac =
@@ -63,34 +120,44 @@ void RecomputeGuestTickScalar() {
 
   std::lock_guard<std::mutex> lock(tick_mutex_);
   guest_tick_ratio_ = frac;
-}
 
-// Update the guest timer for all threads.
-// Return a copy of the value so locking is reduced.
-uint64_t UpdateGuestClock() {
+  // Begin the update before sampling the host tick count to rebase at, so no
+  // reader can extrapolate the old parameters past the new base. The full
+  // fence makes the odd sequence visible before the host tick count is read.
+  uint32_t sequence = guest_clock_sequence_.load(std::memory_order_relaxed);
+  guest_clock_sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  // Rebase the clock at the current time so it stays continuous and
+  // monotonic, and publish the new ratio. Only this thread can modify the
+  // parameters while tick_mutex_ is held.
   uint64_t host_tick_count = Clock::QueryHostTickCount();
+  uint64_t guest_tick_count = ExtrapolateGuestTickCount(
+      host_tick_count,
+      guest_clock_host_tick_base_.load(std::memory_order_relaxed),
+      guest_clock_guest_tick_base_.load(std::memory_order_relaxed),
+      guest_clock_tick_multiplier_.load(std::memory_order_relaxed));
+  guest_clock_host_tick_base_.store(host_tick_count,
+                                    std::memory_order_relaxed);
+  guest_clock_guest_tick_base_.store(guest_tick_count,
+                                     std::memory_order_relaxed);
+  // 53 bits of precision are more than enough for the 32.32 ratio.
+  guest_clock_tick_multiplier_.store(
+      static_cast<uint64_t>(double(frac.first) / double(frac.second) *
+                            4294967296.0),
+      std::memory_order_relaxed);
+  guest_clock_sequence_.store(sequence + 2, std::memory_order_release);
+}
 
+// Query the guest timer, lock-free.
+uint64_t UpdateGuestClock() {
   if (cvars::clock_no_scaling) {
     // Nothing to update, calculate on the fly
-    return host_tick_count * guest_tick_ratio_.first / guest_tick_ratio_.second;
+    return Clock::QueryHostTickCount() * guest_tick_ratio_.first /
+           guest_tick_ratio_.second;
   }
 
-  std::unique_lock<std::mutex> lock(tick_mutex_, std::defer_lock);
-  if (lock.try_lock()) {
-    // Translate host tick count to guest tick count.
-    uint64_t host_tick_delta = host_tick_count > last_host_tick_count_
-                                   ? host_tick_count - last_host_tick_count_
-                                   : 0;
-    last_host_tick_count_ = host_tick_count;
-    uint64_t guest_tick_delta =
-        host_tick_delta * guest_tick_ratio_.first / guest_tick_ratio_.second;
-    last_guest_tick_count_ += guest_tick_delta;
-    return last_guest_tick_count_;
-  } else {
-    // Wait until another thread has finished updating the clock.
-    lock.lock();
-    return last_guest_tick_count_;
-  }
+  return CalculateGuestTickCount();
 }
 
 // Offset of the current guest system file time relative to the guest base time.
@@ -89,6 +89,16 @@ bool Protect(void* base_address, size_t length, PageAccess access,
 // the region.
 bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out);
 
+// Hints the host to back the given view of a file mapping (from MapFileView)
+// with huge pages where possible to reduce TLB misses. The access rights can
+// still be changed with page_size() granularity afterwards - the host falls
+// back to regular pages for the parts of huge pages with different access
+// rights. Returns false if huge pages can't be used for file mapping views
+// with the current host configuration, which is not an error. Even if true is
+// returned, the host may still use regular pages if huge ones can't be
+// allocated.
+bool AdviseHugePages(void* base_address, size_t length);
+
 // Allocates a block of memory for a type with the given alignment.
 // The memory must be freed with AlignedFree.
 template <typename T>
@@ -13,6 +13,9 @@
 #include <sys/mman.h>
 #include <unistd.h>
 #include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
 
 #include "xenia/base/math.h"
 #include "xenia/base/platform.h"
@@ -112,6 +115,73 @@ bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   return false;
 }
 
+#ifdef MADV_HUGEPAGE
+// Returns the selected value of a sysfs setting listing all the possible
+// values, like "always within_size advise [never] deny force", or an empty
+// string if it's not available.
+static std::string ReadSysfsSelection(const char* path) {
+  std::ifstream stream(path);
+  std::string value;
+  while (stream >> value) {
+    if (value.size() >= 2 && value.front() == '[' && value.back() == ']') {
+      return value.substr(1, value.size() - 2);
+    }
+  }
+  return std::string();
+}
+
+// Whether transparent huge pages may be used for the shared memory file
+// mappings when advised. madvise succeeds even if the hint is ignored, so the
+// policy has to be checked explicitly. Files created with shm_open are on the
+// tmpfs mounted at /dev/shm, which uses huge pages according to its huge= mount
+// option unless that's overridden by shmem_enabled being deny or force.
+static bool AreSharedMemoryHugePagesAllowed() {
+  std::string shmem_enabled = ReadSysfsSelection(
+      "/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+  if (shmem_enabled.empty() || shmem_enabled == "deny") {
+    return false;
+  }
+  if (shmem_enabled == "force") {
+    return true;
+  }
+  std::ifstream mounts_stream("/proc/mounts");
+  std::string line;
+  while (std::getline(mounts_stream, line)) {
+    std::istringstream line_stream(line);
+    std::string device, mount_point, type, options;
+    line_stream >> device >> mount_point >> type >> options;
+    if (mount_point != "/dev/shm" || type != "tmpfs") {
+      continue;
+    }
+    std::istringstream options_stream(options);
+    std::string option;
+    while (std::getline(options_stream, option, ',')) {
+      if (option == "huge=always" || option == "huge=within_size" ||
+          option == "huge=advise") {
+        return true;
+      }
+    }
+    return false;
+  }
+  return false;
+}
+#endif
+
+bool AdviseHugePages(void* base_address, size_t length) {
+#ifdef MADV_HUGEPAGE
+  // Transparent huge pages - unlike hugetlbfs, they don't need to be reserved
+  // by the administrator, and mprotect of a part of a huge page only splits
+  // the mapping into regular pages.
+  static const bool huge_pages_allowed = AreSharedMemoryHugePagesAllowed();
+  if (!huge_pages_allowed) {
+    return false;
+  }
+  return madvise(base_address, length, MADV_HUGEPAGE) == 0;
+#else
+  return false;
+#endif
+}
+
 FileMappingHandle CreateFileMappingHandle(const std::filesystem::path& path,
                                           size_t length, PageAccess access,
                                           bool commit) {
@@ -172,6 +172,13 @@ bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   return true;
 }
 
+bool AdviseHugePages(void* base_address, size_t length) {
+  // Large pages on Windows must be allocated with MEM_LARGE_PAGES, require
+  // SeLockMemoryPrivilege, are never paged out, and can't be protected
+  // partially, so they're not usable for the guest memory.
+  return false;
+}
+
 FileMappingHandle CreateFileMappingHandle(const std::filesystem::path& path,
                                           size_t length, PageAccess access,
                                           bool commit) {
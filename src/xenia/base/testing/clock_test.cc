@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2022 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/clock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::base::test {
+
+TEST_CASE("Guest tick count is monotonic across threads", "[clock]") {
+  constexpr size_t kThreadCount = 6;
+  constexpr size_t kQueryCount = 100000;
+
+  std::atomic<bool> went_backwards = false;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&went_backwards]() {
+      uint64_t last_tick_count = 0;
+      for (size_t j = 0; j < kQueryCount; ++j) {
+        uint64_t tick_count = Clock::QueryGuestTickCount();
+        if (tick_count < last_tick_count) {
+          went_backwards = true;
+        }
+        last_tick_count = tick_count;
+      }
+    });
+  }
+
+  // Rebase the clock while it's being queried.
+  double scalar = Clock::guest_time_scalar();
+  Clock::set_guest_time_scalar(2.0);
+  Clock::set_guest_time_scalar(0.5);
+  Clock::set_guest_time_scalar(scalar);
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(!went_backwards);
+}
+
+TEST_CASE("Guest tick count honors the time scalar", "[clock]") {
+  using namespace std::chrono_literals;
+
+  double scalar = Clock::guest_time_scalar();
+  Clock::set_guest_time_scalar(2.0);
+
+  uint64_t host_start = Clock::QueryHostTickCount();
+  uint64_t guest_start = Clock::QueryGuestTickCount();
+  std::this_thread::sleep_for(50ms);
+  uint64_t host_end = Clock::QueryHostTickCount();
+  uint64_t guest_end = Clock::QueryGuestTickCount();
+
+  Clock::set_guest_time_scalar(scalar);
+
+  double host_seconds = double(host_end - host_start) /
+                        double(Clock::QueryHostTickFrequency());
+  double guest_seconds =
+      double(guest_end - guest_start) / double(Clock::guest_tick_frequency());
+  REQUIRE(guest_seconds / host_seconds == Approx(2.0).epsilon(0.05));
+}
+
+TEST_CASE("Guest tick count query throughput", "[.benchmark][clock]") {
+  // Each thread queries the clock kQueryCount times, the time per query is the
+  // measured time divided by kQueryCount.
+  constexpr size_t kQueryCount = 100000;
+  auto query_on_threads = [](size_t thread_count) {
+    std::atomic<uint64_t> tick_count_sum = 0;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads.emplace_back([&tick_count_sum]() {
+        uint64_t thread_tick_count_sum = 0;
+        for (size_t j = 0; j < kQueryCount; ++j) {
+          thread_tick_count_sum += Clock::QueryGuestTickCount();
+        }
+        tick_count_sum += thread_tick_count_sum;
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    return tick_count_sum.load();
+  };
+  size_t hardware_thread_count =
+      std::max(std::thread::hardware_concurrency(), 1u);
+
+  BENCHMARK("1 thread") { return query_on_threads(1); };
+  BENCHMARK("4 threads") { return query_on_threads(4); };
+  BENCHMARK("1 thread per hardware thread") {
+    return query_on_threads(hardware_thread_count);
+  };
+}
+
+}  // namespace xe::base::test
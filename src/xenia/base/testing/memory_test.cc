@@ -15,6 +15,11 @@
 #include "xenia/base/clock.h"
 
 #include <array>
+#if XE_PLATFORM_LINUX
+#include <fstream>
+#include <sstream>
+#include <string>
+#endif
 
 namespace xe {
 namespace base {
@@ -558,6 +563,81 @@ TEST_CASE("read_write_view", "[virtual_memory_mapping]") {
   xe::memory::CloseFileMappingHandle(memory, path);
 }
 
+#if XE_PLATFORM_LINUX
+// Returns the VmFlags of the mapping starting at the address in smaps, or an
+// empty string if it's not found.
+static std::string GetSmapsVmFlags(uintptr_t address) {
+  std::ifstream smaps_stream("/proc/self/smaps");
+  std::string range_start = fmt::format("{:x}-", address);
+  std::string line;
+  bool in_mapping = false;
+  while (std::getline(smaps_stream, line)) {
+    if (line.compare(0, range_start.size(), range_start) == 0) {
+      in_mapping = true;
+    } else if (in_mapping && line.compare(0, 8, "VmFlags:") == 0) {
+      return line.substr(8);
+    }
+  }
+  return std::string();
+}
+#endif  // XE_PLATFORM_LINUX
+
+// Whether huge pages are actually allocated depends on the host configuration
+// and memory fragmentation, so only the advice being applied is checked where
+// it can be queried. Other than that, this is a smoke test for the view staying
+// usable with page-granular protection.
+TEST_CASE("huge_pages_view", "[virtual_memory_mapping]") {
+  // Larger than a huge page on common hosts, so at least one may be used.
+  const size_t length = 0x400000;
+  auto path = fmt::format("xenia_test_{}", Clock::QueryHostTickCount());
+  auto memory = xe::memory::CreateFileMappingHandle(
+      path, length, xe::memory::PageAccess::kReadWrite, true);
+  REQUIRE(memory != xe::memory::kFileMappingHandleInvalid);
+
+  uintptr_t address = 0x100000000;
+  auto view =
+      xe::memory::MapFileView(memory, reinterpret_cast<void*>(address), length,
+                              xe::memory::PageAccess::kReadWrite, 0);
+  REQUIRE(reinterpret_cast<uintptr_t>(view) == address);
+
+  // Not required to succeed, but the view must stay usable either way.
+  [[maybe_unused]] bool huge_pages_advised =
+      xe::memory::AdviseHugePages(view, length);
+#if XE_PLATFORM_LINUX
+  // MADV_HUGEPAGE is reported as the hg flag of the mapping if smaps is
+  // available.
+  std::string vm_flags = GetSmapsVmFlags(address);
+  if (huge_pages_advised && !vm_flags.empty()) {
+    std::istringstream vm_flags_stream(vm_flags);
+    bool vm_flag_hg = false;
+    std::string vm_flag;
+    while (vm_flags_stream >> vm_flag) {
+      vm_flag_hg |= vm_flag == "hg";
+    }
+    REQUIRE(vm_flag_hg);
+  }
+#endif  // XE_PLATFORM_LINUX
+  for (uint32_t i = 0; i < length; i += sizeof(uint32_t)) {
+    *reinterpret_cast<uint32_t*>(address + i) = i;
+  }
+
+  // Page-granular protection must still work within a huge page.
+  size_t page_size = xe::memory::page_size();
+  void* protected_page = reinterpret_cast<void*>(address + length / 2);
+  REQUIRE(xe::memory::Protect(protected_page, page_size,
+                              xe::memory::PageAccess::kReadOnly));
+  for (uint32_t i = 0; i < length; i += sizeof(uint32_t)) {
+    REQUIRE(*reinterpret_cast<const uint32_t*>(address + i) == i);
+  }
+  REQUIRE(xe::memory::Protect(protected_page, page_size,
+                              xe::memory::PageAccess::kReadWrite));
+  *reinterpret_cast<uint32_t*>(protected_page) = 0;
+  REQUIRE(*reinterpret_cast<const uint32_t*>(protected_page) == 0);
+
+  xe::memory::UnmapFileView(memory, reinterpret_cast<void*>(address), length);
+  xe::memory::CloseFileMappingHandle(memory, path);
+}
+
 TEST_CASE("make_fourcc", "[fourcc]") {
   SECTION("'1234'") {
     const uint32_t fourcc_host = 0x31323334;
@@ -11,6 +11,7 @@
 
 #include "xenia/base/threading.h"
 
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #define CATCH_CONFIG_ENABLE_CHRONO_STRINGMAKER
 #include "third_party/catch/include/catch.hpp"
 
@@ -1142,6 +1143,37 @@ TEST_CASE("Test Thread QueueUserCallback", "[thread]") {
   // callbacks.
 }
 
+TEST_CASE("Thread Create and Join Throughput", "[.benchmark][thread]") {
+  // Short-lived guest threads each create a host thread with a big stack. Also
+  // measure handing the same work to a parked thread instead.
+  Thread::CreationParameters params = {};
+  params.stack_size = 16 * 1024 * 1024;
+
+  BENCHMARK("Create and join") {
+    auto thread = Thread::Create(params, [] {});
+    return Wait(thread.get(), false, 1s);
+  };
+
+  std::atomic<bool> running(true);
+  auto work_event = Event::CreateAutoResetEvent(false);
+  auto done_event = Event::CreateAutoResetEvent(false);
+  auto parked_thread = Thread::Create(params, [&] {
+    while (true) {
+      Wait(work_event.get(), false);
+      if (!running) {
+        break;
+      }
+      done_event->Set();
+    }
+  });
+  BENCHMARK("Wake parked and join") {
+    return SignalAndWait(work_event.get(), done_event.get(), false, 1s);
+  };
+  running = false;
+  work_event->Set();
+  REQUIRE(Wait(parked_thread.get(), false, 1s) == WaitResult::kSuccess);
+}
+
 }  // namespace test
 }  // namespace base
 }  // namespace xe
@@ -19,11 +19,13 @@
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/atomic.h"
 #include "xenia/base/clock.h"
 #include "xenia/base/literals.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
+#include "xenia/base/profiling.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/module.h"
 
@@ -254,8 +256,8 @@ void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
                 static_cast<size_t>(end_write_address - tail_write_address));
 
     // Notify subclasses of placed code.
-    PlaceCode(guest_address, machine_code, func_info, code_execute_address,
-              unwind_reservation);
+    PlaceCode(guest_address, machine_code, func_info, function_info,
+              code_execute_address, unwind_reservation);
   }
 
 #if ENABLE_VTUNE
@@ -335,6 +337,66 @@ uint32_t X64CodeCache::PlaceData(const void* data, size_t length) {
   return uint32_t(uintptr_t(data_address));
 }
 
+void X64CodeCache::LinkGuestCode(uint32_t guest_address,
+                                 void* code_execute_address,
+                                 const std::vector<CallSite>& call_sites) {
+  auto global_lock = global_critical_region_.Acquire();
+
+  auto code = reinterpret_cast<uint8_t*>(code_execute_address);
+  linked_functions_[guest_address] = code;
+
+  // Callers placed before the function.
+  auto waiting_range = call_sites_.equal_range(guest_address);
+  for (auto it = waiting_range.first; it != waiting_range.second; ++it) {
+    PatchCallSite(it->second, code);
+  }
+
+  // Calls from the function, including recursive ones.
+  for (const CallSite& call_site : call_sites) {
+    PlacedCallSite placed_call_site;
+    placed_call_site.end_execute_address = code + call_site.end_offset;
+    placed_call_site.stub_execute_address = code + call_site.stub_offset;
+    placed_call_site.target_execute_address =
+        placed_call_site.stub_execute_address;
+    auto target_it = linked_functions_.find(call_site.target_address);
+    if (target_it != linked_functions_.end()) {
+      PatchCallSite(placed_call_site, target_it->second);
+    }
+    call_sites_.emplace(call_site.target_address, placed_call_site);
+  }
+
+  UpdateCallSiteCounters();
+}
+
+void X64CodeCache::PatchCallSite(PlacedCallSite& call_site,
+                                 const uint8_t* target_execute_address) {
+  // Functions placed again (such as when recompiled) are linked again.
+  if (call_site.target_execute_address == target_execute_address) {
+    return;
+  }
+  if (call_site.target_execute_address == call_site.stub_execute_address) {
+    ++linked_call_site_count_;
+  }
+  call_site.target_execute_address = target_execute_address;
+  // The rel32 is aligned, so it's replaced atomically, and other threads
+  // executing the call concurrently see either the old or the new target,
+  // which are both valid.
+  int32_t displacement = int32_t(intptr_t(target_execute_address) -
+                                 intptr_t(call_site.end_execute_address));
+  auto displacement_write_address = reinterpret_cast<volatile int32_t*>(
+      generated_code_write_base_ +
+      (call_site.end_execute_address - sizeof(int32_t) -
+       generated_code_execute_base_));
+  assert_zero(uintptr_t(displacement_write_address) & (sizeof(int32_t) - 1));
+  xe::atomic_exchange(displacement, displacement_write_address);
+}
+
+void X64CodeCache::UpdateCallSiteCounters() {
+  COUNT_profile_set("cpu/code_cache/call_sites", call_sites_.size());
+  COUNT_profile_set("cpu/code_cache/linked_call_sites",
+                    linked_call_site_count_);
+}
+
 GuestFunction* X64CodeCache::LookupFunction(uint64_t host_pc) {
   uint32_t key = uint32_t(host_pc - kGeneratedCodeExecuteBase);
   void* fn_entry = std::bsearch(
@@ -15,6 +15,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -39,6 +40,19 @@ struct EmitFunctionInfo {
   size_t stack_size;
 };
 
+// Unwind information returned by LookupUnwindInfo on platforms without a
+// system function table (everything except Windows), where the DWARF CFI
+// registered for the unwinder is not convenient to parse back. Sufficient to
+// step out of any generated function: the return address is at
+// rsp + stack_size once the stack has been allocated by the prolog, and at rsp
+// before that.
+struct X64UnwindEntry {
+  uint64_t code_begin;
+  uint64_t code_end;
+  uint32_t prolog_stack_alloc_offset;
+  uint32_t stack_size;
+};
+
 class X64CodeCache : public CodeCache {
  public:
   ~X64CodeCache() override;
@@ -74,6 +88,21 @@ class X64CodeCache : public CodeCache {
                       void*& code_write_address_out);
   uint32_t PlaceData(const void* data, size_t length);
 
+  // Direct call to another guest function, initially jumping to a stub that
+  // calls through the indirection table, and patched to jump to the function
+  // itself while it's compiled.
+  struct CallSite {
+    // Offsets in the code of the caller of the end of the call or jmp
+    // instruction with a 4-byte-aligned rel32 operand, and of the stub.
+    uint32_t end_offset;
+    uint32_t stub_offset;
+    uint32_t target_address;
+  };
+  // Links the call sites of a newly placed and relocated function, and the
+  // call sites of previously placed functions waiting for it.
+  void LinkGuestCode(uint32_t guest_address, void* code_execute_address,
+                     const std::vector<CallSite>& call_sites);
+
   GuestFunction* LookupFunction(uint64_t host_pc) override;
 
  protected:
@@ -108,6 +137,7 @@ class X64CodeCache : public CodeCache {
   }
   virtual void PlaceCode(uint32_t guest_address, void* machine_code,
                          const EmitFunctionInfo& func_info,
+                         GuestFunction* function_info,
                          void* code_execute_address,
                          UnwindReservation unwind_reservation) {}
 
@@ -141,6 +171,22 @@ class X64CodeCache : public CodeCache {
   // This can be used to bsearch on host PC to find the guest function.
   // The key is [start address | end address].
   std::vector<std::pair<uint64_t, GuestFunction*>> generated_code_map_;
+
+  struct PlacedCallSite {
+    uint8_t* end_execute_address;
+    uint8_t* stub_execute_address;
+    // The stub until linked.
+    const uint8_t* target_execute_address;
+  };
+  void PatchCallSite(PlacedCallSite& call_site,
+                     const uint8_t* target_execute_address);
+  void UpdateCallSiteCounters();
+  // Guest address -> code of the linked functions, under the global lock.
+  std::unordered_map<uint32_t, uint8_t*> linked_functions_;
+  // Target guest address -> call sites, linked if the target is in
+  // linked_functions_, under the global lock.
+  std::unordered_multimap<uint32_t, PlacedCallSite> call_sites_;
+  size_t linked_call_site_count_ = 0;
 };
 
 }  // namespace x64
@@ -9,11 +9,58 @@
 
 #include "xenia/cpu/backend/x64/x64_code_cache.h"
 
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "third_party/fmt/include/fmt/format.h"
+#include "xenia/base/assert.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/platform.h"
+#include "xenia/cpu/function.h"
+
+DEFINE_bool(perf_map, false,
+            "Write /tmp/perf-<pid>.map with the host address range and the "
+            "guest address and name of every function placed in the code "
+            "cache, for symbolizing generated code in Linux perf.",
+            "CPU");
+
+// Provided by the unwinder runtime (libgcc or LLVM libunwind).
+extern "C" void __register_frame(void* begin);
+extern "C" void __deregister_frame(void* begin);
+
 namespace xe {
 namespace cpu {
 namespace backend {
 namespace x64 {
 
+// DWARF call frame information for each placed function, laid out as a
+// minimal zero-terminated .eh_frame section (CIE, FDE, terminator). The
+// unwinder then can step through generated code like through any other frame.
+// See the DWARF 4 specification, section 6.4, and the LSB for the .eh_frame
+// specifics.
+//
+// IMPORTANT: this must be kept in sync with the prolog emitted by X64Emitter
+// and the thunks in X64Backend (the only CFA change in the prolog is a single
+// `sub rsp, stack_size`).
+enum DwarfCFA : uint8_t {
+  DW_CFA_nop = 0x00,
+  DW_CFA_advance_loc1 = 0x02,
+  DW_CFA_def_cfa = 0x0C,
+  DW_CFA_def_cfa_offset = 0x0E,
+  DW_CFA_advance_loc = 0x40,
+  DW_CFA_offset = 0x80,
+};
+// DWARF x86-64 register numbers.
+constexpr uint8_t kDwarfRegRsp = 7;
+constexpr uint8_t kDwarfRegReturnAddress = 16;
+// CIE (24 bytes with padding) + FDE (at most 32 bytes with padding) +
+// terminator.
+constexpr size_t kUnwindInfoSize = 24 + 32 + 4;
+
 class PosixX64CodeCache : public X64CodeCache {
  public:
   PosixX64CodeCache();
@@ -21,19 +68,33 @@ class PosixX64CodeCache : public X64CodeCache {
 
   bool Initialize() override;
 
-  void* LookupUnwindInfo(uint64_t host_pc) override { return nullptr; }
+  void* LookupUnwindInfo(uint64_t host_pc) override;
 
  private:
-  /*
   UnwindReservation RequestUnwindReservation(uint8_t* entry_address) override;
-  void PlaceCode(uint32_t guest_address, void* machine_code, size_t code_size,
-                 size_t stack_size, void* code_execute_address,
+  void PlaceCode(uint32_t guest_address, void* machine_code,
+                 const EmitFunctionInfo& func_info,
+                 GuestFunction* function_info, void* code_execute_address,
                  UnwindReservation unwind_reservation) override;
 
   void InitializeUnwindEntry(uint8_t* unwind_entry_address,
-                             size_t unwind_table_slot, void* code_address,
-                             size_t code_size, size_t stack_size);
-  */
+                             size_t unwind_table_slot,
+                             void* code_execute_address,
+                             const EmitFunctionInfo& func_info);
+
+  void WritePerfMapEntry(uint32_t guest_address, GuestFunction* function_info,
+                         void* code_execute_address, size_t code_size);
+
+  // Unwind table entries, sorted by the code address since the code is placed
+  // in order.
+  std::vector<X64UnwindEntry> unwind_table_;
+  // Registered .eh_frame section for each unwind table entry, for
+  // deregistration.
+  std::vector<void*> unwind_frames_;
+  // Current number of entries in the table.
+  std::atomic<uint32_t> unwind_table_count_ = {0};
+
+  FILE* perf_map_file_ = nullptr;
 };
 
 std::unique_ptr<X64CodeCache> X64CodeCache::Create() {
@@ -41,11 +102,206 @@ std::unique_ptr<X64CodeCache> X64CodeCache::Create() {
 }
 
 PosixX64CodeCache::PosixX64CodeCache() = default;
-PosixX64CodeCache::~PosixX64CodeCache() = default;
 
-bool PosixX64CodeCache::Initialize() { return X64CodeCache::Initialize(); }
+PosixX64CodeCache::~PosixX64CodeCache() {
+  uint32_t unwind_table_count = unwind_table_count_;
+  for (uint32_t i = 0; i < unwind_table_count; ++i) {
+    if (unwind_frames_[i]) {
+      __deregister_frame(unwind_frames_[i]);
+    }
+  }
+  if (perf_map_file_) {
+    std::fclose(perf_map_file_);
+  }
+}
+
+bool PosixX64CodeCache::Initialize() {
+  if (!X64CodeCache::Initialize()) {
+    return false;
+  }
+
+  // Compute total number of unwind entries we should allocate.
+  // We don't support reallocing right now, so this should be high.
+  unwind_table_.resize(kMaximumFunctionCount);
+  unwind_frames_.resize(kMaximumFunctionCount);
+
+  if (cvars::perf_map) {
+    std::string perf_map_path = fmt::format("/tmp/perf-{}.map", getpid());
+    perf_map_file_ = std::fopen(perf_map_path.c_str(), "w");
+    if (!perf_map_file_) {
+      XELOGE("Unable to open {} for writing the perf map", perf_map_path);
+    }
+  }
+
+  return true;
+}
+
+PosixX64CodeCache::UnwindReservation
+PosixX64CodeCache::RequestUnwindReservation(uint8_t* entry_address) {
+  assert_false(unwind_table_count_ >= kMaximumFunctionCount);
+  UnwindReservation unwind_reservation;
+  unwind_reservation.data_size = xe::round_up(kUnwindInfoSize, 16);
+  unwind_reservation.table_slot = unwind_table_count_++;
+  unwind_reservation.entry_address = entry_address;
+  return unwind_reservation;
+}
+
+void PosixX64CodeCache::PlaceCode(uint32_t guest_address, void* machine_code,
+                                  const EmitFunctionInfo& func_info,
+                                  GuestFunction* function_info,
+                                  void* code_execute_address,
+                                  UnwindReservation unwind_reservation) {
+  // Add unwind info.
+  InitializeUnwindEntry(unwind_reservation.entry_address,
+                        unwind_reservation.table_slot, code_execute_address,
+                        func_info);
+
+  // Called under the global lock, so the perf map lines are not interleaved.
+  if (perf_map_file_) {
+    WritePerfMapEntry(guest_address, function_info, code_execute_address,
+                      func_info.code_size.total);
+  }
+}
+
+void PosixX64CodeCache::InitializeUnwindEntry(
+    uint8_t* unwind_entry_address, size_t unwind_table_slot,
+    void* code_execute_address, const EmitFunctionInfo& func_info) {
+  uint8_t* p = unwind_entry_address;
+  auto write_u8 = [&p](uint8_t value) { *(p++) = value; };
+  auto write_u32 = [&p](uint32_t value) {
+    std::memcpy(p, &value, sizeof(value));
+    p += sizeof(value);
+  };
+  auto write_u64 = [&p](uint64_t value) {
+    std::memcpy(p, &value, sizeof(value));
+    p += sizeof(value);
+  };
+  auto write_uleb128 = [&p](uint64_t value) {
+    do {
+      uint8_t byte = uint8_t(value & 0x7F);
+      value >>= 7;
+      if (value) {
+        byte |= 0x80;
+      }
+      *(p++) = byte;
+    } while (value);
+  };
+  // Pads the record that started at the given address with DW_CFA_nop so that
+  // it ends on pointer size alignment, and writes its length.
+  auto end_record = [&p](uint8_t* record_start) {
+    while ((p - record_start) & 7) {
+      *(p++) = DW_CFA_nop;
+    }
+    uint32_t length = uint32_t(p - record_start - sizeof(uint32_t));
+    std::memcpy(record_start, &length, sizeof(length));
+  };
+
+  // CIE, identical for all generated functions, but repeated so that each
+  // section is self-contained: the CFA is rsp + 8 at the entry, with the return
+  // address right below it.
+  uint8_t* cie = p;
+  write_u32(0);  // Length, written later.
+  write_u32(0);  // CIE ID.
+  write_u8(1);   // Version.
+  write_u8('z');
+  write_u8('R');
+  write_u8('\0');
+  write_uleb128(1);  // Code alignment factor.
+  write_u8(0x78);    // Data alignment factor, SLEB128 -8.
+  write_u8(kDwarfRegReturnAddress);
+  write_uleb128(1);  // Augmentation data length.
+  write_u8(0x00);    // FDE pointer encoding - DW_EH_PE_absptr.
+  write_u8(DW_CFA_def_cfa);
+  write_uleb128(kDwarfRegRsp);
+  write_uleb128(8);
+  write_u8(DW_CFA_offset | kDwarfRegReturnAddress);
+  write_uleb128(1);
+  end_record(cie);
+
+  // FDE describing the stack allocation in the prolog.
+  uint8_t* fde = p;
+  write_u32(0);  // Length, written later.
+  write_u32(uint32_t(p - cie));  // Offset back to the CIE.
+  write_u64(reinterpret_cast<uint64_t>(code_execute_address));
+  write_u64(func_info.code_size.total);
+  write_uleb128(0);  // Augmentation data length.
+  if (func_info.stack_size) {
+    assert_true(func_info.prolog_stack_alloc_offset < 256);
+    if (func_info.prolog_stack_alloc_offset < 64) {
+      write_u8(DW_CFA_advance_loc |
+               uint8_t(func_info.prolog_stack_alloc_offset));
+    } else {
+      write_u8(DW_CFA_advance_loc1);
+      write_u8(uint8_t(func_info.prolog_stack_alloc_offset));
+    }
+    write_u8(DW_CFA_def_cfa_offset);
+    write_uleb128(func_info.stack_size + 8);
+  }
+  end_record(fde);
+
+  // Section terminator.
+  write_u32(0);
+  assert_true(size_t(p - unwind_entry_address) <= kUnwindInfoSize);
+
+#if XE_PLATFORM_ANDROID || XE_PLATFORM_MAC
+  // LLVM libunwind registers individual FDEs.
+  void* frame = fde;
+#else
+  // libgcc registers whole zero-terminated .eh_frame sections.
+  void* frame = cie;
+#endif
+  __register_frame(frame);
+  unwind_frames_[unwind_table_slot] = frame;
+
+  // Add entry.
+  auto& fn_entry = unwind_table_[unwind_table_slot];
+  fn_entry.code_begin = reinterpret_cast<uint64_t>(code_execute_address);
+  fn_entry.code_end = fn_entry.code_begin + func_info.code_size.total;
+  fn_entry.prolog_stack_alloc_offset =
+      uint32_t(func_info.prolog_stack_alloc_offset);
+  fn_entry.stack_size = uint32_t(func_info.stack_size);
+}
+
+void PosixX64CodeCache::WritePerfMapEntry(uint32_t guest_address,
+                                          GuestFunction* function_info,
+                                          void* code_execute_address,
+                                          size_t code_size) {
+  // https://github.com/torvalds/linux/blob/master/tools/perf/Documentation/jit-interface.txt
+  std::string name;
+  if (function_info && !function_info->name().empty()) {
+    name = fmt::format("{} [{:08X}]", function_info->name(), guest_address);
+  } else if (guest_address) {
+    name = fmt::format("sub_{:08X}", guest_address);
+  } else {
+    name = "xenia_host_code";
+  }
+  std::string line =
+      fmt::format("{:x} {:x} {}\n",
+                  reinterpret_cast<uintptr_t>(code_execute_address), code_size,
+                  name);
+  std::fwrite(line.data(), 1, line.size(), perf_map_file_);
+  // perf may read the map while we're still running (perf top).
+  std::fflush(perf_map_file_);
+}
+
+void* PosixX64CodeCache::LookupUnwindInfo(uint64_t host_pc) {
+  return std::bsearch(
+      &host_pc, unwind_table_.data(), unwind_table_count_,
+      sizeof(X64UnwindEntry),
+      [](const void* key_ptr, const void* element_ptr) {
+        auto key = *reinterpret_cast<const uint64_t*>(key_ptr);
+        auto element = reinterpret_cast<const X64UnwindEntry*>(element_ptr);
+        if (key < element->code_begin) {
+          return -1;
+        } else if (key >= element->code_end) {
+          return 1;
+        } else {
+          return 0;
+        }
+      });
+}
 
 }  // namespace x64
 }  // namespace backend
 }  // namespace cpu
-}  // namespace xe
\ No newline at end of file
+}  // namespace xe
@@ -107,7 +107,8 @@ class Win32X64CodeCache : public X64CodeCache {
  private:
   UnwindReservation RequestUnwindReservation(uint8_t* entry_address) override;
   void PlaceCode(uint32_t guest_address, void* machine_code,
-                 const EmitFunctionInfo& func_info, void* code_execute_address,
+                 const EmitFunctionInfo& func_info,
+                 GuestFunction* function_info, void* code_execute_address,
                  UnwindReservation unwind_reservation) override;
 
   void InitializeUnwindEntry(uint8_t* unwind_entry_address,
@@ -219,6 +220,7 @@ Win32X64CodeCache::RequestUnwindReservation(uint8_t* entry_address) {
 
 void Win32X64CodeCache::PlaceCode(uint32_t guest_address, void* machine_code,
                                   const EmitFunctionInfo& func_info,
+                                  GuestFunction* function_info,
                                   void* code_execute_address,
                                   UnwindReservation unwind_reservation) {
   // Add unwind info.
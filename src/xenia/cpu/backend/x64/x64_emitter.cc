@@ -29,6 +29,7 @@
 #include "xenia/cpu/backend/x64/x64_function.h"
 #include "xenia/cpu/backend/x64/x64_sequences.h"
 #include "xenia/cpu/backend/x64/x64_stack_layout.h"
+#include "xenia/cpu/backend/x64/x64_tracers.h"
 #include "xenia/cpu/cpu_flags.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/function_debug_info.h"
@@ -43,6 +44,10 @@ DEFINE_bool(ignore_undefined_externs, true,
 DEFINE_bool(emit_source_annotations, false,
             "Add extra movs and nops to make disassembly easier to read.",
             "CPU");
+DEFINE_bool(link_guest_calls, true,
+            "Patch direct calls between guest functions to jump to the callee "
+            "once it's compiled instead of through the indirection table.",
+            "CPU");
 
 namespace xe {
 namespace cpu {
@@ -116,6 +121,7 @@ bool X64Emitter::Emit(GuestFunction* function, HIRBuilder* builder,
   debug_info_flags_ = debug_info_flags;
   trace_data_ = &function->trace_data();
   source_map_arena_.Reset();
+  call_sites_.clear();
 
   // Fill the generator with code.
   EmitFunctionInfo func_info = {};
@@ -158,6 +164,22 @@ void* X64Emitter::Emplace(const EmitFunctionInfo& func_info,
   ready();
   top_ = old_address;
   reset();
+
+  // Link only after relocation, as ready() rewrites the call displacements.
+  if (function && code_cache_->has_indirection_table()) {
+    std::vector<X64CodeCache::CallSite> call_sites;
+    call_sites.reserve(call_sites_.size());
+    for (const CallSite& call_site : call_sites_) {
+      X64CodeCache::CallSite& placed_call_site = call_sites.emplace_back();
+      placed_call_site.end_offset = uint32_t(call_site.end_offset);
+      placed_call_site.stub_offset = uint32_t(call_site.stub_offset);
+      placed_call_site.target_address = call_site.target_address;
+    }
+    code_cache_->LinkGuestCode(function->address(), new_execute_address,
+                               call_sites);
+  }
+  call_sites_.clear();
+
   return new_execute_address;
 }
 
@@ -256,6 +278,9 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
       label = label->next;
     }
 
+    // The block may be entered from elsewhere with different flags.
+    flags_source_ = nullptr;
+
     // Process instructions.
     const Instr* instr = block->instr_head;
     while (instr) {
@@ -268,6 +293,9 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
         XELOGE("Unable to process HIR opcode {}", instr->opcode->name);
         break;
       }
+      if (flags_source_ != instr && !PreservesFlags(instr)) {
+        flags_source_ = nullptr;
+      }
       instr = new_tail;
     }
 
@@ -287,6 +315,8 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
 
   code_offsets.tail = getSize();
 
+  EmitCallSiteStubs();
+
   if (cvars::emit_source_annotations) {
     nop();
     nop();
@@ -307,6 +337,49 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
   return true;
 }
 
+bool X64Emitter::PreservesFlags(const hir::Instr* instr) const {
+  // Only opcodes whose sequences are known to consist of moves.
+  switch (instr->opcode->num) {
+    case hir::OPCODE_ASSIGN:
+    case hir::OPCODE_LOAD_LOCAL:
+    case hir::OPCODE_STORE_LOCAL:
+    case hir::OPCODE_ZERO_EXTEND:
+    case hir::OPCODE_TRUNCATE:
+    case hir::OPCODE_NOT:
+      return true;
+    case hir::OPCODE_LOAD_CONTEXT:
+    case hir::OPCODE_STORE_CONTEXT:
+      return !IsTracingData();
+    case hir::OPCODE_ADD_CARRY:
+      return IsAddCarryFlagless(instr);
+    case hir::OPCODE_SOURCE_OFFSET:
+      return !(debug_info_flags_ &
+               DebugInfoFlags::kDebugInfoTraceFunctionCoverage);
+    default:
+      return false;
+  }
+}
+
+bool X64Emitter::AreFlagsFromCompareOf(const hir::Value* src1,
+                                       const hir::Value* src2) const {
+  return flags_source_ && flags_source_->opcode->num != hir::OPCODE_DID_CARRY &&
+         flags_source_->src1.value == src1 &&
+         flags_source_->src2.value == src2;
+}
+
+bool X64Emitter::IsCarryFlagOf(const hir::Value* value) const {
+  return flags_source_ && flags_source_->opcode->num == hir::OPCODE_DID_CARRY &&
+         flags_source_->dest == value;
+}
+
+bool X64Emitter::IsAddCarryFlagless(const hir::Instr* instr) const {
+  assert_true(instr->opcode->num == hir::OPCODE_ADD_CARRY);
+  return (instr->dest->type == hir::INT32_TYPE ||
+          instr->dest->type == hir::INT64_TYPE) &&
+         !instr->src3.value->IsConstant() &&
+         !IsCarryFlagOf(instr->src3.value);
+}
+
 void X64Emitter::MarkSourceOffset(const Instr* i) {
   auto entry = source_map_arena_.Alloc<SourceMapEntry>();
   entry->guest_address = static_cast<uint32_t>(i->src1.offset);
@@ -414,6 +487,31 @@ uint64_t ResolveFunction(void* raw_context, uint64_t target_address) {
 void X64Emitter::Call(const hir::Instr* instr, GuestFunction* function) {
   assert_not_null(function);
   auto fn = static_cast<X64Function*>(function);
+  bool is_tail = (instr->flags & hir::CALL_TAIL) != 0;
+  if (cvars::link_guest_calls && code_cache_->has_indirection_table()) {
+    // Jump to a stub loading the target from the indirection table, which the
+    // code cache redirects to the function itself once it's compiled.
+    CallSite& call_site = call_sites_.emplace_back();
+    call_site.target_address = function->address();
+    if (is_tail) {
+      EmitTraceUserCallReturn();
+      mov(rcx, qword[rsp + StackLayout::GUEST_RET_ADDR]);
+      add(rsp, static_cast<uint32_t>(stack_size()));
+    } else {
+      mov(rcx, qword[rsp + StackLayout::GUEST_CALL_RET_ADDR]);
+    }
+    // Align the rel32 so it can be patched atomically.
+    nop((4 - (getSize() + 1) % 4) % 4);
+    if (is_tail) {
+      jmp(call_site.stub_label, CodeGenerator::T_NEAR);
+    } else {
+      call(call_site.stub_label);
+    }
+    call_site.end_offset = getSize();
+    assert_zero(call_site.end_offset % 4);
+    return;
+  }
+
   // Resolve address to the function to call and store in rax.
   if (fn->machine_code()) {
     // TODO(benvanik): is it worth it to do this? It removes the need for
@@ -429,12 +527,11 @@ void X64Emitter::Call(const hir::Instr* instr, GuestFunction* function) {
   } else {
     // Old-style resolve.
     // Not too important because indirection table is almost always available.
-    // TODO: Overwrite the call-site with a straight call.
     CallNative(&ResolveFunction, function->address());
   }
 
   // Actually jump/call to rax.
-  if (instr->flags & hir::CALL_TAIL) {
+  if (is_tail) {
     // Since we skip the prolog we need to mark the return here.
     EmitTraceUserCallReturn();
 
@@ -451,6 +548,19 @@ void X64Emitter::Call(const hir::Instr* instr, GuestFunction* function) {
   }
 }
 
+void X64Emitter::EmitCallSiteStubs() {
+  for (CallSite& call_site : call_sites_) {
+    // Entered with the return address of the call site on the stack, or
+    // without a frame for a tail call, so this must not touch the stack.
+    L(call_site.stub_label);
+    call_site.stub_offset = getSize();
+    // The resolve thunk takes the target address in ebx.
+    mov(ebx, call_site.target_address);
+    mov(eax, dword[ebx]);
+    jmp(rax);
+  }
+}
+
 void X64Emitter::CallIndirect(const hir::Instr* instr,
                               const Xbyak::Reg64& reg) {
   // Check if return.
@@ -762,6 +872,7 @@ static const vec128_t xmm_consts[] = {
     /* XMMQNaN                */ vec128i(0x7FC00000u),
     /* XMMInt127              */ vec128i(0x7Fu),
     /* XMM2To32               */ vec128f(0x1.0p32f),
+    /* XMMThreeFloatMask      */ vec128i(~0u, ~0u, ~0u, 0u),
 };
 
 // First location to try and place constants.
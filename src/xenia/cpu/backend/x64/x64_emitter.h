@@ -10,6 +10,7 @@
 #ifndef XENIA_CPU_BACKEND_X64_X64_EMITTER_H_
 #define XENIA_CPU_BACKEND_X64_X64_EMITTER_H_
 
+#include <list>
 #include <vector>
 
 #include "xenia/base/arena.h"
@@ -116,6 +117,7 @@ enum XmmConst {
   XMMQNaN,
   XMMInt127,
   XMM2To32,
+  XMMThreeFloatMask,
 };
 
 // Unfortunately due to the design of xbyak we have to pass this to the ctor.
@@ -241,12 +243,32 @@ class X64Emitter : public Xbyak::CodeGenerator {
 
   size_t stack_size() const { return stack_size_; }
 
+  // Integer comparison instruction whose result is currently in the host
+  // flags. Comparison sequences set it, and it's reset whenever an instruction
+  // that may modify the flags is emitted. While it's valid, other comparisons
+  // of the same operands (like the lt, gt and eq bits of a PPC condition
+  // register field update) and conditional branches on their results can use
+  // the flags directly instead of redoing the cmp or testing the result.
+  // DID_CARRY also sets it, leaving its result in CF for the next link of an
+  // add with carry chain.
+  const hir::Instr* flags_source() const { return flags_source_; }
+  void set_flags_source(const hir::Instr* instr) { flags_source_ = instr; }
+  bool AreFlagsFromCompareOf(const hir::Value* src1,
+                             const hir::Value* src2) const;
+  bool IsCarryFlagOf(const hir::Value* value) const;
+  // Whether an ADD_CARRY is emitted with lea, preserving the flags, because its
+  // carry in is not in CF (usually because the DID_CARRY of the same link of a
+  // chain has already replaced it with the carry out).
+  bool IsAddCarryFlagless(const hir::Instr* instr) const;
+
  protected:
   void* Emplace(const EmitFunctionInfo& func_info,
                 GuestFunction* function = nullptr);
   bool Emit(hir::HIRBuilder* builder, EmitFunctionInfo& func_info);
   void EmitGetCurrentThreadId();
   void EmitTraceUserCallReturn();
+  void EmitCallSiteStubs();
+  bool PreservesFlags(const hir::Instr* instr) const;
 
  protected:
   Processor* processor_ = nullptr;
@@ -260,6 +282,8 @@ class X64Emitter : public Xbyak::CodeGenerator {
 
   hir::Instr* current_instr_ = nullptr;
 
+  const hir::Instr* flags_source_ = nullptr;
+
   FunctionDebugInfo* debug_info_ = nullptr;
   uint32_t debug_info_flags_ = 0;
   FunctionTraceData* trace_data_ = nullptr;
@@ -267,6 +291,15 @@ class X64Emitter : public Xbyak::CodeGenerator {
 
   size_t stack_size_ = 0;
 
+  // Calls to other guest functions to be linked by the code cache.
+  struct CallSite {
+    Xbyak::Label stub_label;
+    size_t end_offset;
+    size_t stub_offset;
+    uint32_t target_address;
+  };
+  std::list<CallSite> call_sites_;
+
   static const uint32_t gpr_reg_map_[GPR_COUNT];
   static const uint32_t xmm_reg_map_[XMM_COUNT];
 };
@@ -444,12 +444,151 @@ struct BRANCH : Sequence<BRANCH, I<OPCODE_BRANCH, VoidOp, LabelOp>> {
 };
 EMITTER_OPCODE_TABLE(OPCODE_BRANCH, BRANCH);
 
+// If the condition is the result of an integer comparison of the values still
+// compared in the host flags, emits a conditional jump using the flags
+// directly rather than testing the result of the comparison.
+static bool EmitBranchOnCompareFlags(X64Emitter& e, const Value* condition,
+                                     bool branch_if_true, const char* label) {
+  const Instr* compare = condition->def;
+  if (!compare) {
+    return false;
+  }
+  Opcode opcode = compare->opcode->num;
+  switch (opcode) {
+    case OPCODE_COMPARE_EQ:
+    case OPCODE_COMPARE_NE:
+    case OPCODE_COMPARE_SLT:
+    case OPCODE_COMPARE_SLE:
+    case OPCODE_COMPARE_SGT:
+    case OPCODE_COMPARE_SGE:
+    case OPCODE_COMPARE_ULT:
+    case OPCODE_COMPARE_ULE:
+    case OPCODE_COMPARE_UGT:
+    case OPCODE_COMPARE_UGE:
+      break;
+    default:
+      return false;
+  }
+  if (!e.AreFlagsFromCompareOf(compare->src1.value, compare->src2.value)) {
+    return false;
+  }
+  // The operands were swapped in the cmp if the first is constant.
+  if (compare->src1.value->IsConstant()) {
+    switch (opcode) {
+      case OPCODE_COMPARE_SLT:
+        opcode = OPCODE_COMPARE_SGT;
+        break;
+      case OPCODE_COMPARE_SLE:
+        opcode = OPCODE_COMPARE_SGE;
+        break;
+      case OPCODE_COMPARE_SGT:
+        opcode = OPCODE_COMPARE_SLT;
+        break;
+      case OPCODE_COMPARE_SGE:
+        opcode = OPCODE_COMPARE_SLE;
+        break;
+      case OPCODE_COMPARE_ULT:
+        opcode = OPCODE_COMPARE_UGT;
+        break;
+      case OPCODE_COMPARE_ULE:
+        opcode = OPCODE_COMPARE_UGE;
+        break;
+      case OPCODE_COMPARE_UGT:
+        opcode = OPCODE_COMPARE_ULT;
+        break;
+      case OPCODE_COMPARE_UGE:
+        opcode = OPCODE_COMPARE_ULE;
+        break;
+      default:
+        break;
+    }
+  }
+  switch (opcode) {
+    case OPCODE_COMPARE_EQ:
+      if (branch_if_true) {
+        e.je(label, e.T_NEAR);
+      } else {
+        e.jne(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_NE:
+      if (branch_if_true) {
+        e.jne(label, e.T_NEAR);
+      } else {
+        e.je(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_SLT:
+      if (branch_if_true) {
+        e.jl(label, e.T_NEAR);
+      } else {
+        e.jge(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_SLE:
+      if (branch_if_true) {
+        e.jle(label, e.T_NEAR);
+      } else {
+        e.jg(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_SGT:
+      if (branch_if_true) {
+        e.jg(label, e.T_NEAR);
+      } else {
+        e.jle(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_SGE:
+      if (branch_if_true) {
+        e.jge(label, e.T_NEAR);
+      } else {
+        e.jl(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_ULT:
+      if (branch_if_true) {
+        e.jb(label, e.T_NEAR);
+      } else {
+        e.jae(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_ULE:
+      if (branch_if_true) {
+        e.jbe(label, e.T_NEAR);
+      } else {
+        e.ja(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_UGT:
+      if (branch_if_true) {
+        e.ja(label, e.T_NEAR);
+      } else {
+        e.jbe(label, e.T_NEAR);
+      }
+      return true;
+    case OPCODE_COMPARE_UGE:
+      if (branch_if_true) {
+        e.jae(label, e.T_NEAR);
+      } else {
+        e.jb(label, e.T_NEAR);
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
 // ============================================================================
 // OPCODE_BRANCH_TRUE
 // ============================================================================
 struct BRANCH_TRUE_I8
     : Sequence<BRANCH_TRUE_I8, I<OPCODE_BRANCH_TRUE, VoidOp, I8Op, LabelOp>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
+    if (EmitBranchOnCompareFlags(e, i.src1.value, true,
+                                 i.src2.value->name)) {
+      return;
+    }
     e.test(i.src1, i.src1);
     e.jnz(i.src2.value->name, e.T_NEAR);
   }
@@ -499,6 +638,10 @@ EMITTER_OPCODE_TABLE(OPCODE_BRANCH_TRUE, BRANCH_TRUE_I8, BRANCH_TRUE_I16,
 struct BRANCH_FALSE_I8
     : Sequence<BRANCH_FALSE_I8, I<OPCODE_BRANCH_FALSE, VoidOp, I8Op, LabelOp>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
+    if (EmitBranchOnCompareFlags(e, i.src1.value, false,
+                                 i.src2.value->name)) {
+      return;
+    }
     e.test(i.src1, i.src1);
     e.jz(i.src2.value->name, e.T_NEAR);
   }
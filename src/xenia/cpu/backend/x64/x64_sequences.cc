@@ -25,6 +25,7 @@
 #include "xenia/cpu/backend/x64/x64_sequences.h"
 
 #include <algorithm>
+#include <array>
 #include <unordered_map>
 
 #include "xenia/base/assert.h"
@@ -34,6 +35,7 @@
 #include "xenia/base/threading.h"
 #include "xenia/cpu/backend/x64/x64_emitter.h"
 #include "xenia/cpu/backend/x64/x64_op.h"
+#include "xenia/cpu/backend/x64/x64_stack_layout.h"
 #include "xenia/cpu/backend/x64/x64_tracers.h"
 #include "xenia/cpu/backend/x64/x64_util.h"
 #include "xenia/cpu/hir/hir_builder.h"
@@ -921,57 +923,69 @@ EMITTER_OPCODE_TABLE(OPCODE_IS_NAN, IS_NAN_F32, IS_NAN_F64);
 struct COMPARE_EQ_I8
     : Sequence<COMPARE_EQ_I8, I<OPCODE_COMPARE_EQ, I8Op, I8Op, I8Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg8& src1, const Reg8& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg8& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg8& src1, const Reg8& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg8& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.sete(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_EQ_I16
     : Sequence<COMPARE_EQ_I16, I<OPCODE_COMPARE_EQ, I8Op, I16Op, I16Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg16& src1, const Reg16& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg16& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg16& src1, const Reg16& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg16& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.sete(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_EQ_I32
     : Sequence<COMPARE_EQ_I32, I<OPCODE_COMPARE_EQ, I8Op, I32Op, I32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg32& src1, const Reg32& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg32& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg32& src1, const Reg32& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg32& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.sete(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_EQ_I64
     : Sequence<COMPARE_EQ_I64, I<OPCODE_COMPARE_EQ, I8Op, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg64& src1, const Reg64& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg64& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg64& src1, const Reg64& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg64& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.sete(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_EQ_F32
@@ -1004,57 +1018,69 @@ EMITTER_OPCODE_TABLE(OPCODE_COMPARE_EQ, COMPARE_EQ_I8, COMPARE_EQ_I16,
 struct COMPARE_NE_I8
     : Sequence<COMPARE_NE_I8, I<OPCODE_COMPARE_NE, I8Op, I8Op, I8Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg8& src1, const Reg8& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg8& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg8& src1, const Reg8& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg8& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.setne(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_NE_I16
     : Sequence<COMPARE_NE_I16, I<OPCODE_COMPARE_NE, I8Op, I16Op, I16Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg16& src1, const Reg16& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg16& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg16& src1, const Reg16& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg16& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.setne(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_NE_I32
     : Sequence<COMPARE_NE_I32, I<OPCODE_COMPARE_NE, I8Op, I32Op, I32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg32& src1, const Reg32& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg32& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg32& src1, const Reg32& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg32& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.setne(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_NE_I64
     : Sequence<COMPARE_NE_I64, I<OPCODE_COMPARE_NE, I8Op, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitCommutativeCompareOp(
-        e, i,
-        [](X64Emitter& e, const Reg64& src1, const Reg64& src2) {
-          e.cmp(src1, src2);
-        },
-        [](X64Emitter& e, const Reg64& src1, int32_t constant) {
-          e.cmp(src1, constant);
-        });
+    if (!e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {
+      EmitCommutativeCompareOp(
+          e, i,
+          [](X64Emitter& e, const Reg64& src1, const Reg64& src2) {
+            e.cmp(src1, src2);
+          },
+          [](X64Emitter& e, const Reg64& src1, int32_t constant) {
+            e.cmp(src1, constant);
+          });
+    }
     e.setne(i.dest);
+    e.set_flags_source(i.instr);
   }
 };
 struct COMPARE_NE_F32
@@ -1084,6 +1110,17 @@ EMITTER_OPCODE_TABLE(OPCODE_COMPARE_NE, COMPARE_NE_I8, COMPARE_NE_I16,
       : Sequence<COMPARE_##op##_##type,                                 \
                  I<OPCODE_COMPARE_##op, I8Op, type, type>> {            \
     static void Emit(X64Emitter& e, const EmitArgType& i) {             \
+      if (e.AreFlagsFromCompareOf(i.src1.value, i.src2.value)) {        \
+        /* The operands were swapped in the cmp if the first is */      \
+        /* constant. */                                                 \
+        if (!i.src1.is_constant) {                                      \
+          e.instr(i.dest);                                              \
+        } else {                                                        \
+          e.inverse_instr(i.dest);                                      \
+        }                                                               \
+        e.set_flags_source(i.instr);                                    \
+        return;                                                         \
+      }                                                                 \
       EmitAssociativeCompareOp(                                         \
           e, i,                                                         \
           [](X64Emitter& e, const Reg8& dest, const reg_type& src1,     \
@@ -1104,6 +1141,7 @@ EMITTER_OPCODE_TABLE(OPCODE_COMPARE_NE, COMPARE_NE_I8, COMPARE_NE_I16,
               e.inverse_instr(dest);                                    \
             }                                                           \
           });                                                           \
+      e.set_flags_source(i.instr);                                      \
     }                                                                   \
   };
 #define EMITTER_ASSOCIATIVE_COMPARE_XX(op, instr, inverse_instr)           \
@@ -1241,23 +1279,15 @@ EMITTER_OPCODE_TABLE(OPCODE_ADD, ADD_I8, ADD_I16, ADD_I32, ADD_I64, ADD_F32,
 // TODO(benvanik): put dest/src1|2 together.
 template <typename SEQ, typename REG, typename ARGS>
 void EmitAddCarryXX(X64Emitter& e, const ARGS& i) {
-  // TODO(benvanik): faster setting? we could probably do some fun math tricks
-  // here to get the carry flag set.
   if (i.src3.is_constant) {
     if (i.src3.constant()) {
       e.stc();
     } else {
       e.clc();
     }
-  } else {
-    if (i.src3.reg().getIdx() <= 4) {
-      // Can move from A/B/C/DX to AH.
-      e.mov(e.ah, i.src3.reg().cvt8());
-    } else {
-      e.mov(e.al, i.src3);
-      e.mov(e.ah, e.al);
-    }
-    e.sahf();
+  } else if (!e.IsCarryFlagOf(i.src3.value)) {
+    // Bit 0 of the carry byte to CF (the upper bits are zero anyway).
+    e.bt(i.src3.reg().cvt32(), 0);
   }
   SEQ::EmitCommutativeBinaryOp(
       e, i,
@@ -1280,21 +1310,129 @@ struct ADD_CARRY_I16
     EmitAddCarryXX<ADD_CARRY_I16, Reg16>(e, i);
   }
 };
+// If the carry in is not in CF, the sum is calculated with lea instead of
+// loading the carry in to CF for an adc, so the flags are preserved. This is
+// the case for PPC add with carry chains, where the carry out of each link is
+// calculated by a DID_CARRY before the sum, and it must stay in CF for the
+// next link.
+template <typename ARGS>
+void EmitAddCarryFlagless(X64Emitter& e, const ARGS& i) {
+  // The operands are added at 64 bits, and for 32-bit results, the upper bits
+  // are dropped by the lea.
+  e.movzx(e.eax, i.src3.reg());
+  if (i.src1.is_constant && i.src2.is_constant) {
+    e.mov(e.rcx, uint64_t(i.src1.constant()) + uint64_t(i.src2.constant()));
+    e.lea(i.dest, e.ptr[e.rax + e.rcx]);
+    return;
+  }
+  const auto& augend = i.src1.is_constant ? i.src2 : i.src1;
+  const auto& addend = i.src1.is_constant ? i.src1 : i.src2;
+  Reg64 augend_reg = augend.reg().cvt64();
+  if (!addend.is_constant) {
+    e.lea(e.rax, e.ptr[e.rax + augend_reg]);
+    e.lea(i.dest, e.ptr[e.rax + addend.reg().cvt64()]);
+  } else if (addend.ConstantFitsIn32Reg()) {
+    e.lea(i.dest,
+          e.ptr[e.rax + augend_reg + static_cast<int32_t>(addend.constant())]);
+  } else {
+    e.mov(e.rcx, addend.constant());
+    e.lea(e.rax, e.ptr[e.rax + augend_reg]);
+    e.lea(i.dest, e.ptr[e.rax + e.rcx]);
+  }
+}
 struct ADD_CARRY_I32
     : Sequence<ADD_CARRY_I32, I<OPCODE_ADD_CARRY, I32Op, I32Op, I32Op, I8Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitAddCarryXX<ADD_CARRY_I32, Reg32>(e, i);
+    if (e.IsAddCarryFlagless(i.instr)) {
+      EmitAddCarryFlagless(e, i);
+    } else {
+      EmitAddCarryXX<ADD_CARRY_I32, Reg32>(e, i);
+    }
   }
 };
 struct ADD_CARRY_I64
     : Sequence<ADD_CARRY_I64, I<OPCODE_ADD_CARRY, I64Op, I64Op, I64Op, I8Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    EmitAddCarryXX<ADD_CARRY_I64, Reg64>(e, i);
+    if (e.IsAddCarryFlagless(i.instr)) {
+      EmitAddCarryFlagless(e, i);
+    } else {
+      EmitAddCarryXX<ADD_CARRY_I64, Reg64>(e, i);
+    }
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_ADD_CARRY, ADD_CARRY_I8, ADD_CARRY_I16,
                      ADD_CARRY_I32, ADD_CARRY_I64);
 
+// ============================================================================
+// OPCODE_DID_CARRY
+// ============================================================================
+// The carry is produced in CF by an adc, and it's kept there for the next link
+// of an add with carry chain (ADD_CARRY or DID_CARRY taking it as the carry
+// in), which then doesn't need to reload it from the materialized byte.
+template <typename SEQ, typename REG, typename ARGS>
+void EmitDidCarryXX(X64Emitter& e, const ARGS& i) {
+  REG sum(e.rax.getIdx());
+  REG addend_reg(e.rcx.getIdx());
+  // Moves don't modify the flags, so the operands are loaded before the carry
+  // in is set up.
+  const auto& augend = i.src1.is_constant ? i.src2 : i.src1;
+  const auto& addend = i.src1.is_constant ? i.src1 : i.src2;
+  if (augend.is_constant) {
+    e.mov(sum, augend.constant());
+  } else {
+    e.mov(sum, augend);
+  }
+  bool addend_is_immediate =
+      addend.is_constant && addend.ConstantFitsIn32Reg();
+  if (addend.is_constant && !addend_is_immediate) {
+    e.mov(addend_reg, addend.constant());
+  }
+  if (i.src3.is_constant) {
+    if (i.src3.constant()) {
+      e.stc();
+    } else {
+      e.clc();
+    }
+  } else if (!e.IsCarryFlagOf(i.src3.value)) {
+    e.bt(i.src3.reg().cvt32(), 0);
+  }
+  if (addend_is_immediate) {
+    e.adc(sum, static_cast<int32_t>(addend.constant()));
+  } else if (addend.is_constant) {
+    e.adc(sum, addend_reg);
+  } else {
+    e.adc(sum, addend);
+  }
+  e.setc(i.dest);
+  e.set_flags_source(i.instr);
+}
+struct DID_CARRY_I8
+    : Sequence<DID_CARRY_I8, I<OPCODE_DID_CARRY, I8Op, I8Op, I8Op, I8Op>> {
+  static void Emit(X64Emitter& e, const EmitArgType& i) {
+    EmitDidCarryXX<DID_CARRY_I8, Reg8>(e, i);
+  }
+};
+struct DID_CARRY_I16
+    : Sequence<DID_CARRY_I16, I<OPCODE_DID_CARRY, I8Op, I16Op, I16Op, I8Op>> {
+  static void Emit(X64Emitter& e, const EmitArgType& i) {
+    EmitDidCarryXX<DID_CARRY_I16, Reg16>(e, i);
+  }
+};
+struct DID_CARRY_I32
+    : Sequence<DID_CARRY_I32, I<OPCODE_DID_CARRY, I8Op, I32Op, I32Op, I8Op>> {
+  static void Emit(X64Emitter& e, const EmitArgType& i) {
+    EmitDidCarryXX<DID_CARRY_I32, Reg32>(e, i);
+  }
+};
+struct DID_CARRY_I64
+    : Sequence<DID_CARRY_I64, I<OPCODE_DID_CARRY, I8Op, I64Op, I64Op, I8Op>> {
+  static void Emit(X64Emitter& e, const EmitArgType& i) {
+    EmitDidCarryXX<DID_CARRY_I64, Reg64>(e, i);
+  }
+};
+EMITTER_OPCODE_TABLE(OPCODE_DID_CARRY, DID_CARRY_I8, DID_CARRY_I16,
+                     DID_CARRY_I32, DID_CARRY_I64);
+
 // ============================================================================
 // OPCODE_SUB
 // ============================================================================
@@ -2573,44 +2711,91 @@ struct LOG2_V128 : Sequence<LOG2_V128, I<OPCODE_LOG2, V128Op, V128Op>> {
 EMITTER_OPCODE_TABLE(OPCODE_LOG2, LOG2_F32, LOG2_F64, LOG2_V128);
 
 struct DOT_PRODUCT_V128 {
-  static void Emit(X64Emitter& e, Xmm dest, Xmm src1, Xmm src2, uint8_t imm) {
-    // TODO(benvanik): apparently this is very slow
-    // - find alternative?
-    Xbyak::Label end;
-    e.inLocalLabel();
-
-    // Grab space to put MXCSR.
-    // TODO(gibbed): stick this in TLS or
-    // something?
-    e.sub(e.rsp, 8);
-
-    // Grab MXCSR and mask off the overflow flag,
-    // because it's sticky.
-    e.vstmxcsr(e.dword[e.rsp]);
-    e.mov(e.eax, e.dword[e.rsp]);
-    e.and_(e.eax, uint32_t(~8));
-    e.mov(e.dword[e.rsp], e.eax);
-    e.vldmxcsr(e.dword[e.rsp]);
-
-    // Hey we can do the dot product now.
-    e.vdpps(dest, src1, src2, imm);
-
-    // Load MXCSR...
-    e.vstmxcsr(e.dword[e.rsp]);
-
-    // ..free our temporary space and get MXCSR at
-    // the same time
-    e.pop(e.rax);
-
-    // Did we overflow?
-    e.test(e.al, 8);
-    e.jz(end);
-
-    // Infinity? HA! Give NAN.
-    e.vmovdqa(dest, e.GetXmmConstPtr(XMMQNaN));
-
+  // Computes the dot product in lane 0 without writing MXCSR (dpps would
+  // require clearing and checking the sticky overflow flag around it). The
+  // summation order is the same as in dpps, (x + y) + (z + w), so the result
+  // is bit-exact.
+  //
+  // Under round-to-nearest, an overflow in any step makes the result infinite
+  // or NaN, so only those rare results need to be checked for it in the slow
+  // path. Under the other rounding modes (VMX shares MXCSR with the FPU, so
+  // the mode set by the guest for scalar code applies here too), an overflow
+  // may round to the largest finite value instead. Then the flag is the only
+  // way to detect it, so everything goes to the slow path.
+  static void Emit(X64Emitter& e, Xmm dest, Xmm src1, Xmm src2,
+                   bool four_lanes) {
+    // xmm0 may contain a constant source.
+    Xbyak::Label slow, end;
+    auto mxcsr = e.dword[e.rsp + StackLayout::GUEST_SCRATCH];
+    e.vstmxcsr(mxcsr);
+    e.test(mxcsr, uint32_t(0x6000));
+    e.jnz(slow, CodeGenerator::T_NEAR);
+
+    e.vmulps(e.xmm1, src1, src2);
+    if (!four_lanes) {
+      e.vandps(e.xmm1, e.xmm1, e.GetXmmConstPtr(XMMThreeFloatMask));
+    }
+    // xmm1 = [x + y, ?, z + w, ?].
+    e.vmovshdup(e.xmm2, e.xmm1);
+    e.vaddps(e.xmm1, e.xmm1, e.xmm2);
+    e.vmovhlps(e.xmm2, e.xmm2, e.xmm1);
+    e.vaddss(e.xmm1, e.xmm1, e.xmm2);
+
+    // All exponent bits set - infinity or NaN.
+    e.vmovd(e.eax, e.xmm1);
+    e.not_(e.eax);
+    e.test(e.eax, 0x7F800000);
+    e.jnz(end, CodeGenerator::T_NEAR);
+
+    e.L(slow);
+    e.lea(e.GetNativeParam(1), e.StashXmm(1, src2));
+    e.lea(e.GetNativeParam(0), e.StashXmm(0, src1));
+    e.CallNativeSafe(reinterpret_cast<void*>(
+        four_lanes ? EmulateChecked<true> : EmulateChecked<false>));
+    e.vmovaps(e.xmm1, e.xmm0);
     e.L(end);
-    e.outLocalLabel();
+    e.vmovaps(dest, e.xmm1);
+  }
+
+  // Repeats the steps of dpps with the overflow flag cleared, returning QNaN
+  // if it has been raised, as the guest expects. MXCSR, including the flags
+  // raised before, is restored afterwards.
+  template <bool kFourLanes>
+  static __m128 EmulateChecked(void*, __m128 src1, __m128 src2) {
+    // The operands and the result go through volatile memory, so the compiler
+    // can't move the arithmetic across the MXCSR accesses.
+    alignas(16) float values1[4];
+    alignas(16) float values2[4];
+    _mm_store_ps(values1, src1);
+    _mm_store_ps(values2, src2);
+    volatile float operands1[4];
+    volatile float operands2[4];
+    for (size_t n = 0; n < 4; ++n) {
+      operands1[n] = values1[n];
+      operands2[n] = values2[n];
+    }
+    uint32_t mxcsr = _mm_getcsr();
+    _mm_setcsr(mxcsr & ~uint32_t(_MM_EXCEPT_OVERFLOW));
+    __m128 products[4];
+    for (size_t n = 0; n < 4; ++n) {
+      if (n == 3 && !kFourLanes) {
+        products[n] = _mm_setzero_ps();
+        continue;
+      }
+      products[n] =
+          _mm_mul_ss(_mm_set_ss(operands1[n]), _mm_set_ss(operands2[n]));
+    }
+    // With NaNs in multiple lanes, dpps returns the one in the higher lane, so
+    // it's the first operand of each addition.
+    volatile float result =
+        _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(products[1], products[0]),
+                                 _mm_add_ss(products[3], products[2])));
+    bool overflow = (_mm_getcsr() & _MM_EXCEPT_OVERFLOW) != 0;
+    _mm_setcsr(mxcsr);
+    if (overflow) {
+      return _mm_castsi128_ps(_mm_set1_epi32(0x7FC00000));
+    }
+    return _mm_set_ss(result);
   }
 };
 
@@ -2624,7 +2809,7 @@ struct DOT_PRODUCT_3_V128
     // https://msdn.microsoft.com/en-us/library/bb514054(v=vs.90).aspx
     EmitCommutativeBinaryXmmOp(
         e, i, [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-          DOT_PRODUCT_V128::Emit(e, dest, src1, src2, 0b01110001);
+          DOT_PRODUCT_V128::Emit(e, dest, src1, src2, false);
         });
   }
 };
@@ -2640,7 +2825,7 @@ struct DOT_PRODUCT_4_V128
     // https://msdn.microsoft.com/en-us/library/bb514054(v=vs.90).aspx
     EmitCommutativeBinaryXmmOp(
         e, i, [](X64Emitter& e, Xmm dest, Xmm src1, Xmm src2) {
-          DOT_PRODUCT_V128::Emit(e, dest, src1, src2, 0b11110001);
+          DOT_PRODUCT_V128::Emit(e, dest, src1, src2, true);
         });
   }
 };
@@ -3327,6 +3512,70 @@ struct SET_ROUNDING_MODE_I32
 };
 EMITTER_OPCODE_TABLE(OPCODE_SET_ROUNDING_MODE, SET_ROUNDING_MODE_I32);
 
+// ============================================================================
+// OPCODE_LOAD_FP_EXCEPTIONS
+// ============================================================================
+// Output: FPSCR exception bits (PPC format) raised since the last load,
+// without FX, which depends on the previous FPSCR value.
+static const auto fp_exceptions_table = [] {
+  std::array<uint32_t, 64> table = {};
+  for (uint32_t mxcsr = 0; mxcsr < 64; ++mxcsr) {
+    uint32_t fpscr = 0;
+    if (mxcsr & 0x01) {
+      // Invalid operation - VX.
+      fpscr |= 1u << 29;
+    }
+    if (mxcsr & 0x04) {
+      // Divide by zero - ZX.
+      fpscr |= 1u << 26;
+    }
+    if (mxcsr & 0x08) {
+      // Overflow - OX.
+      fpscr |= 1u << 28;
+    }
+    if (mxcsr & 0x10) {
+      // Underflow - UX.
+      fpscr |= 1u << 27;
+    }
+    if (mxcsr & 0x20) {
+      // Precision - XX.
+      fpscr |= 1u << 25;
+    }
+    table[mxcsr] = fpscr;
+  }
+  return table;
+}();
+struct LOAD_FP_EXCEPTIONS
+    : Sequence<LOAD_FP_EXCEPTIONS, I<OPCODE_LOAD_FP_EXCEPTIONS, I32Op>> {
+  static void Emit(X64Emitter& e, const EmitArgType& i) {
+    // Read and clear the sticky exception flags.
+    auto mxcsr = e.dword[e.rsp + StackLayout::GUEST_SCRATCH];
+    e.vstmxcsr(mxcsr);
+    e.mov(e.eax, mxcsr);
+    e.and_(mxcsr, ~uint32_t(0x3F));
+    e.vldmxcsr(mxcsr);
+    e.and_(e.eax, 0x3F);
+    e.mov(e.rcx, uintptr_t(fp_exceptions_table.data()));
+    e.mov(i.dest, e.dword[e.rcx + e.rax * 4]);
+  }
+};
+EMITTER_OPCODE_TABLE(OPCODE_LOAD_FP_EXCEPTIONS, LOAD_FP_EXCEPTIONS);
+
+// ============================================================================
+// OPCODE_CLEAR_FP_EXCEPTIONS
+// ============================================================================
+struct CLEAR_FP_EXCEPTIONS
+    : Sequence<CLEAR_FP_EXCEPTIONS, I<OPCODE_CLEAR_FP_EXCEPTIONS, VoidOp>> {
+  static void Emit(X64Emitter& e, const EmitArgType& i) {
+    // Drop the sticky exception flags without converting them.
+    auto mxcsr = e.dword[e.rsp + StackLayout::GUEST_SCRATCH];
+    e.vstmxcsr(mxcsr);
+    e.and_(mxcsr, ~uint32_t(0x3F));
+    e.vldmxcsr(mxcsr);
+  }
+};
+EMITTER_OPCODE_TABLE(OPCODE_CLEAR_FP_EXCEPTIONS, CLEAR_FP_EXCEPTIONS);
+
 // Include anchors to other sequence sources so they get included in the build.
 extern volatile int anchor_control;
 static int anchor_control_dest = anchor_control;
@@ -32,6 +32,34 @@ using xe::cpu::hir::HIRBuilder;
 using xe::cpu::hir::TypeName;
 using xe::cpu::hir::Value;
 
+static bool ConstantDidCarry(const Value* value1, const Value* value2,
+                             bool carry_in) {
+  switch (value1->type) {
+    case INT8_TYPE:
+      return uint32_t(uint8_t(value1->constant.i8)) +
+                 uint8_t(value2->constant.i8) + carry_in >
+             UINT8_MAX;
+    case INT16_TYPE:
+      return uint32_t(uint16_t(value1->constant.i16)) +
+                 uint16_t(value2->constant.i16) + carry_in >
+             UINT16_MAX;
+    case INT32_TYPE:
+      return uint64_t(uint32_t(value1->constant.i32)) +
+                 uint32_t(value2->constant.i32) + carry_in >
+             UINT32_MAX;
+    case INT64_TYPE: {
+      uint64_t sum = uint64_t(value1->constant.i64) +
+                     uint64_t(value2->constant.i64);
+      // Only one of the two additions can carry.
+      return sum < uint64_t(value1->constant.i64) ||
+             (carry_in && sum == UINT64_MAX);
+    }
+    default:
+      assert_unhandled_case(value1->type);
+      return false;
+  }
+}
+
 ConstantPropagationPass::ConstantPropagationPass()
     : ConditionalGroupSubpass() {}
 
@@ -475,6 +503,16 @@ bool ConstantPropagationPass::Run(HIRBuilder* builder, bool& result) {
             result = true;
           }
           break;
+        case OPCODE_DID_CARRY:
+          if (i->src1.value->IsConstant() && i->src2.value->IsConstant() &&
+              i->src3.value->IsConstant()) {
+            bool carry_in = i->src3.value->constant.i8 != 0;
+            v->set_constant(int8_t(
+                ConstantDidCarry(i->src1.value, i->src2.value, carry_in)));
+            i->Remove();
+            result = true;
+          }
+          break;
         case OPCODE_SUB:
           if (i->src1.value->IsConstant() && i->src2.value->IsConstant()) {
             v->set_from(i->src1.value);
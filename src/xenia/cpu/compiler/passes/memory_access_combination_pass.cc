@@ -0,0 +1,214 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compiler/passes/memory_access_combination_pass.h"
+
+#include <cstddef>
+#include <utility>
+
+#include "xenia/base/profiling.h"
+#include "xenia/cpu/ppc/ppc_context.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// TODO(benvanik): remove when enums redefined.
+using namespace xe::cpu::hir;
+
+using xe::cpu::hir::HIRBuilder;
+using xe::cpu::hir::Instr;
+using xe::cpu::hir::Value;
+
+MemoryAccessCombinationPass::MemoryAccessCombinationPass() : CompilerPass() {}
+
+MemoryAccessCombinationPass::~MemoryAccessCombinationPass() = default;
+
+bool MemoryAccessCombinationPass::Run(HIRBuilder* builder) {
+  // Register spilling and structure copying on the stack is done with runs of
+  // lwz/stw to consecutive addresses:
+  //   v1.i32 = load_offset v0, +16, [swap]
+  //   v2.i32 = load_offset v0, +20, [swap]
+  // becomes:
+  //   v3.i64 = load_offset v0, +16, [swap]
+  //   v4.i64 = shr v3.i64, 32
+  //   v1.i32 = truncate v4.i64
+  //   v2.i32 = truncate v3.i64
+  // and the same for stores, with the values packed before the second store.
+  //
+  // Only addresses relative to the stack pointer are considered. Any other
+  // address may be MMIO, which is handled by decoding the faulting host
+  // instruction, and only 32-bit accesses can be decoded there. Reserved loads
+  // and stores use different opcodes and are never combined.
+  auto block = builder->first_block();
+  while (block) {
+    Instr* pending_load = nullptr;
+    Value* pending_load_base = nullptr;
+    Instr* pending_store = nullptr;
+    Value* pending_store_base = nullptr;
+    auto i = block->instr_head;
+    while (i) {
+      auto next = i->next;
+      Value* base = nullptr;
+      if (i->opcode == &OPCODE_LOAD_OFFSET_info &&
+          (base = GetStackAccessBase(i)) != nullptr) {
+        if (pending_load && pending_load_base == base &&
+            AreAdjacent(pending_load, i)) {
+          CombineLoads(builder, pending_load, i);
+          pending_load = nullptr;
+        } else {
+          pending_load = i;
+          pending_load_base = base;
+        }
+        // The pending store can't be moved past a load that may alias it.
+        pending_store = nullptr;
+      } else if (i->opcode == &OPCODE_STORE_OFFSET_info &&
+                 (base = GetStackAccessBase(i)) != nullptr) {
+        if (pending_store && pending_store_base == base &&
+            AreAdjacent(pending_store, i)) {
+          CombineStores(builder, pending_store, i);
+          pending_store = nullptr;
+        } else {
+          pending_store = i;
+          pending_store_base = base;
+        }
+        pending_load = nullptr;
+      } else if (i->opcode->flags &
+                 (OPCODE_FLAG_MEMORY | OPCODE_FLAG_VOLATILE)) {
+        // Other loads don't change the memory, but anything else accessing it
+        // or having side effects can't be reordered with the accesses.
+        if ((i->opcode->flags & OPCODE_FLAG_VOLATILE) ||
+            (i->opcode != &OPCODE_LOAD_info &&
+             i->opcode != &OPCODE_LOAD_OFFSET_info)) {
+          pending_load = nullptr;
+        }
+        pending_store = nullptr;
+      }
+      i = next;
+    }
+    block = block->next;
+  }
+  return true;
+}
+
+Value* MemoryAccessCombinationPass::GetStackAccessBase(Instr* i) {
+  // Only byte-swapped 32-bit guest accesses with a constant offset.
+  if (i->flags != LoadStoreFlags::LOAD_STORE_BYTE_SWAP ||
+      !i->src2.value->IsConstant()) {
+    return nullptr;
+  }
+  if (i->opcode == &OPCODE_LOAD_OFFSET_info) {
+    if (i->dest->type != INT32_TYPE) {
+      return nullptr;
+    }
+  } else {
+    // Constant values would need the packing to be folded.
+    if (i->src3.value->type != INT32_TYPE || i->src3.value->IsConstant()) {
+      return nullptr;
+    }
+  }
+  Value* base = i->src1.value;
+  while (base->def && base->def->opcode == &OPCODE_ASSIGN_info) {
+    base = base->def->src1.value;
+  }
+  if (!IsStackPointerDerived(base)) {
+    return nullptr;
+  }
+  return base;
+}
+
+bool MemoryAccessCombinationPass::IsStackPointerDerived(Value* value) {
+  // r1 is only loaded from the context at the beginning of a block. After
+  // ContextPromotionPass, within the block, it's the value written by the last
+  // stwu r1 or addi r1, r1, so a frame set up by the prolog is:
+  //   v0.i64 = load_context +8 (r1)
+  //   v1.i64 = add v0, -96
+  //   store v1, v2.i32 (the back chain)
+  //   store_offset v1, +88, v3.i32, [swap]
+  //   store_offset v1, +92, v4.i32, [swap]
+  // Pointers into the frame in other registers, like addi r11, r1, 80, are
+  // derived the same way.
+  while (value->def) {
+    Instr* def = value->def;
+    if (def->opcode == &OPCODE_ASSIGN_info) {
+      value = def->src1.value;
+    } else if (def->opcode == &OPCODE_ADD_info) {
+      if (def->src2.value->IsConstant()) {
+        value = def->src1.value;
+      } else if (def->src1.value->IsConstant()) {
+        value = def->src2.value;
+      } else {
+        return false;
+      }
+    } else {
+      return def->opcode == &OPCODE_LOAD_CONTEXT_info &&
+             def->src1.offset == offsetof(ppc::PPCContext, r) + 1 * 8;
+    }
+  }
+  return false;
+}
+
+bool MemoryAccessCombinationPass::AreAdjacent(Instr* i1, Instr* i2) {
+  int64_t offset1 = i1->src2.value->constant.i64;
+  int64_t offset2 = i2->src2.value->constant.i64;
+  return offset1 + 4 == offset2 || offset2 + 4 == offset1;
+}
+
+void MemoryAccessCombinationPass::CombineLoads(HIRBuilder* builder, Instr* i1,
+                                               Instr* i2) {
+  // The word at the lower address is in the upper half of the big-endian
+  // doubleword.
+  Instr* i_high = i1;
+  Instr* i_low = i2;
+  if (i2->src2.value->constant.i64 < i1->src2.value->constant.i64) {
+    std::swap(i_high, i_low);
+  }
+  Value* value =
+      builder->LoadOffset(i1->src1.value,
+                          builder->LoadConstantInt64(
+                              i_high->src2.value->constant.i64),
+                          INT64_TYPE, LoadStoreFlags::LOAD_STORE_BYTE_SWAP);
+  builder->last_instr()->MoveBefore(i1);
+  Value* value_high = builder->Shr(value, int8_t(32));
+  builder->last_instr()->MoveBefore(i_high);
+  i_high->Replace(&OPCODE_TRUNCATE_info, 0);
+  i_high->set_src1(value_high);
+  i_low->Replace(&OPCODE_TRUNCATE_info, 0);
+  i_low->set_src1(value);
+}
+
+void MemoryAccessCombinationPass::CombineStores(HIRBuilder* builder, Instr* i1,
+                                                Instr* i2) {
+  // Both values are available at the second store, which is where the
+  // combined store is done.
+  Value* value_high = i1->src3.value;
+  Value* value_low = i2->src3.value;
+  int64_t offset = i1->src2.value->constant.i64;
+  if (i2->src2.value->constant.i64 < offset) {
+    std::swap(value_high, value_low);
+    offset = i2->src2.value->constant.i64;
+  }
+  value_high = builder->ZeroExtend(value_high, INT64_TYPE);
+  builder->last_instr()->MoveBefore(i2);
+  value_high = builder->Shl(value_high, int8_t(32));
+  builder->last_instr()->MoveBefore(i2);
+  value_low = builder->ZeroExtend(value_low, INT64_TYPE);
+  builder->last_instr()->MoveBefore(i2);
+  Value* value = builder->Or(value_high, value_low);
+  builder->last_instr()->MoveBefore(i2);
+  i2->set_src2(builder->LoadConstantInt64(offset));
+  i2->set_src3(value);
+  i1->Remove();
+}
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,43 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILER_PASSES_MEMORY_ACCESS_COMBINATION_PASS_H_
+#define XENIA_CPU_COMPILER_PASSES_MEMORY_ACCESS_COMBINATION_PASS_H_
+
+#include "xenia/cpu/compiler/compiler_pass.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// Combines pairs of byte-swapped 32-bit loads or stores to adjacent stack
+// addresses into single 64-bit accesses. Must run after
+// MemorySequenceCombinationPass has merged the byte swaps into the accesses.
+class MemoryAccessCombinationPass : public CompilerPass {
+ public:
+  MemoryAccessCombinationPass();
+  ~MemoryAccessCombinationPass() override;
+
+  bool Run(hir::HIRBuilder* builder) override;
+
+ private:
+  static hir::Value* GetStackAccessBase(hir::Instr* i);
+  static bool IsStackPointerDerived(hir::Value* value);
+  static bool AreAdjacent(hir::Instr* i1, hir::Instr* i2);
+  void CombineLoads(hir::HIRBuilder* builder, hir::Instr* i1, hir::Instr* i2);
+  void CombineStores(hir::HIRBuilder* builder, hir::Instr* i1, hir::Instr* i2);
+};
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILER_PASSES_MEMORY_ACCESS_COMBINATION_PASS_H_
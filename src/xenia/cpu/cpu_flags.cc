@@ -17,6 +17,15 @@ DEFINE_string(
     "database.",
     "CPU");
 
+DEFINE_path(
+    crt_function_signatures, "",
+    "Text file with signatures of C runtime routines (such as memcpy, memset, "
+    "strlen) to replace with host implementations when found in loaded "
+    "modules. Each line is the name of the routine followed by its first "
+    "instructions as 8-digit big-endian hex words, where ? matches any digit. "
+    "Lines starting with # are ignored.",
+    "CPU");
+
 DEFINE_bool(disassemble_functions, false,
             "Disassemble functions during generation.", "CPU");
 
@@ -38,6 +47,11 @@ DEFINE_bool(
 DEFINE_bool(validate_hir, false,
             "Perform validation checks on the HIR during compilation.", "CPU");
 
+DEFINE_bool(combine_stack_accesses, true,
+            "Combine adjacent 32-bit guest loads and stores relative to the "
+            "stack pointer into 64-bit host accesses.",
+            "CPU");
+
 DEFINE_uint64(
     pvr, 0x710700,
     "Processor version and revision number.\nBits 0 to 15 are the version "
@@ -15,6 +15,8 @@ DECLARE_string(cpu);
 
 DECLARE_string(load_module_map);
 
+DECLARE_path(crt_function_signatures);
+
 DECLARE_bool(disassemble_functions);
 
 DECLARE_bool(trace_functions);
@@ -25,6 +27,7 @@ DECLARE_bool(trace_function_data);
 DECLARE_bool(disable_global_lock);
 
 DECLARE_bool(validate_hir);
+DECLARE_bool(combine_stack_accesses);
 
 DECLARE_uint64(pvr);
 
@@ -0,0 +1,233 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/crt_functions.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/mutex.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/memory.h"
+
+namespace xe {
+namespace cpu {
+
+namespace {
+
+// Guest memory accessed by a routine on behalf of the guest, checked the same
+// way as buffers accessed by the kernel (see XFile::Read). The guest page
+// protection must allow the access, and MMIO can't be accessed by host code at
+// all. Physical memory is accessed through the physical mapping to bypass the
+// host protection of watched pages, and write callbacks must be triggered
+// after writing with FinishCrtWrite.
+struct CrtRange {
+  uint8_t* host_address;
+  PhysicalHeap* physical_heap;
+};
+
+bool TranslateCrtRange(Memory* memory, uint32_t address, uint32_t length,
+                       bool is_write, CrtRange* out_range) {
+  assert_not_zero(length);
+  if (UINT32_MAX - address < length - 1) {
+    return false;
+  }
+  uint32_t high_address = address + length - 1;
+  BaseHeap* heap = memory->LookupHeap(address);
+  if (!heap || heap != memory->LookupHeap(high_address)) {
+    return false;
+  }
+  for (uint32_t page = address & ~uint32_t(0xFFF);; page += 0x1000) {
+    if (memory->LookupVirtualMappedRange(std::max(page, address))) {
+      return false;
+    }
+    if (high_address - page < 0x1000) {
+      break;
+    }
+  }
+  xe::memory::PageAccess access =
+      heap->QueryRangeAccess(address, high_address);
+  if (is_write ? access != xe::memory::PageAccess::kReadWrite
+               : access == xe::memory::PageAccess::kNoAccess) {
+    return false;
+  }
+  if (heap->heap_type() == HeapType::kGuestPhysical) {
+    auto physical_heap = static_cast<PhysicalHeap*>(heap);
+    out_range->host_address =
+        memory->TranslatePhysical(physical_heap->GetPhysicalAddress(address));
+    out_range->physical_heap = physical_heap;
+  } else {
+    out_range->host_address = memory->TranslateVirtual(address);
+    out_range->physical_heap = nullptr;
+  }
+  return true;
+}
+
+void FinishCrtWrite(const CrtRange& range, uint32_t address, uint32_t length) {
+  if (range.physical_heap) {
+    range.physical_heap->TriggerCallbacks(
+        xe::global_critical_region::AcquireDirect(), address, length, true,
+        true);
+  }
+}
+
+void LogInaccessibleCrtRange(const char* name, uint32_t address,
+                             uint32_t length) {
+  XELOGE("{}: guest range {:08X} ({} bytes) can't be accessed, skipping", name,
+         address, length);
+}
+
+// Reads a guest string a page at a time, since its length isn't known in
+// advance.
+class CrtStringReader {
+ public:
+  CrtStringReader(Memory* memory, uint32_t address)
+      : memory_(memory), address_(address) {}
+
+  // Returns false if the guest would fault reading the next character.
+  bool Next(uint8_t* out_char) {
+    if (!page_remaining_) {
+      uint32_t page_remaining = 0x1000 - (address_ & 0xFFF);
+      CrtRange range;
+      if (!TranslateCrtRange(memory_, address_, page_remaining, false,
+                             &range)) {
+        return false;
+      }
+      host_address_ = range.host_address;
+      page_remaining_ = page_remaining;
+    }
+    *out_char = *(host_address_++);
+    ++address_;
+    --page_remaining_;
+    return true;
+  }
+
+  uint32_t address() const { return address_; }
+
+ private:
+  Memory* memory_;
+  uint32_t address_;
+  const uint8_t* host_address_ = nullptr;
+  uint32_t page_remaining_ = 0;
+};
+
+// void* memcpy(void* dest, const void* src, size_t count);
+// void* memmove(void* dest, const void* src, size_t count);
+// Overlapping ranges are undefined behavior for memcpy, so it can be handled
+// like memmove.
+void CrtMemmove(ppc::PPCContext* ppc_context,
+                kernel::KernelState* kernel_state) {
+  Memory* memory = ppc_context->processor->memory();
+  uint32_t dest = uint32_t(ppc_context->r[3]);
+  uint32_t src = uint32_t(ppc_context->r[4]);
+  uint32_t count = uint32_t(ppc_context->r[5]);
+  if (count) {
+    CrtRange dest_range, src_range;
+    if (!TranslateCrtRange(memory, dest, count, true, &dest_range)) {
+      LogInaccessibleCrtRange("memmove", dest, count);
+    } else if (!TranslateCrtRange(memory, src, count, false, &src_range)) {
+      LogInaccessibleCrtRange("memmove", src, count);
+    } else {
+      std::memmove(dest_range.host_address, src_range.host_address, count);
+      FinishCrtWrite(dest_range, dest, count);
+    }
+  }
+  // The destination remains in r3 as the return value.
+}
+
+// void* memset(void* dest, int c, size_t count);
+void CrtMemset(ppc::PPCContext* ppc_context,
+               kernel::KernelState* kernel_state) {
+  Memory* memory = ppc_context->processor->memory();
+  uint32_t dest = uint32_t(ppc_context->r[3]);
+  uint32_t count = uint32_t(ppc_context->r[5]);
+  if (count) {
+    CrtRange dest_range;
+    if (!TranslateCrtRange(memory, dest, count, true, &dest_range)) {
+      LogInaccessibleCrtRange("memset", dest, count);
+    } else {
+      std::memset(dest_range.host_address, uint8_t(ppc_context->r[4]), count);
+      FinishCrtWrite(dest_range, dest, count);
+    }
+  }
+  // The destination remains in r3 as the return value.
+}
+
+// size_t strlen(const char* str);
+void CrtStrlen(ppc::PPCContext* ppc_context,
+               kernel::KernelState* kernel_state) {
+  CrtStringReader reader(ppc_context->processor->memory(),
+                         uint32_t(ppc_context->r[3]));
+  uint32_t length = 0;
+  uint8_t c;
+  while (true) {
+    if (!reader.Next(&c)) {
+      LogInaccessibleCrtRange("strlen", reader.address(), 1);
+      break;
+    }
+    if (!c) {
+      break;
+    }
+    ++length;
+  }
+  ppc_context->r[3] = length;
+}
+
+// int strcmp(const char* str1, const char* str2);
+void CrtStrcmp(ppc::PPCContext* ppc_context,
+               kernel::KernelState* kernel_state) {
+  Memory* memory = ppc_context->processor->memory();
+  CrtStringReader reader1(memory, uint32_t(ppc_context->r[3]));
+  CrtStringReader reader2(memory, uint32_t(ppc_context->r[4]));
+  int32_t result = 0;
+  uint8_t c1, c2;
+  while (true) {
+    if (!reader1.Next(&c1)) {
+      LogInaccessibleCrtRange("strcmp", reader1.address(), 1);
+      break;
+    }
+    if (!reader2.Next(&c2)) {
+      LogInaccessibleCrtRange("strcmp", reader2.address(), 1);
+      break;
+    }
+    if (c1 != c2) {
+      result = c1 < c2 ? -1 : 1;
+      break;
+    }
+    if (!c1) {
+      break;
+    }
+  }
+  ppc_context->r[3] = uint64_t(int64_t(result));
+}
+
+// XMemCpy and XMemSet are the XDK's cache-aware versions with the same
+// semantics as the C runtime ones.
+const CrtFunction kCrtFunctions[] = {
+    {"memcpy", CrtMemmove}, {"XMemCpy", CrtMemmove}, {"memmove", CrtMemmove},
+    {"memset", CrtMemset},  {"XMemSet", CrtMemset},  {"strlen", CrtStrlen},
+    {"strcmp", CrtStrcmp},
+};
+
+}  // namespace
+
+const CrtFunction* FindCrtFunction(const std::string_view name) {
+  for (size_t i = 0; i < xe::countof(kCrtFunctions); ++i) {
+    if (name == kCrtFunctions[i].name) {
+      return &kCrtFunctions[i];
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace cpu
+}  // namespace xe
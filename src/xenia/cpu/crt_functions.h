@@ -0,0 +1,35 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_CRT_FUNCTIONS_H_
+#define XENIA_CPU_CRT_FUNCTIONS_H_
+
+#include <string_view>
+
+#include "xenia/cpu/function.h"
+
+namespace xe {
+namespace cpu {
+
+// Host implementations of C runtime routines statically linked into titles.
+// They follow the guest calling convention - arguments in r3-r5 and the result
+// in r3 - and leave the rest of the context untouched, which is allowed since
+// everything else they could clobber is volatile across calls.
+struct CrtFunction {
+  const char* name;
+  GuestFunction::ExternHandler handler;
+};
+
+// Returns nullptr if there's no host implementation of the routine.
+const CrtFunction* FindCrtFunction(const std::string_view name);
+
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_CRT_FUNCTIONS_H_
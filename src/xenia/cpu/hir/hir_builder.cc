@@ -1289,6 +1289,17 @@ void HIRBuilder::SetRoundingMode(Value* value) {
   i->set_src1(value);
 }
 
+Value* HIRBuilder::LoadFPExceptions() {
+  Instr* i =
+      AppendInstr(OPCODE_LOAD_FP_EXCEPTIONS_info, 0, AllocValue(INT32_TYPE));
+  i->src1.value = i->src2.value = i->src3.value = NULL;
+  return i->dest;
+}
+
+void HIRBuilder::ClearFPExceptions() {
+  AppendInstr(OPCODE_CLEAR_FP_EXCEPTIONS_info, 0);
+}
+
 Value* HIRBuilder::Max(Value* value1, Value* value2) {
   ASSERT_TYPES_EQUAL(value1, value2);
 
@@ -1532,6 +1543,17 @@ Value* HIRBuilder::AddWithCarry(Value* value1, Value* value2, Value* value3,
   return i->dest;
 }
 
+Value* HIRBuilder::DidCarry(Value* value1, Value* value2, Value* value3) {
+  ASSERT_TYPES_EQUAL(value1, value2);
+  assert_true(value3->type == INT8_TYPE);
+
+  Instr* i = AppendInstr(OPCODE_DID_CARRY_info, 0, AllocValue(INT8_TYPE));
+  i->set_src1(value1);
+  i->set_src2(value2);
+  i->set_src3(value3);
+  return i->dest;
+}
+
 Value* HIRBuilder::VectorAdd(Value* value1, Value* value2, TypeName part_type,
                              uint32_t arithmetic_flags) {
   ASSERT_VECTOR_TYPE(value1);
@@ -173,6 +173,8 @@ class HIRBuilder {
   void MemoryBarrier();
 
   void SetRoundingMode(Value* value);
+  Value* LoadFPExceptions();
+  void ClearFPExceptions();
   Value* Max(Value* value1, Value* value2);
   Value* VectorMax(Value* value1, Value* value2, TypeName part_type,
                    uint32_t arithmetic_flags = 0);
@@ -203,6 +205,9 @@ class HIRBuilder {
   Value* Add(Value* value1, Value* value2, uint32_t arithmetic_flags = 0);
   Value* AddWithCarry(Value* value1, Value* value2, Value* value3,
                       uint32_t arithmetic_flags = 0);
+  // Whether value1 + value2 + value3 (the carry in, INT8_TYPE) carries out of
+  // the type of value1 and value2.
+  Value* DidCarry(Value* value1, Value* value2, Value* value3);
   Value* VectorAdd(Value* value1, Value* value2, TypeName part_type,
                    uint32_t arithmetic_flags = 0);
   Value* Sub(Value* value1, Value* value2, uint32_t arithmetic_flags = 0);
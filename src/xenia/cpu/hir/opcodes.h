@@ -237,6 +237,7 @@ enum Opcode {
   OPCODE_VECTOR_COMPARE_UGE,
   OPCODE_ADD,
   OPCODE_ADD_CARRY,
+  OPCODE_DID_CARRY,
   OPCODE_VECTOR_ADD,
   OPCODE_SUB,
   OPCODE_VECTOR_SUB,
@@ -280,6 +281,8 @@ enum Opcode {
   OPCODE_ATOMIC_EXCHANGE,
   OPCODE_ATOMIC_COMPARE_EXCHANGE,
   OPCODE_SET_ROUNDING_MODE,
+  OPCODE_LOAD_FP_EXCEPTIONS,
+  OPCODE_CLEAR_FP_EXCEPTIONS,
   __OPCODE_MAX_VALUE,  // Keep at end.
 };
 
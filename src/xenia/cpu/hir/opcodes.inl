@@ -416,6 +416,12 @@ DEFINE_OPCODE(
     OPCODE_SIG_V_V_V_V,
     0)
 
+DEFINE_OPCODE(
+    OPCODE_DID_CARRY,
+    "did_carry",
+    OPCODE_SIG_V_V_V_V,
+    0)
+
 DEFINE_OPCODE(
     OPCODE_VECTOR_ADD,
     "vector_add",
@@ -673,3 +679,15 @@ DEFINE_OPCODE(
     "set_rounding_mode",
     OPCODE_SIG_X_V,
     0)
+
+DEFINE_OPCODE(
+    OPCODE_LOAD_FP_EXCEPTIONS,
+    "load_fp_exceptions",
+    OPCODE_SIG_V,
+    0)
+
+DEFINE_OPCODE(
+    OPCODE_CLEAR_FP_EXCEPTIONS,
+    "clear_fp_exceptions",
+    OPCODE_SIG_X,
+    0)
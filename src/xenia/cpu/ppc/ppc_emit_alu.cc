@@ -24,25 +24,28 @@ using xe::cpu::hir::Value;
 
 // Integer arithmetic (A-3)
 
+// The carry is out of the low 32 bits. It's computed with a single DID_CARRY
+// so the backend can keep it in the host flags between the links of a chain
+// (addc, adde, adde...) instead of materializing and reloading XER[CA]. For
+// the instructions taking XER[CA], the DID_CARRY is emitted before the
+// ADD_CARRY for the result, which then doesn't need the carry in the flags, so
+// the carry out is still in the flags when the next link begins.
+
 Value* AddDidCarry(PPCHIRBuilder& f, Value* v1, Value* v2) {
-  return f.CompareUGT(f.Truncate(v2, INT32_TYPE),
-                      f.Not(f.Truncate(v1, INT32_TYPE)));
+  return f.DidCarry(f.Truncate(v1, INT32_TYPE), f.Truncate(v2, INT32_TYPE),
+                    f.LoadZeroInt8());
 }
 
 Value* SubDidCarry(PPCHIRBuilder& f, Value* v1, Value* v2) {
-  return f.Or(f.CompareUGT(f.Truncate(v1, INT32_TYPE),
-                           f.Not(f.Neg(f.Truncate(v2, INT32_TYPE)))),
-              f.IsFalse(f.Truncate(v2, INT32_TYPE)));
+  // v1 - v2 = v1 + ¬v2 + 1.
+  return f.DidCarry(f.Truncate(v1, INT32_TYPE),
+                    f.Not(f.Truncate(v2, INT32_TYPE)),
+                    f.LoadConstantInt8(1));
 }
 
-// https://github.com/sebastianbiallas/pearpc/blob/0b3c823f61456faa677f6209545a7b906e797421/src/cpu/cpu_generic/ppc_tools.h#L26
 Value* AddWithCarryDidCarry(PPCHIRBuilder& f, Value* v1, Value* v2, Value* v3) {
-  v1 = f.Truncate(v1, INT32_TYPE);
-  v2 = f.Truncate(v2, INT32_TYPE);
   assert_true(v3->type == INT8_TYPE);
-  v3 = f.ZeroExtend(v3, INT32_TYPE);
-  return f.Or(f.CompareULT(f.Add(f.Add(v1, v2), v3), v3),
-              f.CompareULT(f.Add(v1, v2), v1));
+  return f.DidCarry(f.Truncate(v1, INT32_TYPE), f.Truncate(v2, INT32_TYPE), v3);
 }
 
 int InstrEmit_addx(PPCHIRBuilder& f, const InstrData& i) {
@@ -83,13 +86,15 @@ int InstrEmit_addex(PPCHIRBuilder& f, const InstrData& i) {
   // CA <- carry bit
   Value* ra = f.LoadGPR(i.XO.RA);
   Value* rb = f.LoadGPR(i.XO.RB);
-  Value* v = f.AddWithCarry(ra, rb, f.LoadCA());
+  Value* ca = f.LoadCA();
+  Value* ca_out = AddWithCarryDidCarry(f, ra, rb, ca);
+  Value* v = f.AddWithCarry(ra, rb, ca);
   f.StoreGPR(i.XO.RT, v);
   if (i.XO.OE) {
     XEINSTRNOTIMPLEMENTED();
     // e.update_xer_with_overflow(EFLAGS OF?);
   } else {
-    f.StoreCA(AddWithCarryDidCarry(f, ra, rb, f.LoadCA()));
+    f.StoreCA(ca_out);
   }
   if (i.XO.Rc) {
     f.UpdateCR(0, v);
@@ -150,7 +155,9 @@ int InstrEmit_addmex(PPCHIRBuilder& f, const InstrData& i) {
   // RT <- (RA) + CA - 1
   // CA <- carry bit
   Value* ra = f.LoadGPR(i.XO.RA);
-  Value* v = f.AddWithCarry(ra, f.LoadConstantInt64(-1), f.LoadCA());
+  Value* ca = f.LoadCA();
+  Value* ca_out = AddWithCarryDidCarry(f, ra, f.LoadConstantInt64(-1), ca);
+  Value* v = f.AddWithCarry(ra, f.LoadConstantInt64(-1), ca);
   f.StoreGPR(i.XO.RT, v);
   if (i.XO.OE) {
     // With XER[SO] update too.
@@ -158,7 +165,7 @@ int InstrEmit_addmex(PPCHIRBuilder& f, const InstrData& i) {
     XEINSTRNOTIMPLEMENTED();
   } else {
     // Just CA update.
-    f.StoreCA(AddWithCarryDidCarry(f, ra, f.LoadConstantInt64(-1), f.LoadCA()));
+    f.StoreCA(ca_out);
   }
   if (i.XO.Rc) {
     f.UpdateCR(0, v);
@@ -170,7 +177,9 @@ int InstrEmit_addzex(PPCHIRBuilder& f, const InstrData& i) {
   // RT <- (RA) + CA
   // CA <- carry bit
   Value* ra = f.LoadGPR(i.XO.RA);
-  Value* v = f.AddWithCarry(ra, f.LoadZeroInt64(), f.LoadCA());
+  Value* ca = f.LoadCA();
+  Value* ca_out = AddWithCarryDidCarry(f, ra, f.LoadZeroInt64(), ca);
+  Value* v = f.AddWithCarry(ra, f.LoadZeroInt64(), ca);
   f.StoreGPR(i.XO.RT, v);
   if (i.XO.OE) {
     // With XER[SO] update too.
@@ -179,7 +188,7 @@ int InstrEmit_addzex(PPCHIRBuilder& f, const InstrData& i) {
     return 1;
   } else {
     // Just CA update.
-    f.StoreCA(AddWithCarryDidCarry(f, ra, f.LoadZeroInt64(), f.LoadCA()));
+    f.StoreCA(ca_out);
   }
   if (i.XO.Rc) {
     f.UpdateCR(0, v);
@@ -483,14 +492,16 @@ int InstrEmit_subfex(PPCHIRBuilder& f, const InstrData& i) {
   // RT <- ¬(RA) + (RB) + CA
   Value* not_ra = f.Not(f.LoadGPR(i.XO.RA));
   Value* rb = f.LoadGPR(i.XO.RB);
-  Value* v = f.AddWithCarry(not_ra, rb, f.LoadCA());
+  Value* ca = f.LoadCA();
+  Value* ca_out = AddWithCarryDidCarry(f, not_ra, rb, ca);
+  Value* v = f.AddWithCarry(not_ra, rb, ca);
   f.StoreGPR(i.XO.RT, v);
   if (i.XO.OE) {
     XEINSTRNOTIMPLEMENTED();
     return 1;
     // e.update_xer_with_overflow_and_carry(b.CreateExtractValue(v, 1));
   } else {
-    f.StoreCA(AddWithCarryDidCarry(f, not_ra, rb, f.LoadCA()));
+    f.StoreCA(ca_out);
   }
   if (i.XO.Rc) {
     f.UpdateCR(0, v);
@@ -501,15 +512,16 @@ int InstrEmit_subfex(PPCHIRBuilder& f, const InstrData& i) {
 int InstrEmit_subfmex(PPCHIRBuilder& f, const InstrData& i) {
   // RT <- ¬(RA) + CA - 1
   Value* not_ra = f.Not(f.LoadGPR(i.XO.RA));
-  Value* v = f.AddWithCarry(not_ra, f.LoadConstantInt64(-1), f.LoadCA());
+  Value* ca = f.LoadCA();
+  Value* ca_out = AddWithCarryDidCarry(f, not_ra, f.LoadConstantInt64(-1), ca);
+  Value* v = f.AddWithCarry(not_ra, f.LoadConstantInt64(-1), ca);
   f.StoreGPR(i.XO.RT, v);
   if (i.XO.OE) {
     XEINSTRNOTIMPLEMENTED();
     return 1;
     // e.update_xer_with_overflow_and_carry(b.CreateExtractValue(v, 1));
   } else {
-    f.StoreCA(
-        AddWithCarryDidCarry(f, not_ra, f.LoadConstantInt64(-1), f.LoadCA()));
+    f.StoreCA(ca_out);
   }
   if (i.XO.Rc) {
     f.UpdateCR(0, v);
@@ -520,14 +532,16 @@ int InstrEmit_subfmex(PPCHIRBuilder& f, const InstrData& i) {
 int InstrEmit_subfzex(PPCHIRBuilder& f, const InstrData& i) {
   // RT <- ¬(RA) + CA
   Value* not_ra = f.Not(f.LoadGPR(i.XO.RA));
-  Value* v = f.AddWithCarry(not_ra, f.LoadZeroInt64(), f.LoadCA());
+  Value* ca = f.LoadCA();
+  Value* ca_out = AddWithCarryDidCarry(f, not_ra, f.LoadZeroInt64(), ca);
+  Value* v = f.AddWithCarry(not_ra, f.LoadZeroInt64(), ca);
   f.StoreGPR(i.XO.RT, v);
   if (i.XO.OE) {
     XEINSTRNOTIMPLEMENTED();
     return 1;
     // e.update_xer_with_overflow_and_carry(b.CreateExtractValue(v, 1));
   } else {
-    f.StoreCA(AddWithCarryDidCarry(f, not_ra, f.LoadZeroInt64(), f.LoadCA()));
+    f.StoreCA(ca_out);
   }
   if (i.XO.Rc) {
     f.UpdateCR(0, v);
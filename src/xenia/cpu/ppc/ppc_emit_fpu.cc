@@ -351,8 +351,24 @@ int InstrEmit_fcmpu(PPCHIRBuilder& f, const InstrData& i) {
 // Floating-point status and control register (A
 
 int InstrEmit_mcrfs(PPCHIRBuilder& f, const InstrData& i) {
-  XEINSTRNOTIMPLEMENTED();
-  return 1;
+  // CR[4*BF:4*BF+3] <- FPSCR[4*BFA:4*BFA+3]
+  // FPSCR exception bits in the field, other than FEX and VX, are cleared.
+  const uint32_t crf_d = i.X.RT >> 2;
+  const uint32_t crf_s = i.X.RA >> 2;
+  const uint32_t shift = 4 * (7 - crf_s);
+  Value* fpscr = f.LoadFPSCR();
+  for (uint32_t bit = 0; bit < 4; ++bit) {
+    f.StoreCRField(crf_d, bit,
+                   f.And(f.Truncate(f.Shr(fpscr, shift + 3 - bit), INT8_TYPE),
+                         f.LoadConstantInt8(1)));
+  }
+  // FX, OX, UX, ZX, XX, VXSNAN, VXISI, VXIDI, VXZDZ, VXIMZ, VXVC, VXSOFT,
+  // VXSQRT, VXCVI.
+  const uint32_t clear_mask = 0x9FF80700 & (0xFu << shift);
+  if (clear_mask) {
+    f.StoreFPSCR(f.And(fpscr, f.LoadConstantUint32(~clear_mask)));
+  }
+  return 0;
 }
 
 int InstrEmit_mffsx(PPCHIRBuilder& f, const InstrData& i) {
@@ -45,6 +45,74 @@ using xe::cpu::hir::Label;
 using xe::cpu::hir::TypeName;
 using xe::cpu::hir::Value;
 
+// How an instruction interacts with the host floating-point exception flags,
+// which accumulate the FPSCR exception bits raised by scalar floating-point
+// instructions until FPSCR is observed.
+enum class HostFPExceptionsUse {
+  kNone,
+  // Needs the flags to hold only unfolded FPSCR exceptions - scalar
+  // floating-point math, and branches within the function.
+  kAccumulate,
+  // May raise exceptions that don't belong in FPSCR - VMX math, and calls to
+  // guest or host code (the kernel, the global lock behind the MSR, the time
+  // base).
+  kForeign,
+  // Leaves the function.
+  kExit,
+};
+
+static HostFPExceptionsUse GetHostFPExceptionsUse(const InstrData& i,
+                                                  uint32_t start_address,
+                                                  uint32_t end_address) {
+  if (i.opcode_info->group == PPCOpcodeGroup::kF) {
+    return HostFPExceptionsUse::kAccumulate;
+  }
+  if (i.opcode_info->group == PPCOpcodeGroup::kV) {
+    return HostFPExceptionsUse::kForeign;
+  }
+  uint32_t nia;
+  switch (i.opcode) {
+    case PPCOpcode::bx:
+      if (i.I.LK) {
+        return HostFPExceptionsUse::kForeign;
+      }
+      nia = uint32_t(XEEXTS26(i.I.LI << 2));
+      if (!i.I.AA) {
+        nia += i.address;
+      }
+      break;
+    case PPCOpcode::bcx:
+      if (i.B.LK) {
+        return HostFPExceptionsUse::kForeign;
+      }
+      nia = uint32_t(XEEXTS16(i.B.BD << 2));
+      if (!i.B.AA) {
+        nia += i.address;
+      }
+      break;
+    case PPCOpcode::bcctrx:
+    case PPCOpcode::bclrx:
+      return i.XL.LK ? HostFPExceptionsUse::kForeign
+                     : HostFPExceptionsUse::kExit;
+    case PPCOpcode::sc:
+    case PPCOpcode::mfmsr:
+    case PPCOpcode::mtmsr:
+    case PPCOpcode::mtmsrd:
+    case PPCOpcode::mftb:
+      return HostFPExceptionsUse::kForeign;
+    case PPCOpcode::mfspr: {
+      const uint32_t n = ((i.XFX.spr & 0x1F) << 5) | ((i.XFX.spr >> 5) & 0x1F);
+      return (n == 268 || n == 269) ? HostFPExceptionsUse::kForeign
+                                    : HostFPExceptionsUse::kNone;
+    }
+    default:
+      return HostFPExceptionsUse::kNone;
+  }
+  return (nia >= start_address && nia <= end_address)
+             ? HostFPExceptionsUse::kAccumulate
+             : HostFPExceptionsUse::kExit;
+}
+
 // The number of times each opcode has been translated.
 // Accumulated across the entire run.
 uint32_t opcode_translation_counts[static_cast<int>(PPCOpcode::kInvalid)] = {0};
@@ -115,6 +183,30 @@ bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags) {
 
   uint32_t start_address = function_->address();
   uint32_t end_address = function_->end_address();
+
+  // The host floating-point exception flags are only maintained in functions
+  // that may raise FPSCR exceptions. Others can read FPSCR directly, as
+  // functions fold their exceptions before calls and returns.
+  fp_exceptions_used_ = false;
+  for (uint32_t address = start_address; address <= end_address;
+       address += 4) {
+    uint32_t code =
+        xe::load_and_swap<uint32_t>(memory->TranslateVirtual(address));
+    if (GetOpcodeInfo(LookupOpcode(code)).group == PPCOpcodeGroup::kF) {
+      fp_exceptions_used_ = true;
+      break;
+    }
+  }
+  fp_exceptions_polluted_ = false;
+  fp_exceptions_polluted_list_ = nullptr;
+  if (fp_exceptions_used_) {
+    fp_exceptions_polluted_list_ =
+        (bool*)arena_->Alloc(instr_count_ * sizeof(bool), alignof(bool));
+    std::memset(fp_exceptions_polluted_list_, 0, instr_count_ * sizeof(bool));
+    // The caller may leave anything in the flags. This is done before the
+    // entry label so branches back to the start don't drop the exceptions.
+    ClearFPExceptions();
+  }
   for (uint32_t address = start_address, offset = 0; address <= end_address;
        address += 4, offset++) {
     trace_info_.dest_count = 0;
@@ -123,14 +215,59 @@ bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags) {
     auto opcode = LookupOpcode(code);
     auto& opcode_info = GetOpcodeInfo(opcode);
 
+    InstrData i;
+    i.address = address;
+    i.code = code;
+    i.opcode = opcode;
+    i.opcode_info = &opcode_info;
+
     // Mark label, if we were assigned one earlier on in the walk.
     // We may still get a label, but it'll be inserted by LookupLabel
     // as needed.
     Label* label = label_list_[offset];
     if (label) {
+      // Branches bring only FPSCR exceptions, so drop the foreign ones on the
+      // fall-through path.
+      if (fp_exceptions_polluted_) {
+        ClearFPExceptions();
+        fp_exceptions_polluted_ = false;
+      }
       MarkLabel(label);
     }
 
+    // Only scalar floating-point instructions contribute to the FPSCR
+    // exception bits, but the host exception flags are also raised by VMX
+    // and by code called from the guest. Fold before the first such
+    // instruction in a run, and clear after the run, when the flags are
+    // needed again. This is done before the label point of the instruction
+    // so branches added by LookupLabel see the state the instruction runs
+    // in.
+    if (fp_exceptions_used_) {
+      switch (GetHostFPExceptionsUse(i, start_address, end_address)) {
+        case HostFPExceptionsUse::kNone:
+          break;
+        case HostFPExceptionsUse::kAccumulate:
+          if (fp_exceptions_polluted_) {
+            ClearFPExceptions();
+            fp_exceptions_polluted_ = false;
+          }
+          break;
+        case HostFPExceptionsUse::kForeign:
+          if (!fp_exceptions_polluted_) {
+            FoldFPExceptions();
+            fp_exceptions_polluted_ = true;
+          }
+          break;
+        case HostFPExceptionsUse::kExit:
+          // With foreign exceptions the FPSCR ones have already been folded.
+          if (!fp_exceptions_polluted_) {
+            FoldFPExceptions();
+          }
+          break;
+      }
+      fp_exceptions_polluted_list_[offset] = fp_exceptions_polluted_;
+    }
+
     Instr* first_instr = 0;
     if (with_debug_info_) {
       if (label) {
@@ -170,11 +307,6 @@ bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags) {
 
     MaybeBreakOnInstruction(address);
 
-    InstrData i;
-    i.address = address;
-    i.code = code;
-    i.opcode = opcode;
-    i.opcode_info = &opcode_info;
     if (!opcode_info.emit || opcode_info.emit(*this, i)) {
       auto& disasm_info = GetOpcodeDisasmInfo(opcode);
       XELOGE(
@@ -188,6 +320,11 @@ bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags) {
     }
   }
 
+  // Falling off the end of the function.
+  if (fp_exceptions_used_ && !fp_exceptions_polluted_) {
+    FoldFPExceptions();
+  }
+
   if (false) {
     DumpAllOpcodeCounts();
   }
@@ -272,6 +409,14 @@ Label* PPCHIRBuilder::LookupLabel(uint32_t address) {
   label_list_[offset] = label;
   Instr* instr = instr_offset_list_[offset];
   if (instr) {
+    // The instruction has already been translated with foreign exceptions in
+    // the flags, and they will be cleared before the FPSCR ones are folded -
+    // fold the exceptions of this path before branching.
+    if (fp_exceptions_used_ && fp_exceptions_polluted_list_[offset] &&
+        !fp_exceptions_polluted_) {
+      FoldFPExceptions();
+    }
+
     if (instr->prev) {
       // Insert label, breaking up existing instructions.
       InsertLabel(label, instr->prev);
@@ -428,11 +573,27 @@ void PPCHIRBuilder::UpdateCR6(Value* src_value) {
 }
 
 Value* PPCHIRBuilder::LoadFPSCR() {
+  // Floating-point instructions don't update the exception bits themselves -
+  // the host accumulates them in its sticky flags, which are folded in
+  // whenever FPSCR is observed or something else may raise them.
+  if (fp_exceptions_used_) {
+    if (fp_exceptions_polluted_) {
+      ClearFPExceptions();
+      fp_exceptions_polluted_ = false;
+    } else {
+      FoldFPExceptions();
+    }
+  }
   return LoadContext(offsetof(PPCContext, fpscr), INT32_TYPE);
 }
 
 void PPCHIRBuilder::StoreFPSCR(Value* value) {
   assert_true(value->type == INT32_TYPE);
+  // Exceptions raised before the store are overwritten by it.
+  if (fp_exceptions_used_) {
+    ClearFPExceptions();
+    fp_exceptions_polluted_ = false;
+  }
   StoreContext(offsetof(PPCContext, fpscr), value);
 
   auto& trace_reg = trace_info_.dests[trace_info_.dest_count++];
@@ -441,33 +602,22 @@ void PPCHIRBuilder::StoreFPSCR(Value* value) {
 }
 
 void PPCHIRBuilder::UpdateFPSCR(Value* result, bool update_cr1) {
-  // TODO(benvanik): detect overflow and nan cases.
-  // fx and vx are the most important.
-  Value* fx = LoadConstantInt8(0);
-  Value* fex = LoadConstantInt8(0);
-  Value* vx = LoadConstantInt8(0);
-  Value* ox = LoadConstantInt8(0);
-
+  // The exception bits are accumulated by the host and only folded into
+  // FPSCR when needed (see LoadFPSCR), so there's nothing to do here unless
+  // the instruction observes them via CR1.
+  // TODO(benvanik): FPRF, FR and FI, and the FEX and VX summary bits.
   if (update_cr1) {
-    // Store into the CR1 field.
-    // We do this instead of just calling CopyFPSCRToCR1 so that we don't
-    // have to read back the bits and do shifting work.
-    StoreContext(offsetof(PPCContext, cr1.cr1_fx), fx);
-    StoreContext(offsetof(PPCContext, cr1.cr1_fex), fex);
-    StoreContext(offsetof(PPCContext, cr1.cr1_vx), vx);
-    StoreContext(offsetof(PPCContext, cr1.cr1_ox), ox);
+    CopyFPSCRToCR1();
   }
+}
 
-  // Generate our new bits.
-  Value* new_bits = Shl(ZeroExtend(fx, INT32_TYPE), 31);
-  new_bits = Or(new_bits, Shl(ZeroExtend(fex, INT32_TYPE), 30));
-  new_bits = Or(new_bits, Shl(ZeroExtend(vx, INT32_TYPE), 29));
-  new_bits = Or(new_bits, Shl(ZeroExtend(ox, INT32_TYPE), 28));
-
-  // Mix into fpscr while preserving sticky bits (FX and OX).
-  Value* bits = LoadFPSCR();
-  bits = Or(And(bits, LoadConstantUint32(0x9FFFFFFF)), new_bits);
-  StoreFPSCR(bits);
+void PPCHIRBuilder::FoldFPExceptions() {
+  Value* exceptions = LoadFPExceptions();
+  Value* fpscr = LoadContext(offsetof(PPCContext, fpscr), INT32_TYPE);
+  // FX is set only when an exception bit changes from 0 to 1.
+  Value* fx =
+      Shl(ZeroExtend(IsTrue(And(exceptions, Not(fpscr))), INT32_TYPE), 31);
+  StoreContext(offsetof(PPCContext, fpscr), Or(Or(fpscr, exceptions), fx));
 }
 
 void PPCHIRBuilder::CopyFPSCRToCR1() {
@@ -84,6 +84,7 @@ class PPCHIRBuilder : public hir::HIRBuilder {
  private:
   void MaybeBreakOnInstruction(uint32_t address);
   void AnnotateLabel(uint32_t address, Label* label);
+  void FoldFPExceptions();
 
   PPCFrontend* frontend_;
 
@@ -98,6 +99,15 @@ class PPCHIRBuilder : public hir::HIRBuilder {
   Instr** instr_offset_list_;
   Label** label_list_;
 
+  // Whether the function may raise FPSCR exceptions, which are then
+  // accumulated in the host floating-point exception flags.
+  bool fp_exceptions_used_;
+  // Whether the flags may currently contain exceptions not belonging in FPSCR
+  // (raised by VMX or host code), to be cleared before they're needed again.
+  // The list has the state each instruction was translated with.
+  bool fp_exceptions_polluted_;
+  bool* fp_exceptions_polluted_list_;
+
   // Reset each instruction.
   struct {
     uint32_t dest_count;
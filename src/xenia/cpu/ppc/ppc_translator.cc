@@ -69,6 +69,13 @@ PPCTranslator::PPCTranslator(PPCFrontend* frontend) : frontend_(frontend) {
         std::make_unique<passes::MemorySequenceCombinationPass>());
     if (validate)
       compiler_->AddPass(std::make_unique<passes::ValidationPass>());
+    if (cvars::combine_stack_accesses) {
+      // Needs the byte swaps already merged into the loads and stores.
+      compiler_->AddPass(
+          std::make_unique<passes::MemoryAccessCombinationPass>());
+      if (validate)
+        compiler_->AddPass(std::make_unique<passes::ValidationPass>());
+    }
   }
   compiler_->AddPass(std::make_unique<passes::SimplificationPass>());
   if (validate) compiler_->AddPass(std::make_unique<passes::ValidationPass>());
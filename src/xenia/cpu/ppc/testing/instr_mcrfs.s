@@ -0,0 +1,116 @@
+test_mcrfs_1:
+  #_ REGISTER_IN f1 1.0
+  #_ REGISTER_IN f2 0.0
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  fdiv f3, f1, f2
+  mcrfs cr2, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT f1 1.0
+  #_ REGISTER_OUT f2 0.0
+  #_ REGISTER_OUT r12 0x00400000
+
+test_mcrfs_2:
+  #_ REGISTER_IN f1 1.0
+  #_ REGISTER_IN f2 0.0
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  fdiv f3, f1, f2
+  mcrfs cr2, 0
+  mcrfs cr3, 1
+  mcrfs cr4, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT f1 1.0
+  #_ REGISTER_OUT f2 0.0
+  #_ REGISTER_OUT r12 0x00840000
+
+test_mcrfs_3:
+  #_ REGISTER_IN f1 1.0
+  #_ REGISTER_IN f2 2.0
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  fadd f3, f1, f2
+  mcrfs cr2, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT f1 1.0
+  #_ REGISTER_OUT f2 2.0
+  #_ REGISTER_OUT f3 3.0
+  #_ REGISTER_OUT r12 0
+
+test_mcrfs_4:
+  # FX is only set when an exception bit changes from 0 to 1.
+  #_ REGISTER_IN f1 1.0
+  #_ REGISTER_IN f2 0.0
+  mtfsfi 0, 0
+  mtfsfi 1, 4
+  fdiv f3, f1, f2
+  mcrfs cr2, 0
+  mcrfs cr3, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT f1 1.0
+  #_ REGISTER_OUT f2 0.0
+  #_ REGISTER_OUT r12 0x00040000
+
+test_mcrfs_5:
+  # Exceptions raised by VMX instructions don't go to FPSCR.
+  #_ REGISTER_IN f1 1.0
+  #_ REGISTER_IN f2 2.0
+  #_ REGISTER_IN v3 [3F800000, 3F800000, 3F800000, 3F800000]
+  #_ REGISTER_IN v4 [32000000, 32000000, 32000000, 32000000]
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  vaddfp v5, v3, v4
+  fadd f3, f1, f2
+  mcrfs cr2, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT f1 1.0
+  #_ REGISTER_OUT f2 2.0
+  #_ REGISTER_OUT f3 3.0
+  #_ REGISTER_OUT r12 0
+
+test_mcrfs_6:
+  # Exceptions raised in a loop are folded after it.
+  #_ REGISTER_IN r3 4
+  #_ REGISTER_IN f1 1.0
+  #_ REGISTER_IN f2 0.0
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  mtctr r3
+mcrfs_6_loop:
+  fdiv f3, f1, f2
+  bdnz mcrfs_6_loop
+  mcrfs cr2, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT r3 4
+  #_ REGISTER_OUT f1 1.0
+  #_ REGISTER_OUT f2 0.0
+  #_ REGISTER_OUT r12 0x00400000
+
+test_mcrfs_7:
+  # VMX exceptions in a loop with scalar floating-point math don't go to FPSCR.
+  #_ REGISTER_IN r3 4
+  #_ REGISTER_IN f1 1.0
+  #_ REGISTER_IN f2 0.0
+  #_ REGISTER_IN v3 [3F800000, 3F800000, 3F800000, 3F800000]
+  #_ REGISTER_IN v4 [32000000, 32000000, 32000000, 32000000]
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  mtctr r3
+mcrfs_7_loop:
+  vaddfp v5, v3, v4
+  fdiv f3, f1, f2
+  vaddfp v5, v3, v4
+  bdnz mcrfs_7_loop
+  mcrfs cr2, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT r3 4
+  #_ REGISTER_OUT f1 1.0
+  #_ REGISTER_OUT f2 0.0
+  #_ REGISTER_OUT r12 0x00400000
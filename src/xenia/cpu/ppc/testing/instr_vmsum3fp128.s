@@ -8,3 +8,32 @@ test_vmsum3fp128_1:
   #_ REGISTER_OUT v3 [3f800000, 3fc00000, 3f8ccccd, 01020304]
   #_ REGISTER_OUT v4 [40000000, 40700000, 4013d70a, 01020304]
   #_ REGISTER_OUT v5 [4122A7F0, 4122A7F0, 4122A7F0, 4122A7F0]
+
+test_vmsum3fp128_2:
+  # Pairwise summation order: (x + y) + z.
+  #_ REGISTER_IN v3 [4cbebc20, 3f800000, ccbebc20, 3f800000]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  vmsum3fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [4cbebc20, 3f800000, ccbebc20, 3f800000]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [00000000, 00000000, 00000000, 00000000]
+
+test_vmsum3fp128_3:
+  # W is ignored even if it would overflow.
+  #_ REGISTER_IN v3 [3f800000, 3f800000, 3f800000, 7f61b1e6]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 7f61b1e6]
+  vmsum3fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [3f800000, 3f800000, 3f800000, 7f61b1e6]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 7f61b1e6]
+  #_ REGISTER_OUT v5 [40400000, 40400000, 40400000, 40400000]
+
+test_vmsum3fp128_4:
+  #_ REGISTER_IN v3 [80000000, 80000000, 80000000, 80000000]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  vmsum3fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [80000000, 80000000, 80000000, 80000000]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [00000000, 00000000, 00000000, 00000000]
@@ -6,3 +6,65 @@ test_vmsum4fp128_1:
   #_ REGISTER_OUT v3 [3f800000, 3fc00000, 3f8ccccd, 3ff33333]
   #_ REGISTER_OUT v4 [40000000, 40700000, 4013d70a, 40b051eb]
   #_ REGISTER_OUT v5 [41A5147B, 41A5147B, 41A5147B, 41A5147B]
+
+test_vmsum4fp128_2:
+  # Pairwise summation order: (x + y) + (z + w).
+  #_ REGISTER_IN v3 [4cbebc20, 3f800000, ccbebc20, 3f800000]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  vmsum4fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [4cbebc20, 3f800000, ccbebc20, 3f800000]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [00000000, 00000000, 00000000, 00000000]
+
+test_vmsum4fp128_3:
+  # Product overflow gives QNaN.
+  #_ REGISTER_IN v3 [7e967699, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_IN v4 [41200000, 3f800000, 3f800000, 3f800000]
+  vmsum4fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [7e967699, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v4 [41200000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [7FC00000, 7FC00000, 7FC00000, 7FC00000]
+
+test_vmsum4fp128_4:
+  # Sum overflow gives QNaN.
+  #_ REGISTER_IN v3 [7f61b1e6, 7f61b1e6, 00000000, 00000000]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  vmsum4fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [7f61b1e6, 7f61b1e6, 00000000, 00000000]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [7FC00000, 7FC00000, 7FC00000, 7FC00000]
+
+test_vmsum4fp128_5:
+  # Infinite operands don't overflow.
+  #_ REGISTER_IN v3 [7f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  vmsum4fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [7f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [7F800000, 7F800000, 7F800000, 7F800000]
+
+test_vmsum4fp128_6:
+  #_ REGISTER_IN v3 [80000000, 80000000, 80000000, 80000000]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  vmsum4fp128 v5, v3, v4
+  blr
+  #_ REGISTER_OUT v3 [80000000, 80000000, 80000000, 80000000]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [80000000, 80000000, 80000000, 80000000]
+
+test_vmsum4fp128_7:
+  # Product overflow gives QNaN also when the FPU rounds toward zero, where the
+  # product itself would be the largest finite value.
+  #_ REGISTER_IN v3 [7e967699, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_IN v4 [41200000, 3f800000, 3f800000, 3f800000]
+  mtfsfi 7, 1
+  vmsum4fp128 v5, v3, v4
+  mtfsfi 7, 0
+  blr
+  #_ REGISTER_OUT v3 [7e967699, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v4 [41200000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [7FC00000, 7FC00000, 7FC00000, 7FC00000]
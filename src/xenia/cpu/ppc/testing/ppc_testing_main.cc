@@ -7,6 +7,7 @@
  ******************************************************************************
  */
 
+#include "xenia/base/clock.h"
 #include "xenia/base/console_app_main.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/filesystem.h"
@@ -34,6 +35,10 @@ DEFINE_path(test_path, "src/xenia/cpu/ppc/testing/",
 DEFINE_path(test_bin_path, "src/xenia/cpu/ppc/testing/bin/",
             "Directory with binary outputs of the test files.", "Other");
 DEFINE_transient_string(test_name, "", "Test suite name.", "General");
+DEFINE_int32(test_benchmark_iterations, 0,
+             "Number of times to rerun each passing test, logging the time "
+             "per call and the host code size.",
+             "Other");
 
 namespace xe {
 namespace cpu {
@@ -271,11 +276,35 @@ class TestRunner {
       if (fn->is_guest()) {
         static_cast<xe::cpu::GuestFunction*>(fn)->debug_info()->Dump();
       }
+    } else if (cvars::test_benchmark_iterations > 0) {
+      Benchmark(test_case, fn);
     }
 
     return result;
   }
 
+  void Benchmark(TestCase& test_case, Function* fn) {
+    auto ctx = thread_state_->context();
+    uint32_t iterations = uint32_t(cvars::test_benchmark_iterations);
+    uint64_t start_ticks = Clock::QueryHostTickCount();
+    for (uint32_t n = 0; n < iterations; ++n) {
+      SetupTestState(test_case);
+      ctx->lr = 0xBCBCBCBC;
+      fn->Call(thread_state_.get(), uint32_t(ctx->lr));
+    }
+    uint64_t elapsed_ticks = Clock::QueryHostTickCount() - start_ticks;
+    double ns_per_call = double(elapsed_ticks) * 1000000000.0 /
+                         double(Clock::QueryHostTickFrequency()) /
+                         double(iterations);
+    size_t code_length = 0;
+    if (fn->is_guest()) {
+      code_length =
+          static_cast<xe::cpu::GuestFunction*>(fn)->machine_code_length();
+    }
+    XELOGI("    {:.1f} ns per call, {} bytes of host code", ns_per_call,
+           code_length);
+  }
+
   bool SetupTestState(TestCase& test_case) {
     auto ppc_context = thread_state_->context();
     for (auto& it : test_case.annotations) {
@@ -0,0 +1,34 @@
+test_bench_branch:
+  # Compares and conditional branches on a loop counter, as in integer code
+  # with many small ifs.
+  #_ REGISTER_IN r3 1000
+  #_ REGISTER_IN r11 750
+  li r4, 0
+  mtctr r3
+bench_branch_loop:
+  andi. r8, r4, 1
+  beq bench_branch_even
+  add r5, r5, r4
+  b bench_branch_signed
+bench_branch_even:
+  addi r6, r6, 1
+bench_branch_signed:
+  cmpwi r4, 500
+  bge bench_branch_unsigned
+  addi r7, r7, 1
+bench_branch_unsigned:
+  cmplw r4, r11
+  ble bench_branch_next
+  addi r12, r12, 1
+bench_branch_next:
+  addi r4, r4, 1
+  bdnz bench_branch_loop
+  blr
+  #_ REGISTER_OUT r3 1000
+  #_ REGISTER_OUT r4 1000
+  #_ REGISTER_OUT r5 250000
+  #_ REGISTER_OUT r6 500
+  #_ REGISTER_OUT r7 500
+  #_ REGISTER_OUT r8 1
+  #_ REGISTER_OUT r11 750
+  #_ REGISTER_OUT r12 249
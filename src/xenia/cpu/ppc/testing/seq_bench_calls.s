@@ -0,0 +1,18 @@
+test_bench_calls:
+  # Calls to a small leaf function in a loop.
+  #_ REGISTER_IN r3 1000
+  #_ REGISTER_IN r5 3
+  mflr r12
+  mtctr r3
+bench_calls_loop:
+  bl bench_calls_add
+  bdnz bench_calls_loop
+  mtlr r12
+  blr
+  #_ REGISTER_OUT r3 1000
+  #_ REGISTER_OUT r4 3000
+  #_ REGISTER_OUT r5 3
+
+bench_calls_add:
+  add r4, r4, r5
+  blr
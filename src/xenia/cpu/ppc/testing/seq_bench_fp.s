@@ -0,0 +1,53 @@
+test_bench_fp_loop:
+  # Scalar floating-point loop with the exceptions observed once after it.
+  #_ REGISTER_IN r3 1000
+  #_ REGISTER_IN f1 0.0
+  #_ REGISTER_IN f2 1.0
+  #_ REGISTER_IN f3 3.0
+  #_ REGISTER_IN f4 0.5
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  mtctr r3
+bench_fp_loop_loop:
+  fadd f1, f1, f2
+  fmul f5, f3, f4
+  fmadd f6, f5, f4, f1
+  fsub f7, f6, f5
+  fdiv f8, f2, f3
+  bdnz bench_fp_loop_loop
+  mcrfs cr2, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT r3 1000
+  #_ REGISTER_OUT f1 1000.0
+  #_ REGISTER_OUT f5 1.5
+  #_ REGISTER_OUT f6 1000.75
+  #_ REGISTER_OUT f7 999.25
+  #_ REGISTER_OUT r12 0x00200000
+
+test_bench_fp_loop_rc:
+  # The same loop observing the exceptions in CR1 on every iteration.
+  #_ REGISTER_IN r3 1000
+  #_ REGISTER_IN f1 0.0
+  #_ REGISTER_IN f2 1.0
+  #_ REGISTER_IN f3 3.0
+  #_ REGISTER_IN f4 0.5
+  mtfsfi 0, 0
+  mtfsfi 1, 0
+  mtctr r3
+bench_fp_loop_rc_loop:
+  fadd f1, f1, f2
+  fmul f5, f3, f4
+  fmadd f6, f5, f4, f1
+  fsub f7, f6, f5
+  fdiv. f8, f2, f3
+  bdnz bench_fp_loop_rc_loop
+  mcrfs cr2, 1
+  mfcr r12
+  blr
+  #_ REGISTER_OUT r3 1000
+  #_ REGISTER_OUT f1 1000.0
+  #_ REGISTER_OUT f5 1.5
+  #_ REGISTER_OUT f6 1000.75
+  #_ REGISTER_OUT f7 999.25
+  #_ REGISTER_OUT r12 0x08200000
@@ -0,0 +1,30 @@
+test_bench_stack_pairs:
+  # Spilling and reloading register pairs in a stack frame, like the prolog
+  # and epilog of a call made in a loop.
+  #_ REGISTER_IN r3 1000
+  #_ REGISTER_IN r4 1
+  #_ REGISTER_IN r5 3
+  #_ REGISTER_IN r6 4
+  #_ REGISTER_IN r7 2
+  mtctr r3
+bench_stack_pairs_loop:
+  stwu r1, -64(r1)
+  stw r4, 16(r1)
+  stw r5, 20(r1)
+  stw r6, 24(r1)
+  stw r7, 28(r1)
+  lwz r8, 16(r1)
+  lwz r9, 20(r1)
+  lwz r10, 24(r1)
+  lwz r11, 28(r1)
+  addi r1, r1, 64
+  add r12, r12, r8
+  add r12, r12, r11
+  bdnz bench_stack_pairs_loop
+  blr
+  #_ REGISTER_OUT r3 1000
+  #_ REGISTER_OUT r8 1
+  #_ REGISTER_OUT r9 3
+  #_ REGISTER_OUT r10 4
+  #_ REGISTER_OUT r11 2
+  #_ REGISTER_OUT r12 3000
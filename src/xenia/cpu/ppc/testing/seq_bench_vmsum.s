@@ -0,0 +1,20 @@
+test_bench_vmsum:
+  # Dot products accumulated in a loop, like transforming vertices.
+  #_ REGISTER_IN r3 1000
+  #_ REGISTER_IN v3 [3f800000, 40000000, 40400000, 40800000]
+  #_ REGISTER_IN v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  mtctr r3
+bench_vmsum_loop:
+  vmsum4fp128 v5, v3, v4
+  vmsum3fp128 v6, v3, v4
+  vaddfp128 v7, v7, v5
+  vaddfp128 v8, v8, v6
+  bdnz bench_vmsum_loop
+  blr
+  #_ REGISTER_OUT r3 1000
+  #_ REGISTER_OUT v3 [3f800000, 40000000, 40400000, 40800000]
+  #_ REGISTER_OUT v4 [3f800000, 3f800000, 3f800000, 3f800000]
+  #_ REGISTER_OUT v5 [41200000, 41200000, 41200000, 41200000]
+  #_ REGISTER_OUT v6 [40c00000, 40c00000, 40c00000, 40c00000]
+  #_ REGISTER_OUT v7 [461c4000, 461c4000, 461c4000, 461c4000]
+  #_ REGISTER_OUT v8 [45bb8000, 45bb8000, 45bb8000, 45bb8000]
@@ -0,0 +1,116 @@
+test_branch_compare_1:
+  #_ REGISTER_IN r3 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_IN r4 1
+  li r12, 0
+  cmpw r3, r4
+  blt branch_compare_1_good
+  blr
+branch_compare_1_good:
+  li r12, 1
+  blr
+  #_ REGISTER_OUT r3 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_OUT r4 1
+  #_ REGISTER_OUT r12 1
+
+test_branch_compare_2:
+  #_ REGISTER_IN r3 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_IN r4 1
+  li r12, 0
+  cmplw r3, r4
+  bgt branch_compare_2_good
+  blr
+branch_compare_2_good:
+  li r12, 1
+  blr
+  #_ REGISTER_OUT r3 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_OUT r4 1
+  #_ REGISTER_OUT r12 1
+
+test_branch_compare_3:
+  #_ REGISTER_IN r3 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_IN r4 1
+  li r12, 1
+  cmplw r3, r4
+  blt branch_compare_3_bad
+  blr
+branch_compare_3_bad:
+  li r12, 0
+  blr
+  #_ REGISTER_OUT r3 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_OUT r4 1
+  #_ REGISTER_OUT r12 1
+
+test_branch_compare_4:
+  #_ REGISTER_IN r3 3
+  #_ REGISTER_IN r4 3
+  li r12, 0
+  cmpw r3, r4
+  bge branch_compare_4_good
+  blr
+branch_compare_4_good:
+  li r12, 1
+  blr
+  #_ REGISTER_OUT r3 3
+  #_ REGISTER_OUT r4 3
+  #_ REGISTER_OUT r12 1
+
+test_branch_compare_constant_lhs:
+  #_ REGISTER_IN r4 2
+  li r12, 0
+  li r3, 1
+  cmpw r3, r4
+  blt branch_compare_constant_lhs_good
+  blr
+branch_compare_constant_lhs_good:
+  li r12, 1
+  blr
+  #_ REGISTER_OUT r3 1
+  #_ REGISTER_OUT r4 2
+  #_ REGISTER_OUT r12 1
+
+test_branch_compare_constant_lhs_unsigned:
+  #_ REGISTER_IN r4 0xFFFFFFFFFFFFFFFF
+  li r12, 0
+  li r3, 1
+  cmplw r3, r4
+  bgt branch_compare_constant_lhs_unsigned_bad
+  li r12, 1
+  blr
+branch_compare_constant_lhs_unsigned_bad:
+  blr
+  #_ REGISTER_OUT r3 1
+  #_ REGISTER_OUT r4 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_OUT r12 1
+
+test_branch_compare_clobbered:
+  #_ REGISTER_IN r3 2
+  #_ REGISTER_IN r4 2
+  li r12, 0
+  cmpw r3, r4
+  add r5, r3, r4
+  subf r6, r5, r3
+  beq branch_compare_clobbered_good
+  blr
+branch_compare_clobbered_good:
+  li r12, 1
+  blr
+  #_ REGISTER_OUT r3 2
+  #_ REGISTER_OUT r4 2
+  #_ REGISTER_OUT r5 4
+  #_ REGISTER_OUT r6 0xFFFFFFFFFFFFFFFE
+  #_ REGISTER_OUT r12 1
+
+test_branch_compare_record:
+  #_ REGISTER_IN r3 5
+  #_ REGISTER_IN r4 7
+  li r12, 0
+  subf. r5, r4, r3
+  bgt branch_compare_record_bad
+  beq branch_compare_record_bad
+  li r12, 1
+branch_compare_record_bad:
+  blr
+  #_ REGISTER_OUT r3 5
+  #_ REGISTER_OUT r4 7
+  #_ REGISTER_OUT r5 0xFFFFFFFFFFFFFFFE
+  #_ REGISTER_OUT r12 1
@@ -0,0 +1,79 @@
+test_carry_chain_add:
+  #_ REGISTER_IN r3 0xFFFFFFFF
+  #_ REGISTER_IN r4 0xFFFFFFFF
+  #_ REGISTER_IN r5 0xFFFFFFFF
+  #_ REGISTER_IN r6 0
+  #_ REGISTER_IN r7 0
+  #_ REGISTER_IN r8 1
+  addc r11, r5, r8
+  adde r10, r4, r7
+  adde r9, r3, r6
+  adde r12, r0, r0
+  blr
+  #_ REGISTER_OUT r3 0xFFFFFFFF
+  #_ REGISTER_OUT r4 0xFFFFFFFF
+  #_ REGISTER_OUT r5 0xFFFFFFFF
+  #_ REGISTER_OUT r6 0
+  #_ REGISTER_OUT r7 0
+  #_ REGISTER_OUT r8 1
+  #_ REGISTER_OUT r9 0x100000000
+  #_ REGISTER_OUT r10 0x100000000
+  #_ REGISTER_OUT r11 0x100000000
+  #_ REGISTER_OUT r12 1
+
+test_carry_chain_sub:
+  #_ REGISTER_IN r3 7
+  #_ REGISTER_IN r4 5
+  #_ REGISTER_IN r5 0
+  #_ REGISTER_IN r6 3
+  #_ REGISTER_IN r7 2
+  #_ REGISTER_IN r8 1
+  subfc r11, r8, r5
+  subfe r10, r7, r4
+  subfe r9, r6, r3
+  adde r12, r0, r0
+  blr
+  #_ REGISTER_OUT r3 7
+  #_ REGISTER_OUT r4 5
+  #_ REGISTER_OUT r5 0
+  #_ REGISTER_OUT r6 3
+  #_ REGISTER_OUT r7 2
+  #_ REGISTER_OUT r8 1
+  #_ REGISTER_OUT r9 4
+  #_ REGISTER_OUT r10 2
+  #_ REGISTER_OUT r11 0xFFFFFFFFFFFFFFFF
+  #_ REGISTER_OUT r12 1
+
+test_carry_chain_clobbered:
+  #_ REGISTER_IN r3 1
+  #_ REGISTER_IN r4 2
+  #_ REGISTER_IN r5 0xFFFFFFFF
+  #_ REGISTER_IN r7 3
+  #_ REGISTER_IN r8 1
+  addc r11, r5, r8
+  cmpw r3, r4
+  adde r10, r4, r7
+  adde r12, r0, r0
+  blr
+  #_ REGISTER_OUT r3 1
+  #_ REGISTER_OUT r4 2
+  #_ REGISTER_OUT r5 0xFFFFFFFF
+  #_ REGISTER_OUT r7 3
+  #_ REGISTER_OUT r8 1
+  #_ REGISTER_OUT r10 6
+  #_ REGISTER_OUT r11 0x100000000
+  #_ REGISTER_OUT r12 0
+
+test_carry_chain_addze:
+  #_ REGISTER_IN r3 1
+  #_ REGISTER_IN r4 0xFFFFFFFF
+  #_ REGISTER_IN r5 0
+  addic r3, r3, -1
+  addze r4, r4
+  addze r5, r5
+  adde r12, r0, r0
+  blr
+  #_ REGISTER_OUT r3 0
+  #_ REGISTER_OUT r4 0x100000000
+  #_ REGISTER_OUT r5 1
+  #_ REGISTER_OUT r12 0
@@ -0,0 +1,64 @@
+test_stack_pairs_spill:
+  #_ REGISTER_IN r3 0x0123456789ABCDEF
+  #_ REGISTER_IN r4 0xFEDCBA9876543210
+  stw r3, -16(r1)
+  stw r4, -12(r1)
+  lwz r5, -16(r1)
+  lwz r6, -12(r1)
+  ld r7, -16(r1)
+  blr
+  #_ REGISTER_OUT r3 0x0123456789ABCDEF
+  #_ REGISTER_OUT r4 0xFEDCBA9876543210
+  #_ REGISTER_OUT r5 0x89ABCDEF
+  #_ REGISTER_OUT r6 0x76543210
+  #_ REGISTER_OUT r7 0x89ABCDEF76543210
+
+test_stack_pairs_descending:
+  #_ REGISTER_IN r3 0x11223344
+  #_ REGISTER_IN r4 0x55667788
+  stw r4, -12(r1)
+  stw r3, -16(r1)
+  lwz r6, -12(r1)
+  lwz r5, -16(r1)
+  ld r7, -16(r1)
+  blr
+  #_ REGISTER_OUT r3 0x11223344
+  #_ REGISTER_OUT r4 0x55667788
+  #_ REGISTER_OUT r5 0x11223344
+  #_ REGISTER_OUT r6 0x55667788
+  #_ REGISTER_OUT r7 0x1122334455667788
+
+test_stack_pairs_aliased:
+  #_ REGISTER_IN r3 0x11223344
+  #_ REGISTER_IN r4 0x55667788
+  #_ REGISTER_IN r5 0x99AABBCC
+  stw r3, -16(r1)
+  lwz r6, -16(r1)
+  stw r4, -12(r1)
+  stb r5, -16(r1)
+  lwz r7, -16(r1)
+  lwz r8, -12(r1)
+  blr
+  #_ REGISTER_OUT r3 0x11223344
+  #_ REGISTER_OUT r4 0x55667788
+  #_ REGISTER_OUT r5 0x99AABBCC
+  #_ REGISTER_OUT r6 0x11223344
+  #_ REGISTER_OUT r7 0xCC223344
+  #_ REGISTER_OUT r8 0x55667788
+
+test_stack_pairs_frame:
+  #_ REGISTER_IN r3 0x11223344
+  #_ REGISTER_IN r4 0x55667788
+  stwu r1, -32(r1)
+  stw r3, 16(r1)
+  stw r4, 20(r1)
+  lwz r5, 16(r1)
+  lwz r6, 20(r1)
+  ld r7, 16(r1)
+  addi r1, r1, 32
+  blr
+  #_ REGISTER_OUT r3 0x11223344
+  #_ REGISTER_OUT r4 0x55667788
+  #_ REGISTER_OUT r5 0x11223344
+  #_ REGISTER_OUT r6 0x55667788
+  #_ REGISTER_OUT r7 0x1122334455667788
@@ -145,6 +145,14 @@ bool Processor::Setup(std::unique_ptr<backend::Backend> backend) {
       XELOGW("Disabling --debug due to lack of stack walker");
       cvars::debug = false;
     }
+  } else if (!stack_walker_->can_query_thread_context()) {
+    // The debugger walks the stacks of suspended threads.
+    if (cvars::debug) {
+      XELOGW(
+          "Disabling --debug as the stack walker can't capture suspended "
+          "threads");
+      cvars::debug = false;
+    }
   }
 
   // Open the trace data path, if requested.
@@ -1093,6 +1101,9 @@ uint32_t Processor::StepToGuestSafePoint(uint32_t thread_id, bool ignore_host) {
         "Processor::StepToSafePoint(): target thread is the calling thread!");
     return 0;
   }
+  if (!stack_walker_ || !stack_walker_->can_query_thread_context()) {
+    return 0;
+  }
   auto thread_info = QueryThreadDebugInfo(thread_id);
   auto thread = thread_info->thread;
 
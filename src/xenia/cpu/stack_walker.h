@@ -87,6 +87,11 @@ class StackWalker {
                                    HostThreadContext* out_host_context,
                                    uint64_t* out_stack_hash = nullptr) = 0;
 
+  // Whether the CaptureStackTrace overload for other threads can obtain the
+  // context of a suspended thread by itself. If not, it only works with the
+  // in_host_context provided by the caller.
+  virtual bool can_query_thread_context() const = 0;
+
   // Resolves symbol information for the given stack frames.
   // Each frame provided must have host_pc set, and all other fields will be
   // populated.
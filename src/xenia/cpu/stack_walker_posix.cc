@@ -9,16 +9,206 @@
 
 #include "xenia/cpu/stack_walker.h"
 
+#include <dlfcn.h>
+#include <unwind.h>
+#include <cstdint>
+#include <cstring>
+
 #include "xenia/base/logging.h"
+#include "xenia/base/platform.h"
+#include "xenia/base/xxhash.h"
+#include "xenia/cpu/backend/code_cache.h"
+
+#if XE_ARCH_AMD64
+#include "xenia/cpu/backend/x64/x64_code_cache.h"
+#endif  // XE_ARCH_AMD64
 
 namespace xe {
 namespace cpu {
 
+#if XE_ARCH_AMD64
+
+class PosixStackWalker : public StackWalker {
+ public:
+  explicit PosixStackWalker(backend::CodeCache* code_cache)
+      : code_cache_(code_cache) {
+    // Get the boundaries of the code cache so we can quickly tell if a symbol
+    // is ours or not.
+    code_cache_min_ = code_cache_->execute_base_address();
+    code_cache_max_ = code_cache_min_ + code_cache_->total_size();
+  }
+
+  size_t CaptureStackTrace(uint64_t* frame_host_pcs, size_t frame_offset,
+                           size_t frame_count,
+                           uint64_t* out_stack_hash) override {
+    if (out_stack_hash) {
+      *out_stack_hash = 0;
+    }
+    // The code cache registers the unwind information of the generated code
+    // with the unwinder, so this walks through guest frames too.
+    BacktraceState state;
+    state.frame_host_pcs = frame_host_pcs;
+    // Skip this function too.
+    state.frames_to_skip = frame_offset + 1;
+    state.frame_count = frame_count;
+    state.captured_count = 0;
+    _Unwind_Backtrace(BacktraceCallback, &state);
+    if (out_stack_hash && state.captured_count) {
+      *out_stack_hash = XXH3_64bits(
+          frame_host_pcs, sizeof(uint64_t) * state.captured_count);
+    }
+    return state.captured_count;
+  }
+
+  size_t CaptureStackTrace(void* thread_handle, uint64_t* frame_host_pcs,
+                           size_t frame_offset, size_t frame_count,
+                           const HostThreadContext* in_host_context,
+                           HostThreadContext* out_host_context,
+                           uint64_t* out_stack_hash) override {
+    if (out_stack_hash) {
+      *out_stack_hash = 0;
+    }
+    // There's no way to query the context of another thread here, it must be
+    // obtained by the caller (such as from the signal that suspended it).
+    if (!in_host_context) {
+      XELOGE("Stack walk of another thread requires its host context");
+      return 0;
+    }
+    if (out_host_context) {
+      *out_host_context = *in_host_context;
+    }
+
+    // Step through the generated code frames using the unwind information from
+    // the code cache. Host frames are not described by anything this can read
+    // from a foreign thread, so the walk stops at the first one - which for a
+    // thread running guest code is the host to guest thunk's caller.
+    uint64_t pc = in_host_context->rip;
+    uint64_t sp = in_host_context->rsp;
+    size_t frame_index = 0;
+    while (frame_index < frame_offset + frame_count) {
+      if (frame_index >= frame_offset) {
+        frame_host_pcs[frame_index - frame_offset] = pc;
+      }
+      ++frame_index;
+      if (pc < code_cache_min_ || pc >= code_cache_max_) {
+        break;
+      }
+      auto unwind_entry = reinterpret_cast<const backend::x64::X64UnwindEntry*>(
+          code_cache_->LookupUnwindInfo(pc));
+      if (!unwind_entry) {
+        break;
+      }
+      // Before the stack allocation in the prolog, and at the ret after the
+      // deallocation in the epilog, the return address is at the top.
+      if (pc - unwind_entry->code_begin >=
+              unwind_entry->prolog_stack_alloc_offset &&
+          *reinterpret_cast<const uint8_t*>(pc) != 0xC3) {
+        sp += unwind_entry->stack_size;
+      }
+      pc = *reinterpret_cast<const uint64_t*>(sp);
+      sp += sizeof(uint64_t);
+    }
+    size_t captured_count =
+        frame_index > frame_offset ? frame_index - frame_offset : 0;
+    if (out_stack_hash && captured_count) {
+      *out_stack_hash =
+          XXH3_64bits(frame_host_pcs, sizeof(uint64_t) * captured_count);
+    }
+    return captured_count;
+  }
+
+  // Nothing like GetThreadContext exists, the context of a suspended thread
+  // is only known to its own signal handler.
+  bool can_query_thread_context() const override { return false; }
+
+  bool ResolveStack(uint64_t* frame_host_pcs, StackFrame* frames,
+                    size_t frame_count) override {
+    for (size_t i = 0; i < frame_count; ++i) {
+      auto& frame = frames[i];
+      std::memset(&frame, 0, sizeof(frame));
+      frame.host_pc = frame_host_pcs[i];
+
+      // If in the generated range, we know it's ours.
+      if (frame.host_pc >= code_cache_min_ && frame.host_pc < code_cache_max_) {
+        // Guest symbol, so we can look it up quickly in the code cache.
+        frame.type = StackFrame::Type::kGuest;
+        auto function = code_cache_->LookupFunction(frame.host_pc);
+        if (function) {
+          frame.guest_symbol.function = function;
+          // Figure out where in guest code we are by looking up the
+          // displacement in x64 from the JIT'ed code start to the PC.
+          if (function->is_guest()) {
+            auto guest_function = static_cast<GuestFunction*>(function);
+            // Adjust the host PC by -1 so that we will go back into whatever
+            // instruction was executing before the capture (like a call).
+            frame.guest_pc =
+                guest_function->MapMachineCodeToGuestAddress(frame.host_pc - 1);
+          }
+        } else {
+          frame.guest_symbol.function = nullptr;
+        }
+      } else {
+        // Host symbol, which means either emulator or system. Only exported
+        // symbols are known to the dynamic linker.
+        frame.type = StackFrame::Type::kHost;
+        Dl_info info;
+        if (dladdr(reinterpret_cast<void*>(frame.host_pc), &info) &&
+            info.dli_sname) {
+          frame.host_symbol.address =
+              reinterpret_cast<uint64_t>(info.dli_saddr);
+          std::strncpy(frame.host_symbol.name, info.dli_sname,
+                       sizeof(frame.host_symbol.name) - 1);
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  struct BacktraceState {
+    uint64_t* frame_host_pcs;
+    size_t frames_to_skip;
+    size_t frame_count;
+    size_t captured_count;
+  };
+
+  static _Unwind_Reason_Code BacktraceCallback(_Unwind_Context* context,
+                                               void* arg) {
+    auto& state = *reinterpret_cast<BacktraceState*>(arg);
+    if (state.frames_to_skip) {
+      --state.frames_to_skip;
+      return _URC_NO_REASON;
+    }
+    if (state.captured_count >= state.frame_count) {
+      return _URC_END_OF_STACK;
+    }
+    uint64_t pc = _Unwind_GetIP(context);
+    if (!pc) {
+      return _URC_END_OF_STACK;
+    }
+    state.frame_host_pcs[state.captured_count++] = pc;
+    return _URC_NO_REASON;
+  }
+
+  backend::CodeCache* code_cache_;
+  uintptr_t code_cache_min_;
+  uintptr_t code_cache_max_;
+};
+
+std::unique_ptr<StackWalker> StackWalker::Create(
+    backend::CodeCache* code_cache) {
+  return std::make_unique<PosixStackWalker>(code_cache);
+}
+
+#else
+
 std::unique_ptr<StackWalker> StackWalker::Create(
     backend::CodeCache* code_cache) {
   XELOGD("Stack walker unimplemented on posix");
   return nullptr;
 }
 
+#endif  // XE_ARCH_AMD64
+
 }  // namespace cpu
-}  // namespace xe
\ No newline at end of file
+}  // namespace xe
@@ -218,6 +218,8 @@ class Win32StackWalker : public StackWalker {
     return frame_index - frame_offset;
   }
 
+  bool can_query_thread_context() const override { return true; }
+
   bool ResolveStack(uint64_t* frame_host_pcs, StackFrame* frames,
                     size_t frame_count) override {
     // TODO(benvanik): collect symbols to resolve with dbghelp and resolve
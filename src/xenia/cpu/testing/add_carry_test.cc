@@ -0,0 +1,101 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/testing/util.h"
+
+#include "third_party/capstone/include/capstone/capstone.h"
+#include "third_party/capstone/include/capstone/x86.h"
+
+using namespace xe::cpu::hir;
+using namespace xe::cpu;
+using namespace xe::cpu::testing;
+using xe::cpu::ppc::PPCContext;
+
+// An addc, adde, adde chain, built the same way as the PPC frontend builds it:
+// the carry out of each link is calculated before the sum.
+static void BuildCarryChain(HIRBuilder& b) {
+  Value* sum = b.Add(LoadGPR(b, 5), LoadGPR(b, 8));
+  StoreGPR(b, 11, sum);
+  Value* ca = b.DidCarry(b.Truncate(LoadGPR(b, 5), INT32_TYPE),
+                         b.Truncate(LoadGPR(b, 8), INT32_TYPE),
+                         b.LoadZeroInt8());
+  for (int link = 0; link < 2; ++link) {
+    Value* ra = LoadGPR(b, 4 - link);
+    Value* rb = LoadGPR(b, 7 - link);
+    Value* ca_out = b.DidCarry(b.Truncate(ra, INT32_TYPE),
+                               b.Truncate(rb, INT32_TYPE), ca);
+    StoreGPR(b, 10 - link, b.AddWithCarry(ra, rb, ca));
+    ca = ca_out;
+  }
+  StoreGPR(b, 12, b.ZeroExtend(ca, INT64_TYPE));
+  b.Return();
+}
+
+TEST_CASE("ADD_CARRY_CHAIN", "[instr]") {
+  TestFunction test(BuildCarryChain);
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->r[3] = 0xFFFFFFFF;
+        ctx->r[4] = 0xFFFFFFFF;
+        ctx->r[5] = 0xFFFFFFFF;
+        ctx->r[6] = 0;
+        ctx->r[7] = 0;
+        ctx->r[8] = 1;
+      },
+      [](PPCContext* ctx) {
+        REQUIRE(ctx->r[9] == 0x100000000);
+        REQUIRE(ctx->r[10] == 0x100000000);
+        REQUIRE(ctx->r[11] == 0x100000000);
+        REQUIRE(ctx->r[12] == 1);
+      });
+  test.Run(
+      [](PPCContext* ctx) {
+        ctx->r[3] = 1;
+        ctx->r[4] = 0xFFFFFFFE;
+        ctx->r[5] = 0x80000000;
+        ctx->r[6] = 2;
+        ctx->r[7] = 1;
+        ctx->r[8] = 0x7FFFFFFF;
+      },
+      [](PPCContext* ctx) {
+        REQUIRE(ctx->r[9] == 3);
+        REQUIRE(ctx->r[10] == 0xFFFFFFFF);
+        REQUIRE(ctx->r[11] == 0xFFFFFFFF);
+        REQUIRE(ctx->r[12] == 0);
+      });
+}
+
+#if XE_ARCH_AMD64
+TEST_CASE("ADD_CARRY_CHAIN_KEEPS_CF", "[instr]") {
+  // The carry must be passed between the links in CF, without reloading it
+  // from the materialized byte with bt.
+  TestFunction test(BuildCarryChain);
+  csh capstone_handle;
+  REQUIRE(cs_open(CS_ARCH_X86, CS_MODE_64, &capstone_handle) == CS_ERR_OK);
+  for (auto& processor : test.processors) {
+    auto fn =
+        static_cast<GuestFunction*>(processor->ResolveFunction(0x80000000));
+    REQUIRE(fn);
+    const uint8_t* code = fn->machine_code();
+    size_t code_size = fn->machine_code_length();
+    uint64_t address = uint64_t(code);
+    cs_insn* insn = cs_malloc(capstone_handle);
+    size_t carry_reload_count = 0;
+    while (cs_disasm_iter(capstone_handle, &code, &code_size, &address,
+                          insn)) {
+      if (insn->id == X86_INS_BT || insn->id == X86_INS_SAHF) {
+        ++carry_reload_count;
+      }
+    }
+    cs_free(insn, 1);
+    REQUIRE(carry_reload_count == 0);
+  }
+  cs_close(&capstone_handle);
+}
+#endif  // XE_ARCH_AMD64
@@ -0,0 +1,309 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "xenia/base/byte_order.h"
+#include "xenia/base/math.h"
+#include "xenia/cpu/crt_functions.h"
+#include "xenia/cpu/raw_module.h"
+#include "xenia/cpu/testing/util.h"
+#include "xenia/cpu/thread_state.h"
+
+namespace xe {
+namespace cpu {
+namespace testing {
+
+// Compares the host implementations of C runtime routines with the guest
+// routines they replace. The guest versions are simple byte loops, executed by
+// the JIT, and the host versions are reached the same way as after replacing a
+// routine found in a title, through an `sc 2` extern.
+class CrtFunctionTest {
+ public:
+  static constexpr uint32_t kCodeAddress = 0x82000000;
+  static constexpr uint32_t kExternAddress = kCodeAddress + 0x800;
+  static constexpr uint32_t kDataAddress = 0x10000000;
+  static constexpr uint32_t kDataSize = 0x4000;
+
+  // Byte-by-byte guest routines, with the same arguments and results as the
+  // C runtime ones.
+  static constexpr uint32_t kGuestMemmove = kCodeAddress;
+  static constexpr uint32_t kGuestMemset = kCodeAddress + 0x100;
+  static constexpr uint32_t kGuestStrlen = kCodeAddress + 0x200;
+  static constexpr uint32_t kGuestStrcmp = kCodeAddress + 0x300;
+
+  CrtFunctionTest() {
+    memory_ = std::make_unique<Memory>();
+    memory_->Initialize();
+    processor_ = std::make_unique<Processor>(memory_.get(), nullptr);
+#if XE_ARCH_AMD64
+    processor_->Setup(std::make_unique<backend::x64::X64Backend>());
+#endif  // XE_ARCH
+
+    memory_->LookupHeap(kCodeAddress)
+        ->AllocFixed(kCodeAddress, 0x10000, 0,
+                     kMemoryAllocationReserve | kMemoryAllocationCommit,
+                     kMemoryProtectRead | kMemoryProtectWrite);
+    WriteCode(kGuestMemmove, {
+                                 0x28050000,  // cmplwi r5, 0
+                                 0x4D820020,  // beqlr
+                                 0x7C661B78,  // mr r6, r3
+                                 0x7CA903A6,  // mtctr r5
+                                 0x7C041840,  // cmplw r4, r3
+                                 0x4080001C,  // bge forward
+                                 0x7CC32A14,  // add r6, r3, r5
+                                 0x7C842A14,  // add r4, r4, r5
+                                 0x8CE4FFFF,  // backward: lbzu r7, -1(r4)
+                                 0x9CE6FFFF,  // stbu r7, -1(r6)
+                                 0x4200FFF8,  // bdnz backward
+                                 0x4E800020,  // blr
+                                 0x88E40000,  // forward: lbz r7, 0(r4)
+                                 0x98E60000,  // stb r7, 0(r6)
+                                 0x38840001,  // addi r4, r4, 1
+                                 0x38C60001,  // addi r6, r6, 1
+                                 0x4200FFF0,  // bdnz forward
+                                 0x4E800020,  // blr
+                             });
+    WriteCode(kGuestMemset, {
+                                0x28050000,  // cmplwi r5, 0
+                                0x4D820020,  // beqlr
+                                0x7C661B78,  // mr r6, r3
+                                0x7CA903A6,  // mtctr r5
+                                0x98860000,  // loop: stb r4, 0(r6)
+                                0x38C60001,  // addi r6, r6, 1
+                                0x4200FFF8,  // bdnz loop
+                                0x4E800020,  // blr
+                            });
+    WriteCode(kGuestStrlen, {
+                                0x7C641B78,  // mr r4, r3
+                                0x88A40000,  // loop: lbz r5, 0(r4)
+                                0x2C050000,  // cmpwi r5, 0
+                                0x38840001,  // addi r4, r4, 1
+                                0x4082FFF4,  // bne loop
+                                0x7C632050,  // subf r3, r3, r4
+                                0x3863FFFF,  // addi r3, r3, -1
+                                0x4E800020,  // blr
+                            });
+    WriteCode(kGuestStrcmp, {
+                                0x88A30000,  // loop: lbz r5, 0(r3)
+                                0x88C40000,  // lbz r6, 0(r4)
+                                0x7C053040,  // cmplw r5, r6
+                                0x4082001C,  // bne differ
+                                0x2C050000,  // cmpwi r5, 0
+                                0x38630001,  // addi r3, r3, 1
+                                0x38840001,  // addi r4, r4, 1
+                                0x4082FFE4,  // bne loop
+                                0x38600000,  // li r3, 0
+                                0x4E800020,  // blr
+                                0x38600001,  // differ: li r3, 1
+                                0x4D810020,  // bgtlr
+                                0x3860FFFF,  // li r3, -1
+                                0x4E800020,  // blr
+                            });
+
+    auto module = std::make_unique<RawModule>(processor_.get());
+    module_ = module.get();
+    module_->SetAddressRange(kCodeAddress, 0x10000);
+    processor_->AddModule(std::move(module));
+
+    memory_->LookupHeap(kDataAddress)
+        ->AllocFixed(kDataAddress, kDataSize, 0,
+                     kMemoryAllocationReserve | kMemoryAllocationCommit,
+                     kMemoryProtectRead | kMemoryProtectWrite);
+
+    thread_state_ = std::make_unique<ThreadState>(processor_.get(), 0x100);
+  }
+
+  ~CrtFunctionTest() {
+    thread_state_.reset();
+    processor_.reset();
+    memory_.reset();
+  }
+
+  Memory* memory() const { return memory_.get(); }
+  uint8_t* data() const { return memory_->TranslateVirtual(kDataAddress); }
+
+  // Replaces the routine at the address with the host implementation, like
+  // XexModule::FindCrtFunctions does.
+  uint32_t DeclareExtern(const char* name) {
+    uint32_t address = kExternAddress + extern_count_++ * 8;
+    Function* function;
+    REQUIRE(module_->DeclareFunction(address, &function) ==
+            Symbol::Status::kNew);
+    const CrtFunction* crt_function = FindCrtFunction(name);
+    REQUIRE(crt_function);
+    function->set_name(crt_function->name);
+    static_cast<GuestFunction*>(function)->SetupExtern(crt_function->handler);
+    function->set_status(Symbol::Status::kDeclared);
+    WriteCode(address, {0x44000042, 0x4E800020});
+    return address;
+  }
+
+  uint64_t Call(uint32_t address, std::vector<uint64_t> args) {
+    auto ctx = thread_state_->context();
+    for (size_t i = 0; i < args.size(); ++i) {
+      ctx->r[3 + i] = args[i];
+    }
+    ctx->lr = 0xBCBCBCBC;
+    auto function = processor_->ResolveFunction(address);
+    REQUIRE(function);
+    function->Call(thread_state_.get(), uint32_t(ctx->lr));
+    return ctx->r[3];
+  }
+
+  // Runs the guest and the host routine with the same arguments on the same
+  // initial data, and checks that the results and the data are the same.
+  void Compare(uint32_t guest_address, uint32_t host_address,
+               std::vector<uint64_t> args,
+               std::function<void(uint8_t* data)> initialize) {
+    initialize(data());
+    uint64_t guest_result = Call(guest_address, args);
+    std::vector<uint8_t> guest_data(data(), data() + kDataSize);
+    initialize(data());
+    uint64_t host_result = Call(host_address, args);
+    REQUIRE(host_result == guest_result);
+    REQUIRE(std::memcmp(data(), guest_data.data(), kDataSize) == 0);
+  }
+
+ private:
+  void WriteCode(uint32_t address, std::vector<uint32_t> code) {
+    auto p = memory_->TranslateVirtual<xe::be<uint32_t>*>(address);
+    for (size_t i = 0; i < code.size(); ++i) {
+      p[i] = code[i];
+    }
+  }
+
+  std::unique_ptr<Memory> memory_;
+  std::unique_ptr<Processor> processor_;
+  RawModule* module_ = nullptr;
+  std::unique_ptr<ThreadState> thread_state_;
+  uint32_t extern_count_ = 0;
+};
+
+void FillPattern(uint8_t* data) {
+  for (uint32_t i = 0; i < CrtFunctionTest::kDataSize; ++i) {
+    data[i] = uint8_t(i * 7 + (i >> 8));
+  }
+}
+
+void FillStrings(uint8_t* data) {
+  std::memset(data, 0, CrtFunctionTest::kDataSize);
+  const char* strings[] = {"", "hello", "hellp", "hell", "\x80", "\x7F"};
+  for (size_t i = 0; i < xe::countof(strings); ++i) {
+    std::strcpy(reinterpret_cast<char*>(data) + i * 0x10, strings[i]);
+  }
+  // Crossing a page boundary.
+  std::memset(data + 0xFF0, 'a', 0x20);
+}
+
+TEST_CASE("CRT_MEMMOVE", "[crt]") {
+  CrtFunctionTest test;
+  const uint32_t d = CrtFunctionTest::kDataAddress;
+  for (const char* name : {"memcpy", "memmove"}) {
+    uint32_t host = test.DeclareExtern(name);
+    test.Compare(CrtFunctionTest::kGuestMemmove, host, {d + 0x100, d, 0x80},
+                 FillPattern);
+    test.Compare(CrtFunctionTest::kGuestMemmove, host, {d + 0x1001, d, 0x1800},
+                 FillPattern);
+    test.Compare(CrtFunctionTest::kGuestMemmove, host, {d + 3, d, 0x20},
+                 FillPattern);
+    test.Compare(CrtFunctionTest::kGuestMemmove, host, {d, d + 3, 0x20},
+                 FillPattern);
+    test.Compare(CrtFunctionTest::kGuestMemmove, host, {d, d + 0x100, 0},
+                 FillPattern);
+  }
+}
+
+TEST_CASE("CRT_MEMSET", "[crt]") {
+  CrtFunctionTest test;
+  const uint32_t d = CrtFunctionTest::kDataAddress;
+  uint32_t host = test.DeclareExtern("memset");
+  test.Compare(CrtFunctionTest::kGuestMemset, host, {d + 1, 0x1AB, 0x25},
+               FillPattern);
+  test.Compare(CrtFunctionTest::kGuestMemset, host, {d + 0xF00, 0, 0x300},
+               FillPattern);
+  test.Compare(CrtFunctionTest::kGuestMemset, host, {d, 0xFF, 0}, FillPattern);
+}
+
+TEST_CASE("CRT_STRLEN", "[crt]") {
+  CrtFunctionTest test;
+  const uint32_t d = CrtFunctionTest::kDataAddress;
+  uint32_t host = test.DeclareExtern("strlen");
+  for (uint32_t offset : {0x00, 0x10, 0x40, 0xFF0, 0xFF8}) {
+    test.Compare(CrtFunctionTest::kGuestStrlen, host, {d + offset},
+                 FillStrings);
+  }
+}
+
+TEST_CASE("CRT_STRCMP", "[crt]") {
+  CrtFunctionTest test;
+  const uint32_t d = CrtFunctionTest::kDataAddress;
+  uint32_t host = test.DeclareExtern("strcmp");
+  const std::pair<uint32_t, uint32_t> pairs[] = {
+      {0x00, 0x00}, {0x10, 0x10}, {0x10, 0x20}, {0x20, 0x10}, {0x10, 0x30},
+      {0x30, 0x10}, {0x40, 0x50}, {0x50, 0x40}, {0x00, 0x10}, {0xFF0, 0xFF1},
+  };
+  for (const auto& pair : pairs) {
+    test.Compare(CrtFunctionTest::kGuestStrcmp, host,
+                 {d + pair.first, d + pair.second}, FillStrings);
+  }
+}
+
+TEST_CASE("CRT_MEMSET_PROTECTED", "[crt]") {
+  CrtFunctionTest test;
+  const uint32_t d = CrtFunctionTest::kDataAddress;
+  uint32_t host = test.DeclareExtern("memset");
+  // The guest would fault writing to a read-only page, so the host version
+  // must not write anything there.
+  FillPattern(test.data());
+  test.memory()->LookupHeap(d)->Protect(d + 0x1000, 0x1000,
+                                        kMemoryProtectRead);
+  test.Call(host, {d + 0xF00, 0, 0x200});
+  std::vector<uint8_t> expected(CrtFunctionTest::kDataSize);
+  FillPattern(expected.data());
+  REQUIRE(std::memcmp(test.data(), expected.data(), expected.size()) == 0);
+}
+
+TEST_CASE("CRT_MEMSET_WATCHED", "[crt]") {
+  CrtFunctionTest test;
+  Memory* memory = test.memory();
+  // Writes to watched physical memory must trigger the invalidation callbacks,
+  // like guest stores do.
+  const uint32_t physical_address = 0xA0100000;
+  REQUIRE(memory->LookupHeap(physical_address)
+              ->AllocFixed(physical_address, 0x10000, 0,
+                           kMemoryAllocationReserve | kMemoryAllocationCommit,
+                           kMemoryProtectRead | kMemoryProtectWrite));
+  std::vector<std::pair<uint32_t, uint32_t>> invalidations;
+  void* callback_handle = memory->RegisterPhysicalMemoryInvalidationCallback(
+      [](void* context_ptr, uint32_t physical_address_start, uint32_t length,
+         bool exact_range) {
+        static_cast<std::vector<std::pair<uint32_t, uint32_t>>*>(context_ptr)
+            ->emplace_back(physical_address_start, length);
+        return std::make_pair(physical_address_start, length);
+      },
+      &invalidations);
+  memory->EnablePhysicalMemoryAccessCallbacks(physical_address & 0x1FFFFFFF,
+                                              0x10000, true, false);
+  uint32_t host = test.DeclareExtern("memset");
+  test.Call(host, {physical_address + 0x10, 0xCD, 0x20});
+  REQUIRE(!invalidations.empty());
+  REQUIRE(memory->TranslateVirtual(physical_address)[0x10] == 0xCD);
+  REQUIRE(memory->TranslateVirtual(physical_address)[0x2F] == 0xCD);
+  REQUIRE(memory->TranslateVirtual(physical_address)[0x30] == 0x00);
+  memory->UnregisterPhysicalMemoryInvalidationCallback(callback_handle);
+}
+
+}  // namespace testing
+}  // namespace cpu
+}  // namespace xe
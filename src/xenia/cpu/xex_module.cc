@@ -10,16 +10,24 @@
 #include "xenia/cpu/xex_module.h"
 
 #include <algorithm>
+#include <fstream>
+#include <sstream>  // NOLINT(readability/streams): should be replaced.
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "third_party/fmt/include/fmt/format.h"
 
 #include "xenia/base/byte_order.h"
+#include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
 #include "xenia/cpu/cpu_flags.h"
+#include "xenia/cpu/crt_functions.h"
 #include "xenia/cpu/export_resolver.h"
 #include "xenia/cpu/lzx.h"
+#include "xenia/cpu/ppc/ppc_decode_data.h"
 #include "xenia/cpu/processor.h"
 #include "xenia/kernel/kernel_state.h"
 #include "xenia/kernel/xmodule.h"
@@ -1054,6 +1062,11 @@ bool XexModule::LoadContinue() {
     return false;
   }
 
+  // Replace C runtime routines with host implementations.
+  if (!cvars::crt_function_signatures.empty()) {
+    FindCrtFunctions();
+  }
+
   // Load a specified module map and diff.
   if (cvars::load_module_map.size()) {
     if (!ReadMap(cvars::load_module_map.c_str())) {
@@ -1620,5 +1633,188 @@ bool XexModule::FindSaveRest() {
   return true;
 }
 
+void XexModule::FindCrtFunctions() {
+  struct CrtSignature {
+    const CrtFunction* crt_function;
+    // Instruction words as they appear in disassembly, and masks of the bits
+    // to compare.
+    std::vector<uint32_t> values;
+    std::vector<uint32_t> masks;
+  };
+  std::vector<CrtSignature> signatures;
+
+  std::ifstream infile(cvars::crt_function_signatures);
+  if (!infile) {
+    XELOGE("Failed to open the C runtime function signature file {}",
+           xe::path_to_utf8(cvars::crt_function_signatures));
+    return;
+  }
+  std::stringstream sstream;
+  std::string line;
+  std::string name;
+  std::string word;
+  while (std::getline(infile, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    sstream.clear();
+    sstream.str(line);
+    if (!(sstream >> name)) {
+      continue;
+    }
+    const CrtFunction* crt_function = FindCrtFunction(name);
+    if (!crt_function) {
+      XELOGW("No host implementation of the C runtime function {}", name);
+      continue;
+    }
+    CrtSignature signature;
+    signature.crt_function = crt_function;
+    bool signature_valid = true;
+    while (sstream >> word) {
+      if (word.size() != 8) {
+        signature_valid = false;
+        break;
+      }
+      uint32_t value = 0, mask = 0;
+      for (char c : word) {
+        value <<= 4;
+        mask <<= 4;
+        if (c == '?') {
+          continue;
+        }
+        mask |= 0xF;
+        if (c >= '0' && c <= '9') {
+          value |= uint32_t(c - '0');
+        } else if (c >= 'A' && c <= 'F') {
+          value |= uint32_t(c - 'A' + 10);
+        } else if (c >= 'a' && c <= 'f') {
+          value |= uint32_t(c - 'a' + 10);
+        } else {
+          signature_valid = false;
+          break;
+        }
+      }
+      signature.values.push_back(value);
+      signature.masks.push_back(mask);
+    }
+    // At least the two instructions overwritten by the replacement.
+    if (!signature_valid || signature.values.size() < 2) {
+      XELOGW("Invalid signature of the C runtime function {}", name);
+      continue;
+    }
+    signatures.push_back(std::move(signature));
+  }
+  if (signatures.empty()) {
+    return;
+  }
+
+  // Code ranges and known function entry points. A signature may also match
+  // in the middle of a function, and overwriting that would corrupt it, so
+  // only matches at the start of a code section, at the beginning of a .pdata
+  // entry or at the target of a bl are replaced. Looking at the preceding
+  // instruction isn't enough - a blr or padding may be followed by more code
+  // of the same function, such as the other side of a conditional.
+  std::vector<std::pair<uint32_t, uint32_t>> code_ranges;
+  auto page_size = base_address_ <= 0x90000000 ? 64 * 1024 : 4 * 1024;
+  auto sec_header = xex_security_info();
+  for (uint32_t i = 0, page = 0; i < sec_header->page_descriptor_count; i++) {
+    // Byteswap the bitfield manually.
+    xex2_page_descriptor desc;
+    desc.value = xe::byte_swap(sec_header->page_descriptors[i].value);
+
+    const auto start_address = base_address_ + (page * page_size);
+    const auto end_address = start_address + (desc.page_count * page_size);
+    page += desc.page_count;
+    if (desc.info == XEX_SECTION_CODE) {
+      code_ranges.emplace_back(start_address, end_address);
+    }
+  }
+  std::vector<uint32_t> entry_points;
+  for (const auto& code_range : code_ranges) {
+    entry_points.push_back(code_range.first);
+  }
+  const PESection* pdata_section = GetPESection(".pdata");
+  if (pdata_section) {
+    // 8-byte entries - the function start address, and packed prolog and
+    // function lengths and flags.
+    auto pdata = memory()->TranslateVirtual<const xe::be<uint32_t>*>(
+        pdata_section->address);
+    for (uint32_t i = 0; i < pdata_section->size / 8; ++i) {
+      uint32_t begin_address = pdata[i * 2];
+      if (begin_address) {
+        entry_points.push_back(begin_address);
+      }
+    }
+  }
+  for (const auto& code_range : code_ranges) {
+    auto code =
+        memory()->TranslateVirtual<const xe::be<uint32_t>*>(code_range.first);
+    uint32_t code_count = (code_range.second - code_range.first) / 4;
+    for (uint32_t j = 0; j < code_count; ++j) {
+      // bl with a relative target.
+      uint32_t word = code[j];
+      if ((word & 0xFC000003) != 0x48000001) {
+        continue;
+      }
+      entry_points.push_back(code_range.first + j * 4 +
+                             uint32_t(ppc::XEEXTS26(word & 0x03FFFFFC)));
+    }
+  }
+  std::sort(entry_points.begin(), entry_points.end());
+  entry_points.erase(std::unique(entry_points.begin(), entry_points.end()),
+                     entry_points.end());
+
+  for (const auto& code_range : code_ranges) {
+    const auto start_address = code_range.first;
+    auto code =
+        memory()->TranslateVirtual<const xe::be<uint32_t>*>(start_address);
+    uint32_t code_count = (code_range.second - start_address) / 4;
+    for (auto entry_it = std::lower_bound(entry_points.begin(),
+                                          entry_points.end(), start_address);
+         entry_it != entry_points.end() && *entry_it < code_range.second;
+         ++entry_it) {
+      uint32_t address = *entry_it;
+      if (address & 3) {
+        continue;
+      }
+      uint32_t j = (address - start_address) / 4;
+      for (const CrtSignature& signature : signatures) {
+        size_t signature_count = signature.values.size();
+        if (signature_count > code_count - j) {
+          continue;
+        }
+        size_t k = 0;
+        while (k < signature_count &&
+               (code[j + k] & signature.masks[k]) == signature.values[k]) {
+          ++k;
+        }
+        if (k < signature_count) {
+          continue;
+        }
+        Function* function;
+        if (DeclareFunction(address, &function) != Symbol::Status::kNew) {
+          // Already known as something else (like __savegprlr_*).
+          break;
+        }
+        function->set_name(signature.crt_function->name);
+        static_cast<GuestFunction*>(function)->SetupExtern(
+            signature.crt_function->handler);
+        function->set_status(Symbol::Status::kDeclared);
+        // Like imports, calling the host function via a syscall:
+        //     sc 2
+        //     blr
+        // The rest of the guest code of the routine is left in place, but it's
+        // not reachable from the entry point anymore.
+        uint8_t* p = memory()->TranslateVirtual(address);
+        xe::store_and_swap<uint32_t>(p + 0x0, 0x44000042);
+        xe::store_and_swap<uint32_t>(p + 0x4, 0x4E800020);
+        XELOGI("Replaced the C runtime function {} at {:08X}",
+               signature.crt_function->name, address);
+        break;
+      }
+    }
+  }
+}
+
 }  // namespace cpu
 }  // namespace xe
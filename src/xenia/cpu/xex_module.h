@@ -190,6 +190,7 @@ class XexModule : public xe::cpu::Module {
   bool SetupLibraryImports(const std::string_view name,
                            const xex2_import_library* library);
   bool FindSaveRest();
+  void FindCrtFunctions();
 
   Processor* processor_ = nullptr;
   kernel::KernelState* kernel_state_ = nullptr;
@@ -353,7 +353,9 @@ X_STATUS Emulator::LaunchStfsContainer(const std::filesystem::path& path) {
   auto mount_path = "\\Device\\Cdrom0";
 
   // Register the container in the virtual filesystem.
-  auto device = std::make_unique<vfs::StfsContainerDevice>(mount_path, path);
+  auto device = std::make_unique<vfs::StfsContainerDevice>(
+      mount_path, path,
+      cache_root_.empty() ? std::filesystem::path() : cache_root_ / "vfs");
   if (!device->Initialize()) {
     xe::FatalError(
         "Unable to mount STFS container; file not found or corrupt.");
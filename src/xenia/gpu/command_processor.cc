@@ -28,6 +28,12 @@
 #include "xenia/kernel/kernel_state.h"
 #include "xenia/kernel/user_module.h"
 
+DEFINE_bool(gpu_indirect_buffer_cache, true,
+            "Replay indirect buffers not modified since their previous "
+            "execution from a cache of their pre-decoded register writes "
+            "instead of parsing all of their packets again.",
+            "GPU");
+
 namespace xe {
 namespace gpu {
 
@@ -179,7 +185,7 @@ void CommandProcessor::CallInThread(std::function<void()> fn) {
   }
 }
 
-void CommandProcessor::ClearCaches() {}
+void CommandProcessor::ClearCaches() { ClearIndirectBufferCache(); }
 
 void CommandProcessor::SetDesiredSwapPostEffect(
     SwapPostEffect swap_post_effect) {
@@ -559,19 +565,230 @@ void CommandProcessor::ExecuteIndirectBuffer(uint32_t ptr, uint32_t count) {
 
   trace_writer_.WriteIndirectBufferStart(ptr, count * sizeof(uint32_t));
 
+  // The cache doesn't go through the packet parsing that the trace writer
+  // needs to see.
+  CachedIndirectBuffer* cached_indirect_buffer = nullptr;
+  if (cvars::gpu_indirect_buffer_cache && count && !trace_writer_.is_open()) {
+    cached_indirect_buffer = GetCachedIndirectBuffer(ptr, count);
+  }
+
   // Execute commands!
+  ++indirect_buffer_depth_;
   RingBuffer reader(memory_->TranslatePhysical(ptr), count * sizeof(uint32_t));
   reader.set_write_offset(count * sizeof(uint32_t));
-  do {
+  bool parse_packets = true;
+  if (cached_indirect_buffer) {
+    // If the buffer has been modified by one of its own packets, parse the
+    // rest of it (if anything is left) from the guest memory.
+    parse_packets =
+        !ReplayIndirectBuffer(*cached_indirect_buffer, reader) &&
+        reader.read_count();
+  }
+  if (parse_packets) {
+    do {
+      if (!ExecutePacket(&reader)) {
+        // Return up a level if we encounter a bad packet.
+        XELOGE("**** INDIRECT RINGBUFFER: Failed to execute packet.");
+        assert_always();
+        break;
+      }
+    } while (reader.read_count());
+  }
+  --indirect_buffer_depth_;
+
+  trace_writer_.WriteIndirectBufferEnd();
+}
+
+void CommandProcessor::ClearIndirectBufferCache() {
+  if (indirect_buffer_cache_shared_memory_) {
+    auto global_lock = global_critical_region_.Acquire();
+    for (const auto& indirect_buffer_pair : indirect_buffer_cache_) {
+      if (indirect_buffer_pair.second->watch_handle) {
+        indirect_buffer_cache_shared_memory_->UnwatchMemoryRange(
+            indirect_buffer_pair.second->watch_handle);
+      }
+    }
+  }
+  indirect_buffer_cache_.clear();
+  indirect_buffer_cache_shared_memory_ = nullptr;
+}
+
+void CommandProcessor::IndirectBufferWatchCallback(
+    const std::unique_lock<std::recursive_mutex>& global_lock, void* context,
+    void* data, uint64_t argument, bool invalidated_by_gpu) {
+  auto& indirect_buffer = *static_cast<CachedIndirectBuffer*>(data);
+  indirect_buffer.watch_handle = nullptr;
+  ++indirect_buffer.invalidation_count;
+  indirect_buffer.outdated.store(true, std::memory_order_release);
+}
+
+CommandProcessor::CachedIndirectBuffer*
+CommandProcessor::GetCachedIndirectBuffer(uint32_t ptr, uint32_t count) {
+  uint64_t key = uint64_t(ptr) | (uint64_t(count) << 32);
+  auto it = indirect_buffer_cache_.find(key);
+  if (it != indirect_buffer_cache_.end()) {
+    CachedIndirectBuffer& indirect_buffer = *it->second;
+    if (!indirect_buffer.outdated.load(std::memory_order_acquire)) {
+      // Not written since it was decoded.
+      ++indirect_buffer_cache_hits_;
+      return &indirect_buffer;
+    }
+    ++indirect_buffer_cache_misses_;
+    // Keep the entry so the buffer isn't watched and decoded again, as every
+    // watch makes the CPU writes to it trap.
+    if (indirect_buffer.invalidation_count >=
+        kIndirectBufferCacheMaxInvalidations) {
+      indirect_buffer.uncacheable = true;
+    }
+    if (indirect_buffer.uncacheable) {
+      return nullptr;
+    }
+  } else {
+    ++indirect_buffer_cache_misses_;
+  }
+
+  SharedMemory* shared_memory = GetSharedMemoryForIndirectBufferCache();
+  if (!shared_memory) {
+    return nullptr;
+  }
+  if (it == indirect_buffer_cache_.end()) {
+    if (indirect_buffer_cache_.size() >= kIndirectBufferCacheMaxSize) {
+      // Buffers up the stack may be replayed from the cache currently.
+      if (indirect_buffer_depth_) {
+        return nullptr;
+      }
+      ClearIndirectBufferCache();
+    }
+    it = indirect_buffer_cache_
+             .emplace(key, std::make_unique<CachedIndirectBuffer>())
+             .first;
+  }
+  CachedIndirectBuffer& indirect_buffer = *it->second;
+  indirect_buffer_cache_shared_memory_ = shared_memory;
+
+  // The buffer is only read on the CPU, so it's not uploaded, but protected
+  // for the watch to be triggered by CPU writes. Watch before protecting and
+  // decoding, so writes after the decoding are caught.
+  uint32_t length = count * sizeof(uint32_t);
+  {
+    auto global_lock = global_critical_region_.Acquire();
+    assert_null(indirect_buffer.watch_handle);
+    indirect_buffer.watch_handle = shared_memory->WatchMemoryRange(
+        ptr, length, IndirectBufferWatchCallback, this, &indirect_buffer, 0);
+    indirect_buffer.outdated.store(false, std::memory_order_relaxed);
+  }
+  if (indirect_buffer.watch_handle) {
+    shared_memory->ProtectRangeFromCpuWrites(ptr, length);
+  }
+  if (!indirect_buffer.watch_handle ||
+      !DecodeIndirectBuffer(ptr, count, indirect_buffer)) {
+    // Can't track the writes, or the buffer needs the error handling of the
+    // regular parsing - parse it on every execution.
+    auto global_lock = global_critical_region_.Acquire();
+    if (indirect_buffer.watch_handle) {
+      shared_memory->UnwatchMemoryRange(indirect_buffer.watch_handle);
+      indirect_buffer.watch_handle = nullptr;
+    }
+    indirect_buffer.outdated.store(true, std::memory_order_relaxed);
+    indirect_buffer.uncacheable = true;
+    return nullptr;
+  }
+  return &indirect_buffer;
+}
+
+bool CommandProcessor::DecodeIndirectBuffer(
+    uint32_t ptr, uint32_t count, CachedIndirectBuffer& indirect_buffer) {
+  indirect_buffer.register_writes.clear();
+  indirect_buffer.type3_packets.clear();
+  auto dwords =
+      reinterpret_cast<const uint32_t*>(memory_->TranslatePhysical(ptr));
+  uint32_t offset = 0;
+  while (offset < count) {
+    const uint32_t packet = xe::load_and_swap<uint32_t>(dwords + offset);
+    uint32_t count_remaining = count - offset - 1;
+    if (packet == 0) {
+      ++offset;
+      continue;
+    }
+    switch (packet >> 30) {
+      case 0x00: {
+        uint32_t packet_count = ((packet >> 16) & 0x3FFF) + 1;
+        if (count_remaining < packet_count) {
+          return false;
+        }
+        uint32_t base_index = (packet & 0x7FFF);
+        uint32_t write_one_reg = (packet >> 15) & 0x1;
+        for (uint32_t m = 0; m < packet_count; m++) {
+          indirect_buffer.register_writes.emplace_back(
+              write_one_reg ? base_index : base_index + m,
+              xe::load_and_swap<uint32_t>(dwords + offset + 1 + m));
+        }
+        offset += 1 + packet_count;
+      } break;
+      case 0x01: {
+        // The regular parsing wraps around the end of the buffer here.
+        if (count_remaining < 2) {
+          return false;
+        }
+        indirect_buffer.register_writes.emplace_back(
+            packet & 0x7FF, xe::load_and_swap<uint32_t>(dwords + offset + 1));
+        indirect_buffer.register_writes.emplace_back(
+            (packet >> 11) & 0x7FF,
+            xe::load_and_swap<uint32_t>(dwords + offset + 2));
+        offset += 3;
+      } break;
+      case 0x02:
+        ++offset;
+        break;
+      case 0x03: {
+        uint32_t packet_count = ((packet >> 16) & 0x3FFF) + 1;
+        if (count_remaining < packet_count) {
+          return false;
+        }
+        CachedIndirectBuffer::Type3Packet& type3_packet =
+            indirect_buffer.type3_packets.emplace_back();
+        type3_packet.offset = offset;
+        type3_packet.register_writes_before =
+            uint32_t(indirect_buffer.register_writes.size());
+        offset += 1 + packet_count;
+      } break;
+    }
+  }
+  return true;
+}
+
+bool CommandProcessor::ReplayIndirectBuffer(
+    const CachedIndirectBuffer& indirect_buffer, RingBuffer& reader) {
+  uint32_t register_write_count =
+      uint32_t(indirect_buffer.register_writes.size());
+  uint32_t register_write_index = 0;
+  for (const CachedIndirectBuffer::Type3Packet& type3_packet :
+       indirect_buffer.type3_packets) {
+    for (; register_write_index < type3_packet.register_writes_before;
+         ++register_write_index) {
+      const std::pair<uint32_t, uint32_t>& register_write =
+          indirect_buffer.register_writes[register_write_index];
+      WriteRegister(register_write.first, register_write.second);
+    }
+    reader.set_read_offset(type3_packet.offset * sizeof(uint32_t));
     if (!ExecutePacket(&reader)) {
-      // Return up a level if we encounter a bad packet.
       XELOGE("**** INDIRECT RINGBUFFER: Failed to execute packet.");
       assert_always();
-      break;
+      indirect_buffer_cache_register_writes_replayed_ += register_write_index;
+      return true;
     }
-  } while (reader.read_count());
-
-  trace_writer_.WriteIndirectBufferEnd();
+    if (indirect_buffer.outdated.load(std::memory_order_acquire)) {
+      indirect_buffer_cache_register_writes_replayed_ += register_write_index;
+      return false;
+    }
+  }
+  for (; register_write_index < register_write_count; ++register_write_index) {
+    const std::pair<uint32_t, uint32_t>& register_write =
+        indirect_buffer.register_writes[register_write_index];
+    WriteRegister(register_write.first, register_write.second);
+  }
+  indirect_buffer_cache_register_writes_replayed_ += register_write_count;
+  return true;
 }
 
 void CommandProcessor::ExecutePacket(uint32_t ptr, uint32_t count) {
@@ -918,6 +1135,16 @@ bool CommandProcessor::ExecutePacketType3_XE_SWAP(RingBuffer* reader,
 
   IssueSwap(frontbuffer_ptr, frontbuffer_width, frontbuffer_height);
 
+  COUNT_profile_set("gpu/indirect_buffer_cache/hits",
+                    indirect_buffer_cache_hits_);
+  COUNT_profile_set("gpu/indirect_buffer_cache/misses",
+                    indirect_buffer_cache_misses_);
+  COUNT_profile_set("gpu/indirect_buffer_cache/register_writes_replayed",
+                    indirect_buffer_cache_register_writes_replayed_);
+  indirect_buffer_cache_hits_ = 0;
+  indirect_buffer_cache_misses_ = 0;
+  indirect_buffer_cache_register_writes_replayed_ = 0;
+
   ++counter_;
   return true;
 }
@@ -1235,29 +1462,54 @@ bool CommandProcessor::ExecutePacketType3_EVENT_WRITE_ZPD(RingBuffer* reader,
 
   // Occlusion queries:
   // This command is send on query begin and end.
-  // As a workaround report some fixed amount of passed samples.
-  auto fake_sample_count = cvars::query_occlusion_fake_sample_count;
-  if (fake_sample_count >= 0) {
-    auto* pSampleCounts =
-        memory_->TranslatePhysical<xe_gpu_depth_sample_counts*>(
-            register_file_->values[XE_GPU_REG_RB_SAMPLE_COUNT_ADDR].u32);
-    // 0xFFFFFEED is written to this two locations by D3D only on D3DISSUE_END
-    // and used to detect a finished query.
-    bool is_end_via_z_pass = pSampleCounts->ZPass_A == kQueryFinished &&
-                             pSampleCounts->ZPass_B == kQueryFinished;
-    // Older versions of D3D also checks for ZFail (4D5307D5).
-    bool is_end_via_z_fail = pSampleCounts->ZFail_A == kQueryFinished &&
-                             pSampleCounts->ZFail_B == kQueryFinished;
-    std::memset(pSampleCounts, 0, sizeof(xe_gpu_depth_sample_counts));
-    if (is_end_via_z_pass || is_end_via_z_fail) {
-      pSampleCounts->ZPass_A = fake_sample_count;
-      pSampleCounts->Total_A = fake_sample_count;
+  uint32_t sample_count_address =
+      register_file_->values[XE_GPU_REG_RB_SAMPLE_COUNT_ADDR].u32;
+  auto* pSampleCounts =
+      memory_->TranslatePhysical<xe_gpu_depth_sample_counts*>(
+          sample_count_address);
+  // 0xFFFFFEED is written to this two locations by D3D only on D3DISSUE_END
+  // and used to detect a finished query.
+  bool is_end_via_z_pass = pSampleCounts->ZPass_A == kQueryFinished &&
+                           pSampleCounts->ZPass_B == kQueryFinished;
+  // Older versions of D3D also checks for ZFail (4D5307D5).
+  bool is_end_via_z_fail = pSampleCounts->ZFail_A == kQueryFinished &&
+                           pSampleCounts->ZFail_B == kQueryFinished;
+  if (is_end_via_z_pass || is_end_via_z_fail) {
+    // The guest polls the structure until the markers are overwritten, so if
+    // the host measures the samples, the result is written when it's ready.
+    if (!EndOcclusionQuery(sample_count_address)) {
+      // As a workaround report some fixed amount of passed samples.
+      WriteFakeOcclusionQuerySampleCount(sample_count_address);
     }
+  } else if (BeginOcclusionQuery(sample_count_address) ||
+             cvars::query_occlusion_fake_sample_count >= 0) {
+    std::memset(pSampleCounts, 0, sizeof(xe_gpu_depth_sample_counts));
   }
 
   return true;
 }
 
+void CommandProcessor::WriteOcclusionQuerySampleCount(
+    uint32_t sample_count_address, uint32_t sample_count) {
+  auto* pSampleCounts =
+      memory_->TranslatePhysical<xe_gpu_depth_sample_counts*>(
+          sample_count_address);
+  std::memset(pSampleCounts, 0, sizeof(xe_gpu_depth_sample_counts));
+  pSampleCounts->ZPass_A = sample_count;
+  pSampleCounts->Total_A = sample_count;
+}
+
+bool CommandProcessor::WriteFakeOcclusionQuerySampleCount(
+    uint32_t sample_count_address) {
+  auto fake_sample_count = cvars::query_occlusion_fake_sample_count;
+  if (fake_sample_count < 0) {
+    return false;
+  }
+  WriteOcclusionQuerySampleCount(sample_count_address,
+                                 uint32_t(fake_sample_count));
+  return true;
+}
+
 bool CommandProcessor::ExecutePacketType3Draw(RingBuffer* reader,
                                               uint32_t packet,
                                               const char* opcode_name,
@@ -17,12 +17,16 @@
 #include <mutex>
 #include <queue>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "xenia/base/mutex.h"
 #include "xenia/base/ring_buffer.h"
 #include "xenia/base/threading.h"
 #include "xenia/gpu/register_file.h"
 #include "xenia/gpu/registers.h"
+#include "xenia/gpu/shared_memory.h"
 #include "xenia/gpu/trace_writer.h"
 #include "xenia/gpu/xenos.h"
 #include "xenia/kernel/xthread.h"
@@ -169,6 +173,16 @@ class CommandProcessor {
   uint32_t ExecutePrimaryBuffer(uint32_t start_index, uint32_t end_index);
   virtual void OnPrimaryBufferEnd() {}
   void ExecuteIndirectBuffer(uint32_t ptr, uint32_t length);
+
+  // Returns the shared memory to watch cached indirect buffers with, or
+  // nullptr if indirect buffers can't be cached currently.
+  virtual SharedMemory* GetSharedMemoryForIndirectBufferCache() {
+    return nullptr;
+  }
+  // Stops watching the cached indirect buffers and drops them. Must be called
+  // while the shared memory is still alive (in ShutdownContext, for example).
+  void ClearIndirectBufferCache();
+
   bool ExecutePacket(RingBuffer* reader);
   bool ExecutePacketType0(RingBuffer* reader, uint32_t packet);
   bool ExecutePacketType1(RingBuffer* reader, uint32_t packet);
@@ -238,6 +252,23 @@ class CommandProcessor {
                          bool major_mode_explicit) = 0;
   virtual bool IssueCopy() = 0;
 
+  // Occlusion query hooks, called when EVENT_WRITE_ZPD begins or ends a query
+  // with the xe_gpu_depth_sample_counts at the address. If the implementation
+  // returns true from EndOcclusionQuery, it takes the responsibility of writing
+  // the result (with WriteOcclusionQuerySampleCount) later, otherwise the fake
+  // sample count is written immediately.
+  virtual bool BeginOcclusionQuery(uint32_t sample_count_address) {
+    return false;
+  }
+  virtual bool EndOcclusionQuery(uint32_t sample_count_address) {
+    return false;
+  }
+  void WriteOcclusionQuerySampleCount(uint32_t sample_count_address,
+                                      uint32_t sample_count);
+  // Writes the sample count from query_occlusion_fake_sample_count if it's not
+  // negative, returns whether anything was written.
+  bool WriteFakeOcclusionQuerySampleCount(uint32_t sample_count_address);
+
   // "Actual" is for the command processor thread, to be read by the
   // implementations.
   SwapPostEffect GetActualSwapPostEffect() const {
@@ -295,6 +326,52 @@ class CommandProcessor {
   SwapPostEffect swap_post_effect_actual_ = SwapPostEffect::kNone;
 
  private:
+  // Indirect buffer with the type 0 and type 1 packets already decoded into
+  // byte-swapped register writes. Type 3 packets have side effects other than
+  // register writes and are executed from the guest memory when replaying.
+  struct CachedIndirectBuffer {
+    struct Type3Packet {
+      // Offset of the packet header in the indirect buffer, in dwords.
+      uint32_t offset;
+      // Number of register writes to perform before executing the packet.
+      uint32_t register_writes_before;
+    };
+    std::vector<std::pair<uint32_t, uint32_t>> register_writes;
+    std::vector<Type3Packet> type3_packets;
+    SharedMemory::WatchHandle watch_handle = nullptr;
+    std::atomic<bool> outdated{true};
+    // Modified only by the watch callback, and read when outdated.
+    uint32_t invalidation_count = 0;
+    // Rewritten too often for decoding to pay off, can't be watched, or needs
+    // the error handling of the regular parsing.
+    bool uncacheable = false;
+  };
+  static constexpr size_t kIndirectBufferCacheMaxSize = 4096;
+  static constexpr uint32_t kIndirectBufferCacheMaxInvalidations = 4;
+  static void IndirectBufferWatchCallback(
+      const std::unique_lock<std::recursive_mutex>& global_lock, void* context,
+      void* data, uint64_t argument, bool invalidated_by_gpu);
+  // Returns the up-to-date cached indirect buffer, decoding it if needed, or
+  // nullptr if it can't be cached.
+  CachedIndirectBuffer* GetCachedIndirectBuffer(uint32_t ptr, uint32_t count);
+  bool DecodeIndirectBuffer(uint32_t ptr, uint32_t count,
+                            CachedIndirectBuffer& indirect_buffer);
+  // Returns false if the indirect buffer has been modified during the replay,
+  // and the rest of it must be parsed from the read offset of the reader.
+  bool ReplayIndirectBuffer(const CachedIndirectBuffer& indirect_buffer,
+                            RingBuffer& reader);
+
+  xe::global_critical_region global_critical_region_;
+  // Guest address and dword count -> indirect buffer. Nodes are referenced by
+  // the watches, so they're stored as pointers.
+  std::unordered_map<uint64_t, std::unique_ptr<CachedIndirectBuffer>>
+      indirect_buffer_cache_;
+  SharedMemory* indirect_buffer_cache_shared_memory_ = nullptr;
+  uint32_t indirect_buffer_depth_ = 0;
+  uint32_t indirect_buffer_cache_hits_ = 0;
+  uint32_t indirect_buffer_cache_misses_ = 0;
+  uint32_t indirect_buffer_cache_register_writes_replayed_ = 0;
+
   reg::DC_LUT_30_COLOR gamma_ramp_256_entry_table_[256] = {};
   reg::DC_LUT_PWL_DATA gamma_ramp_pwl_rgb_[128][3] = {};
   uint32_t gamma_ramp_rw_component_ = 0;
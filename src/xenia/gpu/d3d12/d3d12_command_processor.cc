@@ -1656,6 +1656,7 @@ void D3D12CommandProcessor::ShutdownContext() {
 
   render_target_cache_.reset();
 
+  ClearIndirectBufferCache();
   shared_memory_.reset();
 
   deferred_command_list_.Reset();
@@ -2087,6 +2088,10 @@ void D3D12CommandProcessor::OnPrimaryBufferEnd() {
   }
 }
 
+SharedMemory* D3D12CommandProcessor::GetSharedMemoryForIndirectBufferCache() {
+  return shared_memory_.get();
+}
+
 Shader* D3D12CommandProcessor::LoadShader(xenos::ShaderType shader_type,
                                           uint32_t guest_address,
                                           const uint32_t* host_address,
@@ -19,6 +19,7 @@
 #include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
+#include "xenia/base/memory.h"
 #include "xenia/base/profiling.h"
 #include "xenia/gpu/register_file.h"
 #include "xenia/gpu/registers.h"
@@ -278,7 +279,8 @@ void PrimitiveProcessor::ClearPerFrameCache() {
               sizeof(cache_buckets_non_empty_l2_));
 }
 
-bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
+bool PrimitiveProcessor::Process(ProcessingResult& result_out,
+                                 bool host_endian_indices) {
   SCOPE_profile_cpu_f("gpu");
 
   const RegisterFile& regs = register_file_;
@@ -822,6 +824,72 @@ bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
         }
         cache_transaction.SetNewResult(cacheable);
       }
+    } else if (host_endian_indices && !guest_primitive_reset_enabled &&
+               (guest_index_endian != xenos::Endian::kNone ||
+                (guest_index_format == xenos::IndexFormat::kInt32 &&
+                 !full_32bit_vertex_indices_used_))) {
+      // The host vertex index must be the guest one, and the fixed-function
+      // vertex input can't swap or mask it - pre-swap and pre-mask the
+      // indices. Without primitive reset, there's nothing else to convert.
+      // Writing to the trace irrespective of the cache lookup result because
+      // cache behavior depends on runtime configuration and state.
+      trace_writer_.WriteMemoryRead(guest_index_base,
+                                    guest_index_buffer_needed_bytes);
+      CacheTransaction cache_transaction(
+          *this, CacheKey(guest_index_base, guest_draw_vertex_count,
+                          guest_index_format, guest_index_endian, false,
+                          xenos::PrimitiveType::kNone, true));
+      if (cache_transaction.GetFoundResult()) {
+        cacheable = *cache_transaction.GetFoundResult();
+      } else {
+        cacheable.host_draw_vertex_count = guest_draw_vertex_count;
+        cacheable.index_buffer_type = ProcessedIndexBufferType::kHostConverted;
+        cacheable.host_shader_index_endian = xenos::Endian::kNone;
+        cacheable.host_primitive_reset_enabled = false;
+        void* host_indices_ptr = RequestHostConvertedIndexBufferForCurrentFrame(
+            guest_index_format, guest_draw_vertex_count, true, guest_index_base,
+            cacheable.host_index_buffer_handle);
+        if (!host_indices_ptr) {
+          return false;
+        }
+        const void* guest_indices_ptr =
+            memory_.TranslatePhysical(guest_index_base);
+        if (guest_index_format == xenos::IndexFormat::kInt16) {
+          // Normalized to 8-in-16 if swapped at all.
+          xe::copy_and_swap_16_unaligned(host_indices_ptr, guest_indices_ptr,
+                                         guest_draw_vertex_count);
+        } else {
+          auto host_indices = reinterpret_cast<uint32_t*>(host_indices_ptr);
+          auto guest_indices =
+              reinterpret_cast<const uint32_t*>(guest_indices_ptr);
+          switch (guest_index_endian) {
+            case xenos::Endian::kNone:
+              TransformIndices(host_indices, guest_indices,
+                               guest_draw_vertex_count,
+                               To24NonSwappingIndexTransform());
+              break;
+            case xenos::Endian::k8in16:
+              TransformIndices(host_indices, guest_indices,
+                               guest_draw_vertex_count,
+                               To24Swapping8In16IndexTransform());
+              break;
+            case xenos::Endian::k8in32:
+              TransformIndices(host_indices, guest_indices,
+                               guest_draw_vertex_count,
+                               To24Swapping8In32IndexTransform());
+              break;
+            case xenos::Endian::k16in32:
+              TransformIndices(host_indices, guest_indices,
+                               guest_draw_vertex_count,
+                               To24Swapping16In32IndexTransform());
+              break;
+            default:
+              assert_unhandled_case(guest_index_endian);
+              return false;
+          }
+        }
+        cache_transaction.SetNewResult(cacheable);
+      }
     } else {
       // Using the same indices on the host as on the guest, either directly or
       // (for backends not supporting full 32-bit indices, thus unable to
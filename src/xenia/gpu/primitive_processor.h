@@ -179,7 +179,12 @@ class PrimitiveProcessor {
 
   // Submission must be open to call (may request the index buffer in the shared
   // memory).
-  bool Process(ProcessingResult& result_out);
+  // If host_endian_indices is true, guest index buffers that would be
+  // endian-swapped or masked in the vertex shader are pre-swapped and
+  // pre-masked (except for those with primitive reset, which is used only for
+  // strips), so the host vertex index is the guest one, as needed for the
+  // fixed-function vertex input.
+  bool Process(ProcessingResult& result_out, bool host_endian_indices = false);
 
   // Invalidates the cache within the range.
   std::pair<uint32_t, uint32_t> MemoryInvalidationCallback(
@@ -527,6 +532,14 @@ class PrimitiveProcessor {
     }
   };
 
+  template <typename Index, typename IndexTransform>
+  static void TransformIndices(Index* dest, const Index* source, uint32_t count,
+                               const IndexTransform& transform) {
+    for (uint32_t i = 0; i < count; ++i) {
+      dest[i] = transform(source[i]);
+    }
+  }
+
   static constexpr uint32_t GetTwoTriangleStripIndexCount(
       uint32_t strip_count) {
     // 4 vertices per strip, and primitive restarts between strips.
@@ -731,13 +744,16 @@ class PrimitiveProcessor {
       uint32_t is_reset_enabled : 1;  // 53
       // kNone if not changing the type (like only processing the reset index).
       xenos::PrimitiveType conversion_guest_primitive_type : 6;  // 59
+      // Pre-swapped and pre-masked for the host without other changes.
+      uint32_t is_pre_swapped : 1;  // 60
     };
 
     CacheKey() : key(0) { static_assert_size(*this, sizeof(key)); }
     CacheKey(uint32_t base, uint32_t count, xenos::IndexFormat format,
              xenos::Endian endian, bool is_reset_enabled,
              xenos::PrimitiveType conversion_guest_primitive_type =
-                 xenos::PrimitiveType::kNone) {
+                 xenos::PrimitiveType::kNone,
+             bool is_pre_swapped = false) {
       // Clear unused bits, then set each field explicitly, not via the
       // initializer list (which causes `uint64_t key = 0;` to be ignored, and
       // also can't contain initializers for aliasing union members).
@@ -748,6 +764,7 @@ class PrimitiveProcessor {
       this->endian = endian;
       this->is_reset_enabled = is_reset_enabled;
       this->conversion_guest_primitive_type = conversion_guest_primitive_type;
+      this->is_pre_swapped = is_pre_swapped;
     }
 
     struct Hasher {
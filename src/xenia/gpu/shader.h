@@ -481,6 +481,10 @@ struct ParsedVertexFetchInstruction {
   // Attributes describing the fetch operation.
   Attributes attributes;
 
+  // Index of the instruction in the ucode (in 3-dword units), for matching it
+  // with the information gathered during the ucode analysis.
+  uint32_t instruction_address = 0;
+
   // Disassembles the instruction into ucode assembly text.
   void Disassemble(StringBuffer* out) const;
 };
@@ -701,6 +705,11 @@ class Shader {
     struct Attribute {
       // Fetch instruction with all parameters.
       ParsedVertexFetchInstruction fetch_instr;
+      // Whether the fetch is always indexed by the unmodified r0.x of a vertex
+      // shader - the vertex index written before the shader starts - on every
+      // control flow path to it, so the host may fetch the data for it with
+      // the fixed-function vertex input.
+      bool is_indexed_by_vertex_index = false;
     };
 
     // Index within the vertex binding listing.
@@ -1058,6 +1067,10 @@ class Shader {
   uint32_t writes_point_size_edge_flag_kill_vertex_ = 0;
   uint32_t writes_color_targets_ = 0b0000;
   bool uses_register_dynamic_addressing_ = false;
+  // Ucode analysis state - whether r0 may have been overwritten, or control
+  // flow that may reach later instructions with r0 overwritten has been
+  // encountered, before the current instruction.
+  bool vertex_index_register_may_be_modified_ = false;
   bool kills_pixels_ = false;
   bool uses_texture_fetch_instruction_results_ = false;
   bool writes_depth_ = false;
@@ -1084,7 +1097,7 @@ class Shader {
       ucode::VertexFetchInstruction& previous_vfetch_full,
       uint32_t& unique_texture_bindings, StringBuffer& ucode_disasm_buffer);
   void GatherVertexFetchInformation(
-      const ucode::VertexFetchInstruction& op,
+      const ucode::VertexFetchInstruction& op, uint32_t instruction_address,
       ucode::VertexFetchInstruction& previous_vfetch_full,
       StringBuffer& ucode_disasm_buffer);
   void GatherTextureFetchInformation(const ucode::TextureFetchInstruction& op,
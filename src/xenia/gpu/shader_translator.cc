@@ -102,6 +102,8 @@ void Shader::AnalyzeUcode(StringBuffer& ucode_disasm_buffer) {
       if (label_addresses_.find(cf_index) != label_addresses_.end()) {
         ucode_disasm_buffer.AppendFormat("                label L{}\n",
                                          cf_index);
+        // May be reached after anything, including via a backward jump.
+        vertex_index_register_may_be_modified_ = true;
       }
       ucode_disasm_buffer.AppendFormat("/* {:4d}.{} */ ", i, j);
 
@@ -139,6 +141,7 @@ void Shader::AnalyzeUcode(StringBuffer& ucode_disasm_buffer) {
           ParsedLoopStartInstruction instr;
           ParseControlFlowLoopStart(cf.loop_start, cf_index, instr);
           instr.Disassemble(&ucode_disasm_buffer);
+          vertex_index_register_may_be_modified_ = true;
           constant_register_map_.loop_bitmap |= uint32_t(1)
                                                 << instr.loop_constant_index;
         } break;
@@ -146,6 +149,7 @@ void Shader::AnalyzeUcode(StringBuffer& ucode_disasm_buffer) {
           ParsedLoopEndInstruction instr;
           ParseControlFlowLoopEnd(cf.loop_end, cf_index, instr);
           instr.Disassemble(&ucode_disasm_buffer);
+          vertex_index_register_may_be_modified_ = true;
           constant_register_map_.loop_bitmap |= uint32_t(1)
                                                 << instr.loop_constant_index;
         } break;
@@ -153,6 +157,7 @@ void Shader::AnalyzeUcode(StringBuffer& ucode_disasm_buffer) {
           ParsedCallInstruction instr;
           ParseControlFlowCondCall(cf.cond_call, cf_index, instr);
           instr.Disassemble(&ucode_disasm_buffer);
+          vertex_index_register_may_be_modified_ = true;
           if (instr.type == ParsedCallInstruction::Type::kConditional) {
             bool_constant_index = instr.bool_constant_index;
           }
@@ -161,11 +166,13 @@ void Shader::AnalyzeUcode(StringBuffer& ucode_disasm_buffer) {
           ParsedReturnInstruction instr;
           ParseControlFlowReturn(cf.ret, cf_index, instr);
           instr.Disassemble(&ucode_disasm_buffer);
+          vertex_index_register_may_be_modified_ = true;
         } break;
         case ControlFlowOpcode::kCondJmp: {
           ParsedJumpInstruction instr;
           ParseControlFlowCondJmp(cf.cond_jmp, cf_index, instr);
           instr.Disassemble(&ucode_disasm_buffer);
+          vertex_index_register_may_be_modified_ = true;
           if (instr.type == ParsedJumpInstruction::Type::kConditional) {
             bool_constant_index = instr.bool_constant_index;
           }
@@ -370,8 +377,8 @@ void Shader::GatherExecInformation(
     if (sequence & 0b01) {
       auto& op = *reinterpret_cast<const FetchInstruction*>(op_ptr);
       if (op.opcode() == FetchOpcode::kVertexFetch) {
-        GatherVertexFetchInformation(op.vertex_fetch(), previous_vfetch_full,
-                                     ucode_disasm_buffer);
+        GatherVertexFetchInformation(op.vertex_fetch(), instr_offset,
+                                     previous_vfetch_full, ucode_disasm_buffer);
       } else {
         GatherTextureFetchInformation(
             op.texture_fetch(), unique_texture_bindings, ucode_disasm_buffer);
@@ -385,15 +392,29 @@ void Shader::GatherExecInformation(
 }
 
 void Shader::GatherVertexFetchInformation(
-    const VertexFetchInstruction& op,
+    const VertexFetchInstruction& op, uint32_t instruction_address,
     VertexFetchInstruction& previous_vfetch_full,
     StringBuffer& ucode_disasm_buffer) {
   ParsedVertexFetchInstruction fetch_instr;
   if (ParseVertexFetchInstruction(op, previous_vfetch_full, fetch_instr)) {
     previous_vfetch_full = op;
   }
+  fetch_instr.instruction_address = instruction_address;
   fetch_instr.Disassemble(&ucode_disasm_buffer);
 
+  // Check the index before the result of this fetch possibly overwrites it.
+  // For vfetch_mini, the index is the one of the preceding vfetch_full, and if
+  // r0 was still unmodified at this point, it was also unmodified there.
+  const InstructionOperand& index_operand = fetch_instr.operands[0];
+  bool is_indexed_by_vertex_index =
+      type() == xenos::ShaderType::kVertex &&
+      !vertex_index_register_may_be_modified_ &&
+      index_operand.storage_source == InstructionStorageSource::kRegister &&
+      index_operand.storage_index == 0 &&
+      index_operand.storage_addressing_mode ==
+          InstructionStorageAddressingMode::kAbsolute &&
+      index_operand.GetComponent(0) == SwizzleSource::kX;
+
   GatherFetchResultInformation(fetch_instr.result);
 
   // Mini-fetches inherit the operands from full fetches.
@@ -438,6 +459,7 @@ void Shader::GatherVertexFetchInformation(
 
   // Populate attribute.
   attrib->fetch_instr = fetch_instr;
+  attrib->is_indexed_by_vertex_index = is_indexed_by_vertex_index;
 }
 
 void Shader::GatherTextureFetchInformation(const TextureFetchInstruction& op,
@@ -573,8 +595,12 @@ void Shader::GatherFetchResultInformation(const InstructionResult& result) {
       InstructionStorageAddressingMode::kAbsolute) {
     register_static_address_bound_ = std::max(
         register_static_address_bound_, result.storage_index + uint32_t(1));
+    if (!result.storage_index) {
+      vertex_index_register_may_be_modified_ = true;
+    }
   } else {
     uses_register_dynamic_addressing_ = true;
+    vertex_index_register_may_be_modified_ = true;
   }
 }
 
@@ -590,8 +616,12 @@ void Shader::GatherAluResultInformation(const InstructionResult& result,
           InstructionStorageAddressingMode::kAbsolute) {
         register_static_address_bound_ = std::max(
             register_static_address_bound_, result.storage_index + uint32_t(1));
+        if (!result.storage_index) {
+          vertex_index_register_may_be_modified_ = true;
+        }
       } else {
         uses_register_dynamic_addressing_ = true;
+        vertex_index_register_may_be_modified_ = true;
       }
       break;
     case InstructionStorageTarget::kInterpolator:
@@ -934,6 +964,7 @@ void ShaderTranslator::TranslateExecInstructions(
                                         vfetch_instr)) {
           previous_vfetch_full_ = vfetch_op;
         }
+        vfetch_instr.instruction_address = instr_offset;
         ProcessVertexFetchInstruction(vfetch_instr);
       } else {
         ParsedTextureFetchInstruction tfetch_instr;
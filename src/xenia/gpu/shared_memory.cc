@@ -212,6 +212,17 @@ void SharedMemory::UnwatchMemoryRange(WatchHandle handle) {
   UnlinkWatchRange(reinterpret_cast<WatchRange*>(handle));
 }
 
+void SharedMemory::ProtectRangeFromCpuWrites(uint32_t start,
+                                              uint32_t length) {
+  if (length == 0 || start >= kBufferSize) {
+    return;
+  }
+  length = std::min(length, kBufferSize - start);
+  if (memory_invalidation_callback_handle_) {
+    memory().EnablePhysicalMemoryAccessCallbacks(start, length, true, false);
+  }
+}
+
 void SharedMemory::FireWatches(uint32_t page_first, uint32_t page_last,
                                bool invalidated_by_gpu) {
   uint32_t address_first = page_first << page_size_log2_;
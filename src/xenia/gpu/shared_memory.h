@@ -72,6 +72,10 @@ class SharedMemory {
                                void* callback_data, uint64_t callback_argument);
   // Unregisters previously registered watched memory range.
   void UnwatchMemoryRange(WatchHandle handle);
+  // CPU writes to ranges not requested yet don't trigger the watches since the
+  // range isn't protected. Protects the range without uploading it, for
+  // watching data that is only read on the CPU side.
+  void ProtectRangeFromCpuWrites(uint32_t start, uint32_t length);
 
   // Checks if the range has been updated, uploads new data if needed and
   // ensures the host GPU memory backing the range are resident. Returns true if
@@ -127,6 +127,7 @@ void SpirvShaderTranslator::Reset() {
 
   uniform_float_constants_ = spv::NoResult;
 
+  input_host_vertex_fetches_.clear();
   input_point_coordinates_ = spv::NoResult;
   input_fragment_coordinates_ = spv::NoResult;
   input_front_facing_ = spv::NoResult;
@@ -1151,6 +1152,28 @@ void SpirvShaderTranslator::StartVertexOrTessEvalShaderBeforeMain() {
     builder_->addDecoration(input_vertex_index_, spv::DecorationBuiltIn,
                             spv::BuiltInVertexIndex);
     main_interface_.push_back(input_vertex_index_);
+    if (GetSpirvShaderModification().vertex.host_vertex_input) {
+      HostVertexInputAttribute
+          host_vertex_input_attributes[kMaxHostVertexInputAttributes];
+      uint32_t host_vertex_input_attribute_count =
+          GetHostVertexInputAttributes(current_shader(),
+                                       host_vertex_input_attributes);
+      for (uint32_t i = 0; i < host_vertex_input_attribute_count; ++i) {
+        const HostVertexInputAttribute& host_vertex_input_attribute =
+            host_vertex_input_attributes[i];
+        spv::Id input_host_vertex_fetch = builder_->createVariable(
+            spv::NoPrecision, spv::StorageClassInput,
+            type_uint_vectors_[host_vertex_input_attribute.word_count - 1],
+            fmt::format("xe_in_vertex_fetch_{}", i).c_str());
+        builder_->addDecoration(input_host_vertex_fetch,
+                                spv::DecorationLocation, int(i));
+        main_interface_.push_back(input_host_vertex_fetch);
+        input_host_vertex_fetches_.emplace(
+            host_vertex_input_attribute.attribute->fetch_instr
+                .instruction_address,
+            input_host_vertex_fetch);
+      }
+    }
   }
 
   uint32_t output_location = 0;
@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -34,7 +35,7 @@ class SpirvShaderTranslator : public ShaderTranslator {
     // TODO(Triang3l): Change to 0xYYYYMMDD once it's out of the rapid
     // prototyping stage (easier to do small granular updates with an
     // incremental counter).
-    static constexpr uint32_t kVersion = 6;
+    static constexpr uint32_t kVersion = 7;
 
     enum class DepthStencilMode : uint32_t {
       kNoModifiers,
@@ -60,6 +61,11 @@ class SpirvShaderTranslator : public ShaderTranslator {
       // Pipeline stage and input configuration.
       Shader::HostVertexShaderType host_vertex_shader_type
           : Shader::kHostVertexShaderTypeBitCount;
+      // Whether the vertex fetches listed by GetHostVertexInputAttributes
+      // obtain their data via the host vertex input - requires the host
+      // vertex index to be the guest one, without byte swapping or loading it
+      // in the shader.
+      uint32_t host_vertex_input : 1;
     } vertex;
     struct PixelShaderModification {
       // uint32_t 0.
@@ -350,6 +356,30 @@ class SpirvShaderTranslator : public ShaderTranslator {
   uint64_t GetDefaultPixelShaderModification(
       uint32_t dynamic_addressable_register_count) const override;
 
+  // A vertex fetch performed via the host fixed-function vertex input, with
+  // the location being the index in the GetHostVertexInputAttributes output.
+  // Vulkan vertex attributes can't be big-endian, so the data is loaded as raw
+  // 32-bit words, and the endian swap and the format unpacking are still done
+  // in the shader - only the shared memory storage buffer loads are replaced.
+  struct HostVertexInputAttribute {
+    // Host binding - one for every vertex fetch constant with such attributes.
+    uint32_t binding;
+    const Shader::VertexBinding* vertex_binding;
+    const Shader::VertexBinding::Attribute* attribute;
+    // Number of 32-bit components of the host attribute, covering the whole
+    // guest element.
+    uint32_t word_count;
+  };
+  // The minimum maxVertexInputAttributes and maxVertexInputBindings.
+  static constexpr uint32_t kMaxHostVertexInputAttributes = 16;
+  // The minimum maxVertexInputAttributeOffset.
+  static constexpr uint32_t kMaxHostVertexInputAttributeOffset = 2047;
+  // Returns the number of the vertex fetches in the shader that can be done
+  // via the host vertex input, written to attributes_out, which must have
+  // space for kMaxHostVertexInputAttributes elements.
+  static uint32_t GetHostVertexInputAttributes(
+      const Shader& shader, HostVertexInputAttribute* attributes_out);
+
   static constexpr uint32_t GetSharedMemoryStorageBufferCountLog2(
       uint32_t max_storage_buffer_range) {
     if (max_storage_buffer_range >= 512 * 1024 * 1024) {
@@ -808,6 +838,9 @@ class SpirvShaderTranslator : public ShaderTranslator {
 
   // VS as VS only - int.
   spv::Id input_vertex_index_;
+  // VS as VS only, with the host vertex input - uint or uintN, by the ucode
+  // instruction address of the vertex fetch.
+  std::unordered_map<uint32_t, spv::Id> input_host_vertex_fetches_;
   // VS as TES only - int.
   spv::Id input_primitive_id_;
   // PS, only when needed - float2.
@@ -23,6 +23,51 @@
 namespace xe {
 namespace gpu {
 
+uint32_t SpirvShaderTranslator::GetHostVertexInputAttributes(
+    const Shader& shader, HostVertexInputAttribute* attributes_out) {
+  uint32_t attribute_count = 0;
+  uint32_t binding_count = 0;
+  for (const Shader::VertexBinding& vertex_binding : shader.vertex_bindings()) {
+    bool binding_used = false;
+    for (const Shader::VertexBinding::Attribute& attribute :
+         vertex_binding.attributes) {
+      if (attribute_count >= kMaxHostVertexInputAttributes) {
+        return attribute_count;
+      }
+      const ParsedVertexFetchInstruction::Attributes& fetch_attributes =
+          attribute.fetch_instr.attributes;
+      // The host vertex input can only provide elements at the offset from the
+      // vertex index multiplied by the stride of the binding.
+      if (!attribute.is_indexed_by_vertex_index || !fetch_attributes.stride ||
+          fetch_attributes.stride != vertex_binding.stride_words ||
+          fetch_attributes.offset < 0 ||
+          uint32_t(fetch_attributes.offset) * sizeof(uint32_t) >
+              kMaxHostVertexInputAttributeOffset) {
+        continue;
+      }
+      uint32_t format_words = xenos::GetVertexFormatNeededWords(
+          fetch_attributes.data_format, 0b1111);
+      if (!xenos::GetVertexFormatNeededWords(
+              fetch_attributes.data_format,
+              attribute.fetch_instr.result.GetUsedResultComponents())) {
+        // Nothing to load.
+        continue;
+      }
+      HostVertexInputAttribute& attribute_out =
+          attributes_out[attribute_count++];
+      attribute_out.binding = binding_count;
+      attribute_out.vertex_binding = &vertex_binding;
+      attribute_out.attribute = &attribute;
+      attribute_out.word_count = xe::bit_count(format_words);
+      binding_used = true;
+    }
+    if (binding_used) {
+      ++binding_count;
+    }
+  }
+  return attribute_count;
+}
+
 void SpirvShaderTranslator::ProcessVertexFetchInstruction(
     const ParsedVertexFetchInstruction& instr) {
   UpdateInstructionPredication(instr.is_predicated, instr.predicate_condition);
@@ -105,7 +150,18 @@ void SpirvShaderTranslator::ProcessVertexFetchInstruction(
     return;
   }
 
-  // Load the needed words.
+  // Load the needed words - from the host vertex input if the element is
+  // provided by it, or from the shared memory otherwise.
+  spv::Id host_vertex_input_words = spv::NoResult;
+  int host_vertex_input_word_count = 0;
+  auto input_host_vertex_fetch_it =
+      input_host_vertex_fetches_.find(instr.instruction_address);
+  if (input_host_vertex_fetch_it != input_host_vertex_fetches_.cend()) {
+    host_vertex_input_words = builder_->createLoad(
+        input_host_vertex_fetch_it->second, spv::NoPrecision);
+    host_vertex_input_word_count =
+        builder_->getNumComponents(host_vertex_input_words);
+  }
   unsigned int word_composite_indices[4] = {};
   spv::Id word_composite_constituents[4];
   uint32_t word_count = 0;
@@ -113,6 +169,15 @@ void SpirvShaderTranslator::ProcessVertexFetchInstruction(
   uint32_t word_index;
   while (xe::bit_scan_forward(words_remaining, &word_index)) {
     words_remaining &= ~(1 << word_index);
+    word_composite_indices[word_index] = word_count;
+    if (host_vertex_input_words != spv::NoResult) {
+      word_composite_constituents[word_count++] =
+          host_vertex_input_word_count > 1
+              ? builder_->createCompositeExtract(host_vertex_input_words,
+                                                 type_uint_, word_index)
+              : host_vertex_input_words;
+      continue;
+    }
     spv::Id word_address = address;
     // Add the word offset from the instruction (signed), plus the offset of the
     // word within the element.
@@ -122,7 +187,6 @@ void SpirvShaderTranslator::ProcessVertexFetchInstruction(
           builder_->createBinOp(spv::OpIAdd, type_int_, word_address,
                                 builder_->makeIntConstant(int(word_offset)));
     }
-    word_composite_indices[word_index] = word_count;
     // FIXME(Triang3l): Bound checking is not done here, but haven't encountered
     // any games relying on out-of-bounds access. On Adreno 200 on Android (LG
     // P705), however, words (not full elements) out of glBufferData bounds
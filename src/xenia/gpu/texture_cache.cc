@@ -525,6 +525,29 @@ void TextureCache::Texture::MakeUpToDateAndWatch(
   }
 }
 
+void TextureCache::Texture::MakeOutdated(
+    [[maybe_unused]] const std::unique_lock<std::recursive_mutex>& global_lock,
+    bool base, bool mips) {
+  SharedMemory& shared_memory = texture_cache().shared_memory();
+  if (base && GetGuestBaseSize()) {
+    if (base_watch_handle_) {
+      shared_memory.UnwatchMemoryRange(base_watch_handle_);
+      base_watch_handle_ = nullptr;
+    }
+    base_outdated_ = true;
+  }
+  if (mips && GetGuestMipsSize()) {
+    if (mips_watch_handle_) {
+      shared_memory.UnwatchMemoryRange(mips_watch_handle_);
+      mips_watch_handle_ = nullptr;
+    }
+    mips_outdated_ = true;
+  }
+  // Recheck the bindings even if the fetch constants stay the same.
+  texture_cache().texture_became_outdated_.store(true,
+                                                 std::memory_order_release);
+}
+
 void TextureCache::Texture::MarkAsUsed() {
   assert_true(last_usage_submission_index_ <=
               texture_cache_.current_submission_index_);
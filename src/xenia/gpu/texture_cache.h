@@ -240,6 +240,11 @@ class TextureCache {
     }
     void MakeUpToDateAndWatch(
         const std::unique_lock<std::recursive_mutex>& global_lock);
+    // Reverts MakeUpToDateAndWatch for the base and / or the mips if loading
+    // their data has failed after the texture has already been marked as up to
+    // date, so the load is retried the next time the texture is requested.
+    void MakeOutdated(const std::unique_lock<std::recursive_mutex>& global_lock,
+                      bool base, bool mips);
 
     void WatchCallback(
         const std::unique_lock<std::recursive_mutex>& global_lock, bool is_mip);
@@ -32,6 +32,15 @@ class DeferredCommandBuffer {
   void Reset();
   void Execute(VkCommandBuffer command_buffer);
 
+  void CmdVkBeginQuery(VkQueryPool query_pool, uint32_t query,
+                       VkQueryControlFlags flags) {
+    auto& args = *reinterpret_cast<ArgsVkBeginQuery*>(
+        WriteCommand(Command::kVkBeginQuery, sizeof(ArgsVkBeginQuery)));
+    args.query_pool = query_pool;
+    args.query = query;
+    args.flags = flags;
+  }
+
   // render_pass_begin->pNext of all barriers must be null.
   void CmdVkBeginRenderPass(const VkRenderPassBeginInfo* render_pass_begin,
                             VkSubpassContents contents) {
@@ -260,6 +269,28 @@ class DeferredCommandBuffer {
     args.first_index = first_index;
     args.vertex_offset = vertex_offset;
     args.first_instance = first_instance;
+    last_draw_indexed_end_ = command_stream_.size();
+  }
+
+  // If nothing has been recorded after the last vkCmdDrawIndexed, adds
+  // index_count indices to it and returns true. For merging draws with
+  // identical state whose index ranges are contiguous.
+  bool ExtendLastDrawIndexed(uint32_t index_count) {
+    if (last_draw_indexed_end_ != command_stream_.size()) {
+      return false;
+    }
+    auto& args = *reinterpret_cast<ArgsVkDrawIndexed*>(
+        command_stream_.data() + (last_draw_indexed_end_ -
+                                  kArgsVkDrawIndexedSizeElements));
+    args.index_count += index_count;
+    return true;
+  }
+
+  void CmdVkEndQuery(VkQueryPool query_pool, uint32_t query) {
+    auto& args = *reinterpret_cast<ArgsVkEndQuery*>(
+        WriteCommand(Command::kVkEndQuery, sizeof(ArgsVkEndQuery)));
+    args.query_pool = query_pool;
+    args.query = query;
   }
 
   void CmdVkEndRenderPass() { WriteCommand(Command::kVkEndRenderPass, 0); }
@@ -288,6 +319,15 @@ class DeferredCommandBuffer {
     std::memcpy(args_ptr + sizeof(ArgsVkPushConstants), values, size);
   }
 
+  void CmdVkResetQueryPool(VkQueryPool query_pool, uint32_t first_query,
+                           uint32_t query_count) {
+    auto& args = *reinterpret_cast<ArgsVkResetQueryPool*>(
+        WriteCommand(Command::kVkResetQueryPool, sizeof(ArgsVkResetQueryPool)));
+    args.query_pool = query_pool;
+    args.first_query = first_query;
+    args.query_count = query_count;
+  }
+
   void CmdVkSetBlendConstants(const float* blend_constants) {
     auto& args = *reinterpret_cast<ArgsVkSetBlendConstants*>(WriteCommand(
         Command::kVkSetBlendConstants, sizeof(ArgsVkSetBlendConstants)));
@@ -359,6 +399,7 @@ class DeferredCommandBuffer {
 
  private:
   enum class Command {
+    kVkBeginQuery,
     kVkBeginRenderPass,
     kVkBindDescriptorSets,
     kVkBindIndexBuffer,
@@ -371,9 +412,11 @@ class DeferredCommandBuffer {
     kVkDispatch,
     kVkDraw,
     kVkDrawIndexed,
+    kVkEndQuery,
     kVkEndRenderPass,
     kVkPipelineBarrier,
     kVkPushConstants,
+    kVkResetQueryPool,
     kVkSetBlendConstants,
     kVkSetDepthBias,
     kVkSetScissor,
@@ -390,6 +433,12 @@ class DeferredCommandBuffer {
   static constexpr size_t kCommandHeaderSizeElements =
       (sizeof(CommandHeader) + sizeof(uintmax_t) - 1) / sizeof(uintmax_t);
 
+  struct ArgsVkBeginQuery {
+    VkQueryPool query_pool;
+    uint32_t query;
+    VkQueryControlFlags flags;
+  };
+
   struct ArgsVkBeginRenderPass {
     VkRenderPass render_pass;
     VkFramebuffer framebuffer;
@@ -484,6 +533,11 @@ class DeferredCommandBuffer {
     uint32_t first_instance;
   };
 
+  struct ArgsVkEndQuery {
+    VkQueryPool query_pool;
+    uint32_t query;
+  };
+
   struct ArgsVkPipelineBarrier {
     VkPipelineStageFlags src_stage_mask;
     VkPipelineStageFlags dst_stage_mask;
@@ -506,6 +560,12 @@ class DeferredCommandBuffer {
     // Followed by `size` bytes of values.
   };
 
+  struct ArgsVkResetQueryPool {
+    VkQueryPool query_pool;
+    uint32_t first_query;
+    uint32_t query_count;
+  };
+
   struct ArgsVkSetBlendConstants {
     float blend_constants[4];
   };
@@ -535,12 +595,18 @@ class DeferredCommandBuffer {
     static_assert(alignof(VkViewport) <= alignof(uintmax_t));
   };
 
+  static constexpr size_t kArgsVkDrawIndexedSizeElements =
+      (sizeof(ArgsVkDrawIndexed) + sizeof(uintmax_t) - 1) / sizeof(uintmax_t);
+
   void* WriteCommand(Command command, size_t arguments_size_bytes);
 
   const VulkanCommandProcessor& command_processor_;
 
   // uintmax_t to ensure uint64_t and pointer alignment of all structures.
   std::vector<uintmax_t> command_stream_;
+  // Size of the command stream right after the last vkCmdDrawIndexed, or
+  // SIZE_MAX if there's no vkCmdDrawIndexed in it.
+  size_t last_draw_indexed_end_ = SIZE_MAX;
 };
 
 }  // namespace vulkan
@@ -19,6 +19,8 @@
 
 #include "xenia/base/assert.h"
 #include "xenia/base/byte_order.h"
+#include "xenia/base/clock.h"
+#include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/profiling.h"
@@ -36,6 +38,28 @@
 #include "xenia/ui/vulkan/vulkan_provider.h"
 #include "xenia/ui/vulkan/vulkan_util.h"
 
+DEFINE_bool(vulkan_occlusion_queries, true,
+            "Measure the guest occlusion query sample counts with host "
+            "occlusion queries rather than reporting "
+            "query_occlusion_fake_sample_count.",
+            "Vulkan");
+DEFINE_uint32(vulkan_occlusion_query_timeout_us, 50000,
+              "Maximum time since the end of an occlusion query for the host "
+              "GPU to finish measuring it when the guest is waiting for "
+              "something, before reporting query_occlusion_fake_sample_count "
+              "for it.",
+              "Vulkan");
+DEFINE_bool(vulkan_host_vertex_input, true,
+            "Load the data for vertex fetches indexed directly by the vertex "
+            "index via the fixed-function vertex input rather than from the "
+            "shared memory storage buffer in the shader, when the host vertex "
+            "index is the guest one.",
+            "Vulkan");
+DEFINE_bool(vulkan_merge_draws, true,
+            "Merge consecutive indexed list draws with identical state and "
+            "contiguous index ranges into one host draw command.",
+            "Vulkan");
+
 namespace xe {
 namespace gpu {
 namespace vulkan {
@@ -346,7 +370,7 @@ bool VulkanCommandProcessor::SetupContext() {
   }
 
   pipeline_cache_ = std::make_unique<VulkanPipelineCache>(
-      *this, *register_file_, *render_target_cache_,
+      *this, *register_file_, *shared_memory_, *render_target_cache_,
       guest_shader_vertex_stages_);
   if (!pipeline_cache_->Initialize()) {
     XELOGE("Failed to initialize the graphics pipeline cache");
@@ -454,6 +478,77 @@ bool VulkanCommandProcessor::SetupContext() {
                              1 + uint32_t(edram_fragment_shader_interlock),
                              write_descriptor_sets, 0, nullptr);
 
+  // Persistent shared memory bindings for compute shaders.
+  shared_memory_compute_binding_range_ =
+      UINT32_C(1) << xe::log2_floor(
+          std::min(provider.device_properties().limits.maxStorageBufferRange,
+                   SharedMemory::kBufferSize));
+  uint32_t shared_memory_compute_binding_count =
+      (SharedMemory::kBufferSize / shared_memory_compute_binding_range_) * 2 -
+      1;
+  VkDescriptorPoolSize shared_memory_compute_descriptor_pool_size;
+  shared_memory_compute_descriptor_pool_size.type =
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  shared_memory_compute_descriptor_pool_size.descriptorCount =
+      shared_memory_compute_binding_count;
+  descriptor_pool_create_info.maxSets = shared_memory_compute_binding_count;
+  descriptor_pool_create_info.pPoolSizes =
+      &shared_memory_compute_descriptor_pool_size;
+  if (dfn.vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr,
+                                 &shared_memory_compute_descriptor_pool_) !=
+      VK_SUCCESS) {
+    XELOGE(
+        "Failed to create the Vulkan descriptor pool for shared memory compute "
+        "bindings");
+    return false;
+  }
+  std::vector<VkDescriptorSetLayout> shared_memory_compute_set_layouts(
+      shared_memory_compute_binding_count,
+      GetSingleTransientDescriptorLayout(
+          SingleTransientDescriptorLayout::kStorageBufferCompute));
+  shared_memory_compute_descriptor_sets_.resize(
+      shared_memory_compute_binding_count);
+  descriptor_set_allocate_info.descriptorPool =
+      shared_memory_compute_descriptor_pool_;
+  descriptor_set_allocate_info.descriptorSetCount =
+      shared_memory_compute_binding_count;
+  descriptor_set_allocate_info.pSetLayouts =
+      shared_memory_compute_set_layouts.data();
+  if (dfn.vkAllocateDescriptorSets(
+          device, &descriptor_set_allocate_info,
+          shared_memory_compute_descriptor_sets_.data()) != VK_SUCCESS) {
+    XELOGE(
+        "Failed to allocate the Vulkan descriptor sets for shared memory "
+        "compute bindings");
+    return false;
+  }
+  std::vector<VkDescriptorBufferInfo> shared_memory_compute_buffers_info(
+      shared_memory_compute_binding_count);
+  std::vector<VkWriteDescriptorSet> shared_memory_compute_write_sets(
+      shared_memory_compute_binding_count);
+  for (uint32_t i = 0; i < shared_memory_compute_binding_count; ++i) {
+    VkDescriptorBufferInfo& buffer_info = shared_memory_compute_buffers_info[i];
+    buffer_info.buffer = shared_memory_->buffer();
+    buffer_info.offset = (shared_memory_compute_binding_range_ >> 1) * i;
+    buffer_info.range = shared_memory_compute_binding_range_;
+    VkWriteDescriptorSet& write_set = shared_memory_compute_write_sets[i];
+    write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write_set.pNext = nullptr;
+    write_set.dstSet = shared_memory_compute_descriptor_sets_[i];
+    write_set.dstBinding = 0;
+    write_set.dstArrayElement = 0;
+    write_set.descriptorCount = 1;
+    write_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write_set.pImageInfo = nullptr;
+    write_set.pBufferInfo = &buffer_info;
+    write_set.pTexelBufferView = nullptr;
+  }
+  dfn.vkUpdateDescriptorSets(device, shared_memory_compute_binding_count,
+                             shared_memory_compute_write_sets.data(), 0,
+                             nullptr);
+  shared_memory_compute_descriptor_writes_saved_ = 0;
+  shared_memory_compute_descriptor_writes_ = 0;
+
   // Swap objects.
 
   // Gamma ramp, either device-local and host-visible at once, or separate
@@ -1031,6 +1126,30 @@ bool VulkanCommandProcessor::SetupContext() {
     return false;
   }
 
+  // Host occlusion queries.
+  if (cvars::vulkan_occlusion_queries) {
+    VkQueryPoolCreateInfo occlusion_query_pool_create_info;
+    occlusion_query_pool_create_info.sType =
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    occlusion_query_pool_create_info.pNext = nullptr;
+    occlusion_query_pool_create_info.flags = 0;
+    occlusion_query_pool_create_info.queryType = VK_QUERY_TYPE_OCCLUSION;
+    occlusion_query_pool_create_info.queryCount = kOcclusionQueryPoolSize;
+    occlusion_query_pool_create_info.pipelineStatistics = 0;
+    if (dfn.vkCreateQueryPool(device, &occlusion_query_pool_create_info,
+                              nullptr, &occlusion_query_pool_) == VK_SUCCESS) {
+      occlusion_query_slots_free_.reserve(kOcclusionQueryPoolSize);
+      for (uint32_t i = kOcclusionQueryPoolSize; i; --i) {
+        occlusion_query_slots_free_.push_back(i - 1);
+      }
+    } else {
+      XELOGE(
+          "Failed to create the Vulkan occlusion query pool, fake occlusion "
+          "query results will be reported");
+      occlusion_query_pool_ = VK_NULL_HANDLE;
+    }
+  }
+
   // Just not to expose uninitialized memory.
   std::memset(&system_constants_, 0, sizeof(system_constants_));
 
@@ -1046,6 +1165,13 @@ void VulkanCommandProcessor::ShutdownContext() {
 
   DestroyScratchBuffer();
 
+  occlusion_query_active_ = false;
+  occlusion_query_current_slot_ = UINT32_MAX;
+  occlusion_queries_pending_.clear();
+  occlusion_query_slots_free_.clear();
+  ui::vulkan::util::DestroyAndNullHandle(dfn.vkDestroyQueryPool, device,
+                                         occlusion_query_pool_);
+
   for (SwapFramebuffer& swap_framebuffer : swap_framebuffers_) {
     ui::vulkan::util::DestroyAndNullHandle(dfn.vkDestroyFramebuffer, device,
                                            swap_framebuffer.framebuffer);
@@ -1083,6 +1209,10 @@ void VulkanCommandProcessor::ShutdownContext() {
   ui::vulkan::util::DestroyAndNullHandle(dfn.vkFreeMemory, device,
                                          gamma_ramp_buffer_memory_);
 
+  shared_memory_compute_descriptor_sets_.clear();
+  ui::vulkan::util::DestroyAndNullHandle(
+      dfn.vkDestroyDescriptorPool, device,
+      shared_memory_compute_descriptor_pool_);
   ui::vulkan::util::DestroyAndNullHandle(
       dfn.vkDestroyDescriptorPool, device,
       shared_memory_and_edram_descriptor_pool_);
@@ -1095,6 +1225,7 @@ void VulkanCommandProcessor::ShutdownContext() {
 
   primitive_processor_.reset();
 
+  ClearIndirectBufferCache();
   shared_memory_.reset();
 
   ClearTransientDescriptorPools();
@@ -1252,6 +1383,13 @@ void VulkanCommandProcessor::OnGammaRampPWLValueWritten() {
   gamma_ramp_pwl_current_frame_ = UINT32_MAX;
 }
 
+void VulkanCommandProcessor::PrepareForWait() {
+  CommandProcessor::PrepareForWait();
+
+  // The guest may be polling for the results of the occlusion queries.
+  PollOcclusionQueryResults();
+}
+
 void VulkanCommandProcessor::IssueSwap(uint32_t frontbuffer_ptr,
                                        uint32_t frontbuffer_width,
                                        uint32_t frontbuffer_height) {
@@ -1481,6 +1619,10 @@ void VulkanCommandProcessor::IssueSwap(uint32_t frontbuffer_ptr,
               VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
         }
 
+        // The presentation draw must not be counted by the guest occlusion
+        // query.
+        SuspendOcclusionQuery();
+
         // End the current render pass before inserting barriers and starting a
         // new one, and insert the barrier.
         SubmitBarriers(true);
@@ -1770,13 +1912,13 @@ bool VulkanCommandProcessor::SubmitBarriers(bool force_end_render_pass) {
   return true;
 }
 
-void VulkanCommandProcessor::SubmitBarriersAndEnterRenderTargetCacheRenderPass(
+bool VulkanCommandProcessor::SubmitBarriersAndEnterRenderTargetCacheRenderPass(
     VkRenderPass render_pass,
     const VulkanRenderTargetCache::Framebuffer* framebuffer) {
   SubmitBarriers(false);
   if (current_render_pass_ == render_pass &&
       current_framebuffer_ == framebuffer) {
-    return;
+    return false;
   }
   if (current_render_pass_ != VK_NULL_HANDLE) {
     deferred_command_buffer_.CmdVkEndRenderPass();
@@ -1797,6 +1939,7 @@ void VulkanCommandProcessor::SubmitBarriersAndEnterRenderTargetCacheRenderPass(
   render_pass_begin_info.pClearValues = nullptr;
   deferred_command_buffer_.CmdVkBeginRenderPass(&render_pass_begin_info,
                                                 VK_SUBPASS_CONTENTS_INLINE);
+  return true;
 }
 
 void VulkanCommandProcessor::EndRenderPass() {
@@ -2145,10 +2288,24 @@ void VulkanCommandProcessor::SetScissor(const VkRect2D& scissor) {
   }
 }
 
+SharedMemory* VulkanCommandProcessor::GetSharedMemoryForIndirectBufferCache() {
+  return shared_memory_.get();
+}
+
 Shader* VulkanCommandProcessor::LoadShader(xenos::ShaderType shader_type,
                                            uint32_t guest_address,
                                            const uint32_t* host_address,
                                            uint32_t dword_count) {
+  // IM_LOAD_IMMEDIATE microcode is in the ring buffer, not at guest_address.
+  // For IM_LOAD, use the cached shader if the memory hasn't been written
+  // instead of hashing it again, which requires the range in the shared
+  // memory to be watched - the submission will be needed for drawing anyway.
+  if (memory_->TranslatePhysical<const uint32_t*>(guest_address) ==
+          host_address &&
+      BeginSubmission(true)) {
+    return pipeline_cache_->LoadShader(shader_type, guest_address,
+                                       host_address, dword_count);
+  }
   return pipeline_cache_->LoadShader(shader_type, host_address, dword_count);
 }
 
@@ -2156,6 +2313,18 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
                                        uint32_t index_count,
                                        IndexBufferInfo* index_buffer_info,
                                        bool major_mode_explicit) {
+  uint64_t issue_draw_start_ticks = xe::Clock::QueryHostTickCount();
+  bool result = IssueDrawImpl(prim_type, index_count, index_buffer_info,
+                              major_mode_explicit);
+  issue_draw_ticks_ += xe::Clock::QueryHostTickCount() - issue_draw_start_ticks;
+  ++guest_draws_;
+  return result;
+}
+
+bool VulkanCommandProcessor::IssueDrawImpl(xenos::PrimitiveType prim_type,
+                                           uint32_t index_count,
+                                           IndexBufferInfo* index_buffer_info,
+                                           bool major_mode_explicit) {
 #if XE_UI_VULKAN_FINE_GRAINED_DRAW_SCOPES
   SCOPE_profile_cpu_f("gpu");
 #endif  // XE_UI_VULKAN_FINE_GRAINED_DRAW_SCOPES
@@ -2213,7 +2382,31 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
                           regs.Get<reg::SQ_CONTEXT_MISC>(), ps_param_gen_pos))
                    : 0;
 
+  const ui::vulkan::VulkanProvider& provider = GetVulkanProvider();
+  const VkPhysicalDeviceFeatures& device_features = provider.device_features();
+  const VkPhysicalDeviceLimits& device_limits =
+      provider.device_properties().limits;
+
+  auto vgt_draw_initiator = regs.Get<reg::VGT_DRAW_INITIATOR>();
+  int32_t vgt_indx_offset = int32_t(regs[XE_GPU_REG_VGT_INDX_OFFSET].u32);
+
+  // Vertex fetches that may be done via the host vertex input. The elements
+  // outside the bound ranges must not crash the device as the index buffer is
+  // not validated, so robust buffer access is required.
+  SpirvShaderTranslator::HostVertexInputAttribute
+      host_vertex_input_attributes
+          [SpirvShaderTranslator::kMaxHostVertexInputAttributes];
+  uint32_t host_vertex_input_attribute_count =
+      cvars::vulkan_host_vertex_input && device_features.robustBufferAccess
+          ? SpirvShaderTranslator::GetHostVertexInputAttributes(
+                *vertex_shader, host_vertex_input_attributes)
+          : 0;
+  std::array<VkDeviceSize, SpirvShaderTranslator::kMaxHostVertexInputAttributes>
+      host_vertex_input_binding_offsets;
+  uint32_t host_vertex_input_binding_count = 0;
+
   PrimitiveProcessor::ProcessingResult primitive_processing_result;
+  bool shader_32bit_index_dma = false;
   SpirvShaderTranslator::Modification vertex_shader_modification;
   SpirvShaderTranslator::Modification pixel_shader_modification;
   VulkanShader::VulkanTranslation* vertex_shader_translation;
@@ -2230,8 +2423,11 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
       return false;
     }
 
-    // Process primitives.
-    if (!primitive_processor_->Process(primitive_processing_result)) {
+    // Process primitives, pre-swapping the indices if the vertex fetches may be
+    // done via the host vertex input.
+    if (!primitive_processor_->Process(
+            primitive_processing_result,
+            host_vertex_input_attribute_count != 0)) {
       return false;
     }
     if (!primitive_processing_result.host_draw_vertex_count) {
@@ -2247,11 +2443,59 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
       return false;
     }
 
+    // Whether to load the guest 32-bit (usually big-endian) vertex index
+    // indirectly in the vertex shader if full 32-bit indices are not supported
+    // by the host.
+    shader_32bit_index_dma =
+        !device_features.fullDrawIndexUint32 &&
+        primitive_processing_result.index_buffer_type ==
+            PrimitiveProcessor::ProcessedIndexBufferType::kGuestDMA &&
+        vgt_draw_initiator.index_size == xenos::IndexFormat::kInt32 &&
+        primitive_processing_result.host_vertex_shader_type ==
+            Shader::HostVertexShaderType::kVertex;
+
+    // The host vertex input can be used if the host vertex index is the guest
+    // one as is, and the elements of the first vertex (offset by the guest
+    // base index) are within the shared memory.
+    host_vertex_input_binding_count = 0;
+    if (host_vertex_input_attribute_count &&
+        primitive_processing_result.host_vertex_shader_type ==
+            Shader::HostVertexShaderType::kVertex &&
+        primitive_processing_result.host_shader_index_endian ==
+            xenos::Endian::kNone &&
+        !shader_32bit_index_dma) {
+      for (uint32_t j = 0; j < host_vertex_input_attribute_count; ++j) {
+        const SpirvShaderTranslator::HostVertexInputAttribute&
+            host_vertex_input_attribute = host_vertex_input_attributes[j];
+        if (host_vertex_input_attribute.binding <
+            host_vertex_input_binding_count) {
+          continue;
+        }
+        const Shader::VertexBinding& vertex_binding =
+            *host_vertex_input_attribute.vertex_binding;
+        const auto& vfetch_constant = regs.Get<xenos::xe_gpu_vertex_fetch_t>(
+            XE_GPU_REG_SHADER_CONSTANT_FETCH_00_0 +
+            vertex_binding.fetch_constant * 2);
+        int64_t binding_offset_dwords =
+            int64_t(vfetch_constant.address) +
+            int64_t(vgt_indx_offset) * vertex_binding.stride_words;
+        if (binding_offset_dwords < 0 ||
+            binding_offset_dwords >=
+                int64_t(SharedMemory::kBufferSize / sizeof(uint32_t))) {
+          host_vertex_input_binding_count = 0;
+          break;
+        }
+        host_vertex_input_binding_offsets[host_vertex_input_binding_count++] =
+            VkDeviceSize(binding_offset_dwords) * sizeof(uint32_t);
+      }
+    }
+
     // Shader modifications.
     vertex_shader_modification =
         pipeline_cache_->GetCurrentVertexShaderModification(
             *vertex_shader, primitive_processing_result.host_vertex_shader_type,
-            interpolator_mask, ps_param_gen_pos != UINT32_MAX);
+            interpolator_mask, ps_param_gen_pos != UINT32_MAX,
+            host_vertex_input_binding_count != 0);
     pixel_shader_modification =
         pixel_shader ? pipeline_cache_->GetCurrentPixelShaderModification(
                            *pixel_shader, interpolator_mask, ps_param_gen_pos)
@@ -2276,33 +2520,49 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
     // different for some reason (like a race condition with the guest in index
     // buffer processing in the primitive processor resulting in different host
     // vertex shader types), the bindings will stay the same.
-    // TODO(Triang3l): Sampler caching and reuse for adjacent draws within one
-    // submission.
+    // Samplers with the same parameters in the same slots as in the previous
+    // draw within the same submission are reused directly, as their last usage
+    // submission is already the current one, and they can't be evicted.
+    bool reuse_previous_samplers =
+        !i && current_samplers_submission_ == GetCurrentSubmission();
+    current_samplers_submission_ = GetCurrentSubmission();
     uint32_t samplers_overflowed_count = 0;
     for (uint32_t j = 0; j < 2; ++j) {
       std::vector<std::pair<VulkanTextureCache::SamplerParameters, VkSampler>>&
           shader_samplers =
               j ? current_samplers_pixel_ : current_samplers_vertex_;
-      if (!i) {
-        shader_samplers.clear();
-      }
       const VulkanShader* shader = j ? pixel_shader : vertex_shader;
       if (!shader) {
+        if (!i) {
+          shader_samplers.clear();
+        }
         continue;
       }
       const std::vector<VulkanShader::SamplerBinding>& shader_sampler_bindings =
           shader->GetSamplerBindingsAfterTranslation();
       if (!i) {
-        shader_samplers.reserve(shader_sampler_bindings.size());
-        for (const VulkanShader::SamplerBinding& shader_sampler_binding :
-             shader_sampler_bindings) {
-          shader_samplers.emplace_back(
-              texture_cache_->GetSamplerParameters(shader_sampler_binding),
-              VK_NULL_HANDLE);
+        size_t previous_sampler_count =
+            reuse_previous_samplers ? shader_samplers.size() : 0;
+        shader_samplers.resize(shader_sampler_bindings.size());
+        for (size_t k = 0; k < shader_sampler_bindings.size(); ++k) {
+          std::pair<VulkanTextureCache::SamplerParameters, VkSampler>&
+              shader_sampler_pair = shader_samplers[k];
+          VulkanTextureCache::SamplerParameters sampler_parameters =
+              texture_cache_->GetSamplerParameters(shader_sampler_bindings[k]);
+          if (k < previous_sampler_count &&
+              shader_sampler_pair.first == sampler_parameters) {
+            continue;
+          }
+          shader_sampler_pair.first = sampler_parameters;
+          shader_sampler_pair.second = VK_NULL_HANDLE;
         }
       }
       for (std::pair<VulkanTextureCache::SamplerParameters, VkSampler>&
                shader_sampler_pair : shader_samplers) {
+        if (!i && shader_sampler_pair.second != VK_NULL_HANDLE) {
+          // Reused from the previous draw.
+          continue;
+        }
         // UseSampler calls are needed even on the second iteration in case the
         // submission was broken (and thus the last usage submission indices for
         // the used samplers need to be updated) due to an overflow within one
@@ -2339,6 +2599,9 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
         texture_cache_->GetSubmissionToAwaitOnSamplerOverflow(
             samplers_overflowed_count);
     assert_true(sampler_overflow_await_submission <= GetCurrentSubmission());
+    if (sampler_overflow_await_submission > GetCompletedSubmission()) {
+      ++sampler_overflow_waits_;
+    }
     CheckSubmissionFenceAndDeviceLoss(sampler_overflow_await_submission);
   }
 
@@ -2419,11 +2682,6 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
     current_guest_graphics_pipeline_layout_ = pipeline_layout;
   }
 
-  const ui::vulkan::VulkanProvider& provider = GetVulkanProvider();
-  const VkPhysicalDeviceFeatures& device_features = provider.device_features();
-  const VkPhysicalDeviceLimits& device_limits =
-      provider.device_properties().limits;
-
   bool host_render_targets_used = render_target_cache_->GetPath() ==
                                   RenderTargetCache::Path::kHostRenderTargets;
 
@@ -2455,19 +2713,6 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
   UpdateDynamicState(viewport_info, primitive_polygonal,
                      normalized_depth_control);
 
-  auto vgt_draw_initiator = regs.Get<reg::VGT_DRAW_INITIATOR>();
-
-  // Whether to load the guest 32-bit (usually big-endian) vertex index
-  // indirectly in the vertex shader if full 32-bit indices are not supported by
-  // the host.
-  bool shader_32bit_index_dma =
-      !device_features.fullDrawIndexUint32 &&
-      primitive_processing_result.index_buffer_type ==
-          PrimitiveProcessor::ProcessedIndexBufferType::kGuestDMA &&
-      vgt_draw_initiator.index_size == xenos::IndexFormat::kInt32 &&
-      primitive_processing_result.host_vertex_shader_type ==
-          Shader::HostVertexShaderType::kVertex;
-
   // Update system constants before uploading them.
   UpdateSystemConstantValues(primitive_polygonal, primitive_processing_result,
                              shader_32bit_index_dma, viewport_info,
@@ -2529,6 +2774,13 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
   // TODO(Triang3l): Memory export.
   shared_memory_->Use(VulkanSharedMemory::Usage::kRead);
 
+  // Resume measuring the guest occlusion query if it has been suspended for
+  // internal draws or by the end of the previous submission. A host query that
+  // may span multiple render passes must be begun outside a render pass.
+  if (occlusion_query_active_) {
+    BeginOcclusionQuerySlot();
+  }
+
   // After all commands that may dispatch, copy or insert barriers, submit the
   // barriers (may end the render pass), and (re)enter the render pass before
   // drawing.
@@ -2537,13 +2789,13 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
       render_target_cache_->last_update_framebuffer());
 
   // Draw.
-  if (primitive_processing_result.index_buffer_type ==
-          PrimitiveProcessor::ProcessedIndexBufferType::kNone ||
-      shader_32bit_index_dma) {
-    deferred_command_buffer_.CmdVkDraw(
-        primitive_processing_result.host_draw_vertex_count, 1, 0, 0);
-  } else {
-    std::pair<VkBuffer, VkDeviceSize> index_buffer;
+  bool draw_indexed =
+      primitive_processing_result.index_buffer_type !=
+          PrimitiveProcessor::ProcessedIndexBufferType::kNone &&
+      !shader_32bit_index_dma;
+  std::pair<VkBuffer, VkDeviceSize> index_buffer;
+  VkIndexType index_type = VK_INDEX_TYPE_UINT16;
+  if (draw_indexed) {
     switch (primitive_processing_result.index_buffer_type) {
       case PrimitiveProcessor::ProcessedIndexBufferType::kGuestDMA:
         index_buffer.first = shared_memory_->buffer();
@@ -2562,16 +2814,76 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
         assert_unhandled_case(primitive_processing_result.index_buffer_type);
         return false;
     }
-    deferred_command_buffer_.CmdVkBindIndexBuffer(
-        index_buffer.first, index_buffer.second,
-        primitive_processing_result.host_index_format ==
-                xenos::IndexFormat::kInt16
-            ? VK_INDEX_TYPE_UINT16
-            : VK_INDEX_TYPE_UINT32);
-    deferred_command_buffer_.CmdVkDrawIndexed(
-        primitive_processing_result.host_draw_vertex_count, 1, 0, 0, 0);
+    if (primitive_processing_result.host_index_format ==
+        xenos::IndexFormat::kInt32) {
+      index_type = VK_INDEX_TYPE_UINT32;
+    }
+  }
+
+  // If nothing has been recorded since the previous indexed draw, all the
+  // state is the same, and if the indices directly continue its index range,
+  // the draws can be merged. This is only valid for lists though - strips and
+  // fans would be connected across the draws.
+  if (draw_indexed && cvars::vulkan_merge_draws &&
+      primitive_processing_result.host_vertex_shader_type ==
+          Shader::HostVertexShaderType::kVertex &&
+      (primitive_processing_result.host_primitive_type ==
+           xenos::PrimitiveType::kPointList ||
+       primitive_processing_result.host_primitive_type ==
+           xenos::PrimitiveType::kLineList ||
+       primitive_processing_result.host_primitive_type ==
+           xenos::PrimitiveType::kTriangleList) &&
+      index_buffer.first == draw_merge_index_buffer_ &&
+      index_buffer.second == draw_merge_index_buffer_end_ &&
+      index_type == draw_merge_index_type_ &&
+      host_vertex_input_binding_count ==
+          draw_merge_host_vertex_input_binding_count_ &&
+      std::equal(host_vertex_input_binding_offsets.cbegin(),
+                 host_vertex_input_binding_offsets.cbegin() +
+                     host_vertex_input_binding_count,
+                 draw_merge_host_vertex_input_binding_offsets_.cbegin()) &&
+      deferred_command_buffer_.ExtendLastDrawIndexed(
+          primitive_processing_result.host_draw_vertex_count)) {
+    draw_merge_index_buffer_end_ +=
+        VkDeviceSize(primitive_processing_result.host_draw_vertex_count)
+        << (index_type == VK_INDEX_TYPE_UINT32 ? 2 : 1);
+    return true;
   }
 
+  // Bind the shared memory as the vertex buffers for the host vertex input.
+  // Not tracking the current bindings as they may be overwritten by external
+  // pipelines, and the offsets change with nearly every draw anyway.
+  if (host_vertex_input_binding_count) {
+    std::array<VkBuffer, SpirvShaderTranslator::kMaxHostVertexInputAttributes>
+        host_vertex_input_buffers;
+    host_vertex_input_buffers.fill(shared_memory_->buffer());
+    deferred_command_buffer_.CmdVkBindVertexBuffers(
+        0, host_vertex_input_binding_count, host_vertex_input_buffers.data(),
+        host_vertex_input_binding_offsets.data());
+  }
+
+  ++host_draws_;
+  if (!draw_indexed) {
+    deferred_command_buffer_.CmdVkDraw(
+        primitive_processing_result.host_draw_vertex_count, 1, 0, 0);
+    return true;
+  }
+  deferred_command_buffer_.CmdVkBindIndexBuffer(
+      index_buffer.first, index_buffer.second, index_type);
+  deferred_command_buffer_.CmdVkDrawIndexed(
+      primitive_processing_result.host_draw_vertex_count, 1, 0, 0, 0);
+  draw_merge_index_buffer_ = index_buffer.first;
+  draw_merge_index_buffer_end_ =
+      index_buffer.second +
+      (VkDeviceSize(primitive_processing_result.host_draw_vertex_count)
+       << (index_type == VK_INDEX_TYPE_UINT32 ? 2 : 1));
+  draw_merge_index_type_ = index_type;
+  draw_merge_host_vertex_input_binding_count_ = host_vertex_input_binding_count;
+  std::copy(host_vertex_input_binding_offsets.cbegin(),
+            host_vertex_input_binding_offsets.cbegin() +
+                host_vertex_input_binding_count,
+            draw_merge_host_vertex_input_binding_offsets_.begin());
+
   return true;
 }
 
@@ -2595,6 +2907,54 @@ bool VulkanCommandProcessor::IssueCopy() {
   return true;
 }
 
+bool VulkanCommandProcessor::BeginOcclusionQuery(
+    uint32_t sample_count_address) {
+  if (occlusion_query_pool_ == VK_NULL_HANDLE || !BeginSubmission(true)) {
+    return false;
+  }
+  if (occlusion_query_active_) {
+    // Not ended by the guest - drop without writing anything, only reclaim
+    // the host queries when they're not used anymore.
+    EndOcclusionQuerySlot();
+    occlusion_query_current_.result_written = true;
+    occlusion_queries_pending_.push_back(std::move(occlusion_query_current_));
+  }
+  occlusion_query_active_ = true;
+  occlusion_query_current_.sample_count_address = sample_count_address;
+  occlusion_query_current_.slots.clear();
+  occlusion_query_current_.submission = GetCurrentSubmission();
+  occlusion_query_current_.incomplete = false;
+  occlusion_query_current_.result_written = false;
+  // The host query is started by the first guest draw, so internal draws
+  // before it aren't counted.
+  return true;
+}
+
+bool VulkanCommandProcessor::EndOcclusionQuery(uint32_t sample_count_address) {
+  if (!occlusion_query_active_ ||
+      occlusion_query_current_.sample_count_address != sample_count_address) {
+    return false;
+  }
+  // If the submission has been closed since the last host query was started,
+  // the host query has already been ended in EndSubmission.
+  if (submission_open_) {
+    EndOcclusionQuerySlot();
+  }
+  occlusion_query_active_ = false;
+  if (occlusion_query_current_.slots.empty()) {
+    if (occlusion_query_current_.incomplete) {
+      // Couldn't measure - report the fake result right now.
+      return false;
+    }
+    // Nothing has been drawn during the query.
+    WriteOcclusionQuerySampleCount(sample_count_address, 0);
+    return true;
+  }
+  occlusion_query_current_.end_host_tick = Clock::QueryHostTickCount();
+  occlusion_queries_pending_.push_back(std::move(occlusion_query_current_));
+  return true;
+}
+
 void VulkanCommandProcessor::InitializeTrace() {
   CommandProcessor::InitializeTrace();
 
@@ -2613,6 +2973,25 @@ void VulkanCommandProcessor::InitializeTrace() {
   }
 }
 
+bool VulkanCommandProcessor::IsSubmissionCompletedOnGpu(
+    uint64_t submission) const {
+  if (submission <= submission_completed_) {
+    return true;
+  }
+  if (submission >= GetCurrentSubmission() || device_lost_) {
+    return false;
+  }
+  const ui::vulkan::VulkanProvider& provider = GetVulkanProvider();
+  const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
+  VkDevice device = provider.device();
+  // Submissions are executed in order, so signaling of the fence of the
+  // submission means all the earlier ones have been completed too.
+  return dfn.vkGetFenceStatus(
+             device, submissions_in_flight_fences_[size_t(
+                         submission - submission_completed_ - 1)]) ==
+         VK_SUCCESS;
+}
+
 void VulkanCommandProcessor::CheckSubmissionFenceAndDeviceLoss(
     uint64_t await_submission) {
   // Only report once, no need to retry a wait that won't succeed anyway.
@@ -2716,6 +3095,8 @@ void VulkanCommandProcessor::CheckSubmissionFenceAndDeviceLoss(
 
   texture_cache_->CompletedSubmissionUpdated(submission_completed_);
 
+  ResolveOcclusionQueries();
+
   // Destroy objects scheduled for destruction.
   while (!destroy_framebuffers_.empty()) {
     const auto& destroy_pair = destroy_framebuffers_.front();
@@ -2816,6 +3197,9 @@ bool VulkanCommandProcessor::BeginSubmission(bool is_guest_command) {
     primitive_processor_->BeginSubmission();
 
     texture_cache_->BeginSubmission(GetCurrentSubmission());
+
+    // The guest occlusion query that has been started in one of the previous
+    // submissions is continued by the next guest draw.
   }
 
   if (is_opening_frame) {
@@ -2961,6 +3345,44 @@ bool VulkanCommandProcessor::EndSubmission(bool is_swap) {
 
   if (is_closing_frame) {
     primitive_processor_->EndFrame();
+
+    if (render_target_cache_->GetPath() ==
+        RenderTargetCache::Path::kHostRenderTargets) {
+      render_target_cache_->EndFrame();
+    }
+
+    COUNT_profile_set("gpu/vulkan/shared_memory_descriptor_writes_saved",
+                      shared_memory_compute_descriptor_writes_saved_);
+    COUNT_profile_set("gpu/vulkan/shared_memory_descriptor_writes",
+                      shared_memory_compute_descriptor_writes_);
+    shared_memory_compute_descriptor_writes_saved_ = 0;
+    shared_memory_compute_descriptor_writes_ = 0;
+    COUNT_profile_set("gpu/vulkan/sampler_overflow_waits",
+                      sampler_overflow_waits_);
+    sampler_overflow_waits_ = 0;
+    COUNT_profile_set("gpu/vulkan/shader_ucode_bytes_hashed",
+                      pipeline_cache_->TakeShaderUcodeBytesHashed());
+    COUNT_profile_set("gpu/vulkan/occlusion_queries_measured",
+                      occlusion_queries_measured_);
+    COUNT_profile_set("gpu/vulkan/occlusion_queries_faked",
+                      occlusion_queries_faked_);
+    occlusion_queries_measured_ = 0;
+    occlusion_queries_faked_ = 0;
+    COUNT_profile_set("gpu/vulkan/guest_draws", guest_draws_);
+    COUNT_profile_set("gpu/vulkan/host_draws", host_draws_);
+    COUNT_profile_set(
+        "gpu/vulkan/issue_draw_microseconds",
+        issue_draw_ticks_ * 1000000 / xe::Clock::QueryHostTickFrequency());
+    guest_draws_ = 0;
+    host_draws_ = 0;
+    issue_draw_ticks_ = 0;
+    uint32_t texture_loads, texture_load_batches, texture_load_dispatches;
+    texture_cache_->TakeTextureLoadCounts(texture_loads, texture_load_batches,
+                                          texture_load_dispatches);
+    COUNT_profile_set("gpu/vulkan/texture_loads", texture_loads);
+    COUNT_profile_set("gpu/vulkan/texture_load_batches", texture_load_batches);
+    COUNT_profile_set("gpu/vulkan/texture_load_dispatches",
+                      texture_load_dispatches);
   }
 
   if (submission_open_) {
@@ -2968,6 +3390,9 @@ bool VulkanCommandProcessor::EndSubmission(bool is_swap) {
 
     EndRenderPass();
 
+    // Host queries can't span multiple command buffers.
+    EndOcclusionQuerySlot();
+
     render_target_cache_->EndSubmission();
 
     primitive_processor_->EndSubmission();
@@ -3167,6 +3592,127 @@ void VulkanCommandProcessor::ClearTransientDescriptorPools() {
   transient_descriptor_allocator_uniform_buffer_.Reset();
 }
 
+void VulkanCommandProcessor::BeginOcclusionQuerySlot() {
+  assert_true(occlusion_query_active_);
+  assert_true(submission_open_);
+  if (occlusion_query_current_slot_ != UINT32_MAX ||
+      occlusion_query_current_.incomplete) {
+    // Already measuring, or the result will be fake anyway.
+    return;
+  }
+  if (occlusion_query_slots_free_.empty()) {
+    // Try to reclaim the host queries from the completed submissions.
+    CheckSubmissionFenceAndDeviceLoss(0);
+    if (occlusion_query_slots_free_.empty()) {
+      occlusion_query_current_.incomplete = true;
+      return;
+    }
+  }
+  uint32_t slot = occlusion_query_slots_free_.back();
+  occlusion_query_slots_free_.pop_back();
+  occlusion_query_current_.slots.push_back(slot);
+  occlusion_query_current_slot_ = slot;
+  // Query commands must be outside a render pass instance if the query spans
+  // multiple render passes.
+  EndRenderPass();
+  deferred_command_buffer_.CmdVkResetQueryPool(occlusion_query_pool_, slot, 1);
+  deferred_command_buffer_.CmdVkBeginQuery(
+      occlusion_query_pool_, slot,
+      GetVulkanProvider().device_features().occlusionQueryPrecise
+          ? VK_QUERY_CONTROL_PRECISE_BIT
+          : 0);
+}
+
+void VulkanCommandProcessor::EndOcclusionQuerySlot() {
+  if (occlusion_query_current_slot_ == UINT32_MAX) {
+    return;
+  }
+  EndRenderPass();
+  deferred_command_buffer_.CmdVkEndQuery(occlusion_query_pool_,
+                                         occlusion_query_current_slot_);
+  occlusion_query_current_slot_ = UINT32_MAX;
+  occlusion_query_current_.submission = GetCurrentSubmission();
+}
+
+void VulkanCommandProcessor::ResolveOcclusionQueries() {
+  if (occlusion_queries_pending_.empty()) {
+    return;
+  }
+  const ui::vulkan::VulkanProvider& provider = GetVulkanProvider();
+  const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
+  VkDevice device = provider.device();
+  // Samples are counted at the host resolution.
+  uint64_t draw_resolution_scale_area =
+      uint64_t(render_target_cache_->draw_resolution_scale_x()) *
+      render_target_cache_->draw_resolution_scale_y();
+  while (!occlusion_queries_pending_.empty()) {
+    OcclusionQuery& query = occlusion_queries_pending_.front();
+    if (query.submission > submission_completed_) {
+      break;
+    }
+    if (!query.result_written) {
+      if (query.incomplete) {
+        WriteFakeOcclusionQuerySampleCount(query.sample_count_address);
+        ++occlusion_queries_faked_;
+      } else {
+        uint64_t sample_count = 0;
+        for (uint32_t slot : query.slots) {
+          uint64_t slot_sample_count;
+          if (dfn.vkGetQueryPoolResults(
+                  device, occlusion_query_pool_, slot, 1, sizeof(uint64_t),
+                  &slot_sample_count, sizeof(uint64_t),
+                  VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+            sample_count += slot_sample_count;
+          }
+        }
+        sample_count /= draw_resolution_scale_area;
+        WriteOcclusionQuerySampleCount(
+            query.sample_count_address,
+            uint32_t(std::min(sample_count, uint64_t(UINT32_MAX))));
+        ++occlusion_queries_measured_;
+      }
+    }
+    occlusion_query_slots_free_.insert(occlusion_query_slots_free_.cend(),
+                                       query.slots.cbegin(),
+                                       query.slots.cend());
+    occlusion_queries_pending_.pop_front();
+  }
+}
+
+void VulkanCommandProcessor::PollOcclusionQueryResults() {
+  // Make sure the queries the guest may be waiting for are executed, without
+  // awaiting them - the results are written as the submissions are completed.
+  if (submission_open_) {
+    uint64_t current_submission = GetCurrentSubmission();
+    for (auto it = occlusion_queries_pending_.crbegin();
+         it != occlusion_queries_pending_.crend() &&
+         it->submission >= current_submission;
+         ++it) {
+      if (!it->result_written) {
+        EndSubmission(false);
+        break;
+      }
+    }
+  }
+  CheckSubmissionFenceAndDeviceLoss(0);
+  // Don't let the guest wait for too long (or forever if the device has been
+  // lost).
+  uint64_t timeout_ticks = uint64_t(cvars::vulkan_occlusion_query_timeout_us) *
+                           Clock::QueryHostTickFrequency() / 1000000;
+  uint64_t host_tick = Clock::QueryHostTickCount();
+  for (OcclusionQuery& query : occlusion_queries_pending_) {
+    if (!device_lost_ && host_tick - query.end_host_tick < timeout_ticks) {
+      // Pending queries are in the order they have been ended in.
+      break;
+    }
+    if (!query.result_written) {
+      WriteFakeOcclusionQuerySampleCount(query.sample_count_address);
+      query.result_written = true;
+      ++occlusion_queries_faked_;
+    }
+  }
+}
+
 void VulkanCommandProcessor::SplitPendingBarrier() {
   size_t pending_buffer_memory_barrier_count =
       pending_barriers_buffer_memory_barriers_.size();
@@ -4387,6 +4933,26 @@ uint8_t* VulkanCommandProcessor::WriteTransientUniformBufferBinding(
   return mapping;
 }
 
+VkDescriptorSet VulkanCommandProcessor::GetSharedMemoryComputeDescriptorSet(
+    uint32_t start, uint32_t length, uint32_t& binding_offset_out) {
+  // Windows begin at every half of the binding range, so any range starting
+  // within the first half of a window and not longer than a half is contained
+  // in it. The last window also covers the end of the buffer.
+  uint32_t window_step = shared_memory_compute_binding_range_ >> 1;
+  uint32_t window_index = std::min(
+      start / window_step,
+      uint32_t(shared_memory_compute_descriptor_sets_.size()) - 1);
+  uint32_t window_offset = window_step * window_index;
+  if (uint64_t(start) + length >
+      uint64_t(window_offset) + shared_memory_compute_binding_range_) {
+    ++shared_memory_compute_descriptor_writes_;
+    return VK_NULL_HANDLE;
+  }
+  ++shared_memory_compute_descriptor_writes_saved_;
+  binding_offset_out = window_offset;
+  return shared_memory_compute_descriptor_sets_[window_index];
+}
+
 uint32_t VulkanCommandProcessor::WriteTransientTextureBindings(
     bool is_vertex, uint32_t texture_count, uint32_t sampler_count,
     VkDescriptorSetLayout descriptor_set_layout,
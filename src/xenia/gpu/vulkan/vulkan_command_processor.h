@@ -161,6 +161,11 @@ class VulkanCommandProcessor : public CommandProcessor {
            uint64_t(submissions_in_flight_fences_.size()) + 1;
   }
   uint64_t GetCompletedSubmission() const { return submission_completed_; }
+  // Checks, without blocking and without reclaiming anything associated with
+  // the submissions, whether the GPU has already executed the submission, so
+  // objects referenced only by it and earlier submissions can be destroyed
+  // before GetCompletedSubmission is updated.
+  bool IsSubmissionCompletedOnGpu(uint64_t submission) const;
 
   // Sparse binds are:
   // - In a single submission, all submitted in one vkQueueBindSparse.
@@ -199,14 +204,20 @@ class VulkanCommandProcessor : public CommandProcessor {
   bool SubmitBarriers(bool force_end_render_pass);
 
   // If not started yet, begins a render pass from the render target cache.
-  // Submission must be open.
-  void SubmitBarriersAndEnterRenderTargetCacheRenderPass(
+  // Returns whether a new render pass instance has been begun. Submission must
+  // be open.
+  bool SubmitBarriersAndEnterRenderTargetCacheRenderPass(
       VkRenderPass render_pass,
       const VulkanRenderTargetCache::Framebuffer* framebuffer);
   // Must be called before doing anything outside the render pass scope,
   // including adding pipeline barriers that are not a part of the render pass
   // scope. Submission must be open.
   void EndRenderPass();
+  // Must be called before internal draws (such as render target ownership
+  // transfers) so they're not counted by the guest occlusion query. Suspends
+  // the measurement until the next guest draw. Ends the render pass if the
+  // query needs to be suspended. Submission must be open.
+  void SuspendOcclusionQuery() { EndOcclusionQuerySlot(); }
 
   VkDescriptorSetLayout GetSingleTransientDescriptorLayout(
       SingleTransientDescriptorLayout transient_descriptor_layout) const {
@@ -226,6 +237,14 @@ class VulkanCommandProcessor : public CommandProcessor {
   uint8_t* WriteTransientUniformBufferBinding(
       size_t size, SingleTransientDescriptorLayout transient_descriptor_layout,
       VkDescriptorSet& descriptor_set_out);
+  // Returns a persistent descriptor set with the kStorageBufferCompute layout
+  // binding a part of the shared memory buffer containing the range
+  // [start, start + length), and the offset in the buffer where the binding
+  // begins, or VK_NULL_HANDLE if no persistent binding fully contains the
+  // range, in which case a transient descriptor needs to be written instead.
+  // If the device allows, a single binding covers the whole shared memory.
+  VkDescriptorSet GetSharedMemoryComputeDescriptorSet(
+      uint32_t start, uint32_t length, uint32_t& binding_offset_out);
 
   // The returned reference is valid until a cache clear.
   VkDescriptorSetLayout GetTextureDescriptorSetLayout(bool is_vertex,
@@ -269,6 +288,10 @@ class VulkanCommandProcessor : public CommandProcessor {
   void OnGammaRamp256EntryTableValueWritten() override;
   void OnGammaRampPWLValueWritten() override;
 
+  void PrepareForWait() override;
+
+  SharedMemory* GetSharedMemoryForIndirectBufferCache() override;
+
   void IssueSwap(uint32_t frontbuffer_ptr, uint32_t frontbuffer_width,
                  uint32_t frontbuffer_height) override;
 
@@ -279,8 +302,14 @@ class VulkanCommandProcessor : public CommandProcessor {
   bool IssueDraw(xenos::PrimitiveType prim_type, uint32_t index_count,
                  IndexBufferInfo* index_buffer_info,
                  bool major_mode_explicit) override;
+  bool IssueDrawImpl(xenos::PrimitiveType prim_type, uint32_t index_count,
+                     IndexBufferInfo* index_buffer_info,
+                     bool major_mode_explicit);
   bool IssueCopy() override;
 
+  bool BeginOcclusionQuery(uint32_t sample_count_address) override;
+  bool EndOcclusionQuery(uint32_t sample_count_address) override;
+
   void InitializeTrace() override;
 
  private:
@@ -430,6 +459,25 @@ class VulkanCommandProcessor : public CommandProcessor {
 
   void ClearTransientDescriptorPools();
 
+  // Starts a new host query for the current guest occlusion query in the open
+  // submission if it's not running already (a guest query may span multiple
+  // submissions and be suspended for internal draws, with the sample counts of
+  // all the host queries summed). Called right before guest draws so only they
+  // are measured. If no free slot is available, marks the guest query as
+  // incomplete.
+  void BeginOcclusionQuerySlot();
+  // Ends the host query of the current guest occlusion query if it has been
+  // started in the open submission.
+  void EndOcclusionQuerySlot();
+  // Writes the results of the guest occlusion queries in the completed
+  // submissions to the guest memory and releases their slots.
+  void ResolveOcclusionQueries();
+  // Submits the guest occlusion queries that the guest may be waiting for and
+  // writes the results of the completed ones without blocking. Writes fake
+  // results for those not completed within vulkan_occlusion_query_timeout_us
+  // after they have been ended.
+  void PollOcclusionQueryResults();
+
   void SplitPendingBarrier();
 
   void DestroyScratchBuffer();
@@ -492,6 +540,36 @@ class VulkanCommandProcessor : public CommandProcessor {
   // Submission indices of frames that have already been submitted.
   uint64_t closed_frame_submissions_[kMaxFramesInFlight] = {};
 
+  // Occlusion queries - measured on the host with a pool of host queries, and
+  // written to the guest memory when the submissions with them are completed.
+  static constexpr uint32_t kOcclusionQueryPoolSize = 1024;
+  struct OcclusionQuery {
+    uint32_t sample_count_address;
+    // Host queries in the pool, one per submission the guest query spans.
+    std::vector<uint32_t> slots;
+    // The last submission in which a host query for this has been ended.
+    uint64_t submission = 0;
+    // When the guest has ended the query.
+    uint64_t end_host_tick = 0;
+    // Some submissions were not covered by host queries due to the pool being
+    // exhausted - a fake result is written instead of a partial one.
+    bool incomplete = false;
+    bool result_written = false;
+  };
+  // VK_NULL_HANDLE if host occlusion queries are disabled or not supported,
+  // fake results are written in this case.
+  VkQueryPool occlusion_query_pool_ = VK_NULL_HANDLE;
+  std::vector<uint32_t> occlusion_query_slots_free_;
+  bool occlusion_query_active_ = false;
+  OcclusionQuery occlusion_query_current_;
+  // UINT32_MAX if no host query is started in the open submission.
+  uint32_t occlusion_query_current_slot_ = UINT32_MAX;
+  // Ended guest queries, sorted by the submission number.
+  std::deque<OcclusionQuery> occlusion_queries_pending_;
+  // Guest occlusion query results written within the current frame.
+  uint32_t occlusion_queries_measured_ = 0;
+  uint32_t occlusion_queries_faked_ = 0;
+
   // <Submission where last used, resource>, sorted by the submission number.
   std::deque<std::pair<uint64_t, VkDeviceMemory>> destroy_memory_;
   std::deque<std::pair<uint64_t, VkBuffer>> destroy_buffers_;
@@ -576,6 +654,18 @@ class VulkanCommandProcessor : public CommandProcessor {
   VkDescriptorPool shared_memory_and_edram_descriptor_pool_ = VK_NULL_HANDLE;
   VkDescriptorSet shared_memory_and_edram_descriptor_set_;
 
+  // Persistent bindings of the shared memory for compute shaders (texture
+  // loading, resolving), to avoid writing transient descriptors for every
+  // operation. If maxStorageBufferRange is smaller than the shared memory,
+  // windows of shared_memory_compute_binding_range_ overlapping by half, so any
+  // range of up to half of the window size is fully contained in one of them.
+  VkDescriptorPool shared_memory_compute_descriptor_pool_ = VK_NULL_HANDLE;
+  std::vector<VkDescriptorSet> shared_memory_compute_descriptor_sets_;
+  uint32_t shared_memory_compute_binding_range_ = 0;
+  // Within the current frame, reported to the profiler when it ends.
+  uint32_t shared_memory_compute_descriptor_writes_saved_ = 0;
+  uint32_t shared_memory_compute_descriptor_writes_ = 0;
+
   // Bytes 0x0...0x3FF - 256-entry gamma ramp table with B10G10R10X2 data (read
   // as R10G10B10X2 with swizzle).
   // Bytes 0x400...0x9FF - 128-entry PWL R16G16 gamma ramp (R - base, G - delta,
@@ -687,6 +777,26 @@ class VulkanCommandProcessor : public CommandProcessor {
       current_samplers_vertex_;
   std::vector<std::pair<VulkanTextureCache::SamplerParameters, VkSampler>>
       current_samplers_pixel_;
+  // The submission in which the current samplers have been obtained - they can
+  // be reused without UseSampler by subsequent draws in the same submission.
+  uint64_t current_samplers_submission_ = 0;
+  // Blocking waits for sampler slots to be freed within the current frame.
+  uint32_t sampler_overflow_waits_ = 0;
+
+  // Index buffer binding and host vertex input offsets of the last indexed
+  // draw, for merging the next draw into it if its index range directly
+  // continues the one of the last draw.
+  VkBuffer draw_merge_index_buffer_ = VK_NULL_HANDLE;
+  VkDeviceSize draw_merge_index_buffer_end_ = 0;
+  VkIndexType draw_merge_index_type_ = VK_INDEX_TYPE_UINT16;
+  uint32_t draw_merge_host_vertex_input_binding_count_ = 0;
+  std::array<VkDeviceSize, SpirvShaderTranslator::kMaxHostVertexInputAttributes>
+      draw_merge_host_vertex_input_binding_offsets_;
+  // Guest draws, host draw commands and the time spent in IssueDraw within the
+  // current frame.
+  uint32_t guest_draws_ = 0;
+  uint32_t host_draws_ = 0;
+  uint64_t issue_draw_ticks_ = 0;
 
   // Cache render pass currently started in the command buffer with the
   // framebuffer.
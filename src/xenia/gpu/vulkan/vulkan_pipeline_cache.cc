@@ -40,11 +40,12 @@ namespace vulkan {
 
 VulkanPipelineCache::VulkanPipelineCache(
     VulkanCommandProcessor& command_processor,
-    const RegisterFile& register_file,
+    const RegisterFile& register_file, SharedMemory& shared_memory,
     VulkanRenderTargetCache& render_target_cache,
     VkShaderStageFlags guest_shader_vertex_stages)
     : command_processor_(command_processor),
       register_file_(register_file),
+      shared_memory_(shared_memory),
       render_target_cache_(render_target_cache),
       guest_shader_vertex_stages_(guest_shader_vertex_stages) {}
 
@@ -109,6 +110,18 @@ void VulkanPipelineCache::Shutdown() {
   }
   geometry_shaders_.clear();
 
+  // Stop watching the shader memory.
+  {
+    auto global_lock = global_critical_region_.Acquire();
+    for (auto& address_shader_pair : address_shaders_) {
+      if (address_shader_pair.second.watch_handle) {
+        shared_memory_.UnwatchMemoryRange(
+            address_shader_pair.second.watch_handle);
+      }
+    }
+  }
+  address_shaders_.clear();
+
   // Destroy all translated shaders.
   for (auto it : shaders_) {
     delete it.second;
@@ -127,6 +140,7 @@ VulkanShader* VulkanPipelineCache::LoadShader(xenos::ShaderType shader_type,
   // Hash the input memory and lookup the shader.
   uint64_t data_hash =
       XXH3_64bits(host_address, dword_count * sizeof(uint32_t));
+  shader_ucode_bytes_hashed_ += dword_count * sizeof(uint32_t);
   auto it = shaders_.find(data_hash);
   if (it != shaders_.end()) {
     // Shader has been previously loaded.
@@ -142,10 +156,53 @@ VulkanShader* VulkanPipelineCache::LoadShader(xenos::ShaderType shader_type,
   return shader;
 }
 
+VulkanShader* VulkanPipelineCache::LoadShader(xenos::ShaderType shader_type,
+                                              uint32_t guest_address,
+                                              const uint32_t* host_address,
+                                              uint32_t dword_count) {
+  AddressShader& address_shader =
+      address_shaders_[GetAddressShaderKey(shader_type, guest_address,
+                                           dword_count)];
+  if (!address_shader.outdated.load(std::memory_order_acquire)) {
+    // Not written since the last load.
+    return address_shader.shader;
+  }
+
+  // The ucode is only read on the CPU, so the range only needs to be protected
+  // for the watch to be triggered by CPU writes, not uploaded. Watch before
+  // protecting and hashing, so writes after the hashing are caught.
+  uint32_t length = dword_count * sizeof(uint32_t);
+  {
+    auto global_lock = global_critical_region_.Acquire();
+    assert_null(address_shader.watch_handle);
+    address_shader.watch_handle = shared_memory_.WatchMemoryRange(
+        guest_address, length, AddressShaderWatchCallback, this,
+        &address_shader, 0);
+    // Without the watch, the writes can't be tracked, hash on every load.
+    address_shader.outdated.store(!address_shader.watch_handle,
+                                  std::memory_order_relaxed);
+  }
+  if (address_shader.watch_handle) {
+    shared_memory_.ProtectRangeFromCpuWrites(guest_address, length);
+  }
+  address_shader.shader = LoadShader(shader_type, host_address, dword_count);
+  return address_shader.shader;
+}
+
+void VulkanPipelineCache::AddressShaderWatchCallback(
+    const std::unique_lock<std::recursive_mutex>& global_lock, void* context,
+    void* data, uint64_t argument, bool invalidated_by_gpu) {
+  auto& address_shader = *static_cast<AddressShader*>(data);
+  // The watch is cancelled after the callback.
+  address_shader.watch_handle = nullptr;
+  address_shader.outdated.store(true, std::memory_order_release);
+}
+
 SpirvShaderTranslator::Modification
 VulkanPipelineCache::GetCurrentVertexShaderModification(
     const Shader& shader, Shader::HostVertexShaderType host_vertex_shader_type,
-    uint32_t interpolator_mask, bool ps_param_gen_used) const {
+    uint32_t interpolator_mask, bool ps_param_gen_used,
+    bool host_vertex_input) const {
   assert_true(shader.type() == xenos::ShaderType::kVertex);
   assert_true(shader.is_ucode_analyzed());
   const auto& regs = register_file_;
@@ -170,6 +227,8 @@ VulkanPipelineCache::GetCurrentVertexShaderModification(
                      xenos::PrimitiveType::kPointList);
   }
 
+  modification.vertex.host_vertex_input = uint32_t(host_vertex_input);
+
   return modification;
 }
 
@@ -1983,6 +2042,61 @@ bool VulkanPipelineCache::EnsurePipelineCreated(
   VkPipelineVertexInputStateCreateInfo vertex_input_state = {};
   vertex_input_state.sType =
       VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  std::array<VkVertexInputBindingDescription,
+             SpirvShaderTranslator::kMaxHostVertexInputAttributes>
+      vertex_input_bindings;
+  std::array<VkVertexInputAttributeDescription,
+             SpirvShaderTranslator::kMaxHostVertexInputAttributes>
+      vertex_input_attributes;
+  if (SpirvShaderTranslator::Modification(
+          creation_arguments.vertex_shader->modification())
+          .vertex.host_vertex_input) {
+    // Raw 32-bit words of the elements fetched via the host vertex input, the
+    // buffer offsets of the bindings are set when drawing.
+    SpirvShaderTranslator::HostVertexInputAttribute
+        host_vertex_input_attributes
+            [SpirvShaderTranslator::kMaxHostVertexInputAttributes];
+    uint32_t host_vertex_input_attribute_count =
+        SpirvShaderTranslator::GetHostVertexInputAttributes(
+            creation_arguments.vertex_shader->shader(),
+            host_vertex_input_attributes);
+    for (uint32_t i = 0; i < host_vertex_input_attribute_count; ++i) {
+      const SpirvShaderTranslator::HostVertexInputAttribute&
+          host_vertex_input_attribute = host_vertex_input_attributes[i];
+      if (host_vertex_input_attribute.binding >=
+          vertex_input_state.vertexBindingDescriptionCount) {
+        VkVertexInputBindingDescription& vertex_input_binding =
+            vertex_input_bindings[vertex_input_state
+                                      .vertexBindingDescriptionCount++];
+        vertex_input_binding.binding = host_vertex_input_attribute.binding;
+        vertex_input_binding.stride =
+            sizeof(uint32_t) *
+            host_vertex_input_attribute.vertex_binding->stride_words;
+        vertex_input_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+      }
+      VkVertexInputAttributeDescription& vertex_input_attribute =
+          vertex_input_attributes[i];
+      vertex_input_attribute.location = i;
+      vertex_input_attribute.binding = host_vertex_input_attribute.binding;
+      static const VkFormat kWordFormats[] = {
+          VK_FORMAT_R32_UINT,
+          VK_FORMAT_R32G32_UINT,
+          VK_FORMAT_R32G32B32_UINT,
+          VK_FORMAT_R32G32B32A32_UINT,
+      };
+      vertex_input_attribute.format =
+          kWordFormats[host_vertex_input_attribute.word_count - 1];
+      vertex_input_attribute.offset =
+          sizeof(uint32_t) * uint32_t(host_vertex_input_attribute.attribute
+                                          ->fetch_instr.attributes.offset);
+    }
+    vertex_input_state.pVertexBindingDescriptions =
+        vertex_input_bindings.data();
+    vertex_input_state.vertexAttributeDescriptionCount =
+        host_vertex_input_attribute_count;
+    vertex_input_state.pVertexAttributeDescriptions =
+        vertex_input_attributes.data();
+  }
 
   VkPipelineInputAssemblyStateCreateInfo input_assembly_state;
   input_assembly_state.sType =
@@ -10,6 +10,7 @@
 #ifndef XENIA_GPU_VULKAN_VULKAN_PIPELINE_STATE_CACHE_H_
 #define XENIA_GPU_VULKAN_VULKAN_PIPELINE_STATE_CACHE_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <functional>
@@ -18,11 +19,13 @@
 #include <utility>
 
 #include "xenia/base/hash.h"
+#include "xenia/base/mutex.h"
 #include "xenia/base/platform.h"
 #include "xenia/base/xxhash.h"
 #include "xenia/gpu/primitive_processor.h"
 #include "xenia/gpu/register_file.h"
 #include "xenia/gpu/registers.h"
+#include "xenia/gpu/shared_memory.h"
 #include "xenia/gpu/spirv_shader_translator.h"
 #include "xenia/gpu/vulkan/vulkan_render_target_cache.h"
 #include "xenia/gpu/vulkan/vulkan_shader.h"
@@ -52,6 +55,7 @@ class VulkanPipelineCache {
 
   VulkanPipelineCache(VulkanCommandProcessor& command_processor,
                       const RegisterFile& register_file,
+                      SharedMemory& shared_memory,
                       VulkanRenderTargetCache& render_target_cache,
                       VkShaderStageFlags guest_shader_vertex_stages);
   ~VulkanPipelineCache();
@@ -61,17 +65,33 @@ class VulkanPipelineCache {
 
   VulkanShader* LoadShader(xenos::ShaderType shader_type,
                            const uint32_t* host_address, uint32_t dword_count);
+  // Loads the shader from the guest physical memory, hashing the microcode
+  // only if it's loaded from this address for the first time or if the memory
+  // has been written since the last load. Requires an open submission, since
+  // the range is requested in the shared memory for write watching.
+  VulkanShader* LoadShader(xenos::ShaderType shader_type,
+                           uint32_t guest_address, const uint32_t* host_address,
+                           uint32_t dword_count);
+  // Returns the number of microcode bytes hashed since the last call.
+  uint64_t TakeShaderUcodeBytesHashed() {
+    uint64_t bytes_hashed = shader_ucode_bytes_hashed_;
+    shader_ucode_bytes_hashed_ = 0;
+    return bytes_hashed;
+  }
   // Analyze shader microcode on the translator thread.
   void AnalyzeShaderUcode(Shader& shader) {
     shader.AnalyzeUcode(ucode_disasm_buffer_);
   }
 
   // Retrieves the shader modification for the current state. The shader must
-  // have microcode analyzed.
+  // have microcode analyzed. host_vertex_input is whether the host vertex index
+  // is the guest one, and the vertex buffers of the vertex fetches from
+  // SpirvShaderTranslator::GetHostVertexInputAttributes will be bound.
   SpirvShaderTranslator::Modification GetCurrentVertexShaderModification(
       const Shader& shader,
       Shader::HostVertexShaderType host_vertex_shader_type,
-      uint32_t interpolator_mask, bool ps_param_gen_used) const;
+      uint32_t interpolator_mask, bool ps_param_gen_used,
+      bool host_vertex_input) const;
   SpirvShaderTranslator::Modification GetCurrentPixelShaderModification(
       const Shader& shader, uint32_t interpolator_mask,
       uint32_t param_gen_pos) const;
@@ -280,6 +300,9 @@ class VulkanPipelineCache {
 
   VulkanCommandProcessor& command_processor_;
   const RegisterFile& register_file_;
+  SharedMemory& shared_memory_;
+
+  xe::global_critical_region global_critical_region_;
   VulkanRenderTargetCache& render_target_cache_;
   VkShaderStageFlags guest_shader_vertex_stages_;
 
@@ -308,6 +331,29 @@ class VulkanPipelineCache {
                      xe::hash::IdentityHasher<uint64_t>>
       shaders_;
 
+  // Shader previously loaded from a guest memory range. The watch callback
+  // may be invoked on any thread with the global critical region locked, so
+  // watch_handle is only accessed with it locked, while outdated can be
+  // checked without locking.
+  struct AddressShader {
+    VulkanShader* shader = nullptr;
+    SharedMemory::WatchHandle watch_handle = nullptr;
+    std::atomic<bool> outdated{true};
+  };
+  static uint64_t GetAddressShaderKey(xenos::ShaderType shader_type,
+                                      uint32_t guest_address,
+                                      uint32_t dword_count) {
+    return uint64_t(guest_address) | (uint64_t(dword_count & 0xFFFF) << 32) |
+           (uint64_t(shader_type) << 48);
+  }
+  static void AddressShaderWatchCallback(
+      const std::unique_lock<std::recursive_mutex>& global_lock, void* context,
+      void* data, uint64_t argument, bool invalidated_by_gpu);
+  // Guest address, dword count and type -> shader. Nodes of unordered_map are
+  // never moved, so the watches refer to the values directly.
+  std::unordered_map<uint64_t, AddressShader> address_shaders_;
+  uint64_t shader_ucode_bytes_hashed_ = 0;
+
   // Geometry shaders for Xenos primitive types not supported by Vulkan.
   // Stores VK_NULL_HANDLE if failed to create.
   std::unordered_map<GeometryShaderKey, VkShaderModule,
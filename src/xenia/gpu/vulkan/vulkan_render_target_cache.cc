@@ -24,6 +24,7 @@
 #include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
+#include "xenia/base/profiling.h"
 #include "xenia/gpu/draw_util.h"
 #include "xenia/gpu/registers.h"
 #include "xenia/gpu/spirv_builder.h"
@@ -54,6 +55,14 @@ DEFINE_string(
     "  Choose what is considered the most optimal for the system (currently "
     "always FB because the FSI path is much slower now).",
     "GPU");
+DEFINE_bool(
+    resolve_direct_from_host_render_targets, true,
+    "With the host render targets path, copy render target contents directly "
+    "to the shared memory in resolves that don't need any format conversion, "
+    "rather than dumping them to the EDRAM buffer first and resolving from it "
+    "in a separate dispatch.\n"
+    "Disable to compare the results with the EDRAM buffer resolve path.",
+    "GPU");
 
 namespace xe {
 namespace gpu {
@@ -728,6 +737,53 @@ bool VulkanRenderTargetCache::Initialize(uint32_t shared_memory_binding_count) {
       Shutdown();
       return false;
     }
+
+    // Direct resolve pipeline layouts.
+    VkDescriptorSetLayout
+        direct_resolve_descriptor_set_layouts[kDirectResolveDescriptorSetCount];
+    direct_resolve_descriptor_set_layouts[kDirectResolveDescriptorSetDest] =
+        command_processor_.GetSingleTransientDescriptorLayout(
+            VulkanCommandProcessor::SingleTransientDescriptorLayout ::
+                kStorageBufferCompute);
+    direct_resolve_descriptor_set_layouts[kDirectResolveDescriptorSetSource] =
+        descriptor_set_layout_sampled_image_;
+    VkPushConstantRange direct_resolve_push_constant_range;
+    direct_resolve_push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    direct_resolve_push_constant_range.offset = 0;
+    direct_resolve_push_constant_range.size =
+        sizeof(uint32_t) * kDirectResolvePushConstantCount;
+    VkPipelineLayoutCreateInfo direct_resolve_pipeline_layout_create_info;
+    direct_resolve_pipeline_layout_create_info.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    direct_resolve_pipeline_layout_create_info.pNext = nullptr;
+    direct_resolve_pipeline_layout_create_info.flags = 0;
+    direct_resolve_pipeline_layout_create_info.setLayoutCount =
+        uint32_t(xe::countof(direct_resolve_descriptor_set_layouts));
+    direct_resolve_pipeline_layout_create_info.pSetLayouts =
+        direct_resolve_descriptor_set_layouts;
+    direct_resolve_pipeline_layout_create_info.pushConstantRangeCount = 1;
+    direct_resolve_pipeline_layout_create_info.pPushConstantRanges =
+        &direct_resolve_push_constant_range;
+    if (dfn.vkCreatePipelineLayout(
+            device, &direct_resolve_pipeline_layout_create_info, nullptr,
+            &direct_resolve_pipeline_layout_color_) != VK_SUCCESS) {
+      XELOGE(
+          "VulkanRenderTargetCache: Failed to create the color render target "
+          "direct resolve pipeline layout");
+      Shutdown();
+      return false;
+    }
+    direct_resolve_descriptor_set_layouts[kDirectResolveDescriptorSetSource] =
+        descriptor_set_layout_sampled_image_x2_;
+    if (dfn.vkCreatePipelineLayout(
+            device, &direct_resolve_pipeline_layout_create_info, nullptr,
+            &direct_resolve_pipeline_layout_depth_) != VK_SUCCESS) {
+      XELOGE(
+          "VulkanRenderTargetCache: Failed to create the depth render target "
+          "direct resolve pipeline layout");
+      Shutdown();
+      return false;
+    }
   } else if (path_ == Path::kPixelShaderInterlock) {
     // Pixel (fragment) shader interlock.
 
@@ -905,6 +961,21 @@ void VulkanRenderTargetCache::Shutdown(bool from_destructor) {
   ui::vulkan::util::DestroyAndNullHandle(dfn.vkDestroyRenderPass, device,
                                          fsi_render_pass_);
 
+  for (const auto& direct_resolve_pipeline_pair : direct_resolve_pipelines_) {
+    // May be null to prevent recreation attempts.
+    if (direct_resolve_pipeline_pair.second != VK_NULL_HANDLE) {
+      dfn.vkDestroyPipeline(device, direct_resolve_pipeline_pair.second,
+                            nullptr);
+    }
+  }
+  direct_resolve_pipelines_.clear();
+  ui::vulkan::util::DestroyAndNullHandle(
+      dfn.vkDestroyPipelineLayout, device,
+      direct_resolve_pipeline_layout_depth_);
+  ui::vulkan::util::DestroyAndNullHandle(
+      dfn.vkDestroyPipelineLayout, device,
+      direct_resolve_pipeline_layout_color_);
+
   for (const auto& dump_pipeline_pair : dump_pipelines_) {
     // May be null to prevent recreation attempts.
     if (dump_pipeline_pair.second != VK_NULL_HANDLE) {
@@ -1030,6 +1101,15 @@ void VulkanRenderTargetCache::EndSubmission() {
   }
 }
 
+void VulkanRenderTargetCache::EndFrame() {
+  COUNT_profile_set("gpu/render_target_cache/vulkan/transfer_render_passes",
+                    transfer_render_passes_in_frame_);
+  COUNT_profile_set("gpu/render_target_cache/vulkan/transfers",
+                    transfers_in_frame_);
+  transfer_render_passes_in_frame_ = 0;
+  transfers_in_frame_ = 0;
+}
+
 bool VulkanRenderTargetCache::Resolve(const Memory& memory,
                                       VulkanSharedMemory& shared_memory,
                                       VulkanTextureCache& texture_cache,
@@ -1063,26 +1143,83 @@ bool VulkanRenderTargetCache::Resolve(const Memory& memory,
   // Copying.
   bool copied = false;
   if (resolve_info.copy_dest_extent_length) {
-    if (GetPath() == Path::kHostRenderTargets) {
-      // Dump the current contents of the render targets owning the affected
-      // range to edram_buffer_.
-      // TODO(Triang3l): Direct host render target -> shared memory resolve
-      // shaders for non-converting cases.
-      uint32_t dump_base;
-      uint32_t dump_row_length_used;
-      uint32_t dump_rows;
-      uint32_t dump_pitch;
-      resolve_info.GetCopyEdramTileSpan(dump_base, dump_row_length_used,
-                                        dump_rows, dump_pitch);
-      DumpRenderTargets(dump_base, dump_row_length_used, dump_rows, dump_pitch);
-    }
-
     draw_util::ResolveCopyShaderConstants copy_shader_constants;
     uint32_t copy_group_count_x, copy_group_count_y;
     draw_util::ResolveCopyShaderIndex copy_shader = resolve_info.GetCopyShader(
         draw_resolution_scale_x(), draw_resolution_scale_y(),
         copy_shader_constants, copy_group_count_x, copy_group_count_y);
     assert_true(copy_group_count_x && copy_group_count_y);
+
+    VulkanRenderTarget* direct_resolve_source = nullptr;
+    uint32_t direct_resolve_source_origin_x = 0;
+    uint32_t direct_resolve_source_origin_y = 0;
+    VkPipeline direct_resolve_pipeline = VK_NULL_HANDLE;
+    if (GetPath() == Path::kHostRenderTargets) {
+      // If the whole source is owned by a single render target and the data
+      // doesn't need conversion, copy from it to the shared memory directly.
+      if (copy_shader ==
+          draw_util::ResolveCopyShaderIndex::kFast32bpp1x2xMSAA) {
+        direct_resolve_source = GetDirectResolveSource(
+            resolve_info, direct_resolve_source_origin_x,
+            direct_resolve_source_origin_y);
+      }
+      if (direct_resolve_source) {
+        RenderTargetKey direct_resolve_source_key =
+            direct_resolve_source->key();
+        DirectResolvePipelineKey direct_resolve_pipeline_key;
+        direct_resolve_pipeline_key.resource_format =
+            direct_resolve_source_key.resource_format;
+        direct_resolve_pipeline_key.is_depth =
+            direct_resolve_source_key.is_depth;
+        direct_resolve_pipeline_key.dest_endian =
+            resolve_info.copy_dest_info.copy_dest_endian;
+        direct_resolve_pipeline_key.red_blue_swap =
+            DirectResolveRedBlueSwap::kNone;
+        if (resolve_info.copy_dest_info.copy_dest_swap) {
+          // Like in the EDRAM buffer resolve shaders, checking the format
+          // value directly regardless of whether it's color or depth.
+          draw_util::ResolveEdramInfo direct_resolve_edram_info =
+              resolve_info.IsCopyingDepth() ? resolve_info.depth_edram_info
+                                            : resolve_info.color_edram_info;
+          switch (xenos::ColorRenderTargetFormat(
+              direct_resolve_edram_info.format)) {
+            case xenos::ColorRenderTargetFormat::k_8_8_8_8:
+            case xenos::ColorRenderTargetFormat::k_8_8_8_8_GAMMA:
+              direct_resolve_pipeline_key.red_blue_swap =
+                  DirectResolveRedBlueSwap::k_8_8_8_8;
+              break;
+            case xenos::ColorRenderTargetFormat::k_2_10_10_10:
+            case xenos::ColorRenderTargetFormat::k_2_10_10_10_FLOAT:
+            case xenos::ColorRenderTargetFormat::k_2_10_10_10_AS_10_10_10_10:
+            case xenos::ColorRenderTargetFormat::
+                k_2_10_10_10_FLOAT_AS_16_16_16_16:
+              direct_resolve_pipeline_key.red_blue_swap =
+                  DirectResolveRedBlueSwap::k_2_10_10_10;
+              break;
+            default:
+              break;
+          }
+        }
+        direct_resolve_pipeline =
+            GetDirectResolvePipeline(direct_resolve_pipeline_key);
+        if (direct_resolve_pipeline == VK_NULL_HANDLE) {
+          direct_resolve_source = nullptr;
+        }
+      }
+      if (!direct_resolve_source) {
+        // Dump the current contents of the render targets owning the affected
+        // range to edram_buffer_.
+        uint32_t dump_base;
+        uint32_t dump_row_length_used;
+        uint32_t dump_rows;
+        uint32_t dump_pitch;
+        resolve_info.GetCopyEdramTileSpan(dump_base, dump_row_length_used,
+                                          dump_rows, dump_pitch);
+        DumpRenderTargets(dump_base, dump_row_length_used, dump_rows,
+                          dump_pitch);
+      }
+    }
+
     if (copy_shader != draw_util::ResolveCopyShaderIndex::kUnknown) {
       const draw_util::ResolveCopyShaderInfo& copy_shader_info =
           draw_util::resolve_copy_shader_info[size_t(copy_shader)];
@@ -1098,77 +1235,142 @@ bool VulkanRenderTargetCache::Resolve(const Memory& memory,
             "VulkanRenderTargetCache: Failed to obtain the resolve destination "
             "memory region");
       } else {
-        // TODO(Triang3l): Switching between descriptors if exceeding
-        // maxStorageBufferRange.
-        // TODO(Triang3l): Use a single 512 MB shared memory binding if
-        // possible.
-        VkDescriptorSet descriptor_set_dest =
-            command_processor_.AllocateSingleTransientDescriptor(
-                VulkanCommandProcessor::SingleTransientDescriptorLayout ::
-                    kStorageBufferCompute);
+        // The destination addresses in the shaders are relative to the
+        // beginning of the binding.
+        uint32_t dest_binding_offset = resolve_info.copy_dest_base;
+        uint32_t dest_binding_range = resolve_info.copy_dest_extent_start -
+                                      resolve_info.copy_dest_base +
+                                      resolve_info.copy_dest_extent_length;
+        VkDescriptorSet descriptor_set_dest = VK_NULL_HANDLE;
+        // TODO(Triang3l): Scaled resolve buffer binding.
+        if (!draw_resolution_scaled) {
+          descriptor_set_dest =
+              command_processor_.GetSharedMemoryComputeDescriptorSet(
+                  dest_binding_offset, dest_binding_range,
+                  dest_binding_offset);
+        }
+        if (descriptor_set_dest == VK_NULL_HANDLE) {
+          descriptor_set_dest =
+              command_processor_.AllocateSingleTransientDescriptor(
+                  VulkanCommandProcessor::SingleTransientDescriptorLayout ::
+                      kStorageBufferCompute);
+          if (descriptor_set_dest != VK_NULL_HANDLE) {
+            // Write the destination descriptor.
+            VkDescriptorBufferInfo write_descriptor_set_dest_buffer_info;
+            write_descriptor_set_dest_buffer_info.buffer =
+                shared_memory.buffer();
+            write_descriptor_set_dest_buffer_info.offset = dest_binding_offset;
+            write_descriptor_set_dest_buffer_info.range = dest_binding_range;
+            VkWriteDescriptorSet write_descriptor_set_dest;
+            write_descriptor_set_dest.sType =
+                VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write_descriptor_set_dest.pNext = nullptr;
+            write_descriptor_set_dest.dstSet = descriptor_set_dest;
+            write_descriptor_set_dest.dstBinding = 0;
+            write_descriptor_set_dest.dstArrayElement = 0;
+            write_descriptor_set_dest.descriptorCount = 1;
+            write_descriptor_set_dest.descriptorType =
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write_descriptor_set_dest.pImageInfo = nullptr;
+            write_descriptor_set_dest.pBufferInfo =
+                &write_descriptor_set_dest_buffer_info;
+            write_descriptor_set_dest.pTexelBufferView = nullptr;
+            dfn.vkUpdateDescriptorSets(device, 1, &write_descriptor_set_dest,
+                                       0, nullptr);
+          }
+        }
         if (descriptor_set_dest != VK_NULL_HANDLE) {
-          // Write the destination descriptor.
-          // TODO(Triang3l): Scaled resolve buffer binding.
-          VkDescriptorBufferInfo write_descriptor_set_dest_buffer_info;
-          write_descriptor_set_dest_buffer_info.buffer = shared_memory.buffer();
-          write_descriptor_set_dest_buffer_info.offset =
-              resolve_info.copy_dest_base;
-          write_descriptor_set_dest_buffer_info.range =
-              resolve_info.copy_dest_extent_start -
-              resolve_info.copy_dest_base +
-              resolve_info.copy_dest_extent_length;
-          VkWriteDescriptorSet write_descriptor_set_dest;
-          write_descriptor_set_dest.sType =
-              VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-          write_descriptor_set_dest.pNext = nullptr;
-          write_descriptor_set_dest.dstSet = descriptor_set_dest;
-          write_descriptor_set_dest.dstBinding = 0;
-          write_descriptor_set_dest.dstArrayElement = 0;
-          write_descriptor_set_dest.descriptorCount = 1;
-          write_descriptor_set_dest.descriptorType =
-              VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-          write_descriptor_set_dest.pImageInfo = nullptr;
-          write_descriptor_set_dest.pBufferInfo =
-              &write_descriptor_set_dest_buffer_info;
-          write_descriptor_set_dest.pTexelBufferView = nullptr;
-          dfn.vkUpdateDescriptorSets(device, 1, &write_descriptor_set_dest, 0,
-                                     nullptr);
-
           // Submit the resolve.
           // TODO(Triang3l): Transition the scaled resolve buffer.
           shared_memory.Use(VulkanSharedMemory::Usage::kComputeWrite,
                             std::pair<uint32_t, uint32_t>(
                                 resolve_info.copy_dest_extent_start,
                                 resolve_info.copy_dest_extent_length));
-          UseEdramBuffer(EdramBufferUsage::kComputeRead);
-          command_processor_.BindExternalComputePipeline(
-              resolve_copy_pipelines_[size_t(copy_shader)]);
-          VkDescriptorSet descriptor_sets[kResolveCopyDescriptorSetCount] = {};
-          descriptor_sets[kResolveCopyDescriptorSetEdram] =
-              edram_storage_buffer_descriptor_set_;
-          descriptor_sets[kResolveCopyDescriptorSetDest] = descriptor_set_dest;
-          command_buffer.CmdVkBindDescriptorSets(
-              VK_PIPELINE_BIND_POINT_COMPUTE, resolve_copy_pipeline_layout_, 0,
-              uint32_t(xe::countof(descriptor_sets)), descriptor_sets, 0,
-              nullptr);
-          if (draw_resolution_scaled) {
+          if (direct_resolve_source) {
+            RenderTargetKey direct_resolve_source_key =
+                direct_resolve_source->key();
+            command_processor_.PushImageMemoryBarrier(
+                direct_resolve_source->image(),
+                ui::vulkan::util::InitializeSubresourceRange(
+                    direct_resolve_source_key.is_depth
+                        ? (VK_IMAGE_ASPECT_DEPTH_BIT |
+                           VK_IMAGE_ASPECT_STENCIL_BIT)
+                        : VK_IMAGE_ASPECT_COLOR_BIT),
+                direct_resolve_source->current_stage_mask(),
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                direct_resolve_source->current_access_mask(),
+                VK_ACCESS_SHADER_READ_BIT,
+                direct_resolve_source->current_layout(),
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            direct_resolve_source->SetUsage(
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            command_processor_.BindExternalComputePipeline(
+                direct_resolve_pipeline);
+            VkPipelineLayout direct_resolve_pipeline_layout =
+                direct_resolve_source_key.is_depth
+                    ? direct_resolve_pipeline_layout_depth_
+                    : direct_resolve_pipeline_layout_color_;
+            VkDescriptorSet direct_resolve_descriptor_sets
+                [kDirectResolveDescriptorSetCount];
+            direct_resolve_descriptor_sets[kDirectResolveDescriptorSetDest] =
+                descriptor_set_dest;
+            direct_resolve_descriptor_sets[kDirectResolveDescriptorSetSource] =
+                direct_resolve_source->GetDescriptorSetTransferSource();
+            command_buffer.CmdVkBindDescriptorSets(
+                VK_PIPELINE_BIND_POINT_COMPUTE, direct_resolve_pipeline_layout,
+                0, uint32_t(xe::countof(direct_resolve_descriptor_sets)),
+                direct_resolve_descriptor_sets, 0, nullptr);
+            uint32_t direct_resolve_constants[kDirectResolvePushConstantCount];
+            direct_resolve_constants[kDirectResolvePushConstantSourceOrigin] =
+                direct_resolve_source_origin_x |
+                (direct_resolve_source_origin_y << 16);
+            direct_resolve_constants[kDirectResolvePushConstantDestOrigin] =
+                (resolve_info.copy_dest_coordinate_info.offset_x_div_8
+                 << xenos::kResolveAlignmentPixelsLog2) |
+                (resolve_info.copy_dest_coordinate_info.offset_y_div_8
+                 << (xenos::kResolveAlignmentPixelsLog2 + 16));
+            direct_resolve_constants[kDirectResolvePushConstantDestPitchDiv32] =
+                resolve_info.copy_dest_coordinate_info.pitch_aligned_div_32;
+            direct_resolve_constants[kDirectResolvePushConstantDestBase] =
+                resolve_info.copy_dest_base - dest_binding_offset;
             command_buffer.CmdVkPushConstants(
-                resolve_copy_pipeline_layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
-                sizeof(copy_shader_constants.dest_relative),
-                &copy_shader_constants.dest_relative);
+                direct_resolve_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                sizeof(direct_resolve_constants), direct_resolve_constants);
+            command_processor_.SubmitBarriers(true);
+            // One invocation per pixel, the resolve area is aligned to 8x8.
+            command_buffer.CmdVkDispatch(
+                resolve_info.coordinate_info.width_div_8,
+                resolve_info.height_div_8, 1);
           } else {
-            // TODO(Triang3l): Proper dest_base in case of one 512 MB shared
-            // memory binding, or multiple shared memory bindings in case of
-            // splitting due to maxStorageBufferRange overflow.
-            copy_shader_constants.dest_base -=
-                uint32_t(write_descriptor_set_dest_buffer_info.offset);
-            command_buffer.CmdVkPushConstants(
-                resolve_copy_pipeline_layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
-                sizeof(copy_shader_constants), &copy_shader_constants);
+            UseEdramBuffer(EdramBufferUsage::kComputeRead);
+            command_processor_.BindExternalComputePipeline(
+                resolve_copy_pipelines_[size_t(copy_shader)]);
+            VkDescriptorSet
+                descriptor_sets[kResolveCopyDescriptorSetCount] = {};
+            descriptor_sets[kResolveCopyDescriptorSetEdram] =
+                edram_storage_buffer_descriptor_set_;
+            descriptor_sets[kResolveCopyDescriptorSetDest] =
+                descriptor_set_dest;
+            command_buffer.CmdVkBindDescriptorSets(
+                VK_PIPELINE_BIND_POINT_COMPUTE, resolve_copy_pipeline_layout_,
+                0, uint32_t(xe::countof(descriptor_sets)), descriptor_sets, 0,
+                nullptr);
+            if (draw_resolution_scaled) {
+              command_buffer.CmdVkPushConstants(
+                  resolve_copy_pipeline_layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                  sizeof(copy_shader_constants.dest_relative),
+                  &copy_shader_constants.dest_relative);
+            } else {
+              copy_shader_constants.dest_base -= dest_binding_offset;
+              command_buffer.CmdVkPushConstants(
+                  resolve_copy_pipeline_layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                  sizeof(copy_shader_constants), &copy_shader_constants);
+            }
+            command_processor_.SubmitBarriers(true);
+            command_buffer.CmdVkDispatch(copy_group_count_x, copy_group_count_y,
+                                         1);
           }
-          command_processor_.SubmitBarriers(true);
-          command_buffer.CmdVkDispatch(copy_group_count_x, copy_group_count_y,
-                                       1);
 
           // Invalidate textures and mark the range as scaled if needed.
           texture_cache.MarkRangeAsResolved(
@@ -4782,13 +4984,13 @@ void VulkanRenderTargetCache::PerformTransfersAndResolveClears(
     }
 
     // Get the objects needed for transfers to the destination.
-    // TODO(Triang3l): Reuse the guest render pass for transfers where possible
-    // (if the Vulkan format used for drawing is also usable for transfers - for
-    // instance, R8G8B8A8_UNORM can be used for both, so the guest pass can be
-    // reused, but R16G16B16A16_SFLOAT render targets use R16G16B16A16_UINT for
-    // transfers, so the transfer pass has to be separate) to avoid stores and
-    // loads on tile-based devices to make this actually applicable. Also
-    // overall perform all non-cross-copying transfers for the current
+    // Using the same render pass and framebuffer as the guest would use for
+    // drawing only to the destination render target if the Vulkan format used
+    // for drawing is also usable for transfers (for instance, R8G8B8A8_UNORM
+    // can be used for both, but R16G16B16A16_SFLOAT render targets use
+    // R16G16B16A16_UINT for transfers), so the render pass is not broken
+    // between the transfers and the subsequent drawing in this case.
+    // TODO(Triang3l): Perform all non-cross-copying transfers for the current
     // framebuffer configuration in a single pass, to load / store only once.
     RenderPassKey transfer_render_pass_key;
     transfer_render_pass_key.msaa_samples = dest_rt_key.msaa_samples;
@@ -4799,7 +5001,11 @@ void VulkanRenderTargetCache::PerformTransfersAndResolveClears(
       transfer_render_pass_key.depth_and_color_used = 0b1 << 1;
       transfer_render_pass_key.color_0_view_format =
           dest_rt_key.GetColorFormat();
-      transfer_render_pass_key.color_rts_use_transfer_formats = 1;
+      bool dest_transfer_format_is_integer;
+      GetColorOwnershipTransferVulkanFormat(dest_rt_key.GetColorFormat(),
+                                            &dest_transfer_format_is_integer);
+      transfer_render_pass_key.color_rts_use_transfer_formats =
+          uint32_t(dest_transfer_format_is_integer);
     }
     VkRenderPass transfer_render_pass =
         GetHostRenderTargetsRenderPass(transfer_render_pass_key);
@@ -4969,8 +5175,12 @@ void VulkanRenderTargetCache::PerformTransfersAndResolveClears(
 
       // Perform the transfers for the render target.
 
-      command_processor_.SubmitBarriersAndEnterRenderTargetCacheRenderPass(
-          transfer_render_pass, transfer_framebuffer);
+      command_processor_.SuspendOcclusionQuery();
+      if (command_processor_.SubmitBarriersAndEnterRenderTargetCacheRenderPass(
+              transfer_render_pass, transfer_framebuffer)) {
+        ++transfer_render_passes_in_frame_;
+      }
+      transfers_in_frame_ += uint32_t(current_transfers.size());
 
       if (stencil_clear_rectangle_count) {
         VkClearAttachment* stencil_clear_attachment;
@@ -5231,81 +5441,114 @@ void VulkanRenderTargetCache::PerformTransfersAndResolveClears(
           }
         }
 
-        // Apply the new bindings.
-        // TODO(Triang3l): Merge binding updates into spans.
+        // Apply the new bindings, with consecutive descriptor sets and push
+        // constants updated in a single call.
         VkPipelineLayout transfer_pipeline_layout =
             transfer_pipeline_layouts_[size_t(transfer_pipeline_layout_index)];
         uint32_t transfer_descriptor_sets_unbound =
             transfer_pipeline_layout_info.used_descriptor_sets &
             ~transfer_descriptor_sets_bound;
-        if (transfer_descriptor_sets_unbound &
-            kTransferUsedDescriptorSetHostDepthBufferBit) {
-          command_buffer.CmdVkBindDescriptorSets(
-              VK_PIPELINE_BIND_POINT_GRAPHICS, transfer_pipeline_layout,
-              xe::bit_count(transfer_pipeline_layout_info.used_descriptor_sets &
-                            (kTransferUsedDescriptorSetHostDepthBufferBit - 1)),
-              1, &edram_storage_buffer_descriptor_set_, 0, nullptr);
-          transfer_descriptor_sets_bound |=
-              kTransferUsedDescriptorSetHostDepthBufferBit;
-        }
-        if (transfer_descriptor_sets_unbound &
-            kTransferUsedDescriptorSetHostDepthStencilTexturesBit) {
-          command_buffer.CmdVkBindDescriptorSets(
-              VK_PIPELINE_BIND_POINT_GRAPHICS, transfer_pipeline_layout,
-              xe::bit_count(
-                  transfer_pipeline_layout_info.used_descriptor_sets &
-                  (kTransferUsedDescriptorSetHostDepthStencilTexturesBit - 1)),
-              1, &last_descriptor_set_host_depth_stencil_textures, 0, nullptr);
-          transfer_descriptor_sets_bound |=
-              kTransferUsedDescriptorSetHostDepthStencilTexturesBit;
-        }
-        if (transfer_descriptor_sets_unbound &
-            kTransferUsedDescriptorSetDepthStencilTexturesBit) {
-          command_buffer.CmdVkBindDescriptorSets(
-              VK_PIPELINE_BIND_POINT_GRAPHICS, transfer_pipeline_layout,
-              xe::bit_count(
-                  transfer_pipeline_layout_info.used_descriptor_sets &
-                  (kTransferUsedDescriptorSetDepthStencilTexturesBit - 1)),
-              1, &last_descriptor_set_depth_stencil_textures, 0, nullptr);
-          transfer_descriptor_sets_bound |=
-              kTransferUsedDescriptorSetDepthStencilTexturesBit;
-        }
-        if (transfer_descriptor_sets_unbound &
-            kTransferUsedDescriptorSetColorTextureBit) {
-          command_buffer.CmdVkBindDescriptorSets(
-              VK_PIPELINE_BIND_POINT_GRAPHICS, transfer_pipeline_layout,
-              xe::bit_count(transfer_pipeline_layout_info.used_descriptor_sets &
-                            (kTransferUsedDescriptorSetColorTextureBit - 1)),
-              1, &last_descriptor_set_color_texture, 0, nullptr);
-          transfer_descriptor_sets_bound |=
-              kTransferUsedDescriptorSetColorTextureBit;
+        if (transfer_descriptor_sets_unbound) {
+          VkDescriptorSet
+              transfer_descriptor_set_values[kTransferUsedDescriptorSetCount];
+          transfer_descriptor_set_values
+              [kTransferUsedDescriptorSetHostDepthBuffer] =
+                  edram_storage_buffer_descriptor_set_;
+          transfer_descriptor_set_values
+              [kTransferUsedDescriptorSetHostDepthStencilTextures] =
+                  last_descriptor_set_host_depth_stencil_textures;
+          transfer_descriptor_set_values
+              [kTransferUsedDescriptorSetDepthStencilTextures] =
+                  last_descriptor_set_depth_stencil_textures;
+          transfer_descriptor_set_values
+              [kTransferUsedDescriptorSetColorTexture] =
+                  last_descriptor_set_color_texture;
+          VkDescriptorSet
+              transfer_descriptor_set_span[kTransferUsedDescriptorSetCount];
+          uint32_t transfer_descriptor_set_span_first = 0;
+          uint32_t transfer_descriptor_set_span_length = 0;
+          uint32_t transfer_descriptor_set_index = 0;
+          for (uint32_t j = 0; j <= kTransferUsedDescriptorSetCount; ++j) {
+            uint32_t transfer_descriptor_set_bit = uint32_t(1) << j;
+            bool transfer_descriptor_set_in_layout =
+                j < kTransferUsedDescriptorSetCount &&
+                (transfer_pipeline_layout_info.used_descriptor_sets &
+                 transfer_descriptor_set_bit);
+            if (j < kTransferUsedDescriptorSetCount &&
+                !transfer_descriptor_set_in_layout) {
+              continue;
+            }
+            if (transfer_descriptor_set_in_layout &&
+                (transfer_descriptor_sets_unbound &
+                 transfer_descriptor_set_bit)) {
+              if (!transfer_descriptor_set_span_length) {
+                transfer_descriptor_set_span_first =
+                    transfer_descriptor_set_index;
+              }
+              transfer_descriptor_set_span
+                  [transfer_descriptor_set_span_length++] =
+                      transfer_descriptor_set_values[j];
+            } else if (transfer_descriptor_set_span_length) {
+              command_buffer.CmdVkBindDescriptorSets(
+                  VK_PIPELINE_BIND_POINT_GRAPHICS, transfer_pipeline_layout,
+                  transfer_descriptor_set_span_first,
+                  transfer_descriptor_set_span_length,
+                  transfer_descriptor_set_span, 0, nullptr);
+              transfer_descriptor_set_span_length = 0;
+            }
+            ++transfer_descriptor_set_index;
+          }
+          transfer_descriptor_sets_bound |= transfer_descriptor_sets_unbound;
         }
+        // The stencil bit is set for every draw separately.
         uint32_t transfer_push_constants_unset =
             transfer_pipeline_layout_info.used_push_constant_dwords &
-            ~transfer_push_constants_set;
-        if (transfer_push_constants_unset &
-            kTransferUsedPushConstantDwordHostDepthAddressBit) {
-          command_buffer.CmdVkPushConstants(
-              transfer_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT,
-              sizeof(uint32_t) *
-                  xe::bit_count(
-                      transfer_pipeline_layout_info.used_push_constant_dwords &
-                      (kTransferUsedPushConstantDwordHostDepthAddressBit - 1)),
-              sizeof(uint32_t), &last_host_depth_address_constant);
-          transfer_push_constants_set |=
-              kTransferUsedPushConstantDwordHostDepthAddressBit;
-        }
-        if (transfer_push_constants_unset &
-            kTransferUsedPushConstantDwordAddressBit) {
-          command_buffer.CmdVkPushConstants(
-              transfer_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT,
-              sizeof(uint32_t) *
-                  xe::bit_count(
-                      transfer_pipeline_layout_info.used_push_constant_dwords &
-                      (kTransferUsedPushConstantDwordAddressBit - 1)),
-              sizeof(uint32_t), &last_address_constant);
-          transfer_push_constants_set |=
-              kTransferUsedPushConstantDwordAddressBit;
+            ~transfer_push_constants_set &
+            ~kTransferUsedPushConstantDwordStencilMaskBit;
+        if (transfer_push_constants_unset) {
+          uint32_t transfer_push_constant_values
+              [kTransferUsedPushConstantDwordCount];
+          transfer_push_constant_values
+              [kTransferUsedPushConstantDwordHostDepthAddress] =
+                  last_host_depth_address_constant.constant;
+          transfer_push_constant_values
+              [kTransferUsedPushConstantDwordAddress] =
+                  last_address_constant.constant;
+          uint32_t
+              transfer_push_constant_span[kTransferUsedPushConstantDwordCount];
+          uint32_t transfer_push_constant_span_first = 0;
+          uint32_t transfer_push_constant_span_length = 0;
+          uint32_t transfer_push_constant_index = 0;
+          for (uint32_t j = 0; j <= kTransferUsedPushConstantDwordCount; ++j) {
+            uint32_t transfer_push_constant_bit = uint32_t(1) << j;
+            bool transfer_push_constant_in_layout =
+                j < kTransferUsedPushConstantDwordCount &&
+                (transfer_pipeline_layout_info.used_push_constant_dwords &
+                 transfer_push_constant_bit);
+            if (j < kTransferUsedPushConstantDwordCount &&
+                !transfer_push_constant_in_layout) {
+              continue;
+            }
+            if (transfer_push_constant_in_layout &&
+                (transfer_push_constants_unset & transfer_push_constant_bit)) {
+              if (!transfer_push_constant_span_length) {
+                transfer_push_constant_span_first =
+                    transfer_push_constant_index;
+              }
+              transfer_push_constant_span
+                  [transfer_push_constant_span_length++] =
+                      transfer_push_constant_values[j];
+            } else if (transfer_push_constant_span_length) {
+              command_buffer.CmdVkPushConstants(
+                  transfer_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT,
+                  sizeof(uint32_t) * transfer_push_constant_span_first,
+                  sizeof(uint32_t) * transfer_push_constant_span_length,
+                  transfer_push_constant_span);
+              transfer_push_constant_span_length = 0;
+            }
+            ++transfer_push_constant_index;
+          }
+          transfer_push_constants_set |= transfer_push_constants_unset;
         }
 
         for (uint32_t j = 0; j < transfer_sample_pipeline_count; ++j) {
@@ -5336,8 +5579,11 @@ void VulkanRenderTargetCache::PerformTransfersAndResolveClears(
 
     // Perform the clear.
     if (resolve_clear_needed) {
-      command_processor_.SubmitBarriersAndEnterRenderTargetCacheRenderPass(
-          transfer_render_pass, transfer_framebuffer);
+      command_processor_.SuspendOcclusionQuery();
+      if (command_processor_.SubmitBarriersAndEnterRenderTargetCacheRenderPass(
+              transfer_render_pass, transfer_framebuffer)) {
+        ++transfer_render_passes_in_frame_;
+      }
       VkClearAttachment resolve_clear_attachment;
       resolve_clear_attachment.colorAttachment = 0;
       std::memset(&resolve_clear_attachment.clearValue, 0,
@@ -5434,6 +5680,176 @@ void VulkanRenderTargetCache::PerformTransfersAndResolveClears(
   }
 }
 
+void VulkanRenderTargetCache::PackHostRenderTargetSample(
+    SpirvBuilder& builder, spv::Id ext_inst_glsl_std_450, bool is_depth,
+    uint32_t resource_format, bool source_is_uint, spv::Id source_vec4,
+    spv::Id source_stencil, spv::Id* packed_out) const {
+  spv::Id type_uint = builder.makeUintType(32);
+  spv::Id type_float = builder.makeFloatType(32);
+  spv::Id source_component_type = source_is_uint ? type_uint : type_float;
+  bool format_is_64bpp =
+      !is_depth && xenos::IsColorRenderTargetFormat64bpp(
+                       xenos::ColorRenderTargetFormat(resource_format));
+  if (is_depth) {
+    spv::Id source_depth32 =
+        builder.createCompositeExtract(source_vec4, type_float, 0);
+    switch (xenos::DepthRenderTargetFormat(resource_format)) {
+      case xenos::DepthRenderTargetFormat::kD24S8: {
+        // Round to the nearest even integer. This seems to be the correct
+        // conversion, adding +0.5 and rounding towards zero results in red
+        // instead of black in the 4D5307E6 clear shader.
+        packed_out[0] = builder.createUnaryOp(
+            spv::OpConvertFToU, type_uint,
+            builder.createUnaryBuiltinCall(
+                type_float, ext_inst_glsl_std_450, GLSLstd450RoundEven,
+                builder.createBinOp(
+                    spv::OpFMul, type_float, source_depth32,
+                    builder.makeFloatConstant(float(0xFFFFFF)))));
+      } break;
+      case xenos::DepthRenderTargetFormat::kD24FS8: {
+        packed_out[0] = SpirvShaderTranslator::PreClampedDepthTo20e4(
+            builder, source_depth32, depth_float24_round(), true,
+            ext_inst_glsl_std_450);
+      } break;
+    }
+    packed_out[0] = builder.createQuadOp(
+        spv::OpBitFieldInsert, type_uint, source_stencil, packed_out[0],
+        builder.makeUintConstant(8), builder.makeUintConstant(24));
+  } else {
+    switch (xenos::ColorRenderTargetFormat(resource_format)) {
+      case xenos::ColorRenderTargetFormat::k_8_8_8_8:
+      case xenos::ColorRenderTargetFormat::k_8_8_8_8_GAMMA: {
+        spv::Id unorm_round_offset = builder.makeFloatConstant(0.5f);
+        spv::Id unorm_scale = builder.makeFloatConstant(255.0f);
+        packed_out[0] = builder.createUnaryOp(
+            spv::OpConvertFToU, type_uint,
+            builder.createBinOp(
+                spv::OpFAdd, type_float,
+                builder.createBinOp(
+                    spv::OpFMul, type_float,
+                    builder.createCompositeExtract(source_vec4, type_float, 0),
+                    unorm_scale),
+                unorm_round_offset));
+        spv::Id component_width = builder.makeUintConstant(8);
+        for (uint32_t i = 1; i < 4; ++i) {
+          packed_out[0] = builder.createQuadOp(
+              spv::OpBitFieldInsert, type_uint, packed_out[0],
+              builder.createUnaryOp(
+                  spv::OpConvertFToU, type_uint,
+                  builder.createBinOp(
+                      spv::OpFAdd, type_float,
+                      builder.createBinOp(spv::OpFMul, type_float,
+                                          builder.createCompositeExtract(
+                                              source_vec4, type_float, i),
+                                          unorm_scale),
+                      unorm_round_offset)),
+              builder.makeUintConstant(8 * i), component_width);
+        }
+      } break;
+      case xenos::ColorRenderTargetFormat::k_2_10_10_10:
+      case xenos::ColorRenderTargetFormat::k_2_10_10_10_AS_10_10_10_10: {
+        spv::Id unorm_round_offset = builder.makeFloatConstant(0.5f);
+        spv::Id unorm_scale_rgb = builder.makeFloatConstant(1023.0f);
+        packed_out[0] = builder.createUnaryOp(
+            spv::OpConvertFToU, type_uint,
+            builder.createBinOp(
+                spv::OpFAdd, type_float,
+                builder.createBinOp(
+                    spv::OpFMul, type_float,
+                    builder.createCompositeExtract(source_vec4, type_float, 0),
+                    unorm_scale_rgb),
+                unorm_round_offset));
+        spv::Id width_rgb = builder.makeUintConstant(10);
+        spv::Id unorm_scale_a = builder.makeFloatConstant(3.0f);
+        spv::Id width_a = builder.makeUintConstant(2);
+        for (uint32_t i = 1; i < 4; ++i) {
+          packed_out[0] = builder.createQuadOp(
+              spv::OpBitFieldInsert, type_uint, packed_out[0],
+              builder.createUnaryOp(
+                  spv::OpConvertFToU, type_uint,
+                  builder.createBinOp(
+                      spv::OpFAdd, type_float,
+                      builder.createBinOp(
+                          spv::OpFMul, type_float,
+                          builder.createCompositeExtract(source_vec4,
+                                                         type_float, i),
+                          i == 3 ? unorm_scale_a : unorm_scale_rgb),
+                      unorm_round_offset)),
+              builder.makeUintConstant(10 * i), i == 3 ? width_a : width_rgb);
+        }
+      } break;
+      case xenos::ColorRenderTargetFormat::k_2_10_10_10_FLOAT:
+      case xenos::ColorRenderTargetFormat::k_2_10_10_10_FLOAT_AS_16_16_16_16: {
+        // Float16 has a wider range for both color and alpha, also NaNs - clamp
+        // and convert.
+        packed_out[0] = SpirvShaderTranslator::UnclampedFloat32To7e3(
+            builder, builder.createCompositeExtract(source_vec4, type_float, 0),
+            ext_inst_glsl_std_450);
+        spv::Id width_rgb = builder.makeUintConstant(10);
+        for (uint32_t i = 1; i < 3; ++i) {
+          packed_out[0] = builder.createQuadOp(
+              spv::OpBitFieldInsert, type_uint, packed_out[0],
+              SpirvShaderTranslator::UnclampedFloat32To7e3(
+                  builder,
+                  builder.createCompositeExtract(source_vec4, type_float, i),
+                  ext_inst_glsl_std_450),
+              builder.makeUintConstant(10 * i), width_rgb);
+        }
+        // Saturate and convert the alpha.
+        spv::Id alpha_saturated = builder.createTriBuiltinCall(
+            type_float, ext_inst_glsl_std_450, GLSLstd450NClamp,
+            builder.createCompositeExtract(source_vec4, type_float, 3),
+            builder.makeFloatConstant(0.0f), builder.makeFloatConstant(1.0f));
+        packed_out[0] = builder.createQuadOp(
+            spv::OpBitFieldInsert, type_uint, packed_out[0],
+            builder.createUnaryOp(
+                spv::OpConvertFToU, type_uint,
+                builder.createBinOp(
+                    spv::OpFAdd, type_float,
+                    builder.createBinOp(spv::OpFMul, type_float,
+                                        alpha_saturated,
+                                        builder.makeFloatConstant(3.0f)),
+                    builder.makeFloatConstant(0.5f))),
+            builder.makeUintConstant(30), builder.makeUintConstant(2));
+      } break;
+      case xenos::ColorRenderTargetFormat::k_16_16:
+      case xenos::ColorRenderTargetFormat::k_16_16_16_16:
+      case xenos::ColorRenderTargetFormat::k_16_16_FLOAT:
+      case xenos::ColorRenderTargetFormat::k_16_16_16_16_FLOAT: {
+        // All 64bpp formats, and all 16 bits per component formats, are
+        // represented as integers in ownership transfer for safe handling of
+        // NaN encodings and -32768 / -32767.
+        // TODO(Triang3l): Handle the case when that's not true (no multisampled
+        // sampled images, no 16-bit UNORM, no cross-packing 32bpp aliasing on a
+        // portability subset device or a 64bpp format where that wouldn't help
+        // anyway).
+        spv::Id component_offset_width = builder.makeUintConstant(16);
+        for (uint32_t i = 0; i <= uint32_t(format_is_64bpp); ++i) {
+          packed_out[i] = builder.createQuadOp(
+              spv::OpBitFieldInsert, type_uint,
+              builder.createCompositeExtract(source_vec4, type_uint, 2 * i),
+              builder.createCompositeExtract(source_vec4, type_uint, 2 * i + 1),
+              component_offset_width, component_offset_width);
+        }
+      } break;
+      // Float32 is transferred as uint32 to preserve NaN encodings. However,
+      // multisampled sampled image support is optional in Vulkan.
+      case xenos::ColorRenderTargetFormat::k_32_FLOAT:
+      case xenos::ColorRenderTargetFormat::k_32_32_FLOAT: {
+        for (uint32_t i = 0; i <= uint32_t(format_is_64bpp); ++i) {
+          spv::Id& packed_ref = packed_out[i];
+          packed_ref = builder.createCompositeExtract(source_vec4,
+                                                      source_component_type, i);
+          if (!source_is_uint) {
+            packed_ref =
+                builder.createUnaryOp(spv::OpBitcast, type_uint, packed_ref);
+          }
+        }
+      } break;
+    }
+  }
+}
+
 VkPipeline VulkanRenderTargetCache::GetDumpPipeline(DumpPipelineKey key) {
   auto pipeline_it = dump_pipelines_.find(key);
   if (pipeline_it != dump_pipelines_.end()) {
@@ -5736,172 +6152,20 @@ VkPipeline VulkanRenderTargetCache::GetDumpPipeline(DumpPipelineKey key) {
       spv::NoPrecision, builder.makeVectorType(source_component_type, 4), false,
       true, false, false, false, source_texture_parameters,
       spv::ImageOperandsMaskNone);
+  spv::Id source_stencil = spv::NoResult;
   if (key.is_depth) {
     source_texture_parameters.sampler =
         builder.createLoad(source_stencil_texture, spv::NoPrecision);
-    spv::Id source_stencil = builder.createCompositeExtract(
+    source_stencil = builder.createCompositeExtract(
         builder.createTextureCall(
             spv::NoPrecision, builder.makeVectorType(type_uint, 4), false, true,
             false, false, false, source_texture_parameters,
             spv::ImageOperandsMaskNone),
         type_uint, 0);
-    spv::Id source_depth32 =
-        builder.createCompositeExtract(source_vec4, type_float, 0);
-    switch (key.GetDepthFormat()) {
-      case xenos::DepthRenderTargetFormat::kD24S8: {
-        // Round to the nearest even integer. This seems to be the correct
-        // conversion, adding +0.5 and rounding towards zero results in red
-        // instead of black in the 4D5307E6 clear shader.
-        packed[0] = builder.createUnaryOp(
-            spv::OpConvertFToU, type_uint,
-            builder.createUnaryBuiltinCall(
-                type_float, ext_inst_glsl_std_450, GLSLstd450RoundEven,
-                builder.createBinOp(
-                    spv::OpFMul, type_float, source_depth32,
-                    builder.makeFloatConstant(float(0xFFFFFF)))));
-      } break;
-      case xenos::DepthRenderTargetFormat::kD24FS8: {
-        packed[0] = SpirvShaderTranslator::PreClampedDepthTo20e4(
-            builder, source_depth32, depth_float24_round(), true,
-            ext_inst_glsl_std_450);
-      } break;
-    }
-    packed[0] = builder.createQuadOp(
-        spv::OpBitFieldInsert, type_uint, source_stencil, packed[0],
-        builder.makeUintConstant(8), builder.makeUintConstant(24));
-  } else {
-    switch (key.GetColorFormat()) {
-      case xenos::ColorRenderTargetFormat::k_8_8_8_8:
-      case xenos::ColorRenderTargetFormat::k_8_8_8_8_GAMMA: {
-        spv::Id unorm_round_offset = builder.makeFloatConstant(0.5f);
-        spv::Id unorm_scale = builder.makeFloatConstant(255.0f);
-        packed[0] = builder.createUnaryOp(
-            spv::OpConvertFToU, type_uint,
-            builder.createBinOp(
-                spv::OpFAdd, type_float,
-                builder.createBinOp(
-                    spv::OpFMul, type_float,
-                    builder.createCompositeExtract(source_vec4, type_float, 0),
-                    unorm_scale),
-                unorm_round_offset));
-        spv::Id component_width = builder.makeUintConstant(8);
-        for (uint32_t i = 1; i < 4; ++i) {
-          packed[0] = builder.createQuadOp(
-              spv::OpBitFieldInsert, type_uint, packed[0],
-              builder.createUnaryOp(
-                  spv::OpConvertFToU, type_uint,
-                  builder.createBinOp(
-                      spv::OpFAdd, type_float,
-                      builder.createBinOp(spv::OpFMul, type_float,
-                                          builder.createCompositeExtract(
-                                              source_vec4, type_float, i),
-                                          unorm_scale),
-                      unorm_round_offset)),
-              builder.makeUintConstant(8 * i), component_width);
-        }
-      } break;
-      case xenos::ColorRenderTargetFormat::k_2_10_10_10:
-      case xenos::ColorRenderTargetFormat::k_2_10_10_10_AS_10_10_10_10: {
-        spv::Id unorm_round_offset = builder.makeFloatConstant(0.5f);
-        spv::Id unorm_scale_rgb = builder.makeFloatConstant(1023.0f);
-        packed[0] = builder.createUnaryOp(
-            spv::OpConvertFToU, type_uint,
-            builder.createBinOp(
-                spv::OpFAdd, type_float,
-                builder.createBinOp(
-                    spv::OpFMul, type_float,
-                    builder.createCompositeExtract(source_vec4, type_float, 0),
-                    unorm_scale_rgb),
-                unorm_round_offset));
-        spv::Id width_rgb = builder.makeUintConstant(10);
-        spv::Id unorm_scale_a = builder.makeFloatConstant(3.0f);
-        spv::Id width_a = builder.makeUintConstant(2);
-        for (uint32_t i = 1; i < 4; ++i) {
-          packed[0] = builder.createQuadOp(
-              spv::OpBitFieldInsert, type_uint, packed[0],
-              builder.createUnaryOp(
-                  spv::OpConvertFToU, type_uint,
-                  builder.createBinOp(
-                      spv::OpFAdd, type_float,
-                      builder.createBinOp(
-                          spv::OpFMul, type_float,
-                          builder.createCompositeExtract(source_vec4,
-                                                         type_float, i),
-                          i == 3 ? unorm_scale_a : unorm_scale_rgb),
-                      unorm_round_offset)),
-              builder.makeUintConstant(10 * i), i == 3 ? width_a : width_rgb);
-        }
-      } break;
-      case xenos::ColorRenderTargetFormat::k_2_10_10_10_FLOAT:
-      case xenos::ColorRenderTargetFormat::k_2_10_10_10_FLOAT_AS_16_16_16_16: {
-        // Float16 has a wider range for both color and alpha, also NaNs - clamp
-        // and convert.
-        packed[0] = SpirvShaderTranslator::UnclampedFloat32To7e3(
-            builder, builder.createCompositeExtract(source_vec4, type_float, 0),
-            ext_inst_glsl_std_450);
-        spv::Id width_rgb = builder.makeUintConstant(10);
-        for (uint32_t i = 1; i < 3; ++i) {
-          packed[0] = builder.createQuadOp(
-              spv::OpBitFieldInsert, type_uint, packed[0],
-              SpirvShaderTranslator::UnclampedFloat32To7e3(
-                  builder,
-                  builder.createCompositeExtract(source_vec4, type_float, i),
-                  ext_inst_glsl_std_450),
-              builder.makeUintConstant(10 * i), width_rgb);
-        }
-        // Saturate and convert the alpha.
-        spv::Id alpha_saturated = builder.createTriBuiltinCall(
-            type_float, ext_inst_glsl_std_450, GLSLstd450NClamp,
-            builder.createCompositeExtract(source_vec4, type_float, 3),
-            builder.makeFloatConstant(0.0f), builder.makeFloatConstant(1.0f));
-        packed[0] = builder.createQuadOp(
-            spv::OpBitFieldInsert, type_uint, packed[0],
-            builder.createUnaryOp(
-                spv::OpConvertFToU, type_uint,
-                builder.createBinOp(
-                    spv::OpFAdd, type_float,
-                    builder.createBinOp(spv::OpFMul, type_float,
-                                        alpha_saturated,
-                                        builder.makeFloatConstant(3.0f)),
-                    builder.makeFloatConstant(0.5f))),
-            builder.makeUintConstant(30), builder.makeUintConstant(2));
-      } break;
-      case xenos::ColorRenderTargetFormat::k_16_16:
-      case xenos::ColorRenderTargetFormat::k_16_16_16_16:
-      case xenos::ColorRenderTargetFormat::k_16_16_FLOAT:
-      case xenos::ColorRenderTargetFormat::k_16_16_16_16_FLOAT: {
-        // All 64bpp formats, and all 16 bits per component formats, are
-        // represented as integers in ownership transfer for safe handling of
-        // NaN encodings and -32768 / -32767.
-        // TODO(Triang3l): Handle the case when that's not true (no multisampled
-        // sampled images, no 16-bit UNORM, no cross-packing 32bpp aliasing on a
-        // portability subset device or a 64bpp format where that wouldn't help
-        // anyway).
-        spv::Id component_offset_width = builder.makeUintConstant(16);
-        for (uint32_t i = 0; i <= uint32_t(format_is_64bpp); ++i) {
-          packed[i] = builder.createQuadOp(
-              spv::OpBitFieldInsert, type_uint,
-              builder.createCompositeExtract(source_vec4, type_uint, 2 * i),
-              builder.createCompositeExtract(source_vec4, type_uint, 2 * i + 1),
-              component_offset_width, component_offset_width);
-        }
-      } break;
-      // Float32 is transferred as uint32 to preserve NaN encodings. However,
-      // multisampled sampled image support is optional in Vulkan.
-      case xenos::ColorRenderTargetFormat::k_32_FLOAT:
-      case xenos::ColorRenderTargetFormat::k_32_32_FLOAT: {
-        for (uint32_t i = 0; i <= uint32_t(format_is_64bpp); ++i) {
-          spv::Id& packed_ref = packed[i];
-          packed_ref = builder.createCompositeExtract(source_vec4,
-                                                      source_component_type, i);
-          if (!source_is_uint) {
-            packed_ref =
-                builder.createUnaryOp(spv::OpBitcast, type_uint, packed_ref);
-          }
-        }
-      } break;
-    }
   }
+  PackHostRenderTargetSample(builder, ext_inst_glsl_std_450, key.is_depth,
+                             key.resource_format, source_is_uint, source_vec4,
+                             source_stencil, packed);
 
   // Write the packed value to the EDRAM buffer.
   spv::Id store_value = packed[0];
@@ -6108,6 +6372,425 @@ void VulkanRenderTargetCache::DumpRenderTargets(uint32_t dump_base,
   }
 }
 
+VulkanRenderTargetCache::VulkanRenderTarget*
+VulkanRenderTargetCache::GetDirectResolveSource(
+    const draw_util::ResolveInfo& resolve_info, uint32_t& source_origin_x_out,
+    uint32_t& source_origin_y_out) {
+  assert_true(GetPath() == Path::kHostRenderTargets);
+  source_origin_x_out = 0;
+  source_origin_y_out = 0;
+  if (!cvars::resolve_direct_from_host_render_targets ||
+      IsDrawResolutionScaled()) {
+    return nullptr;
+  }
+  const draw_util::ResolveEdramInfo& edram_info =
+      resolve_info.IsCopyingDepth() ? resolve_info.depth_edram_info
+                                    : resolve_info.color_edram_info;
+  if (edram_info.msaa_samples != xenos::MsaaSamples::k1X ||
+      edram_info.format_is_64bpp ||
+      resolve_info.copy_dest_info.copy_dest_array ||
+      resolve_info.copy_dest_info.copy_dest_endian >
+          xenos::Endian128::k16in32) {
+    return nullptr;
+  }
+
+  // The whole source area must be owned by a single render target.
+  uint32_t dump_base;
+  uint32_t dump_row_length_used;
+  uint32_t dump_rows;
+  uint32_t dump_pitch;
+  resolve_info.GetCopyEdramTileSpan(dump_base, dump_row_length_used, dump_rows,
+                                    dump_pitch);
+  GetResolveCopyRectanglesToDump(dump_base, dump_row_length_used, dump_rows,
+                                 dump_pitch, dump_rectangles_);
+  if (dump_rectangles_.size() != 1) {
+    return nullptr;
+  }
+  const ResolveCopyDumpRectangle& rectangle = dump_rectangles_.front();
+  if (rectangle.row_first || rectangle.rows != dump_rows ||
+      rectangle.row_first_start ||
+      rectangle.row_last_end != dump_row_length_used) {
+    return nullptr;
+  }
+  auto& vulkan_rt = *static_cast<VulkanRenderTarget*>(rectangle.render_target);
+  RenderTargetKey rt_key = vulkan_rt.key();
+  if (rt_key.msaa_samples != xenos::MsaaSamples::k1X ||
+      bool(rt_key.is_depth) != resolve_info.IsCopyingDepth() ||
+      rt_key.Is64bpp() || rt_key.GetPitchTiles() != dump_pitch) {
+    return nullptr;
+  }
+
+  // Locate the resolve area in the render target texture. With the same pitch,
+  // rows of tiles in the EDRAM are rows of tiles in the texture, but the area
+  // must not cross the right edge of the render target.
+  uint32_t base_tiles_rt_relative =
+      (edram_info.base_tiles + xenos::kEdramTileCount - rt_key.base_tiles) &
+      (xenos::kEdramTileCount - 1);
+  uint32_t source_origin_x =
+      (base_tiles_rt_relative % dump_pitch) * xenos::kEdramTileWidthSamples +
+      (resolve_info.coordinate_info.edram_offset_x_div_8
+       << xenos::kResolveAlignmentPixelsLog2);
+  uint32_t source_origin_y =
+      (base_tiles_rt_relative / dump_pitch) * xenos::kEdramTileHeightSamples +
+      (resolve_info.coordinate_info.edram_offset_y_div_8
+       << xenos::kResolveAlignmentPixelsLog2);
+  uint32_t width = resolve_info.coordinate_info.width_div_8
+                   << xenos::kResolveAlignmentPixelsLog2;
+  uint32_t height = resolve_info.height_div_8
+                    << xenos::kResolveAlignmentPixelsLog2;
+  if (source_origin_x + width > dump_pitch * xenos::kEdramTileWidthSamples ||
+      source_origin_y + height > GetMaxRenderTargetHeight()) {
+    return nullptr;
+  }
+  source_origin_x_out = source_origin_x;
+  source_origin_y_out = source_origin_y;
+  return &vulkan_rt;
+}
+
+VkPipeline VulkanRenderTargetCache::GetDirectResolvePipeline(
+    DirectResolvePipelineKey key) {
+  auto pipeline_it = direct_resolve_pipelines_.find(key);
+  if (pipeline_it != direct_resolve_pipelines_.end()) {
+    return pipeline_it->second;
+  }
+
+  std::vector<spv::Id> id_vector_temp;
+
+  SpirvBuilder builder(spv::Spv_1_0,
+                       (SpirvShaderTranslator::kSpirvMagicToolId << 16) | 1,
+                       nullptr);
+  spv::Id ext_inst_glsl_std_450 = builder.import("GLSL.std.450");
+  builder.addCapability(spv::CapabilityShader);
+  builder.setMemoryModel(spv::AddressingModelLogical, spv::MemoryModelGLSL450);
+  builder.setSource(spv::SourceLanguageUnknown, 0);
+
+  spv::Id type_void = builder.makeVoidType();
+  spv::Id type_int = builder.makeIntType(32);
+  spv::Id type_int2 = builder.makeVectorType(type_int, 2);
+  spv::Id type_uint = builder.makeUintType(32);
+  spv::Id type_uint3 = builder.makeVectorType(type_uint, 3);
+  spv::Id type_float = builder.makeFloatType(32);
+
+  // Bindings.
+  // Shared memory.
+  id_vector_temp.clear();
+  id_vector_temp.push_back(builder.makeRuntimeArray(type_uint));
+  // Storage buffers have std430 packing, no padding to 4-component vectors.
+  builder.addDecoration(id_vector_temp.back(), spv::DecorationArrayStride,
+                        sizeof(uint32_t));
+  spv::Id type_shared_memory =
+      builder.makeStructType(id_vector_temp, "XeSharedMemory");
+  builder.addMemberName(type_shared_memory, 0, "shared_memory");
+  builder.addMemberDecoration(type_shared_memory, 0,
+                              spv::DecorationNonReadable);
+  builder.addMemberDecoration(type_shared_memory, 0, spv::DecorationOffset, 0);
+  // Block since SPIR-V 1.3, but since SPIR-V 1.0 is generated, it's
+  // BufferBlock.
+  builder.addDecoration(type_shared_memory, spv::DecorationBufferBlock);
+  // StorageBuffer since SPIR-V 1.3, but since SPIR-V 1.0 is generated, it's
+  // Uniform.
+  spv::Id shared_memory_buffer =
+      builder.createVariable(spv::NoPrecision, spv::StorageClassUniform,
+                             type_shared_memory, "xe_shared_memory");
+  builder.addDecoration(shared_memory_buffer, spv::DecorationDescriptorSet,
+                        kDirectResolveDescriptorSetDest);
+  builder.addDecoration(shared_memory_buffer, spv::DecorationBinding, 0);
+  // Color or depth source.
+  bool source_is_uint;
+  if (key.is_depth) {
+    source_is_uint = false;
+  } else {
+    GetColorOwnershipTransferVulkanFormat(
+        xenos::ColorRenderTargetFormat(key.resource_format), &source_is_uint);
+  }
+  spv::Id source_component_type = source_is_uint ? type_uint : type_float;
+  spv::Id source_texture = builder.createVariable(
+      spv::NoPrecision, spv::StorageClassUniformConstant,
+      builder.makeImageType(source_component_type, spv::Dim2D, false, false,
+                            false, 1, spv::ImageFormatUnknown),
+      "xe_direct_resolve_source");
+  builder.addDecoration(source_texture, spv::DecorationDescriptorSet,
+                        kDirectResolveDescriptorSetSource);
+  builder.addDecoration(source_texture, spv::DecorationBinding, 0);
+  // Stencil source.
+  spv::Id source_stencil_texture = spv::NoResult;
+  if (key.is_depth) {
+    source_stencil_texture = builder.createVariable(
+        spv::NoPrecision, spv::StorageClassUniformConstant,
+        builder.makeImageType(type_uint, spv::Dim2D, false, false, false, 1,
+                              spv::ImageFormatUnknown),
+        "xe_direct_resolve_stencil");
+    builder.addDecoration(source_stencil_texture, spv::DecorationDescriptorSet,
+                          kDirectResolveDescriptorSetSource);
+    builder.addDecoration(source_stencil_texture, spv::DecorationBinding, 1);
+  }
+  // Push constants.
+  id_vector_temp.clear();
+  id_vector_temp.reserve(kDirectResolvePushConstantCount);
+  for (uint32_t i = 0; i < kDirectResolvePushConstantCount; ++i) {
+    id_vector_temp.push_back(type_uint);
+  }
+  spv::Id type_push_constants =
+      builder.makeStructType(id_vector_temp, "XeDirectResolvePushConstants");
+  builder.addMemberName(type_push_constants,
+                        kDirectResolvePushConstantSourceOrigin,
+                        "source_origin");
+  builder.addMemberName(type_push_constants,
+                        kDirectResolvePushConstantDestOrigin, "dest_origin");
+  builder.addMemberName(type_push_constants,
+                        kDirectResolvePushConstantDestPitchDiv32,
+                        "dest_pitch_div_32");
+  builder.addMemberName(type_push_constants, kDirectResolvePushConstantDestBase,
+                        "dest_base");
+  for (uint32_t i = 0; i < kDirectResolvePushConstantCount; ++i) {
+    builder.addMemberDecoration(type_push_constants, i, spv::DecorationOffset,
+                                int(sizeof(uint32_t) * i));
+  }
+  builder.addDecoration(type_push_constants, spv::DecorationBlock);
+  spv::Id push_constants = builder.createVariable(
+      spv::NoPrecision, spv::StorageClassPushConstant, type_push_constants,
+      "xe_direct_resolve_push_constants");
+
+  // gl_GlobalInvocationID input.
+  spv::Id input_global_invocation_id =
+      builder.createVariable(spv::NoPrecision, spv::StorageClassInput,
+                             type_uint3, "gl_GlobalInvocationID");
+  builder.addDecoration(input_global_invocation_id, spv::DecorationBuiltIn,
+                        spv::BuiltInGlobalInvocationId);
+
+  // Begin the main function.
+  std::vector<spv::Id> main_param_types;
+  std::vector<std::vector<spv::Decoration>> main_precisions;
+  spv::Block* main_entry;
+  spv::Function* main_function =
+      builder.makeFunctionEntry(spv::NoPrecision, type_void, "main",
+                                main_param_types, main_precisions, &main_entry);
+
+  // One invocation per pixel, always within the resolve area as it's aligned
+  // to 8x8.
+  spv::Id global_invocation_id =
+      builder.createLoad(input_global_invocation_id, spv::NoPrecision);
+  spv::Id pixel_x =
+      builder.createCompositeExtract(global_invocation_id, type_uint, 0);
+  spv::Id pixel_y =
+      builder.createCompositeExtract(global_invocation_id, type_uint, 1);
+
+  spv::Id push_constant_values[kDirectResolvePushConstantCount];
+  for (uint32_t i = 0; i < kDirectResolvePushConstantCount; ++i) {
+    id_vector_temp.clear();
+    id_vector_temp.push_back(builder.makeIntConstant(int32_t(i)));
+    push_constant_values[i] = builder.createLoad(
+        builder.createAccessChain(spv::StorageClassPushConstant,
+                                  push_constants, id_vector_temp),
+        spv::NoPrecision);
+  }
+  spv::Id const_uint_0 = builder.makeUintConstant(0);
+  spv::Id const_uint_16 = builder.makeUintConstant(16);
+
+  // Load the source, and pack the value like when dumping to the EDRAM buffer.
+  spv::Id source_origin =
+      push_constant_values[kDirectResolvePushConstantSourceOrigin];
+  spv::Id source_x = builder.createBinOp(
+      spv::OpIAdd, type_uint, pixel_x,
+      builder.createTriOp(spv::OpBitFieldUExtract, type_uint, source_origin,
+                          const_uint_0, const_uint_16));
+  spv::Id source_y = builder.createBinOp(
+      spv::OpIAdd, type_uint, pixel_y,
+      builder.createBinOp(spv::OpShiftRightLogical, type_uint, source_origin,
+                          const_uint_16));
+  spv::Builder::TextureParameters source_texture_parameters = {};
+  source_texture_parameters.sampler =
+      builder.createLoad(source_texture, spv::NoPrecision);
+  id_vector_temp.clear();
+  id_vector_temp.push_back(
+      builder.createUnaryOp(spv::OpBitcast, type_int, source_x));
+  id_vector_temp.push_back(
+      builder.createUnaryOp(spv::OpBitcast, type_int, source_y));
+  source_texture_parameters.coords =
+      builder.createCompositeConstruct(type_int2, id_vector_temp);
+  source_texture_parameters.lod = builder.makeIntConstant(0);
+  spv::Id source_vec4 = builder.createTextureCall(
+      spv::NoPrecision, builder.makeVectorType(source_component_type, 4), false,
+      true, false, false, false, source_texture_parameters,
+      spv::ImageOperandsMaskNone);
+  spv::Id source_stencil = spv::NoResult;
+  if (key.is_depth) {
+    source_texture_parameters.sampler =
+        builder.createLoad(source_stencil_texture, spv::NoPrecision);
+    source_stencil = builder.createCompositeExtract(
+        builder.createTextureCall(
+            spv::NoPrecision, builder.makeVectorType(type_uint, 4), false, true,
+            false, false, false, source_texture_parameters,
+            spv::ImageOperandsMaskNone),
+        type_uint, 0);
+  }
+  spv::Id packed[2] = {};
+  PackHostRenderTargetSample(builder, ext_inst_glsl_std_450, key.is_depth,
+                             key.resource_format, source_is_uint, source_vec4,
+                             source_stencil, packed);
+  spv::Id value = packed[0];
+
+  // Swap red and blue if needed, like in XeResolveSwap8PixelsRedBlue32bpp.
+  uint32_t red_blue_swap_width = 0;
+  switch (key.red_blue_swap) {
+    case DirectResolveRedBlueSwap::k_8_8_8_8:
+      red_blue_swap_width = 8;
+      break;
+    case DirectResolveRedBlueSwap::k_2_10_10_10:
+      red_blue_swap_width = 10;
+      break;
+    default:
+      break;
+  }
+  if (red_blue_swap_width) {
+    spv::Id const_red_blue_swap_width =
+        builder.makeUintConstant(red_blue_swap_width);
+    spv::Id const_blue_offset =
+        builder.makeUintConstant(red_blue_swap_width * 2);
+    spv::Id red = builder.createTriOp(spv::OpBitFieldUExtract, type_uint, value,
+                                      const_uint_0, const_red_blue_swap_width);
+    spv::Id blue =
+        builder.createTriOp(spv::OpBitFieldUExtract, type_uint, value,
+                            const_blue_offset, const_red_blue_swap_width);
+    value = builder.createQuadOp(spv::OpBitFieldInsert, type_uint, value, blue,
+                                 const_uint_0, const_red_blue_swap_width);
+    value = builder.createQuadOp(spv::OpBitFieldInsert, type_uint, value, red,
+                                 const_blue_offset, const_red_blue_swap_width);
+  }
+
+  // Change the endianness, like in XeEndianSwap32.
+  if (key.dest_endian == xenos::Endian128::k8in16 ||
+      key.dest_endian == xenos::Endian128::k8in32) {
+    spv::Id const_uint_8 = builder.makeUintConstant(8);
+    value = builder.createBinOp(
+        spv::OpBitwiseOr, type_uint,
+        builder.createBinOp(
+            spv::OpShiftLeftLogical, type_uint,
+            builder.createBinOp(spv::OpBitwiseAnd, type_uint, value,
+                                builder.makeUintConstant(0x00FF00FFu)),
+            const_uint_8),
+        builder.createBinOp(
+            spv::OpShiftRightLogical, type_uint,
+            builder.createBinOp(spv::OpBitwiseAnd, type_uint, value,
+                                builder.makeUintConstant(0xFF00FF00u)),
+            const_uint_8));
+  }
+  if (key.dest_endian == xenos::Endian128::k8in32 ||
+      key.dest_endian == xenos::Endian128::k16in32) {
+    value = builder.createBinOp(
+        spv::OpBitwiseOr, type_uint,
+        builder.createBinOp(spv::OpShiftLeftLogical, type_uint, value,
+                            const_uint_16),
+        builder.createBinOp(spv::OpShiftRightLogical, type_uint, value,
+                            const_uint_16));
+  }
+
+  // Calculate the destination address, like XeTextureTiledOffset2D for 32bpp
+  // (all the intermediate values are non-negative, so using unsigned
+  // operations).
+  spv::Id dest_origin =
+      push_constant_values[kDirectResolvePushConstantDestOrigin];
+  spv::Id dest_x = builder.createBinOp(
+      spv::OpIAdd, type_uint, pixel_x,
+      builder.createTriOp(spv::OpBitFieldUExtract, type_uint, dest_origin,
+                          const_uint_0, const_uint_16));
+  spv::Id dest_y = builder.createBinOp(
+      spv::OpIAdd, type_uint, pixel_y,
+      builder.createBinOp(spv::OpShiftRightLogical, type_uint, dest_origin,
+                          const_uint_16));
+  auto uint_and = [&](spv::Id a, uint32_t b) {
+    return builder.createBinOp(spv::OpBitwiseAnd, type_uint, a,
+                               builder.makeUintConstant(b));
+  };
+  auto uint_shl = [&](spv::Id a, uint32_t b) {
+    return builder.createBinOp(spv::OpShiftLeftLogical, type_uint, a,
+                               builder.makeUintConstant(b));
+  };
+  auto uint_shr = [&](spv::Id a, uint32_t b) {
+    return builder.createBinOp(spv::OpShiftRightLogical, type_uint, a,
+                               builder.makeUintConstant(b));
+  };
+  auto uint_add = [&](spv::Id a, spv::Id b) {
+    return builder.createBinOp(spv::OpIAdd, type_uint, a, b);
+  };
+  // macro = ((x >> 5) + (y >> 5) * (pitch >> 5)) << (bpb_log2 + 7)
+  spv::Id tiled_macro = uint_shl(
+      uint_add(uint_shr(dest_x, 5),
+               builder.createBinOp(
+                   spv::OpIMul, type_uint, uint_shr(dest_y, 5),
+                   push_constant_values
+                       [kDirectResolvePushConstantDestPitchDiv32])),
+      2 + 7);
+  // micro = ((x & 7) + ((y & 0xE) << 2)) << bpb_log2
+  spv::Id tiled_micro = uint_shl(
+      uint_add(uint_and(dest_x, 7), uint_shl(uint_and(dest_y, 0xE), 2)), 2);
+  // offset = macro + ((micro & ~0xF) << 1) + (micro & 0xF) + ((y & 1) << 4)
+  spv::Id tiled_offset = uint_add(
+      uint_add(tiled_macro, uint_shl(uint_and(tiled_micro, ~uint32_t(0xF)), 1)),
+      uint_add(uint_and(tiled_micro, 0xF), uint_shl(uint_and(dest_y, 1), 4)));
+  // ((offset & ~0x1FF) << 3) + ((y & 16) << 7) + ((offset & 0x1C0) << 2) +
+  // (((((y & 8) >> 2) + (x >> 3)) & 3) << 6) + (offset & 0x3F)
+  spv::Id dest_address = uint_add(
+      uint_add(uint_shl(uint_and(tiled_offset, ~uint32_t(0x1FF)), 3),
+               uint_shl(uint_and(dest_y, 16), 7)),
+      uint_add(
+          uint_add(uint_shl(uint_and(tiled_offset, 0x1C0), 2),
+                   uint_shl(uint_and(uint_add(uint_shr(uint_and(dest_y, 8), 2),
+                                              uint_shr(dest_x, 3)),
+                                     3),
+                            6)),
+          uint_and(tiled_offset, 0x3F)));
+  dest_address = uint_add(
+      dest_address, push_constant_values[kDirectResolvePushConstantDestBase]);
+
+  // Write the value to the shared memory.
+  id_vector_temp.clear();
+  // The only SSBO structure member.
+  id_vector_temp.push_back(builder.makeIntConstant(0));
+  id_vector_temp.push_back(builder.createUnaryOp(
+      spv::OpBitcast, type_int, uint_shr(dest_address, 2)));
+  // StorageBuffer since SPIR-V 1.3, but since SPIR-V 1.0 is generated, it's
+  // Uniform.
+  builder.createStore(value, builder.createAccessChain(spv::StorageClassUniform,
+                                                       shared_memory_buffer,
+                                                       id_vector_temp));
+
+  // End the main function and make it the entry point.
+  builder.leaveFunction();
+  builder.addExecutionMode(main_function, spv::ExecutionModeLocalSize,
+                           kDirectResolvePixelsPerGroupX,
+                           kDirectResolvePixelsPerGroupY, 1);
+  spv::Instruction* entry_point = builder.addEntryPoint(
+      spv::ExecutionModelGLCompute, main_function, "main");
+  // Bindings only need to be added to the entry point's interface starting with
+  // SPIR-V 1.4 - emitting 1.0 here, so only inputs / outputs.
+  entry_point->addIdOperand(input_global_invocation_id);
+
+  // Serialize the shader code.
+  std::vector<unsigned int> shader_code;
+  builder.dump(shader_code);
+
+  // Create the pipeline, and store the handle even if creation fails not to try
+  // to create it again later.
+  VkPipeline pipeline = ui::vulkan::util::CreateComputePipeline(
+      command_processor_.GetVulkanProvider(),
+      key.is_depth ? direct_resolve_pipeline_layout_depth_
+                   : direct_resolve_pipeline_layout_color_,
+      reinterpret_cast<const uint32_t*>(shader_code.data()),
+      sizeof(uint32_t) * shader_code.size());
+  if (pipeline == VK_NULL_HANDLE) {
+    RenderTargetKey rt_key;
+    rt_key.is_depth = key.is_depth;
+    rt_key.resource_format = key.resource_format;
+    XELOGE(
+        "VulkanRenderTargetCache: Failed to create a direct resolve pipeline "
+        "for render targets with format {}",
+        rt_key.GetFormatName());
+  }
+  direct_resolve_pipelines_.emplace(key, pipeline);
+  return pipeline;
+}
+
 }  // namespace vulkan
 }  // namespace gpu
 }  // namespace xe
@@ -20,6 +20,7 @@
 #include "xenia/base/hash.h"
 #include "xenia/base/xxhash.h"
 #include "xenia/gpu/render_target_cache.h"
+#include "xenia/gpu/spirv_builder.h"
 #include "xenia/gpu/vulkan/vulkan_shared_memory.h"
 #include "xenia/gpu/vulkan/vulkan_texture_cache.h"
 #include "xenia/gpu/xenos.h"
@@ -111,6 +112,7 @@ class VulkanRenderTargetCache final : public RenderTargetCache {
 
   void CompletedSubmissionUpdated();
   void EndSubmission();
+  void EndFrame();
 
   Path GetPath() const override { return path_; }
 
@@ -835,6 +837,73 @@ class VulkanRenderTargetCache final : public RenderTargetCache {
     }
   };
 
+  // Direct copying from a host render target to the shared memory in resolves
+  // that don't need any conversion of the data, without dumping to the EDRAM
+  // buffer first - currently for single-sampled 32bpp sources without
+  // resolution scaling, and non-3D destinations.
+  enum class DirectResolveRedBlueSwap : uint32_t {
+    kNone,
+    k_8_8_8_8,
+    k_2_10_10_10,
+  };
+
+  union DirectResolvePipelineKey {
+    uint32_t key;
+    struct {
+      // Same as in DumpPipelineKey, for packing the samples in the same way.
+      uint32_t resource_format : xenos::kRenderTargetFormatBits;
+      uint32_t is_depth : 1;
+      // Only the 32-bit swaps - kNone, k8in16, k8in32, k16in32.
+      xenos::Endian128 dest_endian : 3;
+      DirectResolveRedBlueSwap red_blue_swap : 2;
+    };
+
+    DirectResolvePipelineKey() : key(0) {
+      static_assert_size(*this, sizeof(key));
+    }
+
+    struct Hasher {
+      size_t operator()(const DirectResolvePipelineKey& key) const {
+        return std::hash<uint32_t>{}(key.key);
+      }
+    };
+    bool operator==(const DirectResolvePipelineKey& other_key) const {
+      return key == other_key.key;
+    }
+    bool operator!=(const DirectResolvePipelineKey& other_key) const {
+      return !(*this == other_key);
+    }
+  };
+
+  // Same as in the EDRAM buffer resolve copy shaders.
+  static constexpr uint32_t kDirectResolvePixelsPerGroupX = 8;
+  static constexpr uint32_t kDirectResolvePixelsPerGroupY = 8;
+
+  enum DirectResolveDescriptorSet : uint32_t {
+    // Shared memory or a region in it, like in the EDRAM buffer resolve copy.
+    kDirectResolveDescriptorSetDest,
+    // Same as kDumpDescriptorSetSource - different layouts for color and
+    // depth.
+    kDirectResolveDescriptorSetSource,
+
+    kDirectResolveDescriptorSetCount,
+  };
+
+  enum DirectResolvePushConstant : uint32_t {
+    // Resolve origin in the source render target texture, X in the lower 16
+    // bits, Y in the upper.
+    kDirectResolvePushConstantSourceOrigin,
+    // Resolve origin in the destination texture, X in the lower 16 bits, Y in
+    // the upper.
+    kDirectResolvePushConstantDestOrigin,
+    // Aligned pitch of the destination texture divided by 32.
+    kDirectResolvePushConstantDestPitchDiv32,
+    // Offset of the destination texture relatively to the bound buffer range.
+    kDirectResolvePushConstantDestBase,
+
+    kDirectResolvePushConstantCount,
+  };
+
   // Returns the framebuffer object, or VK_NULL_HANDLE if failed to create.
   const Framebuffer* GetHostRenderTargetsFramebuffer(
       RenderPassKey render_pass_key, uint32_t pitch_tiles_at_32bpp,
@@ -864,6 +933,24 @@ class VulkanRenderTargetCache final : public RenderTargetCache {
   void DumpRenderTargets(uint32_t dump_base, uint32_t dump_row_length_used,
                          uint32_t dump_rows, uint32_t dump_pitch);
 
+  // Emits the conversion of a sample loaded from a host render target via its
+  // ownership transfer source descriptor set to the guest EDRAM representation
+  // (two 32-bit values for 64bpp formats, one for others).
+  void PackHostRenderTargetSample(SpirvBuilder& builder,
+                                  spv::Id ext_inst_glsl_std_450, bool is_depth,
+                                  uint32_t resource_format, bool source_is_uint,
+                                  spv::Id source_vec4, spv::Id source_stencil,
+                                  spv::Id* packed_out) const;
+
+  VkPipeline GetDirectResolvePipeline(DirectResolvePipelineKey key);
+
+  // Returns the render target that can be copied to the shared memory directly
+  // via a pipeline from GetDirectResolvePipeline, or nullptr if the resolve
+  // needs to go through the EDRAM buffer (or if direct resolving is disabled).
+  VulkanRenderTarget* GetDirectResolveSource(
+      const draw_util::ResolveInfo& resolve_info,
+      uint32_t& source_origin_x_out, uint32_t& source_origin_y_out);
+
   bool gamma_render_target_as_srgb_ = false;
 
   bool depth_unorm24_vulkan_format_supported_ = false;
@@ -888,6 +975,9 @@ class VulkanRenderTargetCache final : public RenderTargetCache {
 
   std::unique_ptr<ui::vulkan::VulkanUploadBufferPool>
       transfer_vertex_buffer_pool_;
+  // Within the current frame, reported to the profiler when it ends.
+  uint32_t transfer_render_passes_in_frame_ = 0;
+  uint32_t transfers_in_frame_ = 0;
   VkShaderModule transfer_passthrough_vertex_shader_ = VK_NULL_HANDLE;
   VkPipelineLayout transfer_pipeline_layouts_[size_t(
       TransferPipelineLayoutIndex::kCount)] = {};
@@ -909,6 +999,14 @@ class VulkanRenderTargetCache final : public RenderTargetCache {
   std::unordered_map<DumpPipelineKey, VkPipeline, DumpPipelineKey::Hasher>
       dump_pipelines_;
 
+  VkPipelineLayout direct_resolve_pipeline_layout_color_ = VK_NULL_HANDLE;
+  VkPipelineLayout direct_resolve_pipeline_layout_depth_ = VK_NULL_HANDLE;
+  // Compute pipelines for copying host render target contents directly to the
+  // shared memory. VK_NULL_HANDLE if failed to create.
+  std::unordered_map<DirectResolvePipelineKey, VkPipeline,
+                     DirectResolvePipelineKey::Hasher>
+      direct_resolve_pipelines_;
+
   // Temporary storage for Resolve.
   std::vector<Transfer> clear_transfers_[2];
 
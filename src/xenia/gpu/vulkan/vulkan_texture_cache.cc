@@ -526,7 +526,11 @@ void VulkanTextureCache::RequestTextures(uint32_t used_texture_mask) {
   SCOPE_profile_cpu_f("gpu");
 #endif  // XE_UI_VULKAN_FINE_GRAINED_DRAW_SCOPES
 
+  // Load the textures that need loading together.
+  texture_load_batch_open_ = true;
   TextureCache::RequestTextures(used_texture_mask);
+  texture_load_batch_open_ = false;
+  FlushTextureLoads();
 
   // Transition the textures into the needed usage.
   VkPipelineStageFlags dst_stage_mask;
@@ -730,8 +734,11 @@ VkSampler VulkanTextureCache::UseSampler(SamplerParameters parameters,
       has_overflown_out = false;
       return VK_NULL_HANDLE;
     }
-    if (sampler_used_first_->second.last_usage_submission >
-        command_processor_.GetCompletedSubmission()) {
+    // The completed submission index is only updated at certain points, poll
+    // the GPU directly to avoid an overflow (and thus a wait) if the GPU has
+    // already finished using the least recently used sampler.
+    if (!command_processor_.IsSubmissionCompletedOnGpu(
+            sampler_used_first_->second.last_usage_submission)) {
       has_overflown_out = true;
       return VK_NULL_HANDLE;
     }
@@ -1079,8 +1086,24 @@ std::unique_ptr<TextureCache::Texture> VulkanTextureCache::CreateTexture(
 bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
                                                                bool load_base,
                                                                bool load_mips) {
-  VulkanTexture& vulkan_texture = static_cast<VulkanTexture&>(texture);
-  TextureKey texture_key = vulkan_texture.key();
+  TextureLoad texture_load;
+  if (!InitializeTextureLoad(static_cast<VulkanTexture&>(texture), load_base,
+                             load_mips, texture_load)) {
+    return false;
+  }
+  if (texture_load_batch_open_) {
+    // Will be loaded together with the rest of the textures needed by the draw
+    // in the end of RequestTextures.
+    pending_texture_loads_.push_back(texture_load);
+    return true;
+  }
+  return LoadTextures(&texture_load, 1);
+}
+
+bool VulkanTextureCache::InitializeTextureLoad(VulkanTexture& texture,
+                                               bool load_base, bool load_mips,
+                                               TextureLoad& texture_load) {
+  TextureKey texture_key = texture.key();
 
   // Get the pipeline.
   const HostFormatPair& host_format_pair = GetHostFormatPair(texture_key);
@@ -1105,22 +1128,22 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
     return false;
   }
   const LoadShaderInfo& load_shader_info = GetLoadShaderInfo(load_shader);
+  texture_load.texture = &texture;
+  texture_load.load_shader = load_shader;
+  texture_load.pipeline = pipeline;
+  texture_load.host_format_block_compressed = host_format.block_compressed;
 
   // Get the guest layout.
-  const texture_util::TextureGuestLayout& guest_layout =
-      vulkan_texture.guest_layout();
-  xenos::DataDimension dimension = texture_key.dimension;
-  bool is_3d = dimension == xenos::DataDimension::k3D;
+  const texture_util::TextureGuestLayout& guest_layout = texture.guest_layout();
+  bool is_3d = texture_key.dimension == xenos::DataDimension::k3D;
   uint32_t width = texture_key.GetWidth();
   uint32_t height = texture_key.GetHeight();
   uint32_t depth_or_array_size = texture_key.GetDepthOrArraySize();
   uint32_t depth = is_3d ? depth_or_array_size : 1;
   uint32_t array_size = is_3d ? 1 : depth_or_array_size;
-  xenos::TextureFormat guest_format = texture_key.format;
-  const FormatInfo* guest_format_info = FormatInfo::Get(guest_format);
+  const FormatInfo* guest_format_info = FormatInfo::Get(texture_key.format);
   uint32_t block_width = guest_format_info->block_width;
   uint32_t block_height = guest_format_info->block_height;
-  uint32_t bytes_per_block = guest_format_info->bytes_per_block();
   uint32_t level_first = load_base ? 0 : 1;
   uint32_t level_last = load_mips ? texture_key.mip_max_level : 0;
   assert_true(level_first <= level_last);
@@ -1131,27 +1154,28 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
       texture_key.scaled_resolve ? draw_resolution_scale_x() : 1;
   uint32_t texture_resolution_scale_y =
       texture_key.scaled_resolve ? draw_resolution_scale_y() : 1;
+  texture_load.level_first = level_first;
+  texture_load.level_last = level_last;
 
   // The loop counter can mean two things depending on whether the packed mip
   // tail is stored as mip 0, because in this case, it would be ambiguous since
   // both the base and the mips would be on "level 0", but stored in separate
   // places.
-  uint32_t loop_level_first, loop_level_last;
   if (level_packed == 0) {
     // Packed mip tail is the level 0 - may need to load mip tails for the base,
     // the mips, or both.
     // Loop iteration 0 - base packed mip tail.
     // Loop iteration 1 - mips packed mip tail.
-    loop_level_first = uint32_t(level_first != 0);
-    loop_level_last = uint32_t(level_last != 0);
+    texture_load.loop_level_first = uint32_t(level_first != 0);
+    texture_load.loop_level_last = uint32_t(level_last != 0);
   } else {
     // Packed mip tail is not the level 0.
     // Loop iteration is the actual level being loaded.
-    loop_level_first = level_stored_first;
-    loop_level_last = level_stored_last;
+    texture_load.loop_level_first = level_stored_first;
+    texture_load.loop_level_last = level_stored_last;
   }
 
-  // Get the host layout and the buffer.
+  // Get the host layout.
   uint32_t host_block_width = host_format.block_compressed ? block_width : 1;
   uint32_t host_block_height = host_format.block_compressed ? block_height : 1;
   uint32_t host_x_blocks_per_thread =
@@ -1160,25 +1184,15 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
     // Decompressing guest blocks.
     host_x_blocks_per_thread *= block_width;
   }
-  VkDeviceSize host_buffer_size = 0;
-  struct HostLayout {
-    VkDeviceSize offset_bytes;
-    VkDeviceSize slice_size_bytes;
-    uint32_t x_pitch_blocks;
-    uint32_t y_pitch_blocks;
-  };
-  HostLayout host_layout_base;
-  // Indexing is the same as for guest stored mips:
-  // 1...min(level_last, level_packed) if level_packed is not 0, or only 0 if
-  // level_packed == 0.
-  HostLayout host_layout_mips[xenos::kTextureMaxMips];
-  for (uint32_t loop_level = loop_level_first; loop_level <= loop_level_last;
-       ++loop_level) {
+  texture_load.host_buffer_size = 0;
+  for (uint32_t loop_level = texture_load.loop_level_first;
+       loop_level <= texture_load.loop_level_last; ++loop_level) {
     bool is_base = loop_level == 0;
     uint32_t level = (level_packed == 0) ? 0 : loop_level;
-    HostLayout& level_host_layout =
-        is_base ? host_layout_base : host_layout_mips[level];
-    level_host_layout.offset_bytes = host_buffer_size;
+    TextureLoad::HostLayout& level_host_layout =
+        is_base ? texture_load.host_layout_base
+                : texture_load.host_layout_mips[level];
+    level_host_layout.offset_bytes = texture_load.host_buffer_size;
     uint32_t level_guest_x_extent_texels_unscaled;
     uint32_t level_guest_y_extent_texels_unscaled;
     uint32_t level_guest_z_extent_texels;
@@ -1212,7 +1226,81 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
         VkDeviceSize(load_shader_info.bytes_per_host_block) *
         level_host_layout.x_pitch_blocks * level_host_layout.y_pitch_blocks *
         level_guest_z_extent_texels;
-    host_buffer_size += level_host_layout.slice_size_bytes * array_size;
+    texture_load.host_buffer_size +=
+        level_host_layout.slice_size_bytes * array_size;
+  }
+  texture_load.host_buffer_offset = 0;
+  return true;
+}
+
+void VulkanTextureCache::FlushTextureLoads() {
+  if (pending_texture_loads_.empty()) {
+    return;
+  }
+
+  // Group the loads by the shader so each pipeline is bound once.
+  std::stable_sort(pending_texture_loads_.begin(), pending_texture_loads_.end(),
+                   [](const TextureLoad& a, const TextureLoad& b) {
+                     if (a.load_shader != b.load_shader) {
+                       return a.load_shader < b.load_shader;
+                     }
+                     return !a.texture->key().scaled_resolve &&
+                            b.texture->key().scaled_resolve;
+                   });
+
+  // The destination of each batch is a single storage buffer binding.
+  VkDeviceSize max_storage_buffer_range =
+      command_processor_.GetVulkanProvider()
+          .device_properties()
+          .limits.maxStorageBufferRange;
+  size_t texture_load_count = pending_texture_loads_.size();
+  size_t batch_start = 0;
+  while (batch_start < texture_load_count) {
+    size_t batch_end = batch_start + 1;
+    VkDeviceSize batch_size =
+        pending_texture_loads_[batch_start].host_buffer_size;
+    while (batch_end < texture_load_count) {
+      VkDeviceSize new_batch_size =
+          xe::align(batch_size, kTextureLoadHostBufferAlignment) +
+          pending_texture_loads_[batch_end].host_buffer_size;
+      if (new_batch_size > max_storage_buffer_range) {
+        break;
+      }
+      batch_size = new_batch_size;
+      ++batch_end;
+    }
+    if (!LoadTextures(pending_texture_loads_.data() + batch_start,
+                      batch_end - batch_start)) {
+      // The resources for the whole batch might have not been obtained, try
+      // loading the textures one by one.
+      for (size_t i = batch_start; i < batch_end; ++i) {
+        TextureLoad& texture_load = pending_texture_loads_[i];
+        if (batch_end - batch_start <= 1 || !LoadTextures(&texture_load, 1)) {
+          // The texture has already been marked as up to date when the load
+          // was deferred - make it outdated again so the load is retried
+          // rather than the uninitialized contents being used.
+          texture_load.texture->MakeOutdated(
+              xe::global_critical_region::AcquireDirect(),
+              texture_load.level_first == 0, texture_load.level_last != 0);
+          texture_load.texture->LogAction("Failed to load");
+        }
+      }
+    }
+    batch_start = batch_end;
+  }
+  pending_texture_loads_.clear();
+}
+
+bool VulkanTextureCache::LoadTextures(TextureLoad* texture_loads,
+                                      size_t texture_load_count) {
+  // Place the host data of all the textures in one buffer.
+  VkDeviceSize host_buffer_size = 0;
+  for (size_t i = 0; i < texture_load_count; ++i) {
+    TextureLoad& texture_load = texture_loads[i];
+    host_buffer_size =
+        xe::align(host_buffer_size, kTextureLoadHostBufferAlignment);
+    texture_load.host_buffer_offset = host_buffer_size;
+    host_buffer_size += texture_load.host_buffer_size;
   }
   VulkanCommandProcessor::ScratchBufferAcquisition scratch_buffer_acquisition(
       command_processor_.AcquireScratchGpuBuffer(
@@ -1230,10 +1318,6 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
       command_processor_.GetVulkanProvider();
   const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
   VkDevice device = provider.device();
-  VulkanSharedMemory& vulkan_shared_memory =
-      static_cast<VulkanSharedMemory&>(shared_memory());
-  std::array<VkWriteDescriptorSet, 3> write_descriptor_sets;
-  uint32_t write_descriptor_set_count = 0;
   VkDescriptorSet descriptor_set_dest =
       command_processor_.AllocateSingleTransientDescriptor(
           VulkanCommandProcessor::SingleTransientDescriptorLayout ::
@@ -1242,26 +1326,150 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
     return false;
   }
   VkDescriptorBufferInfo write_descriptor_set_dest_buffer_info;
-  {
-    write_descriptor_set_dest_buffer_info.buffer = scratch_buffer;
-    write_descriptor_set_dest_buffer_info.offset = 0;
-    write_descriptor_set_dest_buffer_info.range = host_buffer_size;
-    VkWriteDescriptorSet& write_descriptor_set_dest =
-        write_descriptor_sets[write_descriptor_set_count++];
-    write_descriptor_set_dest.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write_descriptor_set_dest.pNext = nullptr;
-    write_descriptor_set_dest.dstSet = descriptor_set_dest;
-    write_descriptor_set_dest.dstBinding = 0;
-    write_descriptor_set_dest.dstArrayElement = 0;
-    write_descriptor_set_dest.descriptorCount = 1;
-    write_descriptor_set_dest.descriptorType =
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    write_descriptor_set_dest.pImageInfo = nullptr;
-    write_descriptor_set_dest.pBufferInfo =
-        &write_descriptor_set_dest_buffer_info;
-    write_descriptor_set_dest.pTexelBufferView = nullptr;
+  write_descriptor_set_dest_buffer_info.buffer = scratch_buffer;
+  write_descriptor_set_dest_buffer_info.offset = 0;
+  write_descriptor_set_dest_buffer_info.range = host_buffer_size;
+  VkWriteDescriptorSet write_descriptor_set_dest;
+  write_descriptor_set_dest.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write_descriptor_set_dest.pNext = nullptr;
+  write_descriptor_set_dest.dstSet = descriptor_set_dest;
+  write_descriptor_set_dest.dstBinding = 0;
+  write_descriptor_set_dest.dstArrayElement = 0;
+  write_descriptor_set_dest.descriptorCount = 1;
+  write_descriptor_set_dest.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  write_descriptor_set_dest.pImageInfo = nullptr;
+  write_descriptor_set_dest.pBufferInfo =
+      &write_descriptor_set_dest_buffer_info;
+  write_descriptor_set_dest.pTexelBufferView = nullptr;
+  dfn.vkUpdateDescriptorSets(device, 1, &write_descriptor_set_dest, 0, nullptr);
+
+  // Obtain the resources for all the dispatches before recording anything, so
+  // nothing is recorded if the batch fails.
+  texture_load_batch_dispatches_.clear();
+  for (size_t i = 0; i < texture_load_count; ++i) {
+    TextureLoad& texture_load = texture_loads[i];
+    texture_load.dispatch_first = texture_load_batch_dispatches_.size();
+    if (!PrepareTextureLoadDispatches(texture_load)) {
+      return false;
+    }
+    texture_load.dispatch_count =
+        texture_load_batch_dispatches_.size() - texture_load.dispatch_first;
   }
-  // TODO(Triang3l): Use a single 512 MB shared memory binding if possible.
+
+  static_cast<VulkanSharedMemory&>(shared_memory())
+      .Use(VulkanSharedMemory::Usage::kRead);
+
+  // Submit the copy buffer population commands.
+
+  DeferredCommandBuffer& command_buffer =
+      command_processor_.deferred_command_buffer();
+
+  command_buffer.CmdVkBindDescriptorSets(
+      VK_PIPELINE_BIND_POINT_COMPUTE, load_pipeline_layout_,
+      kLoadDescriptorSetIndexDestination, 1, &descriptor_set_dest, 0, nullptr);
+
+  command_processor_.SubmitBarriers(true);
+  VkDescriptorSet descriptor_set_source_current = VK_NULL_HANDLE;
+  for (size_t i = 0; i < texture_load_count; ++i) {
+    const TextureLoad& texture_load = texture_loads[i];
+    command_processor_.BindExternalComputePipeline(texture_load.pipeline);
+    for (size_t j = 0; j < texture_load.dispatch_count; ++j) {
+      const TextureLoadDispatch& dispatch =
+          texture_load_batch_dispatches_[texture_load.dispatch_first + j];
+      if (descriptor_set_source_current != dispatch.descriptor_set_source) {
+        descriptor_set_source_current = dispatch.descriptor_set_source;
+        command_buffer.CmdVkBindDescriptorSets(
+            VK_PIPELINE_BIND_POINT_COMPUTE, load_pipeline_layout_,
+            kLoadDescriptorSetIndexSource, 1, &dispatch.descriptor_set_source,
+            0, nullptr);
+      }
+      command_buffer.CmdVkBindDescriptorSets(
+          VK_PIPELINE_BIND_POINT_COMPUTE, load_pipeline_layout_,
+          kLoadDescriptorSetIndexConstants, 1,
+          &dispatch.descriptor_set_constants, 0, nullptr);
+      command_buffer.CmdVkDispatch(dispatch.group_count_x,
+                                   dispatch.group_count_y,
+                                   dispatch.group_count_z);
+    }
+  }
+  texture_load_dispatches_ += uint32_t(texture_load_batch_dispatches_.size());
+
+  // Submit copying from the copy buffer to the host textures, with all the
+  // barriers for them at once.
+  command_processor_.PushBufferMemoryBarrier(
+      scratch_buffer, 0, VK_WHOLE_SIZE,
+      scratch_buffer_acquisition.SetStageMask(VK_PIPELINE_STAGE_TRANSFER_BIT),
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      scratch_buffer_acquisition.SetAccessMask(VK_ACCESS_TRANSFER_READ_BIT),
+      VK_ACCESS_TRANSFER_READ_BIT);
+  VkPipelineStageFlags texture_dst_stage_mask;
+  VkAccessFlags texture_dst_access_mask;
+  VkImageLayout texture_new_layout;
+  GetTextureUsageMasks(VulkanTexture::Usage::kTransferDestination,
+                       texture_dst_stage_mask, texture_dst_access_mask,
+                       texture_new_layout);
+  for (size_t i = 0; i < texture_load_count; ++i) {
+    VulkanTexture& vulkan_texture = *texture_loads[i].texture;
+    vulkan_texture.MarkAsUsed();
+    VulkanTexture::Usage texture_old_usage =
+        vulkan_texture.SetUsage(VulkanTexture::Usage::kTransferDestination);
+    if (texture_old_usage != VulkanTexture::Usage::kTransferDestination) {
+      VkPipelineStageFlags texture_src_stage_mask;
+      VkAccessFlags texture_src_access_mask;
+      VkImageLayout texture_old_layout;
+      GetTextureUsageMasks(texture_old_usage, texture_src_stage_mask,
+                           texture_src_access_mask, texture_old_layout);
+      command_processor_.PushImageMemoryBarrier(
+          vulkan_texture.image(),
+          ui::vulkan::util::InitializeSubresourceRange(),
+          texture_src_stage_mask, texture_dst_stage_mask,
+          texture_src_access_mask, texture_dst_access_mask, texture_old_layout,
+          texture_new_layout);
+    }
+  }
+  command_processor_.SubmitBarriers(true);
+  for (size_t i = 0; i < texture_load_count; ++i) {
+    CopyTextureLoad(texture_loads[i], scratch_buffer);
+  }
+
+  texture_loads_ += uint32_t(texture_load_count);
+  ++texture_load_batches_;
+  return true;
+}
+
+bool VulkanTextureCache::PrepareTextureLoadDispatches(
+    const TextureLoad& texture_load) {
+  const VulkanTexture& vulkan_texture = *texture_load.texture;
+  TextureKey texture_key = vulkan_texture.key();
+  const LoadShaderInfo& load_shader_info =
+      GetLoadShaderInfo(texture_load.load_shader);
+  const texture_util::TextureGuestLayout& guest_layout =
+      vulkan_texture.guest_layout();
+  xenos::DataDimension dimension = texture_key.dimension;
+  bool is_3d = dimension == xenos::DataDimension::k3D;
+  uint32_t width = texture_key.GetWidth();
+  uint32_t height = texture_key.GetHeight();
+  uint32_t depth_or_array_size = texture_key.GetDepthOrArraySize();
+  uint32_t depth = is_3d ? depth_or_array_size : 1;
+  uint32_t array_size = is_3d ? 1 : depth_or_array_size;
+  const FormatInfo* guest_format_info = FormatInfo::Get(texture_key.format);
+  uint32_t block_width = guest_format_info->block_width;
+  uint32_t block_height = guest_format_info->block_height;
+  uint32_t bytes_per_block = guest_format_info->bytes_per_block();
+  uint32_t level_packed = guest_layout.packed_level;
+  uint32_t texture_resolution_scale_x =
+      texture_key.scaled_resolve ? draw_resolution_scale_x() : 1;
+  uint32_t texture_resolution_scale_y =
+      texture_key.scaled_resolve ? draw_resolution_scale_y() : 1;
+
+  const ui::vulkan::VulkanProvider& provider =
+      command_processor_.GetVulkanProvider();
+  const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
+  VkDevice device = provider.device();
+  VulkanSharedMemory& vulkan_shared_memory =
+      static_cast<VulkanSharedMemory&>(shared_memory());
+  std::array<VkWriteDescriptorSet, 2> write_descriptor_sets;
+  uint32_t write_descriptor_set_count = 0;
   // TODO(Triang3l): Scaled resolve buffer bindings.
   // Aligning because if the data for a vector in a storage buffer is provided
   // partially, the value read may still be (0, 0, 0, 0), and small (especially
@@ -1272,7 +1480,21 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
   VkDescriptorSet descriptor_set_source_mips = VK_NULL_HANDLE;
   VkDescriptorBufferInfo write_descriptor_set_source_base_buffer_info;
   VkDescriptorBufferInfo write_descriptor_set_source_mips_buffer_info;
-  if (level_first == 0) {
+  // Offsets of the beginning of the source bindings in the shared memory.
+  uint32_t source_base_binding_offset = texture_key.base_page << 12;
+  uint32_t source_mips_binding_offset = texture_key.mip_page << 12;
+  // The persistent shared memory bindings are unscaled.
+  bool use_shared_memory_compute_bindings =
+      texture_resolution_scale_x == 1 && texture_resolution_scale_y == 1;
+  if (texture_load.level_first == 0 && use_shared_memory_compute_bindings) {
+    descriptor_set_source_base =
+        command_processor_.GetSharedMemoryComputeDescriptorSet(
+            source_base_binding_offset,
+            xe::align(vulkan_texture.GetGuestBaseSize(),
+                      source_length_alignment),
+            source_base_binding_offset);
+  }
+  if (texture_load.level_first == 0 && !descriptor_set_source_base) {
     descriptor_set_source_base =
         command_processor_.AllocateSingleTransientDescriptor(
             VulkanCommandProcessor::SingleTransientDescriptorLayout ::
@@ -1282,8 +1504,8 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
     }
     write_descriptor_set_source_base_buffer_info.buffer =
         vulkan_shared_memory.buffer();
-    write_descriptor_set_source_base_buffer_info.offset = texture_key.base_page
-                                                          << 12;
+    write_descriptor_set_source_base_buffer_info.offset =
+        source_base_binding_offset;
     write_descriptor_set_source_base_buffer_info.range =
         xe::align(vulkan_texture.GetGuestBaseSize(), source_length_alignment);
     VkWriteDescriptorSet& write_descriptor_set_source_base =
@@ -1302,7 +1524,15 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
         &write_descriptor_set_source_base_buffer_info;
     write_descriptor_set_source_base.pTexelBufferView = nullptr;
   }
-  if (level_last != 0) {
+  if (texture_load.level_last != 0 && use_shared_memory_compute_bindings) {
+    descriptor_set_source_mips =
+        command_processor_.GetSharedMemoryComputeDescriptorSet(
+            source_mips_binding_offset,
+            xe::align(vulkan_texture.GetGuestMipsSize(),
+                      source_length_alignment),
+            source_mips_binding_offset);
+  }
+  if (texture_load.level_last != 0 && !descriptor_set_source_mips) {
     descriptor_set_source_mips =
         command_processor_.AllocateSingleTransientDescriptor(
             VulkanCommandProcessor::SingleTransientDescriptorLayout ::
@@ -1312,8 +1542,8 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
     }
     write_descriptor_set_source_mips_buffer_info.buffer =
         vulkan_shared_memory.buffer();
-    write_descriptor_set_source_mips_buffer_info.offset = texture_key.mip_page
-                                                          << 12;
+    write_descriptor_set_source_mips_buffer_info.offset =
+        source_mips_binding_offset;
     write_descriptor_set_source_mips_buffer_info.range =
         xe::align(vulkan_texture.GetGuestMipsSize(), source_length_alignment);
     VkWriteDescriptorSet& write_descriptor_set_source_mips =
@@ -1336,20 +1566,6 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
     dfn.vkUpdateDescriptorSets(device, write_descriptor_set_count,
                                write_descriptor_sets.data(), 0, nullptr);
   }
-  vulkan_shared_memory.Use(VulkanSharedMemory::Usage::kRead);
-
-  // Submit the copy buffer population commands.
-
-  DeferredCommandBuffer& command_buffer =
-      command_processor_.deferred_command_buffer();
-
-  command_processor_.BindExternalComputePipeline(pipeline);
-
-  command_buffer.CmdVkBindDescriptorSets(
-      VK_PIPELINE_BIND_POINT_COMPUTE, load_pipeline_layout_,
-      kLoadDescriptorSetIndexDestination, 1, &descriptor_set_dest, 0, nullptr);
-
-  VkDescriptorSet descriptor_set_source_current = VK_NULL_HANDLE;
 
   LoadConstants load_constants;
   // 3 bits for each.
@@ -1362,23 +1578,21 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
 
   uint32_t guest_x_blocks_per_group_log2 =
       load_shader_info.GetGuestXBlocksPerGroupLog2();
-  for (uint32_t loop_level = loop_level_first; loop_level <= loop_level_last;
-       ++loop_level) {
+  for (uint32_t loop_level = texture_load.loop_level_first;
+       loop_level <= texture_load.loop_level_last; ++loop_level) {
     bool is_base = loop_level == 0;
     uint32_t level = (level_packed == 0) ? 0 : loop_level;
 
     VkDescriptorSet descriptor_set_source =
         is_base ? descriptor_set_source_base : descriptor_set_source_mips;
-    if (descriptor_set_source_current != descriptor_set_source) {
-      descriptor_set_source_current = descriptor_set_source;
-      command_buffer.CmdVkBindDescriptorSets(
-          VK_PIPELINE_BIND_POINT_COMPUTE, load_pipeline_layout_,
-          kLoadDescriptorSetIndexSource, 1, &descriptor_set_source, 0, nullptr);
-    }
 
-    // TODO(Triang3l): guest_offset relative to the storage buffer origin.
-    load_constants.guest_offset = 0;
-    if (!is_base) {
+    // guest_offset is relative to the storage buffer origin.
+    if (is_base) {
+      load_constants.guest_offset =
+          (texture_key.base_page << 12) - source_base_binding_offset;
+    } else {
+      load_constants.guest_offset =
+          (texture_key.mip_page << 12) - source_mips_binding_offset;
       load_constants.guest_offset +=
           guest_layout.mip_offsets_bytes[level] *
           (texture_resolution_scale_x * texture_resolution_scale_y);
@@ -1427,10 +1641,13 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
          ((UINT32_C(1) << kLoadGuestYBlocksPerGroupLog2) - 1)) >>
         kLoadGuestYBlocksPerGroupLog2;
 
-    // TODO(Triang3l): host_offset relative to the storage buffer origin.
-    const HostLayout& level_host_layout =
-        is_base ? host_layout_base : host_layout_mips[level];
-    load_constants.host_offset = uint32_t(level_host_layout.offset_bytes);
+    // host_offset is relative to the storage buffer origin, which is shared by
+    // all the textures in the batch.
+    const TextureLoad::HostLayout& level_host_layout =
+        is_base ? texture_load.host_layout_base
+                : texture_load.host_layout_mips[level];
+    load_constants.host_offset = uint32_t(texture_load.host_buffer_offset +
+                                          level_host_layout.offset_bytes);
     load_constants.host_pitch = load_shader_info.bytes_per_host_block *
                                 level_host_layout.x_pitch_blocks;
 
@@ -1449,53 +1666,62 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
         return false;
       }
       std::memcpy(constants_mapping, &load_constants, sizeof(load_constants));
-      command_buffer.CmdVkBindDescriptorSets(
-          VK_PIPELINE_BIND_POINT_COMPUTE, load_pipeline_layout_,
-          kLoadDescriptorSetIndexConstants, 1, &descriptor_set_constants, 0,
-          nullptr);
-      command_processor_.SubmitBarriers(true);
-      command_buffer.CmdVkDispatch(group_count_x, group_count_y,
-                                   load_constants.size_blocks[2]);
+      TextureLoadDispatch& dispatch =
+          texture_load_batch_dispatches_.emplace_back();
+      dispatch.descriptor_set_source = descriptor_set_source;
+      dispatch.descriptor_set_constants = descriptor_set_constants;
+      dispatch.group_count_x = group_count_x;
+      dispatch.group_count_y = group_count_y;
+      dispatch.group_count_z = load_constants.size_blocks[2];
       load_constants.guest_offset += level_array_slice_stride_bytes_scaled;
       load_constants.host_offset +=
           uint32_t(level_host_layout.slice_size_bytes);
     }
   }
 
-  // Submit copying from the copy buffer to the host texture.
-  command_processor_.PushBufferMemoryBarrier(
-      scratch_buffer, 0, VK_WHOLE_SIZE,
-      scratch_buffer_acquisition.SetStageMask(VK_PIPELINE_STAGE_TRANSFER_BIT),
-      VK_PIPELINE_STAGE_TRANSFER_BIT,
-      scratch_buffer_acquisition.SetAccessMask(VK_ACCESS_TRANSFER_READ_BIT),
-      VK_ACCESS_TRANSFER_READ_BIT);
-  vulkan_texture.MarkAsUsed();
-  VulkanTexture::Usage texture_old_usage =
-      vulkan_texture.SetUsage(VulkanTexture::Usage::kTransferDestination);
-  if (texture_old_usage != VulkanTexture::Usage::kTransferDestination) {
-    VkPipelineStageFlags texture_src_stage_mask, texture_dst_stage_mask;
-    VkAccessFlags texture_src_access_mask, texture_dst_access_mask;
-    VkImageLayout texture_old_layout, texture_new_layout;
-    GetTextureUsageMasks(texture_old_usage, texture_src_stage_mask,
-                         texture_src_access_mask, texture_old_layout);
-    GetTextureUsageMasks(VulkanTexture::Usage::kTransferDestination,
-                         texture_dst_stage_mask, texture_dst_access_mask,
-                         texture_new_layout);
-    command_processor_.PushImageMemoryBarrier(
-        vulkan_texture.image(), ui::vulkan::util::InitializeSubresourceRange(),
-        texture_src_stage_mask, texture_dst_stage_mask, texture_src_access_mask,
-        texture_dst_access_mask, texture_old_layout, texture_new_layout);
-  }
-  command_processor_.SubmitBarriers(true);
-  VkBufferImageCopy* copy_regions = command_buffer.CmdCopyBufferToImageEmplace(
-      scratch_buffer, vulkan_texture.image(),
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, level_last - level_first + 1);
+  return true;
+}
+
+void VulkanTextureCache::CopyTextureLoad(const TextureLoad& texture_load,
+                                         VkBuffer scratch_buffer) {
+  const VulkanTexture& vulkan_texture = *texture_load.texture;
+  TextureKey texture_key = vulkan_texture.key();
+  const LoadShaderInfo& load_shader_info =
+      GetLoadShaderInfo(texture_load.load_shader);
+  bool is_3d = texture_key.dimension == xenos::DataDimension::k3D;
+  uint32_t width = texture_key.GetWidth();
+  uint32_t height = texture_key.GetHeight();
+  uint32_t depth_or_array_size = texture_key.GetDepthOrArraySize();
+  uint32_t depth = is_3d ? depth_or_array_size : 1;
+  uint32_t array_size = is_3d ? 1 : depth_or_array_size;
+  xenos::TextureFormat guest_format = texture_key.format;
+  const FormatInfo* guest_format_info = FormatInfo::Get(guest_format);
+  uint32_t block_width = guest_format_info->block_width;
+  uint32_t block_height = guest_format_info->block_height;
+  uint32_t level_first = texture_load.level_first;
+  uint32_t level_last = texture_load.level_last;
+  uint32_t level_packed = vulkan_texture.guest_layout().packed_level;
+  uint32_t texture_resolution_scale_x =
+      texture_key.scaled_resolve ? draw_resolution_scale_x() : 1;
+  uint32_t texture_resolution_scale_y =
+      texture_key.scaled_resolve ? draw_resolution_scale_y() : 1;
+  uint32_t host_block_width =
+      texture_load.host_format_block_compressed ? block_width : 1;
+  uint32_t host_block_height =
+      texture_load.host_format_block_compressed ? block_height : 1;
+
+  VkBufferImageCopy* copy_regions =
+      command_processor_.deferred_command_buffer().CmdCopyBufferToImageEmplace(
+          scratch_buffer, vulkan_texture.image(),
+          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, level_last - level_first + 1);
   for (uint32_t level = level_first; level <= level_last; ++level) {
     VkBufferImageCopy& copy_region = copy_regions[level - level_first];
-    const HostLayout& level_host_layout =
-        level != 0 ? host_layout_mips[std::min(level, level_packed)]
-                   : host_layout_base;
-    copy_region.bufferOffset = level_host_layout.offset_bytes;
+    const TextureLoad::HostLayout& level_host_layout =
+        level != 0
+            ? texture_load.host_layout_mips[std::min(level, level_packed)]
+            : texture_load.host_layout_base;
+    copy_region.bufferOffset =
+        texture_load.host_buffer_offset + level_host_layout.offset_bytes;
     if (level >= level_packed) {
       uint32_t level_offset_blocks_x, level_offset_blocks_y, level_offset_z;
       texture_util::GetPackedMipOffset(width, height, depth, guest_format,
@@ -1505,7 +1731,7 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
           texture_resolution_scale_x * level_offset_blocks_x;
       uint32_t level_offset_host_blocks_y =
           texture_resolution_scale_y * level_offset_blocks_y;
-      if (!host_format.block_compressed) {
+      if (!texture_load.host_format_block_compressed) {
         level_offset_host_blocks_x *= block_width;
         level_offset_host_blocks_y *= block_height;
       }
@@ -1533,8 +1759,6 @@ bool VulkanTextureCache::LoadTextureDataFromResidentMemoryImpl(Texture& texture,
         std::max((height * texture_resolution_scale_y) >> level, UINT32_C(1));
     copy_region.imageExtent.depth = std::max(depth >> level, UINT32_C(1));
   }
-
-  return true;
 }
 
 void VulkanTextureCache::UpdateTextureBindingsImpl(
@@ -14,6 +14,7 @@
 #include <memory>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "xenia/base/hash.h"
 #include "xenia/gpu/texture_cache.h"
@@ -122,6 +123,19 @@ class VulkanTextureCache final : public TextureCache {
                                  uint32_t& height_scaled_out,
                                  xenos::TextureFormat& format_out);
 
+  // Returns the number of textures loaded, the number of batches they were
+  // loaded in, and the number of load dispatches since the last call.
+  void TakeTextureLoadCounts(uint32_t& texture_loads_out,
+                             uint32_t& texture_load_batches_out,
+                             uint32_t& texture_load_dispatches_out) {
+    texture_loads_out = texture_loads_;
+    texture_load_batches_out = texture_load_batches_;
+    texture_load_dispatches_out = texture_load_dispatches_;
+    texture_loads_ = 0;
+    texture_load_batches_ = 0;
+    texture_load_dispatches_ = 0;
+  }
+
  protected:
   bool IsSignedVersionSeparateForFormat(TextureKey key) const override;
   uint32_t GetHostFormatSwizzle(TextureKey key) const override;
@@ -275,6 +289,56 @@ class VulkanTextureCache final : public TextureCache {
     }
   };
 
+  // Loading of a texture split into the part done before allocating the scratch
+  // buffer shared by multiple textures, and the commands recorded after that.
+  struct TextureLoad {
+    struct HostLayout {
+      // Relative to host_buffer_offset.
+      VkDeviceSize offset_bytes;
+      VkDeviceSize slice_size_bytes;
+      uint32_t x_pitch_blocks;
+      uint32_t y_pitch_blocks;
+    };
+
+    VulkanTexture* texture;
+    LoadShaderIndex load_shader;
+    VkPipeline pipeline;
+    bool host_format_block_compressed;
+    uint32_t level_first;
+    uint32_t level_last;
+    uint32_t loop_level_first;
+    uint32_t loop_level_last;
+    // Size of the untiled data of all the levels, and its offset in the scratch
+    // buffer.
+    VkDeviceSize host_buffer_size;
+    VkDeviceSize host_buffer_offset;
+    HostLayout host_layout_base;
+    // Indexing is the same as for guest stored mips:
+    // 1...min(level_last, level_packed) if level_packed is not 0, or only 0 if
+    // level_packed == 0.
+    HostLayout host_layout_mips[xenos::kTextureMaxMips];
+    // Range of the dispatches of the texture in texture_load_batch_dispatches_,
+    // set by LoadTextures.
+    size_t dispatch_first;
+    size_t dispatch_count;
+  };
+
+  // A compute dispatch of a texture load. All the resources for the dispatches
+  // of a batch are obtained before recording any commands, so a failed batch
+  // doesn't leave partially recorded loads in the command buffer.
+  struct TextureLoadDispatch {
+    VkDescriptorSet descriptor_set_source;
+    VkDescriptorSet descriptor_set_constants;
+    uint32_t group_count_x;
+    uint32_t group_count_y;
+    uint32_t group_count_z;
+  };
+
+  // Placement alignment of textures in the scratch buffer of a batch, enough
+  // for minStorageBufferOffsetAlignment and optimalBufferCopyOffsetAlignment on
+  // any device, and for the largest host block.
+  static constexpr VkDeviceSize kTextureLoadHostBufferAlignment = 256;
+
   struct Sampler {
     VkSampler sampler;
     uint64_t last_usage_submission;
@@ -315,6 +379,21 @@ class VulkanTextureCache final : public TextureCache {
 
   xenos::ClampMode NormalizeClampMode(xenos::ClampMode clamp_mode) const;
 
+  bool InitializeTextureLoad(VulkanTexture& texture, bool load_base,
+                             bool load_mips, TextureLoad& texture_load);
+  // Loads the textures deferred while texture_load_batch_open_ was set.
+  void FlushTextureLoads();
+  // Untiles the textures to a single scratch buffer and copies them to the
+  // images, with the barriers for all the textures submitted at once. Sets
+  // host_buffer_offset in the loads.
+  bool LoadTextures(TextureLoad* texture_loads, size_t texture_load_count);
+  // Obtains the descriptors and the constants for the dispatches of the load
+  // and appends them to texture_load_batch_dispatches_ without recording any
+  // commands.
+  bool PrepareTextureLoadDispatches(const TextureLoad& texture_load);
+  void CopyTextureLoad(const TextureLoad& texture_load,
+                       VkBuffer scratch_buffer);
+
   VulkanCommandProcessor& command_processor_;
   VkPipelineStageFlags guest_shader_pipeline_stages_;
 
@@ -333,6 +412,16 @@ class VulkanTextureCache final : public TextureCache {
   std::array<VkPipeline, kLoadShaderCount> load_pipelines_{};
   std::array<VkPipeline, kLoadShaderCount> load_pipelines_scaled_{};
 
+  // Whether LoadTextureDataFromResidentMemoryImpl should defer the loads until
+  // FlushTextureLoads instead of loading immediately.
+  bool texture_load_batch_open_ = false;
+  std::vector<TextureLoad> pending_texture_loads_;
+  std::vector<TextureLoadDispatch> texture_load_batch_dispatches_;
+
+  uint32_t texture_loads_ = 0;
+  uint32_t texture_load_batches_ = 0;
+  uint32_t texture_load_dispatches_ = 0;
+
   // If both images can be placed in the same allocation, it's one allocation,
   // otherwise it's two separate.
   std::array<VkDeviceMemory, 2> null_images_memory_{};
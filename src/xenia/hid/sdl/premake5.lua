@@ -16,3 +16,4 @@ project("xenia-hid-sdl")
   })
   local_platform_files()
   sdl2_include()
+include("testing")
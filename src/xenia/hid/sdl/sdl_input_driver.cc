@@ -9,7 +9,10 @@
 
 #include "xenia/hid/sdl/sdl_input_driver.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstring>
 
 #if XE_PLATFORM_WIN32
 #include "xenia/base/platform_win.h"
@@ -18,6 +21,7 @@
 #include "xenia/base/clock.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/profiling.h"
 #include "xenia/helper/sdl/sdl_helper.h"
 #include "xenia/hid/hid_flags.h"
 #include "xenia/ui/virtual_key.h"
@@ -28,6 +32,10 @@
 DEFINE_path(mappings_file, "gamecontrollerdb.txt",
             "Filename of a database with custom game controller mappings.",
             "SDL");
+DEFINE_uint32(sdl_input_poll_rate, 1000,
+              "Rate in Hz at which the input thread samples the state of the "
+              "game controllers for the guest.",
+              "SDL");
 
 namespace xe {
 namespace hid {
@@ -38,22 +46,120 @@ SDLInputDriver::SDLInputDriver(xe::ui::Window* window, size_t window_z_order)
       sdl_events_initialized_(false),
       sdl_gamecontroller_initialized_(false),
       sdl_events_unflushed_(0),
-      sdl_pumpevents_queued_(false),
+      input_thread_running_(false),
       controllers_(),
       controllers_mutex_(),
-      keystroke_states_() {}
+      keystroke_states_(),
+      published_states_(),
+      published_states_index_(0) {
+  for (uint32_t i = 0; i < HID_SDL_USER_COUNT; ++i) {
+    // The first connection already increments the packet number.
+    last_read_is_active_[i] = true;
+    packet_number_bias_[i] = 0;
+    last_read_packet_[i] = 0;
+  }
+}
 
 SDLInputDriver::~SDLInputDriver() {
-  // Make sure the CallInUIThread is executed before destroying the references.
-  if (sdl_pumpevents_queued_) {
-    window()->app_context().CallInUIThreadSynchronous([this]() {
-      window()->app_context().ExecutePendingFunctionsFromUIThread();
-    });
+  if (input_thread_) {
+    input_thread_running_ = false;
+    xe::threading::Wait(input_thread_.get(), false);
+    input_thread_.reset();
   }
-  for (size_t i = 0; i < controllers_.size(); i++) {
-    if (controllers_.at(i).sdl) {
-      SDL_GameControllerClose(controllers_.at(i).sdl);
-      controllers_.at(i) = {};
+}
+
+X_STATUS SDLInputDriver::Setup() {
+  if (!TestSDLVersion()) {
+    return X_STATUS_UNSUCCESSFUL;
+  }
+
+  // SDL_PumpEvents should only be run in the thread that initialized SDL. The
+  // input thread does both, so guest input queries neither wait for nor queue
+  // work to the UI thread. If initialization fails, the "initialized" variables
+  // will be false - that's handled safely.
+  input_thread_ready_event_ = xe::threading::Event::CreateAutoResetEvent(false);
+  input_thread_running_ = true;
+  bool sdl_initialized = false;
+  input_thread_ = xe::threading::Thread::Create({}, [this,
+                                                     &sdl_initialized]() {
+    // sdl_initialized is only valid until the ready event is set.
+    bool initialized = InitializeSDL();
+    sdl_initialized = initialized;
+    input_thread_ready_event_->Set();
+    if (initialized) {
+      InputThreadMain();
+    }
+    ShutdownSDL();
+  });
+  if (!input_thread_) {
+    input_thread_running_ = false;
+    return X_STATUS_UNSUCCESSFUL;
+  }
+  input_thread_->set_name("SDL Input");
+  input_thread_->set_priority(xe::threading::ThreadPriority::kAboveNormal);
+  xe::threading::Wait(input_thread_ready_event_.get(), false);
+  return sdl_initialized ? X_STATUS_SUCCESS : X_STATUS_UNSUCCESSFUL;
+}
+
+bool SDLInputDriver::InitializeSDL() {
+  if (!xe::helper::sdl::SDLHelper::Prepare()) {
+    return false;
+  }
+  // Initialize the event system early, so we catch device events for already
+  // connected controllers.
+  if (SDL_InitSubSystem(SDL_INIT_EVENTS) < 0) {
+    return false;
+  }
+  sdl_events_initialized_ = true;
+
+  // With an event watch we will always get notified, even if the event queue
+  // is full, which can happen if another subsystem does not clear its events.
+  SDL_AddEventWatch(EventWatch, this);
+
+  if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) < 0) {
+    return false;
+  }
+  sdl_gamecontroller_initialized_ = true;
+
+  if (!cvars::mappings_file.empty()) {
+    if (!std::filesystem::exists(cvars::mappings_file)) {
+      XELOGW("SDL GameControllerDB: file '{}' does not exist.",
+             xe::path_to_utf8(cvars::mappings_file));
+    } else {
+      auto mappings_file = filesystem::OpenFile(cvars::mappings_file, "rb");
+      if (!mappings_file) {
+        XELOGE("SDL GameControllerDB: failed to open file '{}'.",
+               xe::path_to_utf8(cvars::mappings_file));
+      } else {
+        auto mappings_result = SDL_GameControllerAddMappingsFromRW(
+            SDL_RWFromFP(mappings_file, SDL_TRUE), 1);
+        if (mappings_result < 0) {
+          XELOGE("SDL GameControllerDB: error loading file '{}': {}.",
+                 xe::path_to_utf8(cvars::mappings_file), mappings_result);
+        } else {
+          XELOGI("SDL GameControllerDB: loaded {} mappings.", mappings_result);
+        }
+      }
+    }
+  }
+
+  // Publish the controllers that were already connected.
+  SDL_PumpEvents();
+  PublishControllerStates();
+  return true;
+}
+
+void SDLInputDriver::ShutdownSDL() {
+  if (sdl_events_initialized_) {
+    SDL_DelEventWatch(EventWatch, this);
+  }
+  {
+    std::unique_lock<std::mutex> guard(controllers_mutex_);
+    for (size_t i = 0; i < controllers_.size(); i++) {
+      if (controllers_.at(i).sdl) {
+        SDL_GameControllerClose(controllers_.at(i).sdl);
+        controllers_.at(i) = {};
+      }
     }
   }
   if (sdl_events_initialized_) {
@@ -66,80 +172,68 @@ SDLInputDriver::~SDLInputDriver() {
   }
 }
 
-X_STATUS SDLInputDriver::Setup() {
-  if (!TestSDLVersion()) {
-    return X_STATUS_UNSUCCESSFUL;
+void SDLInputDriver::InputThreadMain() {
+  const auto poll_interval = std::chrono::microseconds(
+      1000000 / std::max(cvars::sdl_input_poll_rate, uint32_t(1)));
+  while (input_thread_running_) {
+    // Events are handled by the watch from within SDL_PumpEvents.
+    SDL_PumpEvents();
+    PublishControllerStates();
+    xe::threading::Sleep(poll_interval);
   }
+}
 
-  // SDL_PumpEvents should only be run in the thread that initialized SDL - we
-  // are hijacking the UI thread for that. If this function fails to be queued,
-  // the "initialized" variables will be false - that's handled safely.
-  window()->app_context().CallInUIThreadSynchronous([this]() {
-    if (!xe::helper::sdl::SDLHelper::Prepare()) {
-      return;
-    }
-    // Initialize the event system early, so we catch device events for already
-    // connected controllers.
-    if (SDL_InitSubSystem(SDL_INIT_EVENTS) < 0) {
-      return;
-    }
-    sdl_events_initialized_ = true;
-
-    // With an event watch we will always get notified, even if the event queue
-    // is full, which can happen if another subsystem does not clear its events.
-    SDL_AddEventWatch(
-        [](void* userdata, SDL_Event* event) -> int {
-          if (!userdata || !event) {
-            assert_always();
-            return 0;
-          }
-
-          const auto type = event->type;
-          if (type < SDL_JOYAXISMOTION || type >= SDL_FINGERDOWN) {
-            return 0;
-          }
-
-          // If another part of xenia uses another SDL subsystem that generates
-          // events, this may seem like a bad idea. They will however not
-          // subscribe to controller events so we get away with that.
-          const auto driver = static_cast<SDLInputDriver*>(userdata);
-          driver->HandleEvent(*event);
-
-          return 0;
-        },
-        this);
-
-    if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) < 0) {
-      return;
-    }
-    sdl_gamecontroller_initialized_ = true;
-
-    if (!cvars::mappings_file.empty()) {
-      if (!std::filesystem::exists(cvars::mappings_file)) {
-        XELOGW("SDL GameControllerDB: file '{}' does not exist.",
-               xe::path_to_utf8(cvars::mappings_file));
+void SDLInputDriver::PublishControllerStates() {
+  // Only this thread writes, so the index can't change in between.
+  uint32_t index = published_states_index_.load(std::memory_order_relaxed) ^ 1;
+  PublishedStates& published = published_states_[index];
+  published.sequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  {
+    std::unique_lock<std::mutex> guard(controllers_mutex_);
+    for (size_t i = 0; i < controllers_.size(); i++) {
+      ControllerState& controller = controllers_[i];
+      PublishedControllerState& published_controller =
+          published.controllers[i];
+      published_controller.connected = controller.sdl != nullptr;
+      if (!controller.sdl) {
+        continue;
+      }
+      // Make sure packet_number is only incremented by 1, even if there have
+      // been multiple updates between two samples.
+      if (controller.state_changed) {
+        controller.state.packet_number++;
+        controller.state_changed = false;
+        published_controller.change_host_tick = controller.change_host_tick;
       } else {
-        auto mappings_file = filesystem::OpenFile(cvars::mappings_file, "rb");
-        if (!mappings_file) {
-          XELOGE("SDL GameControllerDB: failed to open file '{}'.",
-                 xe::path_to_utf8(cvars::mappings_file));
-        } else {
-          auto mappings_result = SDL_GameControllerAddMappingsFromRW(
-              SDL_RWFromFP(mappings_file, SDL_TRUE), 1);
-          if (mappings_result < 0) {
-            XELOGE("SDL GameControllerDB: error loading file '{}': {}.",
-                   xe::path_to_utf8(cvars::mappings_file), mappings_result);
-          } else {
-            XELOGI("SDL GameControllerDB: loaded {} mappings.",
-                   mappings_result);
-          }
-        }
+        published_controller.change_host_tick =
+            published_states_[index ^ 1].controllers[i].change_host_tick;
       }
+      published_controller.state = controller.state;
     }
-  });
-  return (sdl_events_initialized_ && sdl_gamecontroller_initialized_)
-             ? X_STATUS_SUCCESS
-             : X_STATUS_UNSUCCESSFUL;
+  }
+  published.sequence.fetch_add(1, std::memory_order_release);
+  published_states_index_.store(index, std::memory_order_release);
+}
+
+bool SDLInputDriver::ReadPublishedControllerState(
+    uint32_t user_index, PublishedControllerState& state_out) const {
+  while (true) {
+    const PublishedStates& published =
+        published_states_[published_states_index_.load(
+            std::memory_order_acquire)];
+    uint32_t sequence = published.sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      // The input thread has already moved on to this buffer.
+      continue;
+    }
+    std::memcpy(&state_out, &published.controllers[user_index],
+                sizeof(state_out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (published.sequence.load(std::memory_order_relaxed) == sequence) {
+      return state_out.connected;
+    }
+  }
 }
 
 X_RESULT SDLInputDriver::GetCapabilities(uint32_t user_index, uint32_t flags,
@@ -149,8 +243,6 @@ X_RESULT SDLInputDriver::GetCapabilities(uint32_t user_index, uint32_t flags,
     return X_ERROR_BAD_ARGUMENTS;
   }
 
-  QueueControllerUpdate();
-
   std::unique_lock<std::mutex> guard(controllers_mutex_);
 
   auto controller = GetControllerState(user_index);
@@ -176,27 +268,33 @@ X_RESULT SDLInputDriver::GetState(uint32_t user_index,
 
   auto is_active = this->is_active();
 
-  if (is_active) {
-    QueueControllerUpdate();
+  // Lock-free, the input thread samples the controllers independently.
+  PublishedControllerState published;
+  if (!ReadPublishedControllerState(user_index, published)) {
+    return X_ERROR_DEVICE_NOT_CONNECTED;
   }
 
-  std::unique_lock<std::mutex> guard(controllers_mutex_);
-
-  auto controller = GetControllerState(user_index);
-  if (!controller) {
-    return X_ERROR_DEVICE_NOT_CONNECTED;
+  // The input thread increments packet_number once per sample with changes,
+  // additionally increment it when `is_active` changes.
+  if (last_read_is_active_[user_index].exchange(is_active) != is_active) {
+    packet_number_bias_[user_index].fetch_add(1, std::memory_order_relaxed);
   }
 
-  // Make sure packet_number is only incremented by 1, even if there have been
-  // multiple updates between GetState calls. Also track `is_active` to
-  // increment the packet number if it changed.
-  if ((is_active != controller->is_active) ||
-      (is_active && controller->state_changed)) {
-    controller->state.packet_number++;
-    controller->is_active = is_active;
-    controller->state_changed = false;
+  // Input-to-guest latency of the first read of a new state.
+  if (last_read_packet_[user_index].exchange(
+          published.state.packet_number, std::memory_order_relaxed) !=
+          published.state.packet_number &&
+      published.change_host_tick) {
+    uint64_t latency_ticks =
+        Clock::QueryHostTickCount() - published.change_host_tick;
+    COUNT_profile_set(
+        "hid/sdl/input_latency_us",
+        latency_ticks * 1000000 / Clock::QueryHostTickFrequency());
   }
-  std::memcpy(out_state, &controller->state, sizeof(*out_state));
+
+  std::memcpy(out_state, &published.state, sizeof(*out_state));
+  out_state->packet_number +=
+      packet_number_bias_[user_index].load(std::memory_order_relaxed);
   if (!is_active) {
     // Simulate an "untouched" controller. When we become active again the
     // pressed buttons aren't lost and will be visible again.
@@ -212,8 +310,6 @@ X_RESULT SDLInputDriver::SetState(uint32_t user_index,
     return X_ERROR_BAD_ARGUMENTS;
   }
 
-  QueueControllerUpdate();
-
   std::unique_lock<std::mutex> guard(controllers_mutex_);
 
   auto controller = GetControllerState(user_index);
@@ -292,10 +388,6 @@ X_RESULT SDLInputDriver::GetKeystroke(uint32_t users, uint32_t flags,
 
   auto is_active = this->is_active();
 
-  if (is_active) {
-    QueueControllerUpdate();
-  }
-
   std::unique_lock<std::mutex> guard(controllers_mutex_);
 
   for (uint32_t user_index = (user_any ? 0 : users);
@@ -387,9 +479,30 @@ X_RESULT SDLInputDriver::GetKeystroke(uint32_t users, uint32_t flags,
   return X_ERROR_EMPTY;
 }
 
+int SDLInputDriver::EventWatch(void* userdata, SDL_Event* event) {
+  if (!userdata || !event) {
+    assert_always();
+    return 0;
+  }
+
+  const auto type = event->type;
+  if (type < SDL_JOYAXISMOTION || type >= SDL_FINGERDOWN) {
+    return 0;
+  }
+
+  // If another part of xenia uses another SDL subsystem that generates
+  // events, this may seem like a bad idea. They will however not subscribe to
+  // controller events so we get away with that.
+  const auto driver = static_cast<SDLInputDriver*>(userdata);
+  driver->HandleEvent(*event);
+
+  return 0;
+}
+
 void SDLInputDriver::HandleEvent(const SDL_Event& event) {
-  // This callback will likely run on the thread that posts the event, which
-  // may be a dedicated thread SDL has created for the joystick subsystem.
+  // This callback will likely run on the input thread from within
+  // SDL_PumpEvents, but it may also run on a dedicated thread SDL has created
+  // for the joystick subsystem.
 
   // Event queue should never be (this) full
   assert(SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_FIRSTEVENT,
@@ -474,7 +587,7 @@ void SDLInputDriver::OnControllerDeviceAdded(const SDL_Event& event) {
     auto& state = controllers_.at(user_id);
     state = {controller, {}};
     // XInput seems to start with packet_number = 1 .
-    state.state_changed = true;
+    MarkStateChanged(state);
     UpdateXCapabilities(state);
 
     XELOGI("SDL OnControllerDeviceAdded: Added at index {}.", user_id);
@@ -530,7 +643,7 @@ void SDLInputDriver::OnControllerDeviceAxisMotion(const SDL_Event& event) {
       assert_always();
       break;
   }
-  controllers_.at(*idx).state_changed = true;
+  MarkStateChanged(controllers_.at(*idx));
 }
 
 void SDLInputDriver::OnControllerDeviceButtonChanged(const SDL_Event& event) {
@@ -594,7 +707,7 @@ void SDLInputDriver::OnControllerDeviceButtonChanged(const SDL_Event& event) {
     xbuttons &= ~xbutton;
   }
   controller.state.gamepad.buttons = xbuttons;
-  controller.state_changed = true;
+  MarkStateChanged(controller);
 }
 
 std::optional<size_t> SDLInputDriver::GetControllerIndexFromInstanceID(
@@ -697,16 +810,10 @@ void SDLInputDriver::UpdateXCapabilities(ControllerState& state) {
   c.vibration.right_motor_speed = 0xFFFFu;
 }
 
-void SDLInputDriver::QueueControllerUpdate() {
-  // To minimize consecutive event pumps do not queue before previous pump is
-  // finished.
-  bool is_queued = false;
-  sdl_pumpevents_queued_.compare_exchange_strong(is_queued, true);
-  if (!is_queued) {
-    window()->app_context().CallInUIThread([this]() {
-      SDL_PumpEvents();
-      sdl_pumpevents_queued_ = false;
-    });
+void SDLInputDriver::MarkStateChanged(ControllerState& state) {
+  if (!state.state_changed) {
+    state.state_changed = true;
+    state.change_host_tick = Clock::QueryHostTickCount();
   }
 }
 
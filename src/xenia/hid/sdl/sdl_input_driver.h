@@ -12,10 +12,12 @@
 
 #include <array>
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <optional>
 
 #include "SDL.h"
+#include "xenia/base/threading.h"
 #include "xenia/hid/input_driver.h"
 
 #define HID_SDL_USER_COUNT 4
@@ -48,7 +50,23 @@ class SDLInputDriver final : public InputDriver {
     X_INPUT_CAPABILITIES caps;
     X_INPUT_STATE state;
     bool state_changed;
-    bool is_active;
+    // Host tick count of the first event since the last publication.
+    uint64_t change_host_tick;
+  };
+
+  // Controller states as last sampled by the input thread. There are two
+  // buffers, the input thread only writes to the one that is not published,
+  // and the sequence number of a buffer is odd while it's being written. So
+  // readers never wait for the input thread - they only retry if the input
+  // thread has published twice while they were copying.
+  struct PublishedControllerState {
+    X_INPUT_STATE state;
+    uint64_t change_host_tick;
+    bool connected;
+  };
+  struct PublishedStates {
+    std::atomic<uint32_t> sequence;
+    std::array<PublishedControllerState, HID_SDL_USER_COUNT> controllers;
   };
 
   enum class RepeatState {
@@ -65,6 +83,14 @@ class SDLInputDriver final : public InputDriver {
     uint32_t repeat_time;
   };
 
+  bool InitializeSDL();
+  void ShutdownSDL();
+  void InputThreadMain();
+  void PublishControllerStates();
+  bool ReadPublishedControllerState(uint32_t user_index,
+                                    PublishedControllerState& state_out) const;
+
+  static int EventWatch(void* userdata, SDL_Event* event);
   void HandleEvent(const SDL_Event& event);
   void OnControllerDeviceAdded(const SDL_Event& event);
   void OnControllerDeviceRemoved(const SDL_Event& event);
@@ -77,15 +103,26 @@ class SDLInputDriver final : public InputDriver {
   ControllerState* GetControllerState(uint32_t user_index);
   bool TestSDLVersion() const;
   void UpdateXCapabilities(ControllerState& state);
-  void QueueControllerUpdate();
+  void MarkStateChanged(ControllerState& state);
 
   bool sdl_events_initialized_;
   bool sdl_gamecontroller_initialized_;
   int sdl_events_unflushed_;
-  std::atomic<bool> sdl_pumpevents_queued_;
+  // SDL is initialized, pumped and shut down on this thread.
+  std::unique_ptr<xe::threading::Thread> input_thread_;
+  std::unique_ptr<xe::threading::Event> input_thread_ready_event_;
+  std::atomic<bool> input_thread_running_;
   std::array<ControllerState, HID_SDL_USER_COUNT> controllers_;
   std::mutex controllers_mutex_;
   std::array<KeystrokeState, HID_SDL_USER_COUNT> keystroke_states_;
+
+  PublishedStates published_states_[2];
+  std::atomic<uint32_t> published_states_index_;
+  // Guest-side tracking, for the packet number when is_active() changes and
+  // for measuring the latency of the first read of every new state.
+  std::array<std::atomic<bool>, HID_SDL_USER_COUNT> last_read_is_active_;
+  std::array<std::atomic<uint32_t>, HID_SDL_USER_COUNT> packet_number_bias_;
+  std::array<std::atomic<uint32_t>, HID_SDL_USER_COUNT> last_read_packet_;
 };
 
 }  // namespace sdl
@@ -0,0 +1,15 @@
+project_root = "../../../../.."
+include(project_root.."/tools/build")
+
+test_suite("xenia-hid-sdl-tests", project_root, ".", {
+  links = {
+    "fmt",
+    "SDL2",
+    "xenia-base",
+    "xenia-helper-sdl",
+    "xenia-hid",
+    "xenia-hid-sdl",
+    "xenia-ui",
+  },
+})
+  sdl2_include()
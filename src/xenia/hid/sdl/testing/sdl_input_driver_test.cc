@@ -0,0 +1,166 @@
+/**
+******************************************************************************
+* Xenia : Xbox 360 Emulator Research Project                                 *
+******************************************************************************
+* Copyright 2023 Ben Vanik. All rights reserved.                             *
+* Released under the BSD license - see LICENSE in the root for more details. *
+******************************************************************************
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#include "xenia/base/threading.h"
+#include "xenia/hid/sdl/sdl_input_driver.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace hid {
+namespace sdl {
+namespace test {
+using namespace std::chrono_literals;
+
+// Polls the state of the first user until the predicate is satisfied, as the
+// input thread publishes the changes asynchronously.
+template <class Predicate>
+bool WaitForState(SDLInputDriver& driver, Predicate predicate,
+                  X_INPUT_STATE& state_out) {
+  auto timeout_time = std::chrono::steady_clock::now() + 2s;
+  while (std::chrono::steady_clock::now() < timeout_time) {
+    X_RESULT result = driver.GetState(0, &state_out);
+    if (predicate(result, state_out)) {
+      return true;
+    }
+    xe::threading::Sleep(1ms);
+  }
+  return false;
+}
+
+TEST_CASE("SDL Input Virtual Controller", "[hid][sdl]") {
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+  // No window is needed, make sure nothing tries to connect to a display.
+  SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+  // Virtual joysticks can only be attached while the joystick subsystem is
+  // initialized. Subsystems are reference counted, so the input thread of the
+  // driver initializing and shutting down its own is fine.
+  REQUIRE(SDL_InitSubSystem(SDL_INIT_JOYSTICK) == 0);
+  int device_index =
+      SDL_JoystickAttachVirtual(SDL_JOYSTICK_TYPE_GAMECONTROLLER,
+                                SDL_CONTROLLER_AXIS_MAX,
+                                SDL_CONTROLLER_BUTTON_MAX, 0);
+  REQUIRE(device_index >= 0);
+  // Buttons and axes of a virtual game controller are mapped in the order of
+  // SDL_GameControllerButton and SDL_GameControllerAxis.
+  SDL_Joystick* joystick = SDL_JoystickOpen(device_index);
+  REQUIRE(joystick);
+
+  {
+    SDLInputDriver driver(nullptr, 0);
+    REQUIRE(driver.Setup() == X_STATUS_SUCCESS);
+
+    X_INPUT_STATE state;
+    // Already attached when SDL was initialized by the input thread.
+    REQUIRE(WaitForState(
+        driver,
+        [](X_RESULT result, const X_INPUT_STATE& state) {
+          return result == X_ERROR_SUCCESS;
+        },
+        state));
+    REQUIRE(!(state.gamepad.buttons & X_INPUT_GAMEPAD_A));
+    uint32_t connected_packet_number = state.packet_number;
+
+    SECTION("Button changes are published") {
+      REQUIRE(SDL_JoystickSetVirtualButton(joystick, SDL_CONTROLLER_BUTTON_A,
+                                           SDL_PRESSED) == 0);
+      REQUIRE(WaitForState(
+          driver,
+          [](X_RESULT result, const X_INPUT_STATE& state) {
+            return result == X_ERROR_SUCCESS &&
+                   (state.gamepad.buttons & X_INPUT_GAMEPAD_A);
+          },
+          state));
+      REQUIRE(state.packet_number > connected_packet_number);
+
+      // Without changes, the input thread keeps publishing the same state.
+      xe::threading::Sleep(20ms);
+      X_INPUT_STATE idle_state;
+      REQUIRE(driver.GetState(0, &idle_state) == X_ERROR_SUCCESS);
+      REQUIRE(std::memcmp(&idle_state, &state, sizeof(state)) == 0);
+    }
+
+    SECTION("Readers never see a torn state") {
+      // Both buffers are rewritten continuously while another thread reads.
+      // Every read must be a state that has been published as a whole - with
+      // a packet number that never goes back, and the same contents for the
+      // same packet number.
+      std::atomic<bool> reader_running(true);
+      std::atomic<bool> reader_failed(false);
+      std::atomic<uint32_t> reader_states(0);
+      // Catch assertions can't be used on other threads.
+      auto reader = xe::threading::Thread::Create({}, [&]() {
+        X_INPUT_STATE last_state;
+        if (driver.GetState(0, &last_state) != X_ERROR_SUCCESS) {
+          reader_failed = true;
+          return;
+        }
+        while (reader_running) {
+          X_INPUT_STATE read_state;
+          if (driver.GetState(0, &read_state) != X_ERROR_SUCCESS ||
+              read_state.packet_number < last_state.packet_number ||
+              (read_state.packet_number == last_state.packet_number &&
+               std::memcmp(&read_state.gamepad, &last_state.gamepad,
+                           sizeof(read_state.gamepad)))) {
+            reader_failed = true;
+            break;
+          }
+          last_state = read_state;
+          ++reader_states;
+        }
+      });
+      REQUIRE(reader);
+      for (uint32_t i = 0; i < 200; ++i) {
+        Sint16 value = (i & 1) ? SDL_JOYSTICK_AXIS_MAX : SDL_JOYSTICK_AXIS_MIN;
+        SDL_JoystickSetVirtualAxis(joystick, SDL_CONTROLLER_AXIS_TRIGGERLEFT,
+                                   value);
+        SDL_JoystickSetVirtualAxis(joystick, SDL_CONTROLLER_AXIS_LEFTX, value);
+        SDL_JoystickSetVirtualButton(joystick, SDL_CONTROLLER_BUTTON_B,
+                                     (i & 1) ? SDL_PRESSED : SDL_RELEASED);
+        xe::threading::Sleep(500us);
+      }
+      reader_running = false;
+      xe::threading::Wait(reader.get(), false);
+      REQUIRE(!reader_failed);
+      REQUIRE(reader_states > 0);
+      REQUIRE(driver.GetState(0, &state) == X_ERROR_SUCCESS);
+      REQUIRE(state.packet_number > connected_packet_number);
+    }
+
+    SECTION("Disconnection is published") {
+      SDL_JoystickClose(joystick);
+      joystick = nullptr;
+      REQUIRE(SDL_JoystickDetachVirtual(device_index) == 0);
+      REQUIRE(WaitForState(
+          driver,
+          [](X_RESULT result, const X_INPUT_STATE& state) {
+            return result == X_ERROR_DEVICE_NOT_CONNECTED;
+          },
+          state));
+    }
+  }
+
+  if (joystick) {
+    SDL_JoystickClose(joystick);
+    SDL_JoystickDetachVirtual(device_index);
+  }
+  SDL_QuitSubSystem(SDL_INIT_JOYSTICK);
+#else
+  WARN("Virtual joysticks require SDL 2.0.14 or newer");
+#endif  // SDL_VERSION_ATLEAST(2, 0, 14)
+}
+
+}  // namespace test
+}  // namespace sdl
+}  // namespace hid
+}  // namespace xe
@@ -9,6 +9,7 @@
 
 #include "xenia/kernel/kernel_state.h"
 
+#include <iterator>
 #include <string>
 
 #include "third_party/fmt/include/fmt/format.h"
@@ -28,6 +29,11 @@
 #include "xenia/kernel/xobject.h"
 #include "xenia/kernel/xthread.h"
 
+DEFINE_uint32(thread_memory_pool_size, 32,
+              "Maximum number of destroyed threads whose guest stacks and "
+              "kernel blocks are kept for reuse by new threads.",
+              "Kernel");
+
 namespace xe {
 namespace kernel {
 
@@ -270,6 +276,11 @@ object_ref<XThread> KernelState::LaunchModule(object_ref<UserModule> module) {
   SetExecutableModule(module);
   XELOGI("KernelState: Launching module...");
 
+  {
+    auto global_lock = global_critical_region_.Acquire();
+    thread_guest_memory_pool_open_ = true;
+  }
+
   // Create a thread to run in.
   // We start suspended so we can run the debugger prep.
   auto thread = object_ref<XThread>(
@@ -556,6 +567,8 @@ void KernelState::TerminateTitle() {
     process_info_block_address_ = 0;
   }
 
+  FreeThreadGuestMemoryPool();
+
   if (XThread::IsInThread()) {
     threads_by_id_.erase(XThread::GetCurrentThread()->thread_id());
 
@@ -566,6 +579,48 @@ void KernelState::TerminateTitle() {
   }
 }
 
+bool KernelState::AcquireThreadGuestMemory(
+    uint32_t stack_alloc_size, uint32_t tls_total_size,
+    XThreadGuestMemory& guest_memory_out) {
+  auto global_lock = global_critical_region_.Acquire();
+  for (auto it = thread_guest_memory_pool_.rbegin();
+       it != thread_guest_memory_pool_.rend(); ++it) {
+    if (it->stack_alloc_size == stack_alloc_size &&
+        it->tls_total_size == tls_total_size) {
+      guest_memory_out = *it;
+      thread_guest_memory_pool_.erase(std::next(it).base());
+      return true;
+    }
+  }
+  return false;
+}
+
+bool KernelState::ReleaseThreadGuestMemory(
+    const XThreadGuestMemory& guest_memory) {
+  auto global_lock = global_critical_region_.Acquire();
+  if (!thread_guest_memory_pool_open_ ||
+      thread_guest_memory_pool_.size() >= cvars::thread_memory_pool_size) {
+    return false;
+  }
+  thread_guest_memory_pool_.push_back(guest_memory);
+  return true;
+}
+
+void KernelState::FreeThreadGuestMemoryPool() {
+  auto global_lock = global_critical_region_.Acquire();
+  // Threads of the title may still be destroyed later, don't let them refill
+  // the pool.
+  thread_guest_memory_pool_open_ = false;
+  for (const XThreadGuestMemory& guest_memory : thread_guest_memory_pool_) {
+    memory_->LookupHeap(guest_memory.stack_alloc_base)
+        ->Release(guest_memory.stack_alloc_base);
+    memory_->SystemHeapFree(guest_memory.scratch_address);
+    memory_->SystemHeapFree(guest_memory.tls_static_address);
+    memory_->SystemHeapFree(guest_memory.pcr_address);
+  }
+  thread_guest_memory_pool_.clear();
+}
+
 void KernelState::RegisterThread(XThread* thread) {
   auto global_lock = global_critical_region_.Acquire();
   threads_by_id_[thread->thread_id()] = thread;
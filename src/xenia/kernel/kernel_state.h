@@ -82,6 +82,20 @@ struct ProcessInfoBlock {
   xe::be<uint32_t> unk_5C;
 };
 
+// Guest memory blocks of a thread, kept after the thread is destroyed for
+// reuse by new threads, as titles with job systems may create short-lived
+// threads often.
+struct XThreadGuestMemory {
+  uint32_t stack_alloc_base;
+  uint32_t stack_alloc_size;
+  uint32_t stack_base;
+  uint32_t stack_limit;
+  uint32_t scratch_address;
+  uint32_t tls_static_address;
+  uint32_t tls_total_size;
+  uint32_t pcr_address;
+};
+
 struct TerminateNotification {
   uint32_t guest_routine;
   uint32_t priority;
@@ -163,6 +177,16 @@ class KernelState {
   void OnThreadExit(XThread* thread);
   object_ref<XThread> GetThreadByID(uint32_t thread_id);
 
+  // Takes the guest memory of a destroyed thread with the same stack and TLS
+  // allocation sizes, returns false if there is none. The contents are not
+  // reset.
+  bool AcquireThreadGuestMemory(uint32_t stack_alloc_size,
+                                uint32_t tls_total_size,
+                                XThreadGuestMemory& guest_memory_out);
+  // Keeps the guest memory of a destroyed thread, returns false if the pool is
+  // full or the title is being terminated, and it must be freed by the caller.
+  bool ReleaseThreadGuestMemory(const XThreadGuestMemory& guest_memory);
+
   void RegisterNotifyListener(XNotifyListener* listener);
   void UnregisterNotifyListener(XNotifyListener* listener);
   void BroadcastNotification(XNotificationID id, uint32_t data);
@@ -201,6 +225,7 @@ class KernelState {
 
  private:
   void LoadKernelModule(object_ref<KernelModule> kernel_module);
+  void FreeThreadGuestMemoryPool();
 
   Emulator* emulator_;
   Memory* memory_;
@@ -216,6 +241,9 @@ class KernelState {
   // Must be guarded by the global critical region.
   util::ObjectTable object_table_;
   std::unordered_map<uint32_t, XThread*> threads_by_id_;
+  std::vector<XThreadGuestMemory> thread_guest_memory_pool_;
+  // Closed when the title is terminated, until the next one is launched.
+  bool thread_guest_memory_pool_open_ = true;
   std::vector<object_ref<XNotifyListener>> notify_listeners_;
   bool has_notified_startup_ = false;
 
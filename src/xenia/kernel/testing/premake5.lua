@@ -0,0 +1,26 @@
+project_root = "../../../.."
+include(project_root.."/tools/build")
+
+test_suite("xenia-kernel-tests", project_root, ".", {
+  links = {
+    "aes_128",
+    "capstone",
+    "fmt",
+    "xenia-apu",
+    "xenia-base",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-hid",
+    "xenia-kernel",
+    "xenia-ui", -- needed by xenia-base
+    "xenia-vfs",
+  },
+  filtered_links = {
+    {
+      filter = 'architecture:x86_64',
+      links = {
+        "xenia-cpu-backend-x64",
+      },
+    }
+  },
+})
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/kernel/xboxkrnl/xboxkrnl_threading.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::kernel::xboxkrnl::test {
+
+// Acquires and releases the guest spinlock on thread_count host threads, doing
+// some work while holding it. The lock functions only access the lock dword,
+// so they don't need guest threads. Returns the number of acquisitions seen
+// by the critical sections.
+static uint64_t ContendGuestSpinLock(size_t thread_count,
+                                     size_t acquisition_count,
+                                     uint32_t hold_iterations) {
+  alignas(16) uint32_t lock = 0;
+  uint64_t acquisitions = 0;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&]() {
+      for (size_t j = 0; j < acquisition_count; ++j) {
+        xeAcquireGuestSpinLock(&lock);
+        // Not atomic, lost increments mean the lock hasn't excluded others.
+        volatile uint64_t* acquisitions_volatile = &acquisitions;
+        for (uint32_t k = 0; k < hold_iterations; ++k) {
+          *acquisitions_volatile = *acquisitions_volatile;
+        }
+        *acquisitions_volatile = *acquisitions_volatile + 1;
+        xeReleaseGuestSpinLock(&lock);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return acquisitions;
+}
+
+// More guest threads than host cores, so lock holders get preempted.
+static size_t GetOversubscribedThreadCount() {
+  return std::max(size_t(std::thread::hardware_concurrency()), size_t(1)) * 4;
+}
+
+TEST_CASE("Guest spinlock excludes other threads", "[guest_lock]") {
+  size_t thread_count = GetOversubscribedThreadCount();
+  constexpr size_t kAcquisitionCount = 2000;
+  REQUIRE(ContendGuestSpinLock(thread_count, kAcquisitionCount, 16) ==
+          thread_count * kAcquisitionCount);
+}
+
+TEST_CASE("Guest spinlock contention", "[.benchmark][guest_lock]") {
+  size_t hardware_thread_count =
+      std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+  size_t oversubscribed_thread_count = GetOversubscribedThreadCount();
+  constexpr size_t kAcquisitionCount = 10000;
+  BENCHMARK("Short holds, 1 thread per hardware thread") {
+    return ContendGuestSpinLock(hardware_thread_count, kAcquisitionCount, 16);
+  };
+  BENCHMARK("Short holds, 4 threads per hardware thread") {
+    return ContendGuestSpinLock(oversubscribed_thread_count, kAcquisitionCount,
+                                16);
+  };
+  BENCHMARK("Long holds, 4 threads per hardware thread") {
+    return ContendGuestSpinLock(oversubscribed_thread_count, kAcquisitionCount,
+                                1024);
+  };
+}
+
+}  // namespace xe::kernel::xboxkrnl::test
@@ -565,12 +565,8 @@ dword_result_t NtQueryDirectoryFile_entry(
   }
 
   if (file) {
-    X_FILE_DIRECTORY_INFORMATION dir_info = {0};
-    result =
-        file->QueryDirectory(file_info_ptr, length, name, restart_scan != 0);
-    if (XSUCCEEDED(result)) {
-      info = length;
-    }
+    result = file->QueryDirectory(file_info_ptr, length, name,
+                                  restart_scan != 0, &info);
   } else {
     result = X_STATUS_NO_SUCH_FILE;
   }
@@ -429,18 +429,27 @@ void RtlEnterCriticalSection_entry(pointer_t<X_RTL_CRITICAL_SECTION> cs) {
     return;
   }
 
-  // Spin loop
-  while (spin_count--) {
+  // Spin loop, shorter if spinning hasn't been helping recently. After it,
+  // the waiter is parked on the event of the critical section.
+  uint32_t spin_limit = xeGetGuestLockSpinLimit(cs.host_address(), spin_count);
+  for (uint32_t i = 1; i <= spin_limit; ++i) {
     if (xe::atomic_cas(-1, 0, &cs->lock_count)) {
       // Acquired.
+      if (i > 1) {
+        xeUpdateGuestLockSpinStatistics(cs.host_address(), i, false);
+      }
       cs->owning_thread = cur_thread;
       cs->recursion_count = 1;
       return;
     }
+    if (!(i & 15)) {
+      xe::threading::MaybeYield();
+    }
   }
 
   if (xe::atomic_inc(&cs->lock_count) != 0) {
     // Create a full waiter.
+    xeUpdateGuestLockSpinStatistics(cs.host_address(), spin_limit, true);
     xeKeWaitForSingleObject(reinterpret_cast<void*>(cs.host_address()), 8, 0, 0,
                             nullptr);
   }
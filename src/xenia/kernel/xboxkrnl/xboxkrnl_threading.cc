@@ -8,12 +8,18 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 
 #include "xenia/base/atomic.h"
 #include "xenia/base/clock.h"
+#include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/mutex.h"
+#include "xenia/base/profiling.h"
 #include "xenia/cpu/processor.h"
 #include "xenia/kernel/kernel_state.h"
 #include "xenia/kernel/user_module.h"
@@ -27,6 +33,13 @@
 #include "xenia/kernel/xtimer.h"
 #include "xenia/xbox.h"
 
+DEFINE_uint32(guest_lock_max_spin_count, 1024,
+              "Maximum number of times a contended guest spinlock or critical "
+              "section is polled before the waiting thread is parked on the "
+              "host, so a preempted lock holder doesn't leave its waiters "
+              "occupying host cores.",
+              "Kernel");
+
 namespace xe {
 namespace kernel {
 namespace xboxkrnl {
@@ -911,17 +924,107 @@ dword_result_t NtSignalAndWaitForSingleObjectEx_entry(dword_t signal_handle,
 DECLARE_XBOXKRNL_EXPORT3(NtSignalAndWaitForSingleObjectEx, kThreading,
                          kImplemented, kBlocking, kHighFrequency);
 
+// Host wait queues for the waiters of guest locks, keyed by the guest lock
+// address. Multiple locks may share a bucket, so a release wakes all the
+// waiters in the bucket, and they check their own lock again.
+struct GuestLockBucket {
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::atomic<uint32_t> waiter_count{0};
+  // Moving average of the number of polls needed to acquire the locks.
+  std::atomic<uint32_t> average_spin_count{0};
+};
+constexpr uint32_t kGuestLockBucketCountLog2 = 6;
+static GuestLockBucket guest_lock_buckets_[1 << kGuestLockBucketCountLog2];
+
+static GuestLockBucket& GetGuestLockBucket(const void* lock) {
+  auto address = reinterpret_cast<uintptr_t>(lock);
+  // Locks are at least 4-byte-aligned, and often in 16-byte structures.
+  address = (address >> 4) ^ (address >> (4 + kGuestLockBucketCountLog2));
+  return guest_lock_buckets_[address &
+                             ((1 << kGuestLockBucketCountLog2) - 1)];
+}
+
+uint32_t xeGetGuestLockSpinLimit(const void* lock, uint32_t max_spin_count) {
+  uint32_t average_spin_count =
+      GetGuestLockBucket(lock).average_spin_count.load(
+          std::memory_order_relaxed);
+  return std::min(std::min(average_spin_count * 2 + 16,
+                           cvars::guest_lock_max_spin_count),
+                  max_spin_count);
+}
+
+void xeUpdateGuestLockSpinStatistics(const void* lock, uint32_t spin_count,
+                                     bool parked) {
+  COUNT_profile_add("kernel/guest_locks/spin_iterations", spin_count);
+  std::atomic<uint32_t>& average_spin_count =
+      GetGuestLockBucket(lock).average_spin_count;
+  uint32_t average = average_spin_count.load(std::memory_order_relaxed);
+  if (parked) {
+    // Spinning didn't help, likely the holder is not running - spin less.
+    COUNT_profile_add("kernel/guest_locks/parks", 1);
+    average -= average / 8;
+  } else {
+    average = uint32_t(int32_t(average) +
+                       (int32_t(spin_count) - int32_t(average)) / 8);
+  }
+  // Racy, but this is only a heuristic.
+  average_spin_count.store(average, std::memory_order_relaxed);
+}
+
+void xeAcquireGuestSpinLock(uint32_t* lock) {
+  if (xe::atomic_cas(0, 1, lock)) {
+    return;
+  }
+  auto lock_volatile = reinterpret_cast<volatile uint32_t*>(lock);
+  uint32_t spin_limit = xeGetGuestLockSpinLimit(lock, UINT32_MAX);
+  for (uint32_t spin_count = 1; spin_count <= spin_limit; ++spin_count) {
+    xe::threading::MaybeYield();
+    if (!*lock_volatile && xe::atomic_cas(0, 1, lock)) {
+      xeUpdateGuestLockSpinStatistics(lock, spin_count, false);
+      return;
+    }
+  }
+  xeUpdateGuestLockSpinStatistics(lock, spin_limit, true);
+
+  GuestLockBucket& bucket = GetGuestLockBucket(lock);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> bucket_lock(bucket.mutex);
+      // Registered before checking the lock, so the release either is seen
+      // here or sees the waiter.
+      bucket.waiter_count.fetch_add(1);
+      // The guest may also release the lock without calling the kernel, so
+      // don't rely only on the notification.
+      bucket.condition.wait_for(bucket_lock, std::chrono::milliseconds(1),
+                                [lock_volatile]() { return !*lock_volatile; });
+      bucket.waiter_count.fetch_sub(1);
+    }
+    if (xe::atomic_cas(0, 1, lock)) {
+      return;
+    }
+  }
+}
+
+void xeReleaseGuestSpinLock(uint32_t* lock) {
+  xe::atomic_dec(lock);
+  GuestLockBucket& bucket = GetGuestLockBucket(lock);
+  if (bucket.waiter_count.load()) {
+    {
+      // Make sure the waiters that have checked the lock are actually waiting.
+      std::lock_guard<std::mutex> bucket_lock(bucket.mutex);
+    }
+    bucket.condition.notify_all();
+  }
+}
+
 uint32_t xeKeKfAcquireSpinLock(uint32_t* lock) {
   // XELOGD(
   //     "KfAcquireSpinLock({:08X})",
   //     lock_ptr);
 
   // Lock.
-  while (!xe::atomic_cas(0, 1, lock)) {
-    // Spin!
-    // TODO(benvanik): error on deadlock?
-    xe::threading::MaybeYield();
-  }
+  xeAcquireGuestSpinLock(lock);
 
   // Raise IRQL to DISPATCH.
   XThread* thread = XThread::GetCurrentThread();
@@ -943,7 +1046,7 @@ void xeKeKfReleaseSpinLock(uint32_t* lock, dword_t old_irql) {
   thread->LowerIrql(old_irql);
 
   // Unlock.
-  xe::atomic_dec(lock);
+  xeReleaseGuestSpinLock(lock);
 }
 
 void KfReleaseSpinLock_entry(lpdword_t lock_ptr, dword_t old_irql) {
@@ -956,10 +1059,7 @@ DECLARE_XBOXKRNL_EXPORT2(KfReleaseSpinLock, kThreading, kImplemented,
 void KeAcquireSpinLockAtRaisedIrql_entry(lpdword_t lock_ptr) {
   // Lock.
   auto lock = reinterpret_cast<uint32_t*>(lock_ptr.host_address());
-  while (!xe::atomic_cas(0, 1, lock)) {
-    // Spin!
-    // TODO(benvanik): error on deadlock?
-  }
+  xeAcquireGuestSpinLock(lock);
 }
 DECLARE_XBOXKRNL_EXPORT3(KeAcquireSpinLockAtRaisedIrql, kThreading,
                          kImplemented, kBlocking, kHighFrequency);
@@ -978,7 +1078,7 @@ DECLARE_XBOXKRNL_EXPORT4(KeTryToAcquireSpinLockAtRaisedIrql, kThreading,
 void KeReleaseSpinLockFromRaisedIrql_entry(lpdword_t lock_ptr) {
   // Unlock.
   auto lock = reinterpret_cast<uint32_t*>(lock_ptr.host_address());
-  xe::atomic_dec(lock);
+  xeReleaseGuestSpinLock(lock);
 }
 DECLARE_XBOXKRNL_EXPORT2(KeReleaseSpinLockFromRaisedIrql, kThreading,
                          kImplemented, kHighFrequency);
@@ -32,6 +32,21 @@ uint32_t xeKeWaitForSingleObject(void* object_ptr, uint32_t wait_reason,
                                  uint64_t* timeout_ptr);
 uint32_t xeKeSetEvent(X_KEVENT* event_ptr, uint32_t increment, uint32_t wait);
 
+// Returns how many times a waiter for the guest lock should poll it before
+// parking, adapted to how long the locks near it were recently held, and not
+// exceeding max_spin_count.
+uint32_t xeGetGuestLockSpinLimit(const void* lock, uint32_t max_spin_count);
+// Records how many times the lock was polled before it was acquired, or
+// before the waiter was parked.
+void xeUpdateGuestLockSpinStatistics(const void* lock, uint32_t spin_count,
+                                     bool parked);
+
+// Acquires the guest spinlock dword, parking the thread on the host if the
+// lock is not released after some spinning.
+void xeAcquireGuestSpinLock(uint32_t* lock);
+// Releases the guest spinlock dword and wakes the parked waiters.
+void xeReleaseGuestSpinLock(uint32_t* lock);
+
 }  // namespace xboxkrnl
 }  // namespace kernel
 }  // namespace xe
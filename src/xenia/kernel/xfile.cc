@@ -10,6 +10,9 @@
 #include "xenia/kernel/xfile.h"
 #include "xenia/vfs/virtual_file_system.h"
 
+#include <cstddef>
+#include <cstring>
+
 #include "xenia/base/byte_stream.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
@@ -42,57 +45,102 @@ XFile::~XFile() {
 
 X_STATUS XFile::QueryDirectory(X_FILE_DIRECTORY_INFORMATION* out_info,
                                size_t length, const std::string_view file_name,
-                               bool restart) {
+                               bool restart, uint32_t* out_bytes_written) {
   assert_not_null(out_info);
+  assert_not_null(out_bytes_written);
+  *out_bytes_written = 0;
 
-  vfs::Entry* entry = nullptr;
-
-  if (!file_name.empty()) {
+  if (!file_name.empty() && file_name != find_pattern_) {
     // Only queries in the current directory are supported for now.
     assert_true(utf8::find_any_of(file_name, "\\") == std::string_view::npos);
 
     find_engine_.SetRule(file_name);
+    find_pattern_ = file_name;
+    restart = true;
+  }
+  if (restart || !find_snapshot_taken_) {
+    SnapshotDirectory();
+  }
 
-    // Always restart the search?
-    find_index_ = 0;
-    entry = file_->entry()->IterateChildren(find_engine_, &find_index_);
-    if (!entry) {
-      return X_STATUS_NO_SUCH_FILE;
-    }
-  } else {
-    if (restart) {
-      find_index_ = 0;
+  if (find_index_ >= find_entries_.size()) {
+    // Nothing matching the pattern at all, or the end of the enumeration.
+    return find_entries_.empty() && !find_pattern_.empty()
+               ? X_STATUS_NO_SUCH_FILE
+               : X_STATUS_NO_MORE_FILES;
+  }
+
+  // Return as many entries as fit in the buffer, chained by their offsets.
+  auto out_base = reinterpret_cast<uint8_t*>(out_info);
+  size_t out_offset = 0;
+  X_FILE_DIRECTORY_INFORMATION* previous_info = nullptr;
+  while (find_index_ < find_entries_.size()) {
+    const FindEntry& find_entry = find_entries_[find_index_];
+    size_t info_size = offsetof(X_FILE_DIRECTORY_INFORMATION, file_name) +
+                       find_entry.name.size();
+    if (out_offset + info_size > length) {
+      if (!previous_info) {
+        assert_always("Buffer overflow?");
+        return X_STATUS_NO_SUCH_FILE;
+      }
+      break;
     }
 
-    entry = file_->entry()->IterateChildren(find_engine_, &find_index_);
-    if (!entry) {
-      return X_STATUS_NO_MORE_FILES;
+    auto info =
+        reinterpret_cast<X_FILE_DIRECTORY_INFORMATION*>(out_base + out_offset);
+    info->next_entry_offset = 0;
+    info->file_index = find_entry.file_index;
+    info->creation_time = find_entry.create_timestamp;
+    info->last_access_time = find_entry.access_timestamp;
+    info->last_write_time = find_entry.write_timestamp;
+    info->change_time = find_entry.write_timestamp;
+    info->end_of_file = find_entry.size;
+    info->allocation_size = find_entry.allocation_size;
+    info->attributes = find_entry.attributes;
+    info->file_name_length = static_cast<uint32_t>(find_entry.name.size());
+    std::memcpy(info->file_name, find_entry.name.data(),
+                find_entry.name.size());
+
+    if (previous_info) {
+      previous_info->next_entry_offset = static_cast<uint32_t>(
+          reinterpret_cast<uint8_t*>(info) -
+          reinterpret_cast<uint8_t*>(previous_info));
     }
-  }
+    previous_info = info;
+    ++find_index_;
 
-  auto end = reinterpret_cast<uint8_t*>(out_info) + length;
-  const auto& entry_name = entry->name();
-  if (reinterpret_cast<uint8_t*>(&out_info->file_name[0]) + entry_name.size() >
-      end) {
-    assert_always("Buffer overflow?");
-    return X_STATUS_NO_SUCH_FILE;
+    // The padding after the last entry isn't included.
+    *out_bytes_written = static_cast<uint32_t>(out_offset + info_size);
+    // Entries are aligned to 8 bytes due to the 64-bit fields.
+    out_offset = xe::round_up(out_offset + info_size, size_t(8));
   }
 
-  out_info->next_entry_offset = 0;
-  out_info->file_index = static_cast<uint32_t>(find_index_);
-  out_info->creation_time = entry->create_timestamp();
-  out_info->last_access_time = entry->access_timestamp();
-  out_info->last_write_time = entry->write_timestamp();
-  out_info->change_time = entry->write_timestamp();
-  out_info->end_of_file = entry->size();
-  out_info->allocation_size = entry->allocation_size();
-  out_info->attributes = entry->attributes();
-  out_info->file_name_length = static_cast<uint32_t>(entry_name.size());
-  std::memcpy(out_info->file_name, entry_name.data(), entry_name.size());
-
   return X_STATUS_SUCCESS;
 }
 
+void XFile::SnapshotDirectory() {
+  find_entries_.clear();
+  find_index_ = 0;
+  find_snapshot_taken_ = true;
+
+  // Take the lock once for all children instead of for each.
+  auto global_lock = xe::global_critical_region::AcquireDirect();
+  vfs::Entry* directory = file_->entry();
+  size_t child_index = 0;
+  while (vfs::Entry* child =
+             directory->IterateChildren(find_engine_, &child_index)) {
+    FindEntry& find_entry = find_entries_.emplace_back();
+    find_entry.name = child->name();
+    // One-based index of the child in the directory.
+    find_entry.file_index = static_cast<uint32_t>(child_index);
+    find_entry.attributes = child->attributes();
+    find_entry.size = child->size();
+    find_entry.allocation_size = child->allocation_size();
+    find_entry.create_timestamp = child->create_timestamp();
+    find_entry.access_timestamp = child->access_timestamp();
+    find_entry.write_timestamp = child->write_timestamp();
+  }
+}
+
 X_STATUS XFile::Read(uint32_t buffer_guest_address, uint32_t buffer_length,
                      uint64_t byte_offset, uint32_t* out_bytes_read,
                      uint32_t apc_context, bool notify_completion) {
@@ -11,6 +11,7 @@
 #define XENIA_KERNEL_XFILE_H_
 
 #include <string>
+#include <vector>
 
 #include "xenia/kernel/xevent.h"
 #include "xenia/kernel/xiocompletion.h"
@@ -91,8 +92,12 @@ class XFile : public XObject {
   uint64_t position() const { return position_; }
   void set_position(uint64_t value) { position_ = value; }
 
+  // Writes as many entries as fit in the buffer. The pattern in file_name is
+  // only applied when it's different from the one of the current enumeration
+  // or when restarting, further queries may repeat it or pass an empty one.
   X_STATUS QueryDirectory(X_FILE_DIRECTORY_INFORMATION* out_info, size_t length,
-                          const std::string_view file_name, bool restart);
+                          const std::string_view file_name, bool restart,
+                          uint32_t* out_bytes_written);
 
   // Don't do within the global critical region because invalidation callbacks
   // may be triggered (as per the usual rule of not doing I/O within the global
@@ -140,7 +145,27 @@ class XFile : public XObject {
 
   uint64_t position_ = 0;
 
+  // Directory enumeration runs on a snapshot of the matching children taken
+  // on the first or restarted query, so it's consistent across the queries and
+  // doesn't need to hold the global lock.
+  struct FindEntry {
+    std::string name;
+    uint32_t file_index;
+    uint32_t attributes;
+    uint64_t size;
+    uint64_t allocation_size;
+    uint64_t create_timestamp;
+    uint64_t access_timestamp;
+    uint64_t write_timestamp;
+  };
+  void SnapshotDirectory();
+
   xe::filesystem::WildcardEngine find_engine_;
+  // The pattern find_entries_ was taken with, empty for all children.
+  std::string find_pattern_;
+  std::vector<FindEntry> find_entries_;
+  bool find_snapshot_taken_ = false;
+  // Index of the next entry to return in find_entries_.
   size_t find_index_ = 0;
 
   bool is_synchronous_ = false;
@@ -92,10 +92,12 @@ XThread::~XThread() {
   if (thread_state_) {
     delete thread_state_;
   }
-  kernel_state()->memory()->SystemHeapFree(scratch_address_);
-  kernel_state()->memory()->SystemHeapFree(tls_static_address_);
-  kernel_state()->memory()->SystemHeapFree(pcr_address_);
-  FreeStack();
+  if (!ReleaseGuestMemoryToPool()) {
+    kernel_state()->memory()->SystemHeapFree(scratch_address_);
+    kernel_state()->memory()->SystemHeapFree(tls_static_address_);
+    kernel_state()->memory()->SystemHeapFree(pcr_address_);
+    FreeStack();
+  }
 
   if (thread_) {
     // TODO(benvanik): platform kill
@@ -267,6 +269,52 @@ void XThread::FreeStack() {
   }
 }
 
+uint32_t XThread::GetStackAllocationSize(uint32_t size) const {
+  auto heap = memory()->LookupHeap(kStackAddressRangeBegin);
+  // With guard pages on both sides.
+  return xe::round_up(size, heap->page_size()) + heap->page_size() * 2;
+}
+
+bool XThread::AcquirePooledGuestMemory() {
+  XThreadGuestMemory guest_memory;
+  if (!kernel_state()->AcquireThreadGuestMemory(
+          GetStackAllocationSize(creation_params_.stack_size),
+          tls_total_size_, guest_memory)) {
+    return false;
+  }
+  stack_alloc_base_ = guest_memory.stack_alloc_base;
+  stack_alloc_size_ = guest_memory.stack_alloc_size;
+  stack_base_ = guest_memory.stack_base;
+  stack_limit_ = guest_memory.stack_limit;
+  scratch_address_ = guest_memory.scratch_address;
+  tls_static_address_ = guest_memory.tls_static_address;
+  pcr_address_ = guest_memory.pcr_address;
+
+  // Reset everything to the same state as after allocation (TLS is
+  // initialized by the caller in both cases).
+  memory()->Fill(stack_limit_, stack_base_ - stack_limit_, 0xBE);
+  memory()->Zero(scratch_address_, scratch_size_);
+  memory()->Zero(pcr_address_, kPcrSize);
+  return true;
+}
+
+bool XThread::ReleaseGuestMemoryToPool() {
+  if (!stack_alloc_base_ || !scratch_address_ || !tls_static_address_ ||
+      !pcr_address_) {
+    return false;
+  }
+  XThreadGuestMemory guest_memory;
+  guest_memory.stack_alloc_base = stack_alloc_base_;
+  guest_memory.stack_alloc_size = stack_alloc_size_;
+  guest_memory.stack_base = stack_base_;
+  guest_memory.stack_limit = stack_limit_;
+  guest_memory.scratch_address = scratch_address_;
+  guest_memory.tls_static_address = tls_static_address_;
+  guest_memory.tls_total_size = tls_total_size_;
+  guest_memory.pcr_address = pcr_address_;
+  return kernel_state()->ReleaseThreadGuestMemory(guest_memory);
+}
+
 X_STATUS XThread::Create() {
   // Thread kernel object.
   if (!CreateNative<X_KTHREAD>()) {
@@ -274,17 +322,6 @@ X_STATUS XThread::Create() {
     return X_STATUS_NO_MEMORY;
   }
 
-  // Allocate a stack.
-  if (!AllocateStack(creation_params_.stack_size)) {
-    return X_STATUS_NO_MEMORY;
-  }
-
-  // Allocate thread scratch.
-  // This is used by interrupts/APCs/etc so we can round-trip pointers through.
-  scratch_size_ = 4 * 16;
-  scratch_address_ = memory()->SystemHeapAlloc(scratch_size_);
-
-  // Allocate TLS block.
   // Games will specify a certain number of 4b slots that each thread will get.
   xex2_opt_tls_info* tls_header = nullptr;
   auto module = kernel_state()->GetExecutableModule();
@@ -300,17 +337,38 @@ X_STATUS XThread::Create() {
     tls_extended_size = tls_header->data_size;
   }
 
-  // Allocate both the slots and the extended data.
   // Some TLS is compiled with the binary (declspec(thread)) vars. The game
   // will directly access those through 0(r13).
   uint32_t tls_slot_size = tls_slots * 4;
   tls_total_size_ = tls_slot_size + tls_extended_size;
-  tls_static_address_ = memory()->SystemHeapAlloc(tls_total_size_);
-  tls_dynamic_address_ = tls_static_address_ + tls_extended_size;
-  if (!tls_static_address_) {
-    XELOGW("Unable to allocate thread local storage block");
-    return X_STATUS_NO_MEMORY;
+
+  // Thread scratch is used by interrupts/APCs/etc so we can round-trip
+  // pointers through.
+  scratch_size_ = 4 * 16;
+
+  // Reuse the memory of a destroyed thread if possible, or allocate the stack,
+  // the scratch, the TLS block (both the slots and the extended data) and the
+  // thread state block.
+  if (!AcquirePooledGuestMemory()) {
+    if (!AllocateStack(creation_params_.stack_size)) {
+      return X_STATUS_NO_MEMORY;
+    }
+
+    scratch_address_ = memory()->SystemHeapAlloc(scratch_size_);
+
+    tls_static_address_ = memory()->SystemHeapAlloc(tls_total_size_);
+    if (!tls_static_address_) {
+      XELOGW("Unable to allocate thread local storage block");
+      return X_STATUS_NO_MEMORY;
+    }
+
+    pcr_address_ = memory()->SystemHeapAlloc(kPcrSize);
+    if (!pcr_address_) {
+      XELOGW("Unable to allocate thread state block");
+      return X_STATUS_NO_MEMORY;
+    }
   }
+  tls_dynamic_address_ = tls_static_address_ + tls_extended_size;
 
   // Zero all of TLS.
   memory()->Fill(tls_static_address_, tls_total_size_, 0);
@@ -321,7 +379,7 @@ X_STATUS XThread::Create() {
                    tls_header->raw_data_size);
   }
 
-  // Allocate thread state block from heap.
+  // Thread state block (at pcr_address_):
   // https://web.archive.org/web/20170704035330/https://www.microsoft.com/msj/archive/S2CE.aspx
   // This is set as r13 for user code and some special inlined Win32 calls
   // (like GetLastError/etc) will poke it directly.
@@ -336,11 +394,6 @@ X_STATUS XThread::Create() {
   // 0x160: last error
   // So, at offset 0x100 we have a 4b pointer to offset 200, then have the
   // structure.
-  pcr_address_ = memory()->SystemHeapAlloc(0x2D8);
-  if (!pcr_address_) {
-    XELOGW("Unable to allocate thread state block");
-    return X_STATUS_NO_MEMORY;
-  }
 
   // Allocate processor thread state.
   // This is thread safe.
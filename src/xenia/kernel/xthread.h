@@ -245,8 +245,18 @@ class XThread : public XObject, public cpu::Thread {
   }
 
  protected:
+  // Size of the thread state block (KPCR).
+  static constexpr uint32_t kPcrSize = 0x2D8;
+
+  uint32_t GetStackAllocationSize(uint32_t size) const;
   bool AllocateStack(uint32_t size);
   void FreeStack();
+  // Takes the memory of a destroyed thread, with the stack contents and the
+  // thread state block reset, if there's any matching the stack and TLS sizes.
+  bool AcquirePooledGuestMemory();
+  // Gives all the guest memory of the thread to the pool, returns false if it
+  // must be freed.
+  bool ReleaseGuestMemoryToPool();
   void InitializeGuestObject();
 
   void DeliverAPCs();
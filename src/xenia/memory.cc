@@ -20,6 +20,7 @@
 #include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
+#include "xenia/base/platform.h"
 #include "xenia/base/threading.h"
 #include "xenia/cpu/mmio_handler.h"
 
@@ -32,6 +33,12 @@ DEFINE_bool(protect_on_release, false,
             "Protect released memory to prevent accesses.", "Memory");
 DEFINE_bool(scribble_heap, false,
             "Scribble 0xCD into all allocated heap memory.", "Memory");
+DEFINE_bool(guest_memory_huge_pages, false,
+            "Back the guest memory with huge host pages where possible to "
+            "reduce TLB misses in guest code (transparent huge pages on "
+            "Linux). Parts of huge pages with different guest protection or "
+            "watched for writes fall back to regular pages.",
+            "Memory");
 
 namespace xe {
 uint32_t get_page_count(uint32_t value, uint32_t page_size) {
@@ -290,6 +297,25 @@ int Memory::MapViews(uint8_t* mapping_base) {
       return 1;
     }
   }
+  if (cvars::guest_memory_huge_pages) {
+    bool huge_pages_advised = true;
+    for (size_t n = 0; n < xe::countof(map_info); n++) {
+      huge_pages_advised &= xe::memory::AdviseHugePages(
+          views_.all_views[n], map_info[n].virtual_address_end -
+                                   map_info[n].virtual_address_start + 1);
+    }
+    if (!huge_pages_advised) {
+#if XE_PLATFORM_LINUX
+      XELOGW(
+          "Transparent huge pages are not enabled for shared memory, using "
+          "regular pages for the guest memory. They can be enabled by "
+          "mounting /dev/shm with huge=advise, or by setting "
+          "/sys/kernel/mm/transparent_hugepage/shmem_enabled to force");
+#else
+      XELOGW("Huge pages are not supported for the guest memory on this host");
+#endif  // XE_PLATFORM_LINUX
+    }
+  }
   return 0;
 }
 
@@ -10,21 +10,31 @@
 #include "xenia/vfs/devices/stfs_container_device.h"
 
 #include <algorithm>
+#include <cstring>
 #include <queue>
+#include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+#include "third_party/fmt/include/fmt/format.h"
+#include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/mapped_memory.h"
 #include "xenia/base/math.h"
+#include "xenia/base/xxhash.h"
 #include "xenia/vfs/devices/stfs_container_entry.h"
 
 namespace xe {
 namespace vfs {
 
-StfsContainerDevice::StfsContainerDevice(const std::string_view mount_path,
-                                         const std::filesystem::path& host_path)
+StfsContainerDevice::StfsContainerDevice(
+    const std::string_view mount_path, const std::filesystem::path& host_path,
+    const std::filesystem::path& index_root)
     : Device(mount_path),
       name_("STFS"),
       host_path_(host_path),
+      index_root_(index_root),
       files_total_size_(),
       svod_base_offset_(),
       header_(),
@@ -56,17 +66,29 @@ bool StfsContainerDevice::Initialize() {
     return false;
   }
 
+  if (LoadIndex()) {
+    return true;
+  }
+
+  Error read_result;
   switch (header_.metadata.volume_type) {
     case XContentVolumeType::kStfs:
-      return ReadSTFS() == Error::kSuccess;
+      read_result = ReadSTFS();
       break;
     case XContentVolumeType::kSvod:
-      return ReadSVOD() == Error::kSuccess;
+      read_result = ReadSVOD();
+      break;
     default:
       XELOGE("Unknown XContent volume type: {}",
              xe::byte_swap(uint32_t(header_.metadata.volume_type.value)));
       return false;
   }
+  if (read_result != Error::kSuccess) {
+    return false;
+  }
+
+  StoreIndex();
+  return true;
 }
 
 StfsContainerDevice::Error StfsContainerDevice::OpenFiles() {
@@ -784,6 +806,256 @@ const StfsHashEntry* StfsContainerDevice::GetBlockHash(uint32_t block_index) {
   return record_data;
 }
 
+namespace {
+
+// The mount index is a cache local to the host, so it's stored in the host
+// byte order. Entries are in depth-first order, with every parent before its
+// children, and children of an entry in the order they were parsed.
+const uint32_t kIndexMagic = 0x58494658;  // 'XFIX'
+const uint32_t kIndexVersion = 1;
+const uint32_t kIndexNoParent = UINT32_MAX;
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t package_hash;
+  uint64_t files_total_size;
+  uint64_t svod_base_offset;
+  uint32_t svod_layout;
+  uint32_t entry_count;
+  uint32_t block_record_count;
+  uint32_t name_data_size;
+};
+
+struct IndexEntry {
+  uint32_t parent;
+  uint32_t attributes;
+  uint32_t name_offset;
+  uint32_t name_length;
+  uint64_t size;
+  uint64_t allocation_size;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t block;
+  uint64_t create_timestamp;
+  uint64_t access_timestamp;
+  uint64_t write_timestamp;
+  uint32_t block_record_first;
+  uint32_t block_record_count;
+};
+
+struct IndexBlockRecord {
+  uint64_t file;
+  uint64_t offset;
+  uint64_t length;
+};
+
+}  // namespace
+
+uint64_t StfsContainerDevice::GetIndexHash() const {
+  // The header contains the content ID and the hash of the top-level hash
+  // table, which change whenever the contents of the package do.
+  return XXH3_64bits(&header_, sizeof(header_));
+}
+
+std::filesystem::path StfsContainerDevice::GetIndexPath() const {
+  return index_root_ / fmt::format("{:016X}.xfi", GetIndexHash());
+}
+
+bool StfsContainerDevice::LoadIndex() {
+  if (index_root_.empty()) {
+    return false;
+  }
+  auto index_path = GetIndexPath();
+  if (!std::filesystem::exists(index_path)) {
+    return false;
+  }
+  auto index = MappedMemory::Open(index_path, MappedMemory::Mode::kRead);
+  if (!index || index->size() < sizeof(IndexHeader)) {
+    return false;
+  }
+
+  const uint8_t* index_data = index->data();
+  IndexHeader index_header;
+  std::memcpy(&index_header, index_data, sizeof(index_header));
+  if (index_header.magic != kIndexMagic ||
+      index_header.version != kIndexVersion ||
+      index_header.package_hash != GetIndexHash() ||
+      index_header.files_total_size != files_total_size_ ||
+      !index_header.entry_count) {
+    return false;
+  }
+  size_t entries_offset = sizeof(IndexHeader);
+  size_t block_records_offset =
+      entries_offset + sizeof(IndexEntry) * index_header.entry_count;
+  size_t names_offset =
+      block_records_offset +
+      sizeof(IndexBlockRecord) * index_header.block_record_count;
+  if (index->size() != names_offset + index_header.name_data_size) {
+    XELOGW("STFS container index {} is damaged, ignoring it",
+           xe::path_to_utf8(index_path));
+    return false;
+  }
+  const char* names = reinterpret_cast<const char*>(index_data + names_offset);
+
+  std::unique_ptr<Entry> root_entry;
+  std::vector<StfsContainerEntry*> entries;
+  entries.reserve(index_header.entry_count);
+  for (uint32_t i = 0; i < index_header.entry_count; ++i) {
+    IndexEntry index_entry;
+    std::memcpy(&index_entry,
+                index_data + entries_offset + sizeof(IndexEntry) * i,
+                sizeof(index_entry));
+    if (uint64_t(index_entry.name_offset) + index_entry.name_length >
+            index_header.name_data_size ||
+        uint64_t(index_entry.block_record_first) +
+                index_entry.block_record_count >
+            index_header.block_record_count ||
+        (i ? index_entry.parent >= i : index_entry.parent != kIndexNoParent)) {
+      XELOGW("STFS container index {} is damaged, ignoring it",
+             xe::path_to_utf8(index_path));
+      return false;
+    }
+
+    std::unique_ptr<StfsContainerEntry> entry;
+    if (i) {
+      entry = StfsContainerEntry::Create(
+          this, entries[index_entry.parent],
+          std::string_view(names + index_entry.name_offset,
+                           index_entry.name_length),
+          &files_);
+    } else {
+      entry = std::make_unique<StfsContainerEntry>(this, nullptr, "", &files_);
+    }
+    entry->attributes_ = index_entry.attributes;
+    entry->size_ = size_t(index_entry.size);
+    entry->allocation_size_ = size_t(index_entry.allocation_size);
+    entry->data_offset_ = size_t(index_entry.data_offset);
+    entry->data_size_ = size_t(index_entry.data_size);
+    entry->block_ = size_t(index_entry.block);
+    entry->create_timestamp_ = index_entry.create_timestamp;
+    entry->access_timestamp_ = index_entry.access_timestamp;
+    entry->write_timestamp_ = index_entry.write_timestamp;
+    entry->block_list_.reserve(index_entry.block_record_count);
+    for (uint32_t j = 0; j < index_entry.block_record_count; ++j) {
+      IndexBlockRecord index_block_record;
+      std::memcpy(&index_block_record,
+                  index_data + block_records_offset +
+                      sizeof(IndexBlockRecord) *
+                          (index_entry.block_record_first + j),
+                  sizeof(index_block_record));
+      entry->block_list_.push_back({size_t(index_block_record.file),
+                                    size_t(index_block_record.offset),
+                                    size_t(index_block_record.length)});
+    }
+
+    entries.push_back(entry.get());
+    if (i) {
+      entries[index_entry.parent]->children_.emplace_back(std::move(entry));
+    } else {
+      root_entry = std::move(entry);
+    }
+  }
+
+  root_entry_ = std::move(root_entry);
+  svod_base_offset_ = size_t(index_header.svod_base_offset);
+  svod_layout_ = SvodLayoutType(index_header.svod_layout);
+  XELOGI("Loaded {} entries of the STFS container from the index {}",
+         index_header.entry_count, xe::path_to_utf8(index_path));
+  return true;
+}
+
+void StfsContainerDevice::StoreIndex() const {
+  if (index_root_.empty()) {
+    return;
+  }
+
+  std::vector<IndexEntry> index_entries;
+  std::vector<IndexBlockRecord> index_block_records;
+  std::string names;
+  // Pairs of the entry and the index of its parent.
+  std::vector<std::pair<const Entry*, uint32_t>> entry_stack;
+  entry_stack.emplace_back(root_entry_.get(), kIndexNoParent);
+  while (!entry_stack.empty()) {
+    auto [entry, parent] = entry_stack.back();
+    entry_stack.pop_back();
+    auto stfs_entry = static_cast<const StfsContainerEntry*>(entry);
+
+    IndexEntry& index_entry = index_entries.emplace_back();
+    index_entry.parent = parent;
+    index_entry.attributes = entry->attributes();
+    index_entry.name_offset = uint32_t(names.size());
+    index_entry.name_length = uint32_t(entry->name().size());
+    index_entry.size = entry->size();
+    index_entry.allocation_size = entry->allocation_size();
+    index_entry.data_offset = stfs_entry->data_offset();
+    index_entry.data_size = stfs_entry->data_size();
+    index_entry.block = stfs_entry->block();
+    index_entry.create_timestamp = entry->create_timestamp();
+    index_entry.access_timestamp = entry->access_timestamp();
+    index_entry.write_timestamp = entry->write_timestamp();
+    index_entry.block_record_first = uint32_t(index_block_records.size());
+    index_entry.block_record_count = uint32_t(stfs_entry->block_list().size());
+    if (parent != kIndexNoParent) {
+      names += entry->name();
+    }
+    for (const auto& block_record : stfs_entry->block_list()) {
+      index_block_records.push_back(
+          {block_record.file, block_record.offset, block_record.length});
+    }
+
+    // Pushed in reverse so the children are popped in their original order.
+    uint32_t entry_index = uint32_t(index_entries.size() - 1);
+    const auto& children = entry->children();
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      entry_stack.emplace_back(it->get(), entry_index);
+    }
+  }
+
+  IndexHeader index_header;
+  index_header.magic = kIndexMagic;
+  index_header.version = kIndexVersion;
+  index_header.package_hash = GetIndexHash();
+  index_header.files_total_size = files_total_size_;
+  index_header.svod_base_offset = svod_base_offset_;
+  index_header.svod_layout = uint32_t(svod_layout_);
+  index_header.entry_count = uint32_t(index_entries.size());
+  index_header.block_record_count = uint32_t(index_block_records.size());
+  index_header.name_data_size = uint32_t(names.size());
+
+  std::error_code ec;
+  std::filesystem::create_directories(index_root_, ec);
+  // Written to a temporary file first so another mount never sees a partially
+  // written index.
+  auto index_path = GetIndexPath();
+  auto index_temp_path = index_path;
+  index_temp_path += ".tmp";
+  FILE* index_file = xe::filesystem::OpenFile(index_temp_path, "wb");
+  if (!index_file) {
+    XELOGW("Failed to create the STFS container index {}",
+           xe::path_to_utf8(index_temp_path));
+    return;
+  }
+  bool written =
+      fwrite(&index_header, sizeof(index_header), 1, index_file) == 1 &&
+      fwrite(index_entries.data(), sizeof(IndexEntry), index_entries.size(),
+             index_file) == index_entries.size() &&
+      fwrite(index_block_records.data(), sizeof(IndexBlockRecord),
+             index_block_records.size(),
+             index_file) == index_block_records.size() &&
+      fwrite(names.data(), 1, names.size(), index_file) == names.size();
+  fclose(index_file);
+  if (written) {
+    std::filesystem::rename(index_temp_path, index_path, ec);
+    written = !ec;
+  }
+  if (!written) {
+    XELOGW("Failed to write the STFS container index {}",
+           xe::path_to_utf8(index_path));
+    std::filesystem::remove(index_temp_path, ec);
+  }
+}
+
 XContentPackageType StfsContainerDevice::ReadMagic(
     const std::filesystem::path& path) {
   auto map = MappedMemory::Open(path, MappedMemory::Mode::kRead, 0, 4);
@@ -32,8 +32,11 @@ class StfsContainerDevice : public Device {
  public:
   const static uint32_t kBlockSize = 0x1000;
 
-  StfsContainerDevice(const std::string_view mount_path,
-                      const std::filesystem::path& host_path);
+  // If index_root is not empty, the parsed directory tree is stored there and
+  // reused on later mounts of the same package instead of walking it again.
+  StfsContainerDevice(
+      const std::string_view mount_path, const std::filesystem::path& host_path,
+      const std::filesystem::path& index_root = std::filesystem::path());
   ~StfsContainerDevice() override;
 
   bool Initialize() override;
@@ -125,8 +128,14 @@ class StfsContainerDevice : public Device {
 
   const StfsHashEntry* GetBlockHash(uint32_t block_index);
 
+  uint64_t GetIndexHash() const;
+  std::filesystem::path GetIndexPath() const;
+  bool LoadIndex();
+  void StoreIndex() const;
+
   std::string name_;
   std::filesystem::path host_path_;
+  std::filesystem::path index_root_;
 
   std::map<size_t, FILE*> files_;
   size_t files_total_size_;
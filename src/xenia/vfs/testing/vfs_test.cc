@@ -9,7 +9,17 @@
 
 #include "xenia/vfs/devices/stfs_xbox.h"
 
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "third_party/catch/include/catch.hpp"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/math.h"
+#include "xenia/vfs/devices/stfs_container_device.h"
+#include "xenia/vfs/devices/stfs_container_entry.h"
 
 namespace xe::vfs::test {
 
@@ -25,4 +35,284 @@ TEST_CASE("STFS Decode date and time", "[stfs_decode]") {
   }
 }
 
+// Writes a read-only STFS package containing dir\a.bin (two blocks) and b.bin.
+void WriteTestStfsPackage(const std::filesystem::path& path) {
+  const size_t kBlockSize = StfsContainerDevice::kBlockSize;
+  const size_t kHashTableOffset = xe::round_up(sizeof(StfsHeader), kBlockSize);
+  const size_t kBlocksOffset = kHashTableOffset + kBlockSize;
+  std::vector<uint8_t> package(kBlocksOffset + 4 * kBlockSize);
+
+  auto header = reinterpret_cast<StfsHeader*>(package.data());
+  header->header.magic = XContentPackageType::kCon;
+  header->header.header_size = sizeof(StfsHeader);
+  header->metadata.volume_type = XContentVolumeType::kStfs;
+  auto& descriptor = header->metadata.volume_descriptor.stfs;
+  descriptor.descriptor_length = sizeof(StfsVolumeDescriptor);
+  descriptor.flags.bits.read_only_format = 1;
+  descriptor.file_table_block_count = 1;
+  descriptor.set_file_table_block_number(0);
+  descriptor.total_block_count = 4;
+
+  // Block 0 is the file table, blocks 1 and 2 are a.bin, block 3 is b.bin.
+  auto hash_table =
+      reinterpret_cast<StfsHashTable*>(package.data() + kHashTableOffset);
+  hash_table->entries[0].set_level0_next_block(0xFFFFFF);
+  hash_table->entries[1].set_level0_next_block(2);
+  hash_table->entries[2].set_level0_next_block(0xFFFFFF);
+  hash_table->entries[3].set_level0_next_block(0xFFFFFF);
+
+  auto directory =
+      reinterpret_cast<StfsDirectoryBlock*>(package.data() + kBlocksOffset);
+  auto set_entry = [](StfsDirectoryEntry& entry, const char* name,
+                      uint16_t directory_index) {
+    std::memcpy(entry.name, name, std::strlen(name));
+    entry.flags.name_length = uint8_t(std::strlen(name));
+    entry.directory_index = directory_index;
+    entry.create_date = 0x54CA;
+    entry.create_time = 0x9DBD;
+    entry.modified_date = 0x54CA;
+    entry.modified_time = 0x9DBD;
+  };
+  set_entry(directory->entries[0], "dir", 0xFFFF);
+  directory->entries[0].flags.directory = 1;
+  set_entry(directory->entries[1], "a.bin", 0);
+  directory->entries[1].set_start_block_number(1);
+  directory->entries[1].set_allocated_data_blocks(2);
+  directory->entries[1].set_valid_data_blocks(2);
+  directory->entries[1].length = 0x1800;
+  set_entry(directory->entries[2], "b.bin", 0xFFFF);
+  directory->entries[2].set_start_block_number(3);
+  directory->entries[2].set_allocated_data_blocks(1);
+  directory->entries[2].set_valid_data_blocks(1);
+  directory->entries[2].length = 0x10;
+
+  FILE* file = xe::filesystem::OpenFile(path, "wb");
+  REQUIRE(file);
+  REQUIRE(fwrite(package.data(), 1, package.size(), file) == package.size());
+  fclose(file);
+}
+
+// Writes a read-only STFS package with file_count files of blocks_per_file
+// blocks each, spread over directory_count directories. Only the header, the
+// level 0 hash tables and the file table are written, as mounting doesn't
+// read anything else, and the rest of the package is left sparse.
+void WriteLargeTestStfsPackage(const std::filesystem::path& path,
+                               uint32_t directory_count, uint32_t file_count,
+                               uint32_t blocks_per_file) {
+  const uint32_t kBlockSize = StfsContainerDevice::kBlockSize;
+  const uint32_t kBlocksPerHashTable =
+      sizeof(StfsHashTable::entries) / sizeof(StfsHashEntry);
+  const uint32_t kEntriesPerBlock =
+      sizeof(StfsDirectoryBlock::entries) / sizeof(StfsDirectoryEntry);
+  const uint32_t table_block_count = xe::round_up(
+      directory_count + file_count, kEntriesPerBlock) / kEntriesPerBlock;
+  const uint32_t total_block_count =
+      table_block_count + file_count * blocks_per_file;
+  // With more blocks, the level 1 hash tables would need to be placed too.
+  REQUIRE(total_block_count <= kBlocksPerHashTable * kBlocksPerHashTable);
+  const size_t data_offset = xe::round_up(sizeof(StfsHeader), kBlockSize);
+  // In read-only packages, every 170 blocks are preceded by their level 0 hash
+  // table, and the first level 1 hash table is after the first 170 blocks.
+  auto block_to_offset = [&](uint32_t block) {
+    size_t physical_block = block + block / kBlocksPerHashTable + 1;
+    if (block >= kBlocksPerHashTable) {
+      ++physical_block;
+    }
+    return data_offset + physical_block * kBlockSize;
+  };
+  auto hash_table_to_offset = [&](uint32_t hash_table) {
+    size_t physical_block = hash_table * (kBlocksPerHashTable + 1);
+    if (hash_table) {
+      ++physical_block;
+    }
+    return data_offset + physical_block * kBlockSize;
+  };
+
+  std::vector<uint8_t> header_data(sizeof(StfsHeader));
+  auto header = reinterpret_cast<StfsHeader*>(header_data.data());
+  header->header.magic = XContentPackageType::kCon;
+  header->header.header_size = sizeof(StfsHeader);
+  header->metadata.volume_type = XContentVolumeType::kStfs;
+  auto& descriptor = header->metadata.volume_descriptor.stfs;
+  descriptor.descriptor_length = sizeof(StfsVolumeDescriptor);
+  descriptor.flags.bits.read_only_format = 1;
+  descriptor.file_table_block_count = uint16_t(table_block_count);
+  descriptor.set_file_table_block_number(0);
+  descriptor.total_block_count = total_block_count;
+
+  // The file table comes first, followed by the files, each in a single chain.
+  std::vector<StfsHashTable> hash_tables(
+      xe::round_up(total_block_count, kBlocksPerHashTable) /
+      kBlocksPerHashTable);
+  std::memset(hash_tables.data(), 0,
+              sizeof(StfsHashTable) * hash_tables.size());
+  auto set_chain = [&](uint32_t first_block, uint32_t block_count) {
+    for (uint32_t i = 0; i < block_count; ++i) {
+      uint32_t block = first_block + i;
+      hash_tables[block / kBlocksPerHashTable]
+          .entries[block % kBlocksPerHashTable]
+          .set_level0_next_block(i + 1 < block_count ? block + 1 : 0xFFFFFF);
+    }
+  };
+  set_chain(0, table_block_count);
+
+  std::vector<StfsDirectoryBlock> directory_blocks(table_block_count);
+  std::memset(directory_blocks.data(), 0,
+              sizeof(StfsDirectoryBlock) * directory_blocks.size());
+  auto add_entry = [&](uint32_t index, const std::string& name,
+                       uint16_t directory_index) -> StfsDirectoryEntry& {
+    auto& entry = directory_blocks[index / kEntriesPerBlock]
+                      .entries[index % kEntriesPerBlock];
+    std::memcpy(entry.name, name.data(), name.size());
+    entry.flags.name_length = uint8_t(name.size());
+    entry.directory_index = directory_index;
+    entry.create_date = 0x54CA;
+    entry.create_time = 0x9DBD;
+    entry.modified_date = 0x54CA;
+    entry.modified_time = 0x9DBD;
+    return entry;
+  };
+  for (uint32_t i = 0; i < directory_count; ++i) {
+    add_entry(i, "dir" + std::to_string(i), 0xFFFF).flags.directory = 1;
+  }
+  for (uint32_t i = 0; i < file_count; ++i) {
+    uint32_t start_block = table_block_count + i * blocks_per_file;
+    auto& entry = add_entry(directory_count + i,
+                            "file" + std::to_string(i) + ".bin",
+                            uint16_t(i % directory_count));
+    entry.set_start_block_number(start_block);
+    entry.set_allocated_data_blocks(blocks_per_file);
+    entry.set_valid_data_blocks(blocks_per_file);
+    entry.length = blocks_per_file * kBlockSize;
+    set_chain(start_block, blocks_per_file);
+  }
+
+  FILE* file = xe::filesystem::OpenFile(path, "wb");
+  REQUIRE(file);
+  REQUIRE(fwrite(header_data.data(), 1, header_data.size(), file) ==
+          header_data.size());
+  for (uint32_t i = 0; i < hash_tables.size(); ++i) {
+    xe::filesystem::Seek(file, hash_table_to_offset(i), SEEK_SET);
+    REQUIRE(fwrite(&hash_tables[i], sizeof(StfsHashTable), 1, file) == 1);
+  }
+  for (uint32_t i = 0; i < table_block_count; ++i) {
+    xe::filesystem::Seek(file, block_to_offset(i), SEEK_SET);
+    REQUIRE(fwrite(&directory_blocks[i], sizeof(StfsDirectoryBlock), 1,
+                   file) == 1);
+  }
+  fclose(file);
+  std::filesystem::resize_file(path, block_to_offset(total_block_count - 1) +
+                                         kBlockSize);
+}
+
+void RequireEqualEntries(Entry* parsed, Entry* indexed) {
+  REQUIRE(indexed->path() == parsed->path());
+  REQUIRE(indexed->attributes() == parsed->attributes());
+  REQUIRE(indexed->size() == parsed->size());
+  REQUIRE(indexed->allocation_size() == parsed->allocation_size());
+  REQUIRE(indexed->create_timestamp() == parsed->create_timestamp());
+  REQUIRE(indexed->access_timestamp() == parsed->access_timestamp());
+  REQUIRE(indexed->write_timestamp() == parsed->write_timestamp());
+  auto parsed_stfs = static_cast<StfsContainerEntry*>(parsed);
+  auto indexed_stfs = static_cast<StfsContainerEntry*>(indexed);
+  REQUIRE(indexed_stfs->data_offset() == parsed_stfs->data_offset());
+  REQUIRE(indexed_stfs->data_size() == parsed_stfs->data_size());
+  REQUIRE(indexed_stfs->block() == parsed_stfs->block());
+  const auto& parsed_blocks = parsed_stfs->block_list();
+  const auto& indexed_blocks = indexed_stfs->block_list();
+  REQUIRE(indexed_blocks.size() == parsed_blocks.size());
+  for (size_t i = 0; i < parsed_blocks.size(); ++i) {
+    REQUIRE(indexed_blocks[i].file == parsed_blocks[i].file);
+    REQUIRE(indexed_blocks[i].offset == parsed_blocks[i].offset);
+    REQUIRE(indexed_blocks[i].length == parsed_blocks[i].length);
+  }
+  REQUIRE(indexed->child_count() == parsed->child_count());
+  for (size_t i = 0; i < parsed->child_count(); ++i) {
+    RequireEqualEntries(parsed->children()[i].get(),
+                        indexed->children()[i].get());
+  }
+}
+
+TEST_CASE("STFS mount index", "[stfs_index]") {
+  auto test_root =
+      std::filesystem::temp_directory_path() / "xenia_vfs_test_stfs_index";
+  std::filesystem::remove_all(test_root);
+  std::filesystem::create_directories(test_root);
+  auto package_path = test_root / "package";
+  auto index_root = test_root / "index";
+  WriteTestStfsPackage(package_path);
+
+  {
+    StfsContainerDevice parsed_device("\\Device\\Test", package_path,
+                                      index_root);
+    REQUIRE(parsed_device.Initialize());
+    auto a_entry = static_cast<StfsContainerEntry*>(
+        parsed_device.ResolvePath("dir\\a.bin"));
+    REQUIRE(a_entry);
+    REQUIRE(a_entry->size() == 0x1800);
+    REQUIRE(a_entry->block_list().size() == 2);
+
+    auto index_files = xe::filesystem::ListFiles(index_root);
+    REQUIRE(index_files.size() == 1);
+    auto index_path = index_files[0].path / index_files[0].name;
+
+    SECTION("Remount from the index") {
+      StfsContainerDevice indexed_device("\\Device\\Test", package_path,
+                                         index_root);
+      REQUIRE(indexed_device.Initialize());
+      RequireEqualEntries(parsed_device.ResolvePath(""),
+                          indexed_device.ResolvePath(""));
+    }
+
+    SECTION("Remount with a damaged index") {
+      std::filesystem::resize_file(index_path, 16);
+      StfsContainerDevice reparsed_device("\\Device\\Test", package_path,
+                                          index_root);
+      REQUIRE(reparsed_device.Initialize());
+      RequireEqualEntries(parsed_device.ResolvePath(""),
+                          reparsed_device.ResolvePath(""));
+      // The index is rewritten after parsing the package again.
+      REQUIRE(std::filesystem::file_size(index_path) > 16);
+    }
+  }
+
+  std::filesystem::remove_all(test_root);
+}
+
+TEST_CASE("STFS mount time", "[.benchmark][stfs_index]") {
+  auto test_root =
+      std::filesystem::temp_directory_path() / "xenia_vfs_test_stfs_mount";
+  std::filesystem::remove_all(test_root);
+  std::filesystem::create_directories(test_root);
+  auto package_path = test_root / "package";
+  auto index_root = test_root / "index";
+  // 4160 entries and about 24600 blocks - larger packages would need more than
+  // one level 1 hash table, which the package writer doesn't place.
+  WriteLargeTestStfsPackage(package_path, 64, 4096, 6);
+
+  {
+    StfsContainerDevice parsed_device("\\Device\\Test", package_path);
+    REQUIRE(parsed_device.Initialize());
+    StfsContainerDevice indexing_device("\\Device\\Test", package_path,
+                                        index_root);
+    REQUIRE(indexing_device.Initialize());
+    StfsContainerDevice indexed_device("\\Device\\Test", package_path,
+                                       index_root);
+    REQUIRE(indexed_device.Initialize());
+    RequireEqualEntries(parsed_device.ResolvePath(""),
+                        indexed_device.ResolvePath(""));
+  }
+
+  BENCHMARK("Mount by parsing the package") {
+    StfsContainerDevice device("\\Device\\Test", package_path);
+    return device.Initialize();
+  };
+  BENCHMARK("Mount from the index") {
+    StfsContainerDevice device("\\Device\\Test", package_path, index_root);
+    return device.Initialize();
+  };
+
+  std::filesystem::remove_all(test_root);
+}
+
 }  // namespace xe::vfs::test
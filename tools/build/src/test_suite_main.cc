@@ -17,6 +17,7 @@
 #include "xenia/base/cvar.h"
 
 #define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "third_party/catch/single_include/catch2/catch.hpp"
 
 namespace xe {